@@ -14,6 +14,8 @@
 #include <command.h>
 #include <cpu_func.h>
 #include <irq_func.h>
+#include <trace.h>
+#include <worker.h>
 #include <asm/cache.h>
 #include <asm/system.h>
 #include <asm/secure.h>
@@ -44,8 +46,12 @@ int cleanup_before_linux(void)
 	 * disable interrupt and turn off caches etc ...
 	 */
 
+	/* Send the secondary cores back to wait for the OS */
+	worker_stop();
 	board_cleanup_before_linux();
 
+	if (IS_ENABLED(CONFIG_TRACE_SAMPLE))
+		trace_sample_stop();
 	disable_interrupts();
 
 	/*
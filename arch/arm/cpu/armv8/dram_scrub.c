@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Clearing DRAM quickly, see asm/armv8/dram_scrub.h
+ */
+
+#include <common.h>
+#include <bootstage.h>
+#include <cpu_func.h>
+#include <log.h>
+#include <asm/barriers.h>
+#include <asm/armv8/dram_scrub.h>
+#include <asm/armv8/smp_run.h>
+#include <linux/sizes.h>
+
+/* Amount of memory handed to a core at a time */
+#define DRAM_SCRUB_CHUNK	SZ_16M
+
+/* DCZID_EL0 fields */
+#define DCZID_DZP		BIT(4)
+#define DCZID_BS_MASK		0xf
+
+/**
+ * struct dram_scrub_state - work shared between the cores
+ *
+ * @regions: Regions to clear
+ * @count: Number of regions
+ * @chunks: Total number of chunks in all regions
+ * @next: Next chunk to clear
+ * @zva_size: Bytes cleared by DC ZVA, or 0 to use ordinary stores
+ */
+struct dram_scrub_state {
+	const struct dram_scrub_region *regions;
+	int count;
+	u32 chunks;
+	u32 next;
+	uint zva_size;
+};
+
+static u32 dram_scrub_chunks(const struct dram_scrub_region *region)
+{
+	return DIV_ROUND_UP(region->size, DRAM_SCRUB_CHUNK);
+}
+
+/* Get the size of the block cleared by DC ZVA, or 0 if not permitted */
+static uint dram_scrub_zva_size(void)
+{
+	ulong dczid;
+
+	if (!dcache_status())
+		return 0;
+	asm volatile("mrs %0, dczid_el0" : "=r" (dczid));
+	if (dczid & DCZID_DZP)
+		return 0;
+
+	return 4 << (dczid & DCZID_BS_MASK);
+}
+
+static void dram_scrub_zero(ulong addr, ulong size, uint zva_size)
+{
+	ulong end = addr + size;
+
+	if (!zva_size) {
+		memset((void *)addr, '\0', size);
+		return;
+	}
+	for (; addr < end; addr += zva_size)
+		asm volatile("dc zva, %0" : : "r" (addr) : "memory");
+}
+
+/* Clear chunks until there are none left; runs on each core */
+static void dram_scrub_run(void *arg, uint cpu)
+{
+	struct dram_scrub_state *state = arg;
+	u32 chunk;
+
+	while ((chunk = smp_run_claim(&state->next)) < state->chunks) {
+		const struct dram_scrub_region *region = state->regions;
+		phys_size_t offset, size;
+
+		/* There are only a few regions, so just look for it */
+		while (chunk >= dram_scrub_chunks(region)) {
+			chunk -= dram_scrub_chunks(region);
+			region++;
+		}
+		offset = (phys_size_t)chunk * DRAM_SCRUB_CHUNK;
+		size = min_t(phys_size_t, region->size - offset,
+			     DRAM_SCRUB_CHUNK);
+		dram_scrub_zero(region->base + offset, size, state->zva_size);
+	}
+	dsb();
+}
+
+int dram_scrub(const struct dram_scrub_region *regions, int count,
+	       uint max_cpus)
+{
+	struct dram_scrub_state state;
+	int cpus;
+	int i;
+
+	state.regions = regions;
+	state.count = count;
+	state.chunks = 0;
+	state.next = 0;
+	state.zva_size = dram_scrub_zva_size();
+	for (i = 0; i < count; i++) {
+		if (!IS_ALIGNED(regions[i].base | regions[i].size,
+				DRAM_SCRUB_ALIGN))
+			return -EINVAL;
+		state.chunks += dram_scrub_chunks(&regions[i]);
+	}
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_DRAM_SCRUB, "dram_scrub");
+	if (state.zva_size) {
+		cpus = smp_run(dram_scrub_run, &state, max_cpus);
+	} else {
+		/* Exclusive accesses need the cache, so do it all here */
+		for (i = 0; i < count; i++)
+			dram_scrub_zero(regions[i].base, regions[i].size, 0);
+		cpus = 1;
+	}
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_DRAM_SCRUB);
+	log_debug("%u chunks, %d cores, DC ZVA %u bytes\n", state.chunks, cpus,
+		  state.zva_size);
+
+	return cpus;
+}
@@ -0,0 +1,409 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Running work on the secondary cores, see asm/armv8/smp_run.h
+ *
+ * If the devicetree has PSCI firmware, the secondary cores belong to it, so
+ * they are started with CPU_ON and stopped with CPU_OFF. Otherwise, with
+ * ARMV8_MULTIENTRY they wait on the spin table at CPU_RELEASE_ADDR (see
+ * start.S), so they are released by writing smp_run_entry() there and go
+ * back to waiting afterwards. The same is done with ARMV8_SPIN_TABLE in
+ * U-Boot proper, using its own release address.
+ */
+
+#include <common.h>
+#include <cpu_func.h>
+#include <dm.h>
+#include <log.h>
+#include <malloc.h>
+#include <time.h>
+#include <asm/cache.h>
+#include <asm/io.h>
+#include <asm/spin_table.h>
+#include <asm/system.h>
+#include <asm/armv8/smp_run.h>
+#include <asm/global_data.h>
+#include <dm/ofnode.h>
+#include <dm/read.h>
+#include <linux/psci.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* How long to wait for the secondary cores to start */
+#define SMP_RUN_START_TIMEOUT_MS	100
+
+/* Affinity fields of MPIDR_EL1, as used in the devicetree */
+#define SMP_RUN_MPIDR_MASK		0xff00ffffffULL
+
+/* smp_run_boot.next once closed, so that late cores do not get a number */
+#define SMP_RUN_NEXT_CLOSED		0x80000000
+
+/* Where the secondary cores wait to be released, if there is no PSCI */
+#if defined(CONFIG_ARMV8_SPIN_TABLE) && !defined(CONFIG_SPL_BUILD)
+#define SMP_RUN_RELEASE_ADDR		((ulong)&spin_table_cpu_release_addr)
+#elif defined(CONFIG_ARMV8_MULTIENTRY) && defined(CPU_RELEASE_ADDR)
+#define SMP_RUN_RELEASE_ADDR		CPU_RELEASE_ADDR
+#endif
+
+struct smp_run_boot smp_run_boot __aligned(ARCH_DMA_MINALIGN);
+
+/**
+ * struct smp_run_state - the function being run
+ *
+ * @fn: Function to run
+ * @arg: Argument to pass to @fn
+ * @done: Number of secondary cores which have finished
+ */
+static struct smp_run_state {
+	smp_run_fn fn;
+	void *arg;
+	u32 done;
+} smp_run_state;
+
+/* Stacks for the secondary cores, kept for the next smp_run() */
+static void *smp_run_stacks;
+static uint smp_run_stacks_cpus;
+
+/* Number of cores asked to start by smp_run_begin(), 0 if not running */
+static uint smp_run_asked;
+
+static void smp_run_flush_boot(void)
+{
+	ulong start = (ulong)&smp_run_boot;
+
+	flush_dcache_range(start,
+			   start + roundup(sizeof(smp_run_boot),
+					   ARCH_DMA_MINALIGN));
+}
+
+static bool smp_run_is_cpu(ofnode node)
+{
+	const char *type = ofnode_read_string(node, "device_type");
+
+	return type && !strcmp(type, "cpu");
+}
+
+/**
+ * smp_run_psci() - check whether the secondary cores belong to PSCI firmware
+ *
+ * This is decided at runtime rather than from the build configuration,
+ * since a board with a spin table in SPL (ARMV8_MULTIENTRY) normally hands
+ * the cores to firmware such as TF-A before U-Boot proper starts. Then they
+ * no longer wait on the spin table, and must be powered off again when
+ * finished so that the OS can start them.
+ *
+ * Return: how to call the firmware, SMP_RUN_PSCI_SMC or SMP_RUN_PSCI_HVC, or
+ *	0 if there is none and a spin table must be used
+ */
+static uint smp_run_psci(void)
+{
+	struct udevice *dev;
+	const char *method;
+
+	if (IS_ENABLED(CONFIG_SPL_BUILD) || !IS_ENABLED(CONFIG_ARM_PSCI_FW) ||
+	    uclass_get_device_by_name(UCLASS_FIRMWARE, "psci", &dev))
+		return 0;
+	method = dev_read_string(dev, "method");
+
+	return method && !strcmp(method, "hvc") ? SMP_RUN_PSCI_HVC :
+		SMP_RUN_PSCI_SMC;
+}
+
+/**
+ * smp_run_cpu_id() - get the MPIDR of a core from the devicetree
+ *
+ * @node: CPU node
+ * Return: MPIDR affinity bits, or -1 if there are none
+ */
+static u64 smp_run_cpu_id(ofnode node)
+{
+	const fdt32_t *reg;
+	int len;
+
+	reg = ofnode_read_prop(node, "reg", &len);
+	if (len == sizeof(u32))
+		return fdt32_to_cpu(reg[0]);
+	if (len == sizeof(u64))
+		return ((u64)fdt32_to_cpu(reg[0]) << 32) |
+			fdt32_to_cpu(reg[1]);
+
+	return -1ULL;
+}
+
+#ifdef SMP_RUN_RELEASE_ADDR
+static void smp_run_release(ulong entry)
+{
+	writeq(entry, SMP_RUN_RELEASE_ADDR);
+	flush_dcache_range(SMP_RUN_RELEASE_ADDR,
+			   SMP_RUN_RELEASE_ADDR + ARCH_DMA_MINALIGN);
+	dsb();
+	asm volatile("sev");
+}
+#endif
+
+/**
+ * smp_run_start_cpus() - start the secondary cores
+ *
+ * @count: Number of cores to use, including the boot core
+ * Return: number of secondary cores which were asked to start
+ */
+static uint smp_run_start_cpus(uint count)
+{
+	u64 self = read_mpidr() & SMP_RUN_MPIDR_MASK;
+	ulong entry = (ulong)smp_run_entry;
+	uint started = 0;
+	ofnode node;
+
+	if (!smp_run_boot.psci) {
+#ifdef SMP_RUN_RELEASE_ADDR
+		smp_run_release(entry);
+		started = count - 1;
+#endif
+		return started;
+	}
+
+	ofnode_for_each_subnode(node, ofnode_path("/cpus")) {
+		u64 id = smp_run_cpu_id(node);
+		unsigned long ret;
+
+		if (started == count - 1)
+			break;
+		if (!smp_run_is_cpu(node) || id == -1ULL || id == self)
+			continue;
+		ret = invoke_psci_fn(PSCI_0_2_FN64_CPU_ON, id, entry, 0);
+		if (ret == PSCI_RET_SUCCESS)
+			started++;
+		else
+			log_debug("CPU %llx not started (err=%ld)\n", id,
+				  (long)ret);
+	}
+
+	return started;
+}
+
+/* Atomically set *@ptr to @val and return the value it had before */
+static u32 smp_run_xchg(u32 *ptr, u32 val)
+{
+	u32 old, fail;
+
+	asm volatile(
+		"1:	ldaxr	%w0, %2\n"
+		"	stlxr	%w1, %w3, %2\n"
+		"	cbnz	%w1, 1b\n"
+		: "=&r" (old), "=&r" (fail), "+Q" (*ptr)
+		: "r" (val)
+		: "memory");
+
+	return old;
+}
+
+/**
+ * smp_run_close() - stop any more cores from starting
+ *
+ * A core may be slow to start and only take a number after the boot core
+ * has given up waiting for it, or even once the next smp_run() has reset
+ * the numbers, when it would share a number and a stack with another core.
+ * So all the numbers which are left are taken here at once: a core which
+ * comes later gets none and just leaves once the running ones are let go.
+ *
+ * Return: number of secondary cores which took a number to run the function
+ */
+static uint smp_run_close(void)
+{
+	u32 next;
+
+	next = smp_run_xchg(&smp_run_boot.next, SMP_RUN_NEXT_CLOSED);
+#ifdef SMP_RUN_RELEASE_ADDR
+	if (!smp_run_boot.psci)
+		smp_run_release(0);
+#endif
+	WRITE_ONCE(smp_run_boot.closed, 1);
+	dsb();
+	asm volatile("sev");
+
+	return min(next, smp_run_boot.count) - 1;
+}
+
+/**
+ * smp_run_park_addr() - get where the cores should wait when finished
+ *
+ * They go back to the spin table which they were released from. If they
+ * must wait there for the OS, the loop is copied to memory reserved for
+ * that, since U-Boot itself may be overwritten.
+ *
+ * Return: address of the loop, or 0 with PSCI
+ */
+static ulong smp_run_park_addr(void)
+{
+	if (smp_run_boot.psci)
+		return 0;
+#if defined(CONFIG_ARMV8_SPIN_TABLE) && !defined(CONFIG_SPL_BUILD)
+	return (ulong)spin_table_secondary_jump;
+#elif defined(SMP_RUN_RELEASE_ADDR)
+	ulong park = (ulong)smp_run_park;
+#if defined(CONFIG_ARMV8_SMP_RUN_PARK_ADDR) && !defined(CONFIG_SPL_BUILD)
+	ulong size = smp_run_park_end - smp_run_park;
+
+	if (CONFIG_ARMV8_SMP_RUN_PARK_ADDR) {
+		park = CONFIG_ARMV8_SMP_RUN_PARK_ADDR;
+		memcpy((void *)park, smp_run_park, size);
+		flush_dcache_range(park,
+				   park + roundup(size, ARCH_DMA_MINALIGN));
+		invalidate_icache_all();
+	}
+#endif
+
+	return park;
+#else
+	return 0;
+#endif
+}
+
+/* Count the cores in the devicetree */
+static uint smp_run_count_cpus(void)
+{
+	uint count = 0;
+	ofnode node;
+
+	ofnode_for_each_subnode(node, ofnode_path("/cpus")) {
+		if (smp_run_is_cpu(node))
+			count++;
+	}
+
+	return count;
+}
+
+static int smp_run_setup(uint count, uint psci)
+{
+	struct smp_run_boot *boot = &smp_run_boot;
+	ulong ttbr, tcr, mair;
+
+	if (smp_run_stacks_cpus < count) {
+		free(smp_run_stacks);
+		smp_run_stacks_cpus = 0;
+		smp_run_stacks = memalign(16, (count - 1) * SMP_RUN_STACK_SIZE);
+		if (!smp_run_stacks)
+			return -ENOMEM;
+		smp_run_stacks_cpus = count;
+	}
+
+	switch (current_el()) {
+	case 1:
+		asm volatile("mrs %0, ttbr0_el1" : "=r" (ttbr));
+		asm volatile("mrs %0, tcr_el1" : "=r" (tcr));
+		asm volatile("mrs %0, mair_el1" : "=r" (mair));
+		break;
+	case 2:
+		asm volatile("mrs %0, ttbr0_el2" : "=r" (ttbr));
+		asm volatile("mrs %0, tcr_el2" : "=r" (tcr));
+		asm volatile("mrs %0, mair_el2" : "=r" (mair));
+		break;
+	default:
+		asm volatile("mrs %0, ttbr0_el3" : "=r" (ttbr));
+		asm volatile("mrs %0, tcr_el3" : "=r" (tcr));
+		asm volatile("mrs %0, mair_el3" : "=r" (mair));
+		break;
+	}
+	boot->ttbr = ttbr;
+	boot->tcr = tcr;
+	boot->mair = mair;
+	boot->sctlr = get_sctlr();
+	/* The stack of core n ends at stacks + n * SMP_RUN_STACK_SIZE */
+	boot->stacks = (ulong)smp_run_stacks;
+	boot->gd = (ulong)gd;
+	boot->psci = psci;
+	boot->park = smp_run_park_addr();
+	boot->count = count;
+	boot->closed = 0;
+	/* A late core may be waiting for this, so set it once all is ready */
+	dmb();
+	WRITE_ONCE(boot->next, 1);
+
+	/* The secondary cores read this with the MMU off */
+	smp_run_flush_boot();
+
+	return 0;
+}
+
+void smp_run_secondary(uint cpu)
+{
+	struct smp_run_state *state = &smp_run_state;
+
+	if (!READ_ONCE(smp_run_boot.closed))
+		state->fn(state->arg, cpu);
+	/*
+	 * The boot core may turn its cache off as soon as all the cores are
+	 * done, which does not write back what is in the caches of the other
+	 * cores, so write back this one's first
+	 */
+	__asm_flush_dcache_all();
+	smp_run_claim(&state->done);
+	dsb();
+	asm volatile("sev");
+
+	/*
+	 * Stay until the spin table is cleared, so as not to start again.
+	 * With PSCI, smp_run_entry() powers the core off once this returns
+	 */
+	while (!READ_ONCE(smp_run_boot.closed))
+		asm volatile("wfe");
+}
+
+uint smp_run_begin(smp_run_fn fn, void *arg, uint max_cpus)
+{
+	struct smp_run_state *state = &smp_run_state;
+	uint count, psci;
+
+	if (smp_run_asked)
+		return 0;
+	count = min(smp_run_count_cpus(), max_cpus);
+	psci = smp_run_psci();
+	if (count < 2 || !dcache_status())
+		return 0;
+#ifndef SMP_RUN_RELEASE_ADDR
+	if (!psci)
+		return 0;
+#endif
+
+	state->fn = fn;
+	state->arg = arg;
+	state->done = 0;
+	if (smp_run_setup(count, psci))
+		return 0;
+	dsb();
+	smp_run_asked = smp_run_start_cpus(count);
+
+	return smp_run_asked;
+}
+
+uint smp_run_end(void)
+{
+	struct smp_run_state *state = &smp_run_state;
+	uint asked = smp_run_asked;
+	uint started;
+	ulong start;
+
+	if (!asked)
+		return 0;
+
+	/* Give the cores a chance to start, in case fn() was quick */
+	start = get_timer(0);
+	while (READ_ONCE(smp_run_boot.next) - 1 < asked &&
+	       get_timer(start) < SMP_RUN_START_TIMEOUT_MS)
+		;
+	started = smp_run_close();
+	while (READ_ONCE(state->done) < started)
+		;
+	dmb();
+	smp_run_asked = 0;
+	log_debug("%u of %u secondary cores ran\n", started, asked);
+
+	return started;
+}
+
+uint smp_run(smp_run_fn fn, void *arg, uint max_cpus)
+{
+	smp_run_begin(fn, arg, max_cpus);
+	fn(arg, 0);
+
+	return smp_run_end() + 1;
+}
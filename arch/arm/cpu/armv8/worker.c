@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Workers on the secondary cores, see worker.h
+ *
+ * The secondary cores are started with smp_run_begin() and stay in
+ * worker_loop() until worker_stop(), waiting for jobs with WFE.
+ */
+
+#include <common.h>
+#include <worker.h>
+#include <asm/barriers.h>
+#include <asm/armv8/smp_run.h>
+
+static void worker_smp_main(void *arg, uint cpu)
+{
+	worker_loop(cpu);
+}
+
+uint arch_worker_start(uint max)
+{
+	return smp_run_begin(worker_smp_main, NULL,
+			     max == UINT_MAX ? max : max + 1);
+}
+
+void arch_worker_stop(void)
+{
+	smp_run_end();
+}
+
+u32 arch_worker_cmpxchg(u32 *ptr, u32 old, u32 new)
+{
+	u32 val, fail;
+
+	asm volatile(
+		"1:	ldaxr	%w0, %2\n"
+		"	cmp	%w0, %w3\n"
+		"	b.ne	2f\n"
+		"	stlxr	%w1, %w4, %2\n"
+		"	cbnz	%w1, 1b\n"
+		"2:\n"
+		: "=&r" (val), "=&r" (fail), "+Q" (*ptr)
+		: "r" (old), "r" (new)
+		: "cc", "memory");
+
+	return val;
+}
+
+void arch_worker_sync(void)
+{
+	dmb();
+}
+
+void arch_worker_idle(void)
+{
+	asm volatile("wfe");
+}
+
+void arch_worker_wake(void)
+{
+	dsb();
+	asm volatile("sev");
+}
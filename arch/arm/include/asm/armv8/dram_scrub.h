@@ -0,0 +1,49 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Clearing DRAM quickly, e.g. to initialise the ECC bits
+ */
+
+#ifndef __ASM_ARMV8_DRAM_SCRUB_H
+#define __ASM_ARMV8_DRAM_SCRUB_H
+
+#include <linux/types.h>
+
+/* Regions must start and end on this boundary */
+#define DRAM_SCRUB_ALIGN	0x1000
+
+/**
+ * struct dram_scrub_region - a region of DRAM to clear
+ *
+ * @base: Start address, a multiple of DRAM_SCRUB_ALIGN
+ * @size: Size in bytes, a multiple of DRAM_SCRUB_ALIGN
+ */
+struct dram_scrub_region {
+	phys_addr_t base;
+	phys_size_t size;
+};
+
+/**
+ * dram_scrub() - set regions of DRAM to zero
+ *
+ * With the data cache on, each cache line is zeroed with DC ZVA, so DRAM is
+ * only ever written in whole lines and never read. This makes it suitable
+ * for initialising memory with ECC, where a partial write of memory which
+ * has not been written before gives an error. The work is shared between
+ * the cores with smp_run(), if enabled.
+ *
+ * With the data cache off the regions are cleared with ordinary stores on
+ * the boot core.
+ *
+ * The secondary cores write back their caches before this returns, but
+ * the caller must flush the cache of the boot core if the memory is to be
+ * used with the caches off.
+ *
+ * @regions: Regions to clear
+ * @count: Number of regions
+ * @max_cpus: Maximum number of cores to use
+ * Return: number of cores used, or -EINVAL if a region is not aligned
+ */
+int dram_scrub(const struct dram_scrub_region *regions, int count,
+	       uint max_cpus);
+
+#endif /* __ASM_ARMV8_DRAM_SCRUB_H */
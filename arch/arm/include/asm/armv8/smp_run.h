@@ -0,0 +1,204 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Running work on the secondary cores of an ARMv8 system
+ *
+ * The secondary cores are started for a short time, run a function in
+ * parallel with the boot core and then go back to where they were: waiting
+ * on the spin table, or powered off with PSCI if the devicetree has PSCI
+ * firmware.
+ */
+
+#ifndef __ASM_ARMV8_SMP_RUN_H
+#define __ASM_ARMV8_SMP_RUN_H
+
+/* Stack for each secondary core */
+#define SMP_RUN_STACK_SIZE	0x4000
+
+/* Offsets in struct smp_run_boot, for smp_run_v8.S */
+#define SMP_RUN_BOOT_TTBR	0x00
+#define SMP_RUN_BOOT_TCR	0x08
+#define SMP_RUN_BOOT_MAIR	0x10
+#define SMP_RUN_BOOT_SCTLR	0x18
+#define SMP_RUN_BOOT_STACKS	0x20
+#define SMP_RUN_BOOT_GD		0x28
+#define SMP_RUN_BOOT_PARK	0x30
+#define SMP_RUN_BOOT_NEXT	0x38
+#define SMP_RUN_BOOT_COUNT	0x3c
+#define SMP_RUN_BOOT_CLOSED	0x40
+#define SMP_RUN_BOOT_PSCI	0x44
+
+/* Values of smp_run_boot.psci: how to call the PSCI firmware */
+#define SMP_RUN_PSCI_SMC	1
+#define SMP_RUN_PSCI_HVC	2
+
+/* PSCI_0_2_FN_CPU_OFF, since linux/psci.h cannot be used from assembly */
+#define SMP_RUN_PSCI_CPU_OFF	0x84000002
+
+#ifndef __ASSEMBLY__
+
+#include <linux/types.h>
+
+/**
+ * struct smp_run_boot - state needed by a secondary core to start
+ *
+ * The secondary cores start with the MMU off, so this is written back to
+ * memory before they are released. They set up the MMU in the same way as
+ * the boot core, then take a core number from @next and the stack for it.
+ *
+ * @ttbr: TTBR0 of the boot core
+ * @tcr: TCR of the boot core
+ * @mair: MAIR of the boot core
+ * @sctlr: SCTLR of the boot core
+ * @stacks: Base of the stacks for the secondary cores, SMP_RUN_STACK_SIZE
+ *	each. Core n uses the stack which ends at @stacks + n *
+ *	SMP_RUN_STACK_SIZE
+ * @gd: Global data pointer of the boot core
+ * @park: Where to go with the MMU off once finished, to wait on the spin
+ *	table again, or 0 to just wait for an interrupt (e.g. with PSCI)
+ * @next: Number to give to the next core which starts. Once the boot core
+ *	stops waiting for cores to start, this is set so high that any later
+ *	core does not run the function
+ * @count: Number of cores in use, including the boot core. A core which
+ *	gets a number of @count or more does not run the function
+ * @closed: Set by the boot core once it has stopped waiting for cores to
+ *	start. The secondary cores wait for this before leaving
+ * @psci: SMP_RUN_PSCI_SMC or SMP_RUN_PSCI_HVC if the cores were started with
+ *	PSCI and must power off when finished, 0 if they are on a spin table
+ */
+struct smp_run_boot {
+	u64 ttbr;
+	u64 tcr;
+	u64 mair;
+	u64 sctlr;
+	u64 stacks;
+	u64 gd;
+	u64 park;
+	u32 next;
+	u32 count;
+	u32 closed;
+	u32 psci;
+};
+
+/**
+ * typedef smp_run_fn - function run on each core by smp_run()
+ *
+ * The function runs on the boot core and on each secondary core which
+ * started, at the same time. The work is normally shared out by having each
+ * core take pieces of it with smp_run_claim() until there are none left, so
+ * that it all gets done however many cores actually start.
+ *
+ * @arg: Argument passed to smp_run()
+ * @cpu: Number of the core, 0 for the boot core
+ */
+typedef void (*smp_run_fn)(void *arg, uint cpu);
+
+#if CONFIG_IS_ENABLED(ARMV8_SMP_RUN)
+/**
+ * smp_run() - run a function on all cores
+ *
+ * This calls @fn on the boot core and on up to @max_cpus - 1 secondary
+ * cores, and returns when they have all finished. If the secondary cores
+ * cannot be started, @fn just runs on the boot core.
+ *
+ * The MMU and caches of the secondary cores are set up in the same way as
+ * on the boot core, and @fn runs there with interrupts disabled. On the
+ * secondary cores @fn must not use the console, driver model or malloc().
+ * Each secondary core writes back its data cache once @fn returns, before
+ * it is counted as finished.
+ *
+ * @fn: Function to run
+ * @arg: Argument to pass to @fn
+ * @max_cpus: Maximum number of cores to use, including the boot core
+ * Return: number of cores which ran @fn, at least 1
+ */
+uint smp_run(smp_run_fn fn, void *arg, uint max_cpus);
+
+/**
+ * smp_run_begin() - start a function on the secondary cores
+ *
+ * This is the first half of smp_run(), for when the boot core should carry
+ * on with other things while the secondary cores run @fn, e.g. waiting for
+ * work to do. Call smp_run_end() to wait for them to finish.
+ *
+ * Only one function can run on the secondary cores at a time. While it is
+ * running, smp_run() just calls its function on the boot core.
+ *
+ * @fn: Function to run
+ * @arg: Argument to pass to @fn
+ * @max_cpus: Maximum number of cores to use, including the boot core
+ * Return: number of secondary cores which were asked to start, or 0 if none
+ *	could be
+ */
+uint smp_run_begin(smp_run_fn fn, void *arg, uint max_cpus);
+
+/**
+ * smp_run_end() - wait for the secondary cores to finish
+ *
+ * This waits for any secondary cores which are still starting, for up to
+ * 100ms, then for all of those which started to return from the function
+ * passed to smp_run_begin(). They then go back to where they came from.
+ *
+ * Return: number of secondary cores which ran the function
+ */
+uint smp_run_end(void);
+#else
+static inline uint smp_run(smp_run_fn fn, void *arg, uint max_cpus)
+{
+	fn(arg, 0);
+
+	return 1;
+}
+
+static inline uint smp_run_begin(smp_run_fn fn, void *arg, uint max_cpus)
+{
+	return 0;
+}
+
+static inline uint smp_run_end(void)
+{
+	return 0;
+}
+#endif
+
+/**
+ * smp_run_claim() - take the next piece of work
+ *
+ * This atomically increments *@next and returns the value it had before, so
+ * that each value is returned on exactly one core. This uses exclusive
+ * accesses, so the data cache must be enabled.
+ *
+ * @next: Counter shared by the cores
+ * Return: previous value of *@next
+ */
+static inline u32 smp_run_claim(u32 *next)
+{
+	u32 val, tmp, fail;
+
+	asm volatile(
+		"1:	ldaxr	%w0, %3\n"
+		"	add	%w1, %w0, #1\n"
+		"	stlxr	%w2, %w1, %3\n"
+		"	cbnz	%w2, 1b\n"
+		: "=&r" (val), "=&r" (tmp), "=&r" (fail), "+Q" (*next)
+		: : "memory");
+
+	return val;
+}
+
+/* Entry point of the secondary cores, in smp_run_v8.S */
+void smp_run_entry(void);
+
+/*
+ * Loop which waits on the spin table at CPU_RELEASE_ADDR, in smp_run_v8.S.
+ * This only uses PC-relative addressing, so it can be copied elsewhere.
+ */
+extern char smp_run_park[], smp_run_park_end[];
+
+/* Called by smp_run_entry() on each secondary core */
+void smp_run_secondary(uint cpu);
+
+extern struct smp_run_boot smp_run_boot;
+
+#endif /* __ASSEMBLY__ */
+
+#endif /* __ASM_ARMV8_SMP_RUN_H */
@@ -8,8 +8,14 @@
 #include <asm/global_data.h>
 #include <asm/ptrace.h>
 #include <irq_func.h>
+#include <trace.h>
 #include <linux/compiler.h>
+#include <linux/sizes.h>
+#include <linux/stringify.h>
 #include <efi_loader.h>
+#include <asm/gic.h>
+#include <asm/io.h>
+#include <asm/system.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -30,6 +36,143 @@ int disable_interrupts(void)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(TRACE_SAMPLE) && defined(GICR_BASE)
+/* Generic timer PPIs used for sampling, by exception level */
+#define SAMPLE_PPI_EL1_PHYS	30
+#define SAMPLE_PPI_EL2_PHYS	26
+
+#define GICR_TYPER_LAST		BIT(4)
+#define GICR_TYPER_VLPIS	BIT(1)
+
+#define CNT_CTL_ENABLE		BIT(0)
+
+static struct {
+	void *sgi_base;		/* SGI/PPI frame of our redistributor */
+	uint intid;		/* Timer PPI in use */
+	ulong ticks;		/* Timer reload value */
+	ulong saved_hcr;	/* HCR_EL2 before sampling started */
+} sample;
+
+/**
+ * gicr_sgi_base() - find the SGI/PPI frame of this CPU's redistributor
+ *
+ * Return: pointer to the frame, or NULL if not found
+ */
+static void *gicr_sgi_base(void)
+{
+	void *rd = (void *)GICR_BASE;
+	ulong mpidr;
+	u32 aff;
+
+	asm volatile("mrs %0, mpidr_el1" : "=r" (mpidr));
+	aff = (((mpidr >> 32) & 0xff) << 24) | (mpidr & 0xffffff);
+	for (;;) {
+		u64 typer = readq(rd + GICR_TYPER);
+
+		if ((typer >> 32) == aff)
+			return rd + SZ_64K;
+		if (typer & GICR_TYPER_LAST)
+			return NULL;
+		rd += typer & GICR_TYPER_VLPIS ? SZ_256K : SZ_128K;
+	}
+}
+
+static void __attribute__((no_instrument_function)) sample_timer_arm(void)
+{
+	if (sample.intid == SAMPLE_PPI_EL2_PHYS) {
+		asm volatile("msr cnthp_tval_el2, %0" : : "r" (sample.ticks));
+		asm volatile("msr cnthp_ctl_el2, %0" : : "r" (CNT_CTL_ENABLE));
+	} else {
+		asm volatile("msr cntp_tval_el0, %0" : : "r" (sample.ticks));
+		asm volatile("msr cntp_ctl_el0, %0" : : "r" (CNT_CTL_ENABLE));
+	}
+	isb();
+}
+
+int arch_trace_sample_start(uint period_us)
+{
+	ulong freq;
+
+	switch (current_el()) {
+	case 2:
+		sample.intid = SAMPLE_PPI_EL2_PHYS;
+		break;
+	case 1:
+		sample.intid = SAMPLE_PPI_EL1_PHYS;
+		break;
+	default:
+		/* The secure timer belongs to the firmware at EL3 */
+		return -EPERM;
+	}
+	sample.sgi_base = gicr_sgi_base();
+	if (!sample.sgi_base)
+		return -ENODEV;
+
+	asm volatile("mrs %0, cntfrq_el0" : "=r" (freq));
+	sample.ticks = max(1UL, freq / 1000000 * period_us);
+
+	/* Take physical IRQs at EL2 rather than leaving them for EL1 */
+	if (sample.intid == SAMPLE_PPI_EL2_PHYS) {
+		asm volatile("mrs %0, hcr_el2" : "=r" (sample.saved_hcr));
+		asm volatile("msr hcr_el2, %0"
+			     : : "r" (sample.saved_hcr | HCR_EL2_IMO));
+	}
+
+	/* Unmask the timer PPI as a non-secure group 1 interrupt */
+	writeb(0xa0, sample.sgi_base + GICR_IPRIORITYRn + sample.intid);
+	writel(BIT(sample.intid), sample.sgi_base + GICR_ISENABLERn);
+	asm volatile("msr " __stringify(ICC_PMR_EL1) ", %0" : : "r" (0xffUL));
+	asm volatile("msr " __stringify(ICC_IGRPEN1_EL1) ", %0" : : "r" (1UL));
+	isb();
+
+	sample_timer_arm();
+	asm volatile("msr daifclr, #2");
+
+	return 0;
+}
+
+void arch_trace_sample_stop(void)
+{
+	asm volatile("msr daifset, #2");
+	if (sample.intid == SAMPLE_PPI_EL2_PHYS)
+		asm volatile("msr cnthp_ctl_el2, %0" : : "r" (0UL));
+	else
+		asm volatile("msr cntp_ctl_el0, %0" : : "r" (0UL));
+	writel(BIT(sample.intid), sample.sgi_base + GICR_ICENABLERn);
+	if (sample.intid == SAMPLE_PPI_EL2_PHYS)
+		asm volatile("msr hcr_el2, %0" : : "r" (sample.saved_hcr));
+	isb();
+}
+
+/**
+ * sample_irq() - handle the sampling timer interrupt
+ *
+ * @pt_regs:	Registers at the time of the interrupt
+ * Return: true if the interrupt was the sampling timer and was handled
+ */
+static bool __attribute__((no_instrument_function))
+		sample_irq(struct pt_regs *pt_regs)
+{
+	ulong iar;
+
+	asm volatile("mrs %0, " __stringify(ICC_IAR1_EL1) : "=r" (iar));
+	if (iar != sample.intid)
+		return false;
+
+	trace_sample_record(pt_regs->elr, pt_regs->regs[30]);
+	sample_timer_arm();
+	asm volatile("msr " __stringify(ICC_EOIR1_EL1) ", %0" : : "r" (iar));
+	isb();
+
+	return true;
+}
+#else
+static inline bool sample_irq(struct pt_regs *pt_regs)
+{
+	return false;
+}
+#endif
+
 static void show_efi_loaded_images(struct pt_regs *regs)
 {
 	efi_print_image_infos((void *)regs->elr);
@@ -129,6 +272,8 @@ void do_sync(struct pt_regs *pt_regs, unsigned int esr)
 void do_irq(struct pt_regs *pt_regs, unsigned int esr)
 {
 	efi_restore_gd();
+	if (sample_irq(pt_regs))
+		return;
 	printf("\"Irq\" handler, esr 0x%08x\n", esr);
 	show_regs(pt_regs);
 	show_efi_loaded_images(pt_regs);
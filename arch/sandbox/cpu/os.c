@@ -9,6 +9,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <setjmp.h>
 #include <signal.h>
 #include <stdio.h>
@@ -41,6 +42,12 @@ struct os_mem_hdr {
 	size_t length;		/* number of bytes in the block */
 };
 
+struct os_thread {
+	pthread_t id;
+	void (*fn)(void *arg);
+	void *arg;
+};
+
 ssize_t os_read(int fd, void *buf, size_t count)
 {
 	return read(fd, buf, count);
@@ -985,3 +992,41 @@ void os_relaunch(char *argv[])
 	execv(argv[0], argv);
 	os_exit(1);
 }
+
+static void *os_thread_main(void *ptr)
+{
+	struct os_thread *thread = ptr;
+
+	thread->fn(thread->arg);
+
+	return NULL;
+}
+
+int os_thread_create(struct os_thread **threadp, void (*fn)(void *arg),
+		     void *arg)
+{
+	struct os_thread *thread;
+
+	thread = os_malloc(sizeof(*thread));
+	if (!thread)
+		return -ENOMEM;
+	thread->fn = fn;
+	thread->arg = arg;
+	if (pthread_create(&thread->id, NULL, os_thread_main, thread)) {
+		os_free(thread);
+		return -EAGAIN;
+	}
+	*threadp = thread;
+
+	return 0;
+}
+
+int os_thread_join(struct os_thread *thread)
+{
+	int ret;
+
+	ret = pthread_join(thread->id, NULL);
+	os_free(thread);
+
+	return ret ? -ESRCH : 0;
+}
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Workers on host threads, see worker.h
+ *
+ * This allows the worker queue to be tested on sandbox. The threads poll
+ * for jobs, since there is no equivalent of WFE / SEV.
+ */
+
+#include <common.h>
+#include <os.h>
+#include <worker.h>
+
+/* Number of worker threads, as if there were four cores */
+#define SANDBOX_WORKERS		3
+
+static struct os_thread *sandbox_workers[SANDBOX_WORKERS];
+static uint sandbox_worker_count;
+
+static void sandbox_worker_main(void *arg)
+{
+	worker_loop((ulong)arg);
+}
+
+uint arch_worker_start(uint max)
+{
+	uint i;
+
+	for (i = 0; i < min_t(uint, max, SANDBOX_WORKERS); i++) {
+		if (os_thread_create(&sandbox_workers[i], sandbox_worker_main,
+				     (void *)(ulong)(i + 1)))
+			break;
+	}
+	sandbox_worker_count = i;
+
+	return i;
+}
+
+void arch_worker_stop(void)
+{
+	uint i;
+
+	for (i = 0; i < sandbox_worker_count; i++)
+		os_thread_join(sandbox_workers[i]);
+	sandbox_worker_count = 0;
+}
+
+u32 arch_worker_cmpxchg(u32 *ptr, u32 old, u32 new)
+{
+	__atomic_compare_exchange_n(ptr, &old, new, false, __ATOMIC_SEQ_CST,
+				    __ATOMIC_SEQ_CST);
+
+	return old;
+}
+
+void arch_worker_sync(void)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void arch_worker_idle(void)
+{
+	os_usleep(10);
+}
+
+void arch_worker_wake(void)
+{
+}
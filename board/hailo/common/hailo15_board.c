@@ -331,6 +331,11 @@ int fdt_dram_cfg_get(void)
 	return 0;
 }
 
+bool hailo15_dram_ecc_enabled(void)
+{
+	return hailo15_dram_cfg.ecc_enable;
+}
+
 int dram_init(void)
 {
 	int ret;
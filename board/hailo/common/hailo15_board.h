@@ -5,5 +5,7 @@ int hailo15_scmi_init(void);
 int hailo15_scmi_check_version_match(void);
 int hailo15_mmc_boot_partition(void);
 int hailo15_get_active_boot_image_offset(void);
+bool hailo15_dram_ecc_enabled(void);
+void hailo15_dram_scrub(bool preloaded);
 
 #endif /* _HAILO15_BOARD_H */
\ No newline at end of file
@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2019-2024 Hailo Technologies Ltd. All rights reserved.
+ */
+
+#include <common.h>
+#include <cpu_func.h>
+#include <init.h>
+#include <malloc.h>
+#include <time.h>
+#include <asm/global_data.h>
+#include <asm/sections.h>
+#include <asm/system.h>
+#include <asm/armv8/dram_scrub.h>
+#include <linux/libfdt.h>
+#include <linux/sizes.h>
+#include "hailo15_board.h"
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Number of ranges of DRAM which SPL is using */
+#define HAILO15_SCRUB_KEEP	5
+
+static ulong hailo15_get_sp(void)
+{
+	ulong ret;
+
+	asm("mov %0, sp" : "=r"(ret) : );
+	return ret;
+}
+
+static void hailo15_scrub_keep(struct dram_scrub_region *keep, int *count,
+			       phys_addr_t start, phys_addr_t end)
+{
+	struct dram_scrub_region *k = &keep[(*count)++];
+
+	k->base = ALIGN_DOWN(start, DRAM_SCRUB_ALIGN);
+	k->size = ALIGN(end, DRAM_SCRUB_ALIGN) - k->base;
+}
+
+/*
+ * Get the regions of DRAM to clear: all of it except what SPL is using, so
+ * that U-Boot, TF-A and the OS find valid ECC wherever they are loaded
+ */
+static int hailo15_scrub_regions(struct dram_scrub_region *regions)
+{
+	struct dram_scrub_region keep[HAILO15_SCRUB_KEEP];
+	int count = 0, nkeep = 0;
+	int i, j;
+
+	hailo15_scrub_keep(keep, &nkeep, (ulong)__image_copy_start,
+			   (ulong)_image_binary_end);
+	hailo15_scrub_keep(keep, &nkeep, (ulong)__bss_start,
+			   (ulong)__bss_end);
+	/*
+	 * malloc_f, global data and the stack are just below
+	 * CONFIG_SYS_INIT_SP_ADDR. Allow for the stack to grow while
+	 * scrubbing, as arch_lmb_reserve() does.
+	 */
+	hailo15_scrub_keep(keep, &nkeep, hailo15_get_sp() - SZ_16K,
+			   CONFIG_SYS_INIT_SP_ADDR);
+	hailo15_scrub_keep(keep, &nkeep, (ulong)gd->fdt_blob,
+			   (ulong)gd->fdt_blob + fdt_totalsize(gd->fdt_blob));
+	/* The spin table, which the secondary cores are waiting on */
+	hailo15_scrub_keep(keep, &nkeep, CPU_RELEASE_ADDR,
+			   CPU_RELEASE_ADDR + sizeof(u64));
+
+	/* Sort by address, so each bank can be split in one pass */
+	for (i = 1; i < nkeep; i++) {
+		for (j = i; j && keep[j].base < keep[j - 1].base; j--)
+			swap(keep[j], keep[j - 1]);
+	}
+
+	for (i = 0; i < CONFIG_NR_DRAM_BANKS; i++) {
+		phys_addr_t pos = gd->bd->bi_dram[i].start;
+		phys_addr_t end = pos + gd->bd->bi_dram[i].size;
+
+		for (j = 0; j < nkeep; j++) {
+			phys_addr_t kend = keep[j].base + keep[j].size;
+
+			if (kend <= pos || keep[j].base >= end)
+				continue;
+			if (keep[j].base > pos) {
+				regions[count].base = pos;
+				regions[count++].size = keep[j].base - pos;
+			}
+			pos = min(kend, end);
+		}
+		if (pos < end) {
+			regions[count].base = pos;
+			regions[count++].size = end - pos;
+		}
+	}
+
+	return count;
+}
+
+/*
+ * Clear the DDR with the data cache on, so that it is written with whole
+ * cache lines
+ */
+void hailo15_dram_scrub(bool preloaded)
+{
+	struct dram_scrub_region regions[CONFIG_NR_DRAM_BANKS *
+					 (HAILO15_SCRUB_KEEP + 1)];
+	phys_size_t total = 0;
+	ulong start;
+	int count;
+	int cpus;
+	int i;
+
+	if (dram_init() || dram_init_banksize() ||
+	    !hailo15_dram_ecc_enabled())
+		return;
+	if (preloaded) {
+		printf("DRAM:  ECC scrub skipped, boot image is in DRAM\n");
+		return;
+	}
+
+	gd->arch.tlb_size = PGTABLE_SIZE;
+	gd->arch.tlb_addr = (ulong)memalign(SZ_64K, gd->arch.tlb_size);
+	if (gd->arch.tlb_addr)
+		dcache_enable();
+	else
+		printf("DRAM:  No memory for page tables, scrubbing slowly\n");
+
+	/* After the page tables are allocated, so that they are kept */
+	count = hailo15_scrub_regions(regions);
+	for (i = 0; i < count; i++)
+		total += regions[i].size;
+
+	start = get_timer(0);
+	cpus = dram_scrub(regions, count, UINT_MAX);
+	dcache_disable();
+	if (cpus < 0) {
+		printf("DRAM:  ECC scrub failed (err=%d)\n", cpus);
+		return;
+	}
+	printf("DRAM:  ECC scrub of %llu MiB on %d core(s) took %lu ms\n",
+	       (unsigned long long)total / SZ_1M, cpus, get_timer(start));
+}
@@ -70,6 +70,9 @@ void board_boot_order(u32 *spl_boot_list)
 	}
 
 	printf("U-Boot SPL boot source %s\n", s);
+
+	if (IS_ENABLED(CONFIG_HAILO15_DDR_ECC_SCRUB))
+		hailo15_dram_scrub(spl_boot_list[0] == BOOT_DEVICE_RAM);
 }
 
 int spl_mmc_fs_boot_partition(void)
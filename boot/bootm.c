@@ -18,6 +18,8 @@
 #include <malloc.h>
 #include <mapmem.h>
 #include <net.h>
+#include <tpm-v2.h>
+#include <tpm_measure.h>
 #include <asm/cache.h>
 #include <asm/global_data.h>
 #include <asm/io.h>
@@ -68,17 +70,27 @@ static void boot_start_lmb(bootm_headers_t *images)
 	lmb_init_and_reserve_range(&images->lmb, (phys_addr_t)mem_start,
 				   mem_size, NULL);
 }
+
+static void boot_stop_lmb(bootm_headers_t *images)
+{
+	lmb_uninit(&images->lmb);
+}
 #else
 #define lmb_reserve(lmb, base, size)
 static inline void boot_start_lmb(bootm_headers_t *images) { }
+static inline void boot_stop_lmb(bootm_headers_t *images) { }
 #endif
 
 static int bootm_start(struct cmd_tbl *cmdtp, int flag, int argc,
 		       char *const argv[])
 {
+	/* Free anything left over from a previous bootm */
+	boot_stop_lmb(&images);
 	memset((void *)&images, 0, sizeof(images));
 	images.verify = env_get_yesno("verify");
 
+	/* Only use digests from images verified by this bootm */
+	tpm_measure_forget_all();
 	boot_start_lmb(&images);
 
 	bootstage_mark_name(BOOTSTAGE_ID_BOOTM_START, "bootm_start");
@@ -228,6 +240,65 @@ static int bootm_find_os(struct cmd_tbl *cmdtp, int flag, int argc,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(MEASURED_BOOT)
+static int bootm_measure_image(u32 pcr, u32 event_type, const void *data,
+			       ulong size, const char *name)
+{
+	int ret;
+
+	ret = tpm_measure_data(pcr, event_type, data, size, name,
+			       strlen(name) + 1);
+	if (ret)
+		printf("Cannot measure %s (err=%d)\n", name, ret);
+
+	return ret;
+}
+
+/**
+ * bootm_measure() - measure the images and bootargs into the TPM
+ *
+ * @start: Start of the OS image
+ * @size: Size of the OS image, or 0 to use images.os
+ * Return: 0 if OK, -ve on error
+ */
+static int bootm_measure(ulong start, ulong size)
+{
+	const char *bootargs = env_get("bootargs");
+	int ret;
+
+	if (!size) {
+		start = images.os.image_start;
+		size = images.os.image_len;
+	}
+	ret = bootm_measure_image(TPM_MEASURE_PCR_KERNEL, EV_COMPACT_HASH,
+				  map_sysmem(start, size), size, "kernel");
+	if (!ret && images.rd_start) {
+		ulong rd_len = images.rd_end - images.rd_start;
+
+		ret = bootm_measure_image(TPM_MEASURE_PCR_DATA, EV_COMPACT_HASH,
+					  map_sysmem(images.rd_start, rd_len),
+					  rd_len, "initrd");
+	}
+	if (!ret && images.ft_addr)
+		ret = bootm_measure_image(TPM_MEASURE_PCR_DATA,
+					  EV_TABLE_OF_DEVICES, images.ft_addr,
+					  images.ft_len, "dtb");
+	if (!ret && bootargs)
+		ret = bootm_measure_image(TPM_MEASURE_PCR_CONFIG,
+					  EV_PLATFORM_CONFIG_FLAGS, bootargs,
+					  strlen(bootargs), "bootargs");
+	if (ret)
+		return ret;
+
+	/* Extend the PCRs for all of the above in one go */
+	ret = tpm_measure_flush(NULL);
+	if (ret)
+		printf("Cannot extend PCRs (err=%d)\n", ret);
+
+	return ret;
+}
+#endif
+
 /**
  * bootm_find_images - wrapper to find and locate various images
  * @flag: Ignored Argument
@@ -315,6 +386,11 @@ int bootm_find_images(int flag, int argc, char *const argv[], ulong start,
 	}
 #endif
 
+#if CONFIG_IS_ENABLED(MEASURED_BOOT)
+	if (bootm_measure(start, size))
+		return 1;
+#endif
+
 	return 0;
 }
 
@@ -9,6 +9,8 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
+#include <bootstage_timeline.h>
 #include <fdt_support.h>
 #include <fdtdec.h>
 #include <env.h>
@@ -74,9 +76,10 @@ static const image_header_t *image_get_fdt(ulong fdt_addr)
 }
 #endif
 
-static void boot_fdt_reserve_region(struct lmb *lmb, uint64_t addr,
-				    uint64_t size, enum lmb_flags flags)
+static void boot_fdt_reserve_region(void *ctx, uint64_t addr, uint64_t size,
+				    enum lmb_flags flags)
 {
+	struct lmb *lmb = ctx;
 	long ret;
 
 	ret = lmb_reserve_flags(lmb, addr, size, flags);
@@ -93,16 +96,20 @@ static void boot_fdt_reserve_region(struct lmb *lmb, uint64_t addr,
 }
 
 /**
- * boot_fdt_add_mem_rsv_regions - Mark the memreserve and reserved-memory
- * sections as unusable
- * @lmb: pointer to lmb handle, will be used for memory mgmt
- * @fdt_blob: pointer to fdt blob base address
+ * boot_fdt_for_each_mem_rsv() - call a function for each reserved region
  *
- * Adds the and reserved-memorymemreserve regions in the dtb to the lmb block.
- * Adding the memreserve regions prevents u-boot from using them to store the
- * initrd or the fdt blob.
+ * This covers the memreserve entries and the enabled reserved-memory nodes
+ * with a reg property, in the order they appear in the devicetree.
+ *
+ * @fdt_blob: pointer to fdt blob base address
+ * @func: function to call for each region
+ * @ctx: context passed to @func
  */
-void boot_fdt_add_mem_rsv_regions(struct lmb *lmb, void *fdt_blob)
+static void boot_fdt_for_each_mem_rsv(void *fdt_blob,
+				      void (*func)(void *ctx, uint64_t addr,
+						   uint64_t size,
+						   enum lmb_flags flags),
+				      void *ctx)
 {
 	uint64_t addr, size;
 	int i, total, ret;
@@ -118,7 +125,7 @@ void boot_fdt_add_mem_rsv_regions(struct lmb *lmb, void *fdt_blob)
 	for (i = 0; i < total; i++) {
 		if (fdt_get_mem_rsv(fdt_blob, i, &addr, &size) != 0)
 			continue;
-		boot_fdt_reserve_region(lmb, addr, size, LMB_NONE);
+		func(ctx, addr, size, LMB_NONE);
 	}
 
 	/* process reserved-memory */
@@ -136,7 +143,7 @@ void boot_fdt_add_mem_rsv_regions(struct lmb *lmb, void *fdt_blob)
 					flags = LMB_NOMAP;
 				addr = res.start;
 				size = res.end - res.start + 1;
-				boot_fdt_reserve_region(lmb, addr, size, flags);
+				func(ctx, addr, size, flags);
 			}
 
 			subnode = fdt_next_subnode(fdt_blob, subnode);
@@ -144,6 +151,58 @@ void boot_fdt_add_mem_rsv_regions(struct lmb *lmb, void *fdt_blob)
 	}
 }
 
+/**
+ * boot_fdt_add_mem_rsv_regions - Mark the memreserve and reserved-memory
+ * sections as unusable
+ * @lmb: pointer to lmb handle, will be used for memory mgmt
+ * @fdt_blob: pointer to fdt blob base address
+ *
+ * Adds the and reserved-memorymemreserve regions in the dtb to the lmb block.
+ * Adding the memreserve regions prevents u-boot from using them to store the
+ * initrd or the fdt blob.
+ */
+void boot_fdt_add_mem_rsv_regions(struct lmb *lmb, void *fdt_blob)
+{
+	boot_fdt_for_each_mem_rsv(fdt_blob, boot_fdt_reserve_region, lmb);
+}
+
+struct boot_fdt_rsv_list {
+	struct lmb_property *rsv;
+	int count;
+};
+
+static void boot_fdt_list_region(void *ctx, uint64_t addr, uint64_t size,
+				 enum lmb_flags flags)
+{
+	struct boot_fdt_rsv_list *list = ctx;
+
+	if (list->rsv) {
+		list->rsv[list->count].base = addr;
+		list->rsv[list->count].size = size;
+		list->rsv[list->count].flags = flags;
+	}
+	list->count++;
+}
+
+int boot_fdt_get_mem_rsv_regions(void *fdt_blob, struct lmb_property **rsvp)
+{
+	struct boot_fdt_rsv_list list = { };
+
+	/* Count the regions first, then fill in the list */
+	boot_fdt_for_each_mem_rsv(fdt_blob, boot_fdt_list_region, &list);
+	*rsvp = NULL;
+	if (!list.count)
+		return 0;
+	list.rsv = malloc(list.count * sizeof(*list.rsv));
+	if (!list.rsv)
+		return -ENOMEM;
+	list.count = 0;
+	boot_fdt_for_each_mem_rsv(fdt_blob, boot_fdt_list_region, &list);
+	*rsvp = list.rsv;
+
+	return list.count;
+}
+
 /**
  * boot_relocate_fdt - relocate flat device tree
  * @lmb: pointer to lmb handle, will be used for memory mgmt
@@ -581,6 +640,7 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 	int ret = -EPERM;
 	int fdt_ret;
 
+	bootstage_start(BOOTSTAGE_ID_ACCUM_FDT_FIXUP, "fdt_fixup");
 	if (fdt_root(blob) < 0) {
 		printf("ERROR: root node setup failed\n");
 		goto err;
@@ -601,6 +661,13 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 		goto err;
 	}
 
+	if (CONFIG_IS_ENABLED(BOOTSTAGE_TIMELINE)) {
+		fdt_ret = bootstage_timeline_fdt_add(blob);
+		if (fdt_ret)
+			printf("WARNING: could not add bootstage timeline: %d\n",
+			       fdt_ret);
+	}
+
 	/* Update ethernet nodes */
 	fdt_fixup_ethernet(blob);
 #if CONFIG_IS_ENABLED(CMD_PSTORE)
@@ -657,9 +724,11 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 	if (IS_ENABLED(CONFIG_OF_BOARD_SETUP))
 		ft_board_setup_ex(blob, gd->bd);
 #endif
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_FDT_FIXUP);
 
 	return 0;
 err:
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_FDT_FIXUP);
 	printf(" - must RESET the board to recover.\n\n");
 
 	return ret;
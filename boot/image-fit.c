@@ -35,6 +35,7 @@ DECLARE_GLOBAL_DATA_PTR;
 #include <bootm.h>
 #include <image.h>
 #include <bootstage.h>
+#include <tpm_measure.h>
 #include <linux/kconfig.h>
 #include <u-boot/crc.h>
 #include <u-boot/md5.h>
@@ -1269,6 +1270,7 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 	uint8_t *fit_value;
 	int fit_value_len;
 	int ignore;
+	int ret;
 
 	*err_msgp = NULL;
 
@@ -1292,7 +1294,13 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 		return -1;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+#ifdef USE_HOSTCC
+	ret = fit_image_hash_value(fit, noffset, algo, data, size, value,
+				   &value_len);
+#else
+	ret = calculate_hash(data, size, algo, value, &value_len);
+#endif
+	if (ret) {
 		*err_msgp = "Unsupported hash algorithm";
 		return -1;
 	}
@@ -1304,6 +1312,7 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 		*err_msgp = "Bad hash value";
 		return -1;
 	}
+	tpm_measure_note_digest(data, size, algo, value, value_len);
 
 	return 0;
 }
@@ -2160,8 +2169,11 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 	}
 
 	/* perform any post-processing on the image data */
-	if (!tools_build() && IS_ENABLED(CONFIG_FIT_IMAGE_POST_PROCESS))
+	if (!tools_build() && IS_ENABLED(CONFIG_FIT_IMAGE_POST_PROCESS)) {
+		/* the data may be changed in place */
+		tpm_measure_forget(buf, size);
 		board_fit_image_post_process(fit, noffset, &buf, &size);
+	}
 
 	len = (ulong)size;
 
@@ -2223,9 +2235,11 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 			return -ENOEXEC;
 		}
 		len = load_end - load;
+		tpm_measure_forget(loadbuf, len);
 	} else if (load != data) {
 		loadbuf = map_sysmem(load, len);
 		memcpy(loadbuf, buf, len);
+		tpm_measure_move(buf, loadbuf, len);
 	}
 
 	if (image_type == IH_TYPE_RAMDISK && comp != IH_COMP_NONE)
@@ -78,6 +78,79 @@ int format_mac_pxe(char *outbuf, size_t outbuf_len)
 	return 1;
 }
 
+/**
+ * get_relpath() - get the path of a file relative to the PXE file
+ *
+ * @ctx: PXE context
+ * @file_path: File path (relative to the PXE file)
+ * @relfile: Returns the full path; must hold MAX_TFTP_PATH_LEN + 1 bytes
+ * Returns 0 on success, or -ENAMETOOLONG if the path is too long
+ */
+static int get_relpath(struct pxe_context *ctx, const char *file_path,
+		       char *relfile)
+{
+	size_t path_len;
+
+	if (file_path[0] == '/' && ctx->allow_abs_path)
+		*relfile = '\0';
+	else
+		strncpy(relfile, ctx->bootdir, MAX_TFTP_PATH_LEN);
+
+	path_len = strlen(file_path) + strlen(relfile);
+
+	if (path_len > MAX_TFTP_PATH_LEN) {
+		printf("Base path too long (%s%s)\n", relfile, file_path);
+
+		return -ENAMETOOLONG;
+	}
+
+	strcat(relfile, file_path);
+
+	return 0;
+}
+
+static void prefetch_reset(struct pxe_context *ctx)
+{
+	int i;
+
+	for (i = 0; i < ctx->prefetch_count; i++)
+		free(ctx->prefetch[i].path);
+	ctx->prefetch_count = 0;
+}
+
+/**
+ * prefetch_take() - use a file read by label_prefetch()
+ *
+ * Each file is only used once, since the memory it was loaded into may be
+ * changed afterwards
+ *
+ * @ctx: PXE context
+ * @path: Full path of the file
+ * @addr: Address the file is needed at
+ * @sizep: Returns the file size in bytes
+ * @retp: Returns the result of reading the file
+ * Returns true if the file was found, false if it must be read
+ */
+static bool prefetch_take(struct pxe_context *ctx, const char *path,
+			  ulong addr, ulong *sizep, int *retp)
+{
+	int i;
+
+	for (i = 0; i < ctx->prefetch_count; i++) {
+		struct pxe_file *pf = &ctx->prefetch[i];
+
+		if (pf->path && pf->addr == addr && !strcmp(pf->path, path)) {
+			*sizep = pf->size;
+			*retp = pf->ret;
+			free(pf->path);
+			pf->path = NULL;
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /**
  * get_relfile() - read a file relative to the PXE file
  *
@@ -95,32 +168,22 @@ int format_mac_pxe(char *outbuf, size_t outbuf_len)
 static int get_relfile(struct pxe_context *ctx, const char *file_path,
 		       unsigned long file_addr, ulong *filesizep)
 {
-	size_t path_len;
 	char relfile[MAX_TFTP_PATH_LEN + 1];
 	char addr_buf[18];
 	ulong size;
 	int ret;
 
-	if (file_path[0] == '/' && ctx->allow_abs_path)
-		*relfile = '\0';
-	else
-		strncpy(relfile, ctx->bootdir, MAX_TFTP_PATH_LEN);
+	ret = get_relpath(ctx, file_path, relfile);
+	if (ret)
+		return ret;
 
-	path_len = strlen(file_path) + strlen(relfile);
+	if (!prefetch_take(ctx, relfile, file_addr, &size, &ret)) {
+		printf("Retrieving file: %s\n", relfile);
 
-	if (path_len > MAX_TFTP_PATH_LEN) {
-		printf("Base path too long (%s%s)\n", relfile, file_path);
+		sprintf(addr_buf, "%lx", file_addr);
 
-		return -ENAMETOOLONG;
+		ret = ctx->getfile(ctx, relfile, addr_buf, &size);
 	}
-
-	strcat(relfile, file_path);
-
-	printf("Retrieving file: %s\n", relfile);
-
-	sprintf(addr_buf, "%lx", file_addr);
-
-	ret = ctx->getfile(ctx, relfile, addr_buf, &size);
 	if (ret < 0)
 		return log_msg_ret("get", ret);
 	if (filesizep)
@@ -129,6 +192,16 @@ static int get_relfile(struct pxe_context *ctx, const char *file_path,
 	return 1;
 }
 
+/* Terminate a file that was read, so that it can be parsed as a string */
+static void terminate_file(ulong file_addr, ulong size)
+{
+	char *buf;
+
+	buf = map_sysmem(file_addr + size, 1);
+	*buf = '\0';
+	unmap_sysmem(buf);
+}
+
 /**
  * get_pxe_file() - read a file
  *
@@ -144,15 +217,12 @@ int get_pxe_file(struct pxe_context *ctx, const char *file_path,
 {
 	ulong size;
 	int err;
-	char *buf;
 
 	err = get_relfile(ctx, file_path, file_addr, &size);
 	if (err < 0)
 		return err;
 
-	buf = map_sysmem(file_addr + size, 1);
-	*buf = '\0';
-	unmap_sysmem(buf);
+	terminate_file(file_addr, size);
 
 	return 1;
 }
@@ -184,6 +254,68 @@ int get_pxelinux_path(struct pxe_context *ctx, const char *file,
 	return get_pxe_file(ctx, path, pxefile_addr_r);
 }
 
+int get_pxelinux_paths(struct pxe_context *ctx, const char *const files[],
+		       int count, ulong pxefile_addr_r)
+{
+	size_t base_len = strlen(PXELINUX_DIR);
+	char path[MAX_TFTP_PATH_LEN + 1];
+	struct pxe_file *pfiles;
+	int ret, i, n;
+
+	if (!ctx->getfiles) {
+		for (i = 0; i < count; i++) {
+			if (get_pxelinux_path(ctx, files[i],
+					      pxefile_addr_r) > 0)
+				return 1;
+		}
+
+		return -ENOENT;
+	}
+
+	pfiles = calloc(count, sizeof(*pfiles));
+	if (!pfiles)
+		return -ENOMEM;
+
+	ret = 0;
+	for (i = 0, n = 0; i < count; i++) {
+		struct pxe_file *pf = &pfiles[n];
+
+		if (base_len + strlen(files[i]) > MAX_TFTP_PATH_LEN) {
+			printf("path (%s%s) too long, skipping\n",
+			       PXELINUX_DIR, files[i]);
+			continue;
+		}
+		sprintf(path, PXELINUX_DIR "%s", files[i]);
+
+		pf->path = malloc(MAX_TFTP_PATH_LEN + 1);
+		if (!pf->path) {
+			ret = -ENOMEM;
+			break;
+		}
+		if (get_relpath(ctx, path, pf->path)) {
+			free(pf->path);
+			pf->path = NULL;
+			continue;
+		}
+		printf("Retrieving file: %s\n", pf->path);
+		pf->addr = pxefile_addr_r;
+		n++;
+	}
+
+	if (!ret)
+		ret = n ? ctx->getfiles(ctx, pfiles, n, true) : -ENOENT;
+	if (ret >= 0) {
+		terminate_file(pxefile_addr_r, pfiles[ret].size);
+		ret = 1;
+	}
+
+	for (i = 0; i < n; i++)
+		free(pfiles[i].path);
+	free(pfiles);
+
+	return ret;
+}
+
 /**
  * get_relfile_envaddr() - read a file to an address in an env var
  *
@@ -401,6 +533,138 @@ skip_overlay:
 }
 #endif
 
+/**
+ * label_get_fdtfile() - get the name of the FDT file for a label
+ *
+ * @label: Label to process
+ * @fdtfilep: Returns the filename, or NULL if the label does not give one
+ * @fdtfilefreep: Returns memory to free once the filename is not needed, or
+ *	NULL if none
+ * Returns 0 on success, -ENOMEM if out of memory
+ */
+static int label_get_fdtfile(struct pxe_label *label, char **fdtfilep,
+			     char **fdtfilefreep)
+{
+	char *fdtfile = NULL;
+	char *fdtfilefree = NULL;
+	int len;
+
+	if (label->fdt) {
+		fdtfile = label->fdt;
+	} else if (label->fdtdir) {
+		char *f1, *f2, *f3, *f4, *slash;
+
+		f1 = env_get("fdtfile");
+		if (f1) {
+			f2 = "";
+			f3 = "";
+			f4 = "";
+		} else {
+			/*
+			 * For complex cases where this code doesn't
+			 * generate the correct filename, the board
+			 * code should set $fdtfile during early boot,
+			 * or the boot scripts should set $fdtfile
+			 * before invoking "pxe" or "sysboot".
+			 */
+			f1 = env_get("soc");
+			f2 = "-";
+			f3 = env_get("board");
+			f4 = ".dtb";
+			if (!f1) {
+				f1 = "";
+				f2 = "";
+			}
+			if (!f3) {
+				f2 = "";
+				f3 = "";
+			}
+		}
+
+		len = strlen(label->fdtdir);
+		if (!len)
+			slash = "./";
+		else if (label->fdtdir[len - 1] != '/')
+			slash = "/";
+		else
+			slash = "";
+
+		len = strlen(label->fdtdir) + strlen(slash) +
+			strlen(f1) + strlen(f2) + strlen(f3) +
+			strlen(f4) + 1;
+		fdtfilefree = malloc(len);
+		if (!fdtfilefree) {
+			printf("malloc fail (FDT filename)\n");
+			return -ENOMEM;
+		}
+
+		snprintf(fdtfilefree, len, "%s%s%s%s%s%s",
+			 label->fdtdir, slash, f1, f2, f3, f4);
+		fdtfile = fdtfilefree;
+	}
+	*fdtfilep = fdtfile;
+	*fdtfilefreep = fdtfilefree;
+
+	return 0;
+}
+
+/**
+ * label_prefetch() - read the files for a label at once
+ *
+ * If the context can read several files at once, this reads the kernel,
+ * initrd and FDT together, each straight to its load address. get_relfile()
+ * then uses the results rather than reading each file in turn. Overlays are
+ * still read one at a time, since they share a load address.
+ *
+ * @ctx: PXE context
+ * @label: Label to process
+ */
+static void label_prefetch(struct pxe_context *ctx, struct pxe_label *label)
+{
+	const char *names[PXE_PREFETCH_MAX], *envs[PXE_PREFETCH_MAX];
+	char *fdtfile, *fdtfilefree = NULL;
+	int count = 0;
+	int i;
+
+	prefetch_reset(ctx);
+	if (!ctx->getfiles)
+		return;
+
+	names[count] = label->kernel;
+	envs[count++] = "kernel_addr_r";
+	if (label->initrd) {
+		names[count] = label->initrd;
+		envs[count++] = "ramdisk_addr_r";
+	}
+	if (env_get("fdt_addr_r") &&
+	    !label_get_fdtfile(label, &fdtfile, &fdtfilefree) && fdtfile) {
+		names[count] = fdtfile;
+		envs[count++] = "fdt_addr_r";
+	}
+
+	for (i = 0; i < count; i++) {
+		struct pxe_file *pf = &ctx->prefetch[ctx->prefetch_count];
+		char *envaddr = env_get(envs[i]);
+
+		/* Leave any problems to be reported when the file is read */
+		if (!envaddr || strict_strtoul(envaddr, 16, &pf->addr) < 0)
+			continue;
+		pf->path = malloc(MAX_TFTP_PATH_LEN + 1);
+		if (!pf->path)
+			break;
+		if (get_relpath(ctx, names[i], pf->path)) {
+			free(pf->path);
+			continue;
+		}
+		printf("Retrieving file: %s\n", pf->path);
+		ctx->prefetch_count++;
+	}
+	free(fdtfilefree);
+
+	if (ctx->prefetch_count)
+		ctx->getfiles(ctx, ctx->prefetch, ctx->prefetch_count, false);
+}
+
 /**
  * label_boot() - Boot according to the contents of a pxe_label
  *
@@ -434,7 +698,6 @@ static int label_boot(struct pxe_context *ctx, struct pxe_label *label)
 	char *fit_addr = NULL;
 	int bootm_argc = 2;
 	int zboot_argc = 3;
-	int len = 0;
 	ulong kernel_addr_r;
 	void *buf;
 
@@ -454,6 +717,8 @@ static int label_boot(struct pxe_context *ctx, struct pxe_label *label)
 		return 1;
 	}
 
+	label_prefetch(ctx, label);
+
 	if (label->initrd) {
 		ulong size;
 
@@ -556,62 +821,10 @@ static int label_boot(struct pxe_context *ctx, struct pxe_label *label)
 
 	/* if fdt label is defined then get fdt from server */
 	if (bootm_argv[3]) {
-		char *fdtfile = NULL;
-		char *fdtfilefree = NULL;
+		char *fdtfile, *fdtfilefree;
 
-		if (label->fdt) {
-			fdtfile = label->fdt;
-		} else if (label->fdtdir) {
-			char *f1, *f2, *f3, *f4, *slash;
-
-			f1 = env_get("fdtfile");
-			if (f1) {
-				f2 = "";
-				f3 = "";
-				f4 = "";
-			} else {
-				/*
-				 * For complex cases where this code doesn't
-				 * generate the correct filename, the board
-				 * code should set $fdtfile during early boot,
-				 * or the boot scripts should set $fdtfile
-				 * before invoking "pxe" or "sysboot".
-				 */
-				f1 = env_get("soc");
-				f2 = "-";
-				f3 = env_get("board");
-				f4 = ".dtb";
-				if (!f1) {
-					f1 = "";
-					f2 = "";
-				}
-				if (!f3) {
-					f2 = "";
-					f3 = "";
-				}
-			}
-
-			len = strlen(label->fdtdir);
-			if (!len)
-				slash = "./";
-			else if (label->fdtdir[len - 1] != '/')
-				slash = "/";
-			else
-				slash = "";
-
-			len = strlen(label->fdtdir) + strlen(slash) +
-				strlen(f1) + strlen(f2) + strlen(f3) +
-				strlen(f4) + 1;
-			fdtfilefree = malloc(len);
-			if (!fdtfilefree) {
-				printf("malloc fail (FDT filename)\n");
-				goto cleanup;
-			}
-
-			snprintf(fdtfilefree, len, "%s%s%s%s%s%s",
-				 label->fdtdir, slash, f1, f2, f3, f4);
-			fdtfile = fdtfilefree;
-		}
+		if (label_get_fdtfile(label, &fdtfile, &fdtfilefree))
+			goto cleanup;
 
 		if (fdtfile) {
 			int err = get_relfile_envaddr(ctx, fdtfile,
@@ -1492,6 +1705,7 @@ int pxe_setup_ctx(struct pxe_context *ctx, struct cmd_tbl *cmdtp,
 
 void pxe_destroy_ctx(struct pxe_context *ctx)
 {
+	prefetch_reset(ctx);
 	free(ctx->bootdir);
 }
 
@@ -0,0 +1,300 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Microbenchmark command
+ *
+ * Runs the benchmarks declared with BENCH() and reports the time per
+ * operation and the throughput, with the data in the cache (warm) and with
+ * the data flushed from the cache before each operation (cold).
+ */
+
+#include <common.h>
+#include <bench.h>
+#include <command.h>
+#include <console.h>
+#include <cpu_func.h>
+#include <div64.h>
+#include <malloc.h>
+#include <time.h>
+#include <asm/cache.h>
+#include <linux/sizes.h>
+
+/* Default number of bytes processed by each operation, for BENCHF_BUF */
+#define BENCH_DEFAULT_SIZE	SZ_1M
+
+/* Default minimum time to spend on each variant of a benchmark */
+#define BENCH_DEFAULT_MS	200
+
+/* Give up on a cold run after this many times the minimum time */
+#define BENCH_COLD_LIMIT	10
+
+/**
+ * struct bench_opts - options for running benchmarks
+ *
+ * @size: Bytes processed by each operation, for BENCHF_BUF
+ * @min_ticks: Minimum time to spend on each variant, in timer ticks
+ * @warm: true to run the cache-warm variant
+ * @cold: true to run the cache-cold variant
+ */
+struct bench_opts {
+	ulong size;
+	u64 min_ticks;
+	bool warm;
+	bool cold;
+};
+
+static const char *bench_name(struct bench_entry *entry)
+{
+	return entry->name + strlen("bench_");
+}
+
+static void bench_flush(ulong start, ulong size)
+{
+	if (start && size)
+		flush_dcache_range(ALIGN_DOWN(start, ARCH_DMA_MINALIGN),
+				   ALIGN(start + size, ARCH_DMA_MINALIGN));
+}
+
+/**
+ * bench_measure() - time a benchmark
+ *
+ * For the warm variant, one untimed operation is done first and then the
+ * number of operations is doubled until the minimum time is reached. For
+ * the cold variant each operation is timed separately, after flushing the
+ * buffers from the cache.
+ *
+ * @entry: Benchmark to run
+ * @bs: Benchmark state
+ * @opts: Options
+ * @cold: true for the cache-cold variant
+ * @countp: Returns the number of operations timed
+ * @ticksp: Returns the total time taken, in timer ticks
+ * Return: 0 if OK, -EINTR if interrupted, other -ve on error
+ */
+static int bench_measure(struct bench_entry *entry, struct bench_state *bs,
+			 struct bench_opts *opts, bool cold, ulong *countp,
+			 u64 *ticksp)
+{
+	u64 ticks = 0;
+	ulong count;
+	ulong i;
+	int ret;
+
+	if (cold) {
+		u64 limit = get_ticks() + opts->min_ticks * BENCH_COLD_LIMIT;
+
+		for (count = 0; ticks < opts->min_ticks; count++) {
+			u64 start;
+
+			if (get_ticks() > limit || ctrlc())
+				break;
+			bench_flush((ulong)bs->src, bs->src_size);
+			bench_flush((ulong)bs->dst, bs->size);
+			start = get_ticks();
+			ret = entry->run(bs);
+			ticks += get_ticks() - start;
+			if (ret)
+				return ret;
+		}
+	} else {
+		ret = entry->run(bs);
+		if (ret)
+			return ret;
+		for (count = 1;; count *= 2) {
+			u64 start = get_ticks();
+
+			for (i = 0; i < count; i++) {
+				ret = entry->run(bs);
+				if (ret)
+					return ret;
+			}
+			ticks = get_ticks() - start;
+			if (ticks >= opts->min_ticks || count >= ULONG_MAX / 2)
+				break;
+			if (ctrlc())
+				return -EINTR;
+		}
+	}
+	*countp = count;
+	*ticksp = ticks;
+
+	return count ? 0 : -EINTR;
+}
+
+static void bench_show(struct bench_entry *entry, struct bench_state *bs,
+		       bool cold, ulong count, u64 ticks)
+{
+	u64 ns = lldiv(ticks * 1000000000ULL, get_tbclk());
+
+	printf("%-16s %-5s %9lu %10lu %10llu", bench_name(entry),
+	       cold ? "cold" : "warm", bs->size, count,
+	       lldiv(ns, count));
+	if (bs->size && ns)
+		printf(" %9llu", lldiv((u64)bs->size * count * 1000, ns));
+	printf("\n");
+}
+
+static int bench_run_one(struct bench_entry *entry, struct bench_opts *opts)
+{
+	struct bench_state bs;
+	void *src = NULL;
+	ulong count;
+	u64 ticks;
+	int ret = 0;
+	int i;
+
+	memset(&bs, '\0', sizeof(bs));
+	if (entry->flags & BENCHF_BUF) {
+		src = memalign(ARCH_DMA_MINALIGN, opts->size);
+		bs.dst = memalign(ARCH_DMA_MINALIGN, opts->size);
+		if (!src || !bs.dst) {
+			printf("%s: Out of memory\n", bench_name(entry));
+			ret = -ENOMEM;
+			goto out;
+		}
+		memset(src, 0xa5, opts->size);
+		bs.src = src;
+		bs.src_size = opts->size;
+		bs.size = opts->size;
+	}
+
+	if (entry->setup) {
+		ret = entry->setup(&bs);
+		if (ret == -ENOSYS) {
+			printf("%-16s skipped (not enabled)\n", bench_name(entry));
+			ret = 0;
+			goto out;
+		} else if (ret) {
+			printf("%s: Setup failed (err=%d)\n", bench_name(entry),
+			       ret);
+			goto out;
+		}
+	}
+
+	for (i = 0; i < 2; i++) {
+		bool cold = i;
+
+		if (cold ? !opts->cold || (entry->flags & BENCHF_NO_COLD) :
+		    !opts->warm)
+			continue;
+		ret = bench_measure(entry, &bs, opts, cold, &count, &ticks);
+		if (ret) {
+			if (ret != -EINTR)
+				printf("%s: Failed (err=%d)\n",
+				       bench_name(entry), ret);
+			break;
+		}
+		bench_show(entry, &bs, cold, count, ticks);
+	}
+
+	if (entry->teardown)
+		entry->teardown(&bs);
+out:
+	if (entry->flags & BENCHF_BUF) {
+		free(bs.dst);
+		free(src);
+	}
+
+	return ret;
+}
+
+static bool bench_wanted(struct bench_entry *entry, int argc,
+			 char *const argv[])
+{
+	int i;
+
+	if (!argc)
+		return true;
+	for (i = 0; i < argc; i++) {
+		if (!strcmp(bench_name(entry), argv[i]))
+			return true;
+	}
+
+	return false;
+}
+
+static int do_bench_list(struct cmd_tbl *cmdtp, int flag, int argc,
+			 char *const argv[])
+{
+	struct bench_entry *start = BENCH_START();
+	const int count = BENCH_COUNT();
+	struct bench_entry *entry;
+
+	for (entry = start; entry != start + count; entry++)
+		printf("%-16s %s\n", bench_name(entry),
+		       entry->flags & BENCHF_BUF ? "(buffer)" : "");
+
+	return 0;
+}
+
+static int do_bench_run(struct cmd_tbl *cmdtp, int flag, int argc,
+			char *const argv[])
+{
+	struct bench_entry *start = BENCH_START();
+	const int count = BENCH_COUNT();
+	struct bench_opts opts;
+	struct bench_entry *entry;
+	ulong ms = BENCH_DEFAULT_MS;
+	bool found = false;
+	int ret;
+
+	opts.size = BENCH_DEFAULT_SIZE;
+	opts.warm = true;
+	opts.cold = true;
+	for (argc--, argv++; argc && *argv[0] == '-'; argc--, argv++) {
+		const char *opt = argv[0];
+
+		if (!strcmp(opt, "-w")) {
+			opts.cold = false;
+		} else if (!strcmp(opt, "-c")) {
+			opts.warm = false;
+		} else if (argc > 1 && (!strcmp(opt, "-s") ||
+					!strcmp(opt, "-t"))) {
+			ulong val = simple_strtoul(argv[1], NULL, 0);
+
+			if (opt[1] == 's')
+				opts.size = val;
+			else
+				ms = val;
+			argc--;
+			argv++;
+		} else {
+			return CMD_RET_USAGE;
+		}
+	}
+	if (!opts.size || !ms || (!opts.warm && !opts.cold))
+		return CMD_RET_USAGE;
+	opts.min_ticks = lldiv((u64)ms * get_tbclk(), 1000);
+
+	printf("%-16s %-5s %9s %10s %10s %9s\n", "Benchmark", "Cache", "Size",
+	       "Ops", "ns/op", "MB/s");
+	for (entry = start; entry != start + count; entry++) {
+		if (!bench_wanted(entry, argc, argv))
+			continue;
+		found = true;
+		ret = bench_run_one(entry, &opts);
+		if (ret == -EINTR) {
+			printf("<interrupted>\n");
+			return CMD_RET_FAILURE;
+		} else if (ret) {
+			return CMD_RET_FAILURE;
+		}
+	}
+	if (!found) {
+		printf("No benchmarks found\n");
+		return CMD_RET_FAILURE;
+	}
+
+	return 0;
+}
+
+static char bench_help_text[] =
+	"list - list available benchmarks\n"
+	"bench run [-w | -c] [-s size] [-t ms] [name ...] - run benchmarks\n"
+	"   -w      - cache-warm results only\n"
+	"   -c      - cache-cold results only\n"
+	"   -s size - bytes per operation for buffer benchmarks (default 1MiB)\n"
+	"   -t ms   - minimum time for each result (default 200)";
+
+U_BOOT_CMD_WITH_SUBCMDS(bench, "Run microbenchmarks", bench_help_text,
+	U_BOOT_SUBCMD_MKENT(list, 1, 1, do_bench_list),
+	U_BOOT_SUBCMD_MKENT(run, CONFIG_SYS_MAXARGS, 1, do_bench_run));
@@ -16,10 +16,36 @@
 #include <dm/root.h>
 #include <dm/util.h>
 
+/* Check for the -t flag, which selects statistics output */
+static int dm_want_stats(int argc, char *const argv[], bool *statsp)
+{
+	*statsp = false;
+	if (!argc)
+		return 0;
+	if (strcmp(argv[0], "-t"))
+		return CMD_RET_USAGE;
+	if (!CONFIG_IS_ENABLED(DM_STATS)) {
+		printf("Statistics not enabled (CONFIG_DM_STATS)\n");
+		return CMD_RET_FAILURE;
+	}
+	*statsp = true;
+
+	return 0;
+}
+
 static int do_dm_dump_all(struct cmd_tbl *cmdtp, int flag, int argc,
 			  char *const argv[])
 {
-	dm_dump_all();
+	bool stats;
+	int ret;
+
+	ret = dm_want_stats(argc, argv, &stats);
+	if (ret)
+		return ret;
+	if (stats)
+		dm_dump_stats();
+	else
+		dm_dump_all();
 
 	return 0;
 }
@@ -27,7 +53,16 @@ static int do_dm_dump_all(struct cmd_tbl *cmdtp, int flag, int argc,
 static int do_dm_dump_uclass(struct cmd_tbl *cmdtp, int flag, int argc,
 			     char *const argv[])
 {
-	dm_dump_uclass();
+	bool stats;
+	int ret;
+
+	ret = dm_want_stats(argc, argv, &stats);
+	if (ret)
+		return ret;
+	if (stats)
+		dm_dump_uclass_stats();
+	else
+		dm_dump_uclass();
 
 	return 0;
 }
@@ -65,7 +100,7 @@ static int do_dm_dump_static_driver_info(struct cmd_tbl *cmdtp, int flag, int ar
 }
 
 static struct cmd_tbl test_commands[] = {
-	U_BOOT_CMD_MKENT(tree, 0, 1, do_dm_dump_all, "", ""),
+	U_BOOT_CMD_MKENT(tree, 1, 1, do_dm_dump_all, "", ""),
 	U_BOOT_CMD_MKENT(uclass, 1, 1, do_dm_dump_uclass, "", ""),
 	U_BOOT_CMD_MKENT(devres, 1, 1, do_dm_dump_devres, "", ""),
 	U_BOOT_CMD_MKENT(drivers, 1, 1, do_dm_dump_drivers, "", ""),
@@ -109,8 +144,9 @@ static int do_dm(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 U_BOOT_CMD(
 	dm,	3,	1,	do_dm,
 	"Driver model low level access",
-	"tree          Dump driver model tree ('*' = activated)\n"
-	"dm uclass        Dump list of instances for each uclass\n"
+	"tree [-t]     Dump driver model tree ('*' = activated)\n"
+	"dm uclass [-t]   Dump list of instances for each uclass\n"
+	"                 (-t: show probe statistics, needs CONFIG_DM_STATS)\n"
 	"dm devres        Dump list of device resources for each device\n"
 	"dm drivers       Dump list of drivers with uclass and instances\n"
 	"dm compat        Dump list of drivers with compatibility strings\n"
@@ -706,6 +706,40 @@ static int do_efi_show_handles(struct cmd_tbl *cmdtp, int flag,
 	return CMD_RET_SUCCESS;
 }
 
+#ifdef CONFIG_EFI_DISK_READ_AHEAD
+/**
+ * do_efi_show_diskcache() - show block device read-ahead statistics
+ *
+ * @cmdtp:	Command table
+ * @flag:	Command flag
+ * @argc:	Number of arguments
+ * @argv:	Argument array
+ * Return:	CMD_RET_SUCCESS on success, CMD_RET_RET_FAILURE on failure
+ *
+ * Implement efidebug "diskcache" sub-command.
+ * Show how many reads by UEFI applications were served from the read-ahead
+ * cache of each block device.
+ */
+static int do_efi_show_diskcache(struct cmd_tbl *cmdtp, int flag,
+				 int argc, char *const argv[])
+{
+	struct efi_disk_cache_stats stats;
+	int i;
+
+	printf("Device          Reads       Hits Hit%%      Fills     Blocks\n");
+	printf("========== ========== ========== ==== ========== ==========\n");
+	for (i = 0; !efi_disk_get_cache_stats(i, &stats); i++) {
+		printf("%-6s %3d %10lu %10lu %3lu%% %10lu %10llu\n",
+		       blk_get_if_type_name(stats.desc->if_type),
+		       stats.desc->devnum, stats.reads, stats.hits,
+		       stats.reads ? stats.hits * 100 / stats.reads : 0,
+		       stats.fills, stats.blocks);
+	}
+
+	return CMD_RET_SUCCESS;
+}
+#endif
+
 /**
  * do_efi_show_images() - show UEFI images
  *
@@ -1667,6 +1701,10 @@ static struct cmd_tbl cmd_efidebug_sub[] = {
 			 "", ""),
 	U_BOOT_CMD_MKENT(dh, CONFIG_SYS_MAXARGS, 1, do_efi_show_handles,
 			 "", ""),
+#ifdef CONFIG_EFI_DISK_READ_AHEAD
+	U_BOOT_CMD_MKENT(diskcache, CONFIG_SYS_MAXARGS, 1,
+			 do_efi_show_diskcache, "", ""),
+#endif
 	U_BOOT_CMD_MKENT(images, CONFIG_SYS_MAXARGS, 1, do_efi_show_images,
 			 "", ""),
 	U_BOOT_CMD_MKENT(memmap, CONFIG_SYS_MAXARGS, 1, do_efi_show_memmap,
@@ -1759,6 +1797,10 @@ static char efidebug_help_text[] =
 	"  - show UEFI drivers\n"
 	"efidebug dh\n"
 	"  - show UEFI handles\n"
+#ifdef CONFIG_EFI_DISK_READ_AHEAD
+	"efidebug diskcache\n"
+	"  - show block device read-ahead statistics\n"
+#endif
 	"efidebug images\n"
 	"  - show loaded images\n"
 	"efidebug memmap\n"
@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Fast memory test command
+ */
+
+#include <common.h>
+#include <command.h>
+#include <div64.h>
+#include <getopt.h>
+#include <memtest.h>
+#include <vsprintf.h>
+#include <linux/sizes.h>
+
+static const char *const cache_names[] = {
+	[MEMTEST_CACHED]	= "cached",
+	[MEMTEST_FLUSH]		= "flush",
+	[MEMTEST_UNCACHED]	= "uncached",
+};
+
+static int parse_cache(const char *arg)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(cache_names); i++) {
+		if (!strcmp(arg, cache_names[i]))
+			return i;
+	}
+
+	return -EINVAL;
+}
+
+static ulong mib_per_sec(u64 bytes, ulong time_us)
+{
+	ulong time_ms = DIV_ROUND_UP(time_us, 1000);
+
+	if (!time_ms)
+		return 0;
+
+	return lldiv(bytes / SZ_1K * 1000, time_ms) / SZ_1K;
+}
+
+/* Show the errors found, if any */
+static void show_errors(ulong errors, ulong first_error, u64 bit_errors)
+{
+	if (!errors) {
+		printf("OK\n");
+		return;
+	}
+	printf("%lu errors, first at %08lx, bad bits %016llx\n", errors,
+	       first_error, (unsigned long long)bit_errors);
+}
+
+static int do_memtest(struct cmd_tbl *cmdtp, int flag, int argc,
+		      char *const argv[])
+{
+	enum memtest_cache cache = MEMTEST_CACHED;
+	uint patterns = MEMTEST_ALL;
+	struct memtest_result total;
+	uint max_cpus = UINT_MAX;
+	ulong iterations = 1;
+	struct getopt_state gs;
+	ulong start, size;
+	ulong iter;
+	int opt;
+
+	getopt_init_state(&gs);
+	while ((opt = getopt(&gs, argc, argv, "c:m:n:p:")) > 0) {
+		switch (opt) {
+		case 'c':
+			max_cpus = dectoul(gs.arg, NULL);
+			break;
+		case 'm':
+			opt = parse_cache(gs.arg);
+			if (opt < 0)
+				return CMD_RET_USAGE;
+			cache = opt;
+			break;
+		case 'n':
+			iterations = dectoul(gs.arg, NULL);
+			break;
+		case 'p':
+			patterns = hextoul(gs.arg, NULL);
+			break;
+		default:
+			return CMD_RET_USAGE;
+		}
+	}
+	if (argc - gs.index != 2 || !max_cpus || !patterns ||
+	    patterns & ~MEMTEST_ALL)
+		return CMD_RET_USAGE;
+	start = hextoul(argv[gs.index], NULL);
+	size = hextoul(argv[gs.index + 1], NULL);
+
+	printf("Testing %08lx size %lx, cache %s\n", start, size,
+	       cache_names[cache]);
+	memset(&total, '\0', sizeof(total));
+	for (iter = 0; !iterations || iter < iterations; iter++) {
+		uint pattern;
+
+		for (pattern = 1; pattern & MEMTEST_ALL; pattern <<= 1) {
+			struct memtest_result res;
+			int ret;
+
+			if (!(patterns & pattern))
+				continue;
+			printf("%-18s", memtest_pattern_name(pattern));
+			ret = memtest_run(start, size, pattern, cache, max_cpus,
+					  &res);
+			if (ret) {
+				printf("failed (err=%d)\n", ret);
+				return CMD_RET_FAILURE;
+			}
+			printf("%5lu MiB/s, %u core(s): ",
+			       mib_per_sec(res.bytes, res.time_us), res.cpus);
+			show_errors(res.errors, res.first_error,
+				    res.bit_errors);
+
+			if (res.errors && (!total.errors ||
+					   res.first_error < total.first_error))
+				total.first_error = res.first_error;
+			total.errors += res.errors;
+			total.bit_errors |= res.bit_errors;
+			if (res.aborted) {
+				total.aborted = true;
+				break;
+			}
+		}
+		if (total.aborted)
+			break;
+	}
+
+	printf("Tested %lu iteration(s)%s: ", iter,
+	       total.aborted ? " (aborted)" : "");
+	show_errors(total.errors, total.first_error, total.bit_errors);
+
+	return total.errors ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	memtest,	10,	1,	do_memtest,
+	"fast memory test",
+	"[-c <cpus>] [-m <mode>] [-n <iterations>] [-p <patterns>] <start> <size>\n"
+	"  -c  - most cores to use (default all)\n"
+	"  -m  - cache mode: cached (default), flush (after each write pass)\n"
+	"        or uncached\n"
+	"  -n  - number of iterations, 0 to run until Ctrl-C (default 1)\n"
+	"  -p  - hex mask of patterns (default f):\n"
+	"        1 walking-ones, 2 walking-zeros, 4 address,\n"
+	"        8 moving-inversions"
+);
@@ -8,6 +8,7 @@
 #include <command.h>
 #include <fs.h>
 #include <net.h>
+#include <net/tftp.h>
 
 #include "pxe_utils.h"
 
@@ -43,94 +44,131 @@ static int do_get_tftp(struct pxe_context *ctx, const char *file_path,
 	return 1;
 }
 
-/*
- * Looks for a pxe file with a name based on the pxeuuid environment variable.
- *
- * Returns 1 on success or < 0 on error.
- */
-static int pxe_uuid_path(struct pxe_context *ctx, unsigned long pxefile_addr_r)
+static int do_get_tftp_files(struct pxe_context *ctx, struct pxe_file *files,
+			     int count, bool first)
 {
-	char *uuid_str;
+	struct tftp_file tfiles[TFTP_MULTI_MAX];
+	int ret, i;
 
-	uuid_str = from_env("pxeuuid");
+	if (count > TFTP_MULTI_MAX)
+		return -E2BIG;
 
-	if (!uuid_str)
-		return -ENOENT;
+	for (i = 0; i < count; i++) {
+		tfiles[i].name = files[i].path;
+		tfiles[i].addr = files[i].addr;
+	}
+	ret = tftp_get_files(tfiles, count, first);
+	for (i = 0; i < count; i++) {
+		files[i].size = tfiles[i].size;
+		files[i].ret = tfiles[i].ret;
+	}
+	if (first && ret >= 0)
+		ctx->pxe_file_size = files[ret].size;
 
-	return get_pxelinux_path(ctx, uuid_str, pxefile_addr_r);
+	return ret;
 }
 
-/*
- * Looks for a pxe file with a name based on the 'ethaddr' environment
- * variable.
+/* Sets up a context to use TFTP, fetching files together if possible */
+static int pxe_setup_tftp_ctx(struct pxe_context *ctx, struct cmd_tbl *cmdtp)
+{
+	int ret;
+
+	ret = pxe_setup_ctx(ctx, cmdtp, do_get_tftp, NULL, false,
+			    env_get("bootfile"));
+	if (ret)
+		return ret;
+	if (IS_ENABLED(CONFIG_TFTP_MULTI))
+		ctx->getfiles = do_get_tftp_files;
+
+	return 0;
+}
+
+/* Maximum number of names tried for the config file */
+#define PXE_MAX_NAMES	(2 + 8 + ARRAY_SIZE(pxe_default_paths))
+
+/**
+ * struct pxe_names - names to try for the config file, in order
  *
- * Returns 1 on success or < 0 on error.
+ * @name: Names to try
+ * @count: Number of names
+ * @mac: Name based on the MAC address
+ * @ip: Names based on the IP address
  */
-static int pxe_mac_path(struct pxe_context *ctx, unsigned long pxefile_addr_r)
+struct pxe_names {
+	const char *name[PXE_MAX_NAMES];
+	int count;
+	char mac[21];
+	char ip[8][9];
+};
+
+/*
+ * Adds a pxe file name based on the pxeuuid environment variable.
+ */
+static void pxe_uuid_path(struct pxe_names *names)
 {
-	char mac_str[21];
-	int err;
+	char *uuid_str;
 
-	err = format_mac_pxe(mac_str, sizeof(mac_str));
+	uuid_str = from_env("pxeuuid");
 
-	if (err < 0)
-		return err;
+	if (uuid_str)
+		names->name[names->count++] = uuid_str;
+}
 
-	return get_pxelinux_path(ctx, mac_str, pxefile_addr_r);
+/*
+ * Adds a pxe file name based on the 'ethaddr' environment variable.
+ */
+static void pxe_mac_path(struct pxe_names *names)
+{
+	if (format_mac_pxe(names->mac, sizeof(names->mac)) >= 0)
+		names->name[names->count++] = names->mac;
 }
 
 /*
- * Looks for pxe files with names based on our IP address. See pxelinux
- * documentation for details on what these file names look like.  We match
- * that exactly.
- *
- * Returns 1 on success or < 0 on error.
+ * Adds pxe file names based on our IP address. See pxelinux documentation
+ * for details on what these file names look like.  We match that exactly.
  */
-static int pxe_ipaddr_paths(struct pxe_context *ctx, unsigned long pxefile_addr_r)
+static void pxe_ipaddr_paths(struct pxe_names *names)
 {
 	char ip_addr[9];
-	int mask_pos, err;
+	int mask_pos;
 
 	sprintf(ip_addr, "%08X", ntohl(net_ip.s_addr));
 
 	for (mask_pos = 7; mask_pos >= 0;  mask_pos--) {
-		err = get_pxelinux_path(ctx, ip_addr, pxefile_addr_r);
-
-		if (err > 0)
-			return err;
+		char *name = names->ip[7 - mask_pos];
 
+		strcpy(name, ip_addr);
+		names->name[names->count++] = name;
 		ip_addr[mask_pos] = '\0';
 	}
-
-	return -ENOENT;
 }
 
 int pxe_get(ulong pxefile_addr_r, char **bootdirp, ulong *sizep)
 {
 	struct cmd_tbl cmdtp[] = {};	/* dummy */
+	struct pxe_names names;
 	struct pxe_context ctx;
-	int i;
+	int ret, i;
 
-	if (pxe_setup_ctx(&ctx, cmdtp, do_get_tftp, NULL, false,
-			  env_get("bootfile")))
+	if (pxe_setup_tftp_ctx(&ctx, cmdtp))
 		return -ENOMEM;
+
 	/*
 	 * Keep trying paths until we successfully get a file we're looking
 	 * for.
 	 */
-	if (pxe_uuid_path(&ctx, pxefile_addr_r) > 0 ||
-	    pxe_mac_path(&ctx, pxefile_addr_r) > 0 ||
-	    pxe_ipaddr_paths(&ctx, pxefile_addr_r) > 0)
+	names.count = 0;
+	pxe_uuid_path(&names);
+	pxe_mac_path(&names);
+	pxe_ipaddr_paths(&names);
+	for (i = 0; pxe_default_paths[i]; i++)
+		names.name[names.count++] = pxe_default_paths[i];
+
+	ret = get_pxelinux_paths(&ctx, names.name, names.count,
+				 pxefile_addr_r);
+	if (ret > 0)
 		goto done;
 
-	i = 0;
-	while (pxe_default_paths[i]) {
-		if (get_pxelinux_path(&ctx, pxe_default_paths[i],
-				      pxefile_addr_r) > 0)
-			goto done;
-		i++;
-	}
-
 	pxe_destroy_ctx(&ctx);
 
 	return -ENOENT;
@@ -228,8 +266,7 @@ do_pxe_boot(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 		return 1;
 	}
 
-	if (pxe_setup_ctx(&ctx, cmdtp, do_get_tftp, NULL, false,
-			  env_get("bootfile"))) {
+	if (pxe_setup_tftp_ctx(&ctx, cmdtp)) {
 		printf("Out of memory\n");
 		return CMD_RET_FAILURE;
 	}
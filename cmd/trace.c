@@ -76,6 +76,59 @@ static int create_call_list(int argc, char *const argv[])
 	return 0;
 }
 
+#ifdef CONFIG_TRACE_SAMPLE
+static int create_sample_list(int argc, char *const argv[])
+{
+	size_t buff_size, avail, buff_ptr, needed, used;
+	char *buff;
+	int err;
+
+	if (get_args(argc, argv, &buff, &buff_ptr, &buff_size))
+		return -1;
+
+	avail = buff_size - buff_ptr;
+	err = trace_list_samples(buff + buff_ptr, avail, &needed);
+	if (err)
+		printf("Error: truncated (%#zx bytes needed)\n", needed);
+	used = min(avail, (size_t)needed);
+	printf("Samples dumped to %08lx, size %#zx\n",
+	       (ulong)map_to_sysmem(buff + buff_ptr), used);
+
+	env_set_hex("profbase", map_to_sysmem(buff));
+	env_set_hex("profsize", buff_size);
+	env_set_hex("profoffset", buff_ptr + used);
+
+	return 0;
+}
+
+static int do_trace_sample(int argc, char *const argv[])
+{
+	uint period_us = CONFIG_TRACE_SAMPLE_PERIOD_US;
+	const char *cmd = argc < 3 ? NULL : argv[2];
+	int ret;
+
+	if (!cmd)
+		return -1;
+	if (!strcmp(cmd, "start")) {
+		if (argc > 3)
+			period_us = dectoul(argv[3], NULL);
+		ret = trace_sample_start(period_us);
+		if (ret) {
+			printf("Cannot start sampling (err=%d)\n", ret);
+			return ret;
+		}
+	} else if (!strcmp(cmd, "stop")) {
+		trace_sample_stop();
+	} else if (!strcmp(cmd, "dump")) {
+		return create_sample_list(argc - 1, argv + 1);
+	} else {
+		return -1;
+	}
+
+	return 0;
+}
+#endif
+
 int do_trace(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 {
 	const char *cmd = argc < 2 ? NULL : argv[1];
@@ -98,7 +151,17 @@ int do_trace(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 			return cmd_usage(cmdtp);
 		break;
 	case 's':
+#ifdef CONFIG_TRACE_SAMPLE
+		if (!strcmp(cmd, "sample")) {
+			if (do_trace_sample(argc, argv))
+				return cmd_usage(cmdtp);
+			break;
+		}
+#endif
 		trace_print_stats();
+#ifdef CONFIG_TRACE_SAMPLE
+		trace_sample_print_stats();
+#endif
 		break;
 	default:
 		return CMD_RET_USAGE;
@@ -108,7 +171,7 @@ int do_trace(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 }
 
 U_BOOT_CMD(
-	trace,	4,	1,	do_trace,
+	trace,	5,	1,	do_trace,
 	"trace utility commands",
 	"stats                        - display tracing statistics\n"
 	"trace pause                        - pause tracing\n"
@@ -116,4 +179,9 @@ U_BOOT_CMD(
 	"trace funclist [<addr> <size>]     - dump function list into buffer\n"
 	"trace calls  [<addr> <size>]       "
 		"- dump function call trace into buffer"
+#ifdef CONFIG_TRACE_SAMPLE
+	"\ntrace sample start [<period_us>]   - start sampling profiler\n"
+	"trace sample stop                  - stop sampling profiler\n"
+	"trace sample dump [<addr> <size>]  - dump samples into buffer"
+#endif
 );
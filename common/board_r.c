@@ -107,6 +107,19 @@ static int initr_trace(void)
 	return 0;
 }
 
+static int initr_trace_sample(void)
+{
+#ifdef CONFIG_TRACE_SAMPLE_AUTOSTART
+	int ret;
+
+	ret = trace_sample_start(CONFIG_TRACE_SAMPLE_PERIOD_US);
+	if (ret)
+		printf("trace: cannot start sampling (err=%d)\n", ret);
+#endif
+
+	return 0;
+}
+
 static int initr_reloc(void)
 {
 	/* tell others: relocation done */
@@ -622,6 +635,7 @@ static init_fnc_t init_sequence_r[] = {
 #endif
 	initr_barrier,
 	initr_malloc,
+	initr_trace_sample,
 	log_init,
 	initr_bootstage,	/* Needs malloc() but has its own timer */
 #if defined(CONFIG_CONSOLE_RECORD)
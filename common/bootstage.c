@@ -13,11 +13,13 @@
 
 #include <common.h>
 #include <bootstage.h>
+#include <bootstage_timeline.h>
 #include <hang.h>
 #include <log.h>
 #include <malloc.h>
 #include <sort.h>
 #include <spl.h>
+#include <time.h>
 #include <asm/global_data.h>
 #include <linux/compiler.h>
 #include <linux/libfdt.h>
@@ -148,13 +150,48 @@ ulong bootstage_add_record(enum bootstage_id id, const char *name,
 }
 
 
+static const char *get_record_name(char *buf, int len,
+				   const struct bootstage_record *rec);
+
+/**
+ * timeline_mark() - Add a mark to the bootstage timeline, if enabled
+ *
+ * @id:		Bootstage ID of the mark
+ * @name:	Name of the mark, or NULL to use a name based on @id
+ */
+static void timeline_mark(enum bootstage_id id, const char *name)
+{
+	struct bootstage_record rec = { .id = id, .name = name };
+	char buf[20];
+	u64 now;
+
+	if (!CONFIG_IS_ENABLED(BOOTSTAGE_TIMELINE))
+		return;
+#if CONFIG_IS_ENABLED(TIMER) && !defined(CONFIG_TIMER_EARLY)
+	/*
+	 * The first marks come before driver model is set up, when reading
+	 * a driver-model timer would panic, so leave them out of the timeline
+	 */
+	if (!gd->timer)
+		return;
+#endif
+	now = get_ticks();
+	bootstage_timeline_add(BOOTSTAGE_TL_MARK,
+			       get_record_name(buf, sizeof(buf), &rec),
+			       now, now);
+}
+
 ulong bootstage_mark(enum bootstage_id id)
 {
+	timeline_mark(id, NULL);
+
 	return bootstage_add_record(id, NULL, 0, timer_get_boot_us());
 }
 
 ulong bootstage_error(enum bootstage_id id)
 {
+	timeline_mark(id, NULL);
+
 	return bootstage_add_record(id, NULL, BOOTSTAGEF_ERROR,
 				    timer_get_boot_us());
 }
@@ -165,6 +202,7 @@ ulong bootstage_mark_name(enum bootstage_id id, const char *name)
 
 	if (id == BOOTSTAGE_ID_ALLOC)
 		flags = BOOTSTAGEF_ALLOC;
+	timeline_mark(id, name);
 
 	return bootstage_add_record(id, name, flags, timer_get_boot_us());
 }
@@ -199,9 +237,14 @@ ulong bootstage_mark_code(const char *file, const char *func, int linenum)
 uint32_t bootstage_start(enum bootstage_id id, const char *name)
 {
 	struct bootstage_data *data = gd->bootstage;
-	struct bootstage_record *rec = ensure_id(data, id);
-	ulong start_us = timer_get_boot_us();
+	struct bootstage_record *rec;
+	ulong start_us;
 
+	/* As with bootstage_add_record(), we may be called before set-up */
+	if (!data)
+		return 0;
+	rec = ensure_id(data, id);
+	start_us = timer_get_boot_us();
 	if (rec) {
 		rec->start_us = start_us;
 		rec->name = name;
@@ -213,9 +256,12 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name)
 uint32_t bootstage_accum(enum bootstage_id id)
 {
 	struct bootstage_data *data = gd->bootstage;
-	struct bootstage_record *rec = ensure_id(data, id);
+	struct bootstage_record *rec;
 	uint32_t duration;
 
+	if (!data)
+		return 0;
+	rec = ensure_id(data, id);
 	if (!rec)
 		return 0;
 	duration = (uint32_t)timer_get_boot_us() - rec->start_us;
@@ -537,6 +583,8 @@ int bootstage_init(bool first)
 		data->next_id = BOOTSTAGE_ID_USER;
 		bootstage_add_record(BOOTSTAGE_ID_AWAKE, "reset", 0, 0);
 	}
+	if (bootstage_timeline_init())
+		log_warning("Cannot set up bootstage timeline\n");
 
 	return 0;
 }
@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Bootstage timeline
+ *
+ * This records boot events (bootstage marks, device probes and commands)
+ * with raw timer timestamps into a memory region which survives into the OS,
+ * so that SPL, U-Boot proper and the OS can all be shown on a single
+ * timeline.
+ */
+
+#define LOG_CATEGORY	LOGC_BOOT
+
+#include <common.h>
+#include <bootstage_timeline.h>
+#include <fdt_support.h>
+#include <fdtdec.h>
+#include <log.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <spl.h>
+#include <time.h>
+#include <linux/libfdt.h>
+
+/* Events are assumed to need this many bytes of name on average */
+#define AVG_NAME_LEN	16
+
+/* The timeline currently being written to */
+static struct bootstage_timeline_hdr *timeline __section(".data");
+
+static struct bootstage_timeline_event *
+		timeline_events(struct bootstage_timeline_hdr *hdr)
+{
+	return (void *)hdr + hdr->hdr_size;
+}
+
+static char *timeline_strings(struct bootstage_timeline_hdr *hdr)
+{
+	return (char *)(timeline_events(hdr) + hdr->max_count);
+}
+
+static void timeline_setup(struct bootstage_timeline_hdr *hdr, ulong size)
+{
+	ulong per_event;
+
+	memset(hdr, '\0', sizeof(*hdr));
+	hdr->magic = BOOTSTAGE_TIMELINE_MAGIC;
+	hdr->version = BOOTSTAGE_TIMELINE_VERSION;
+	hdr->hdr_size = sizeof(*hdr);
+	hdr->size = size;
+	hdr->tick_rate = get_tbclk();
+	per_event = sizeof(struct bootstage_timeline_event) + AVG_NAME_LEN;
+	hdr->max_count = (size - sizeof(*hdr)) / per_event;
+	hdr->str_size = size - sizeof(*hdr) -
+		hdr->max_count * sizeof(struct bootstage_timeline_event);
+}
+
+static bool timeline_valid(struct bootstage_timeline_hdr *hdr, ulong size)
+{
+	return hdr->magic == BOOTSTAGE_TIMELINE_MAGIC &&
+		hdr->version == BOOTSTAGE_TIMELINE_VERSION &&
+		hdr->hdr_size == sizeof(*hdr) && hdr->size == size &&
+		hdr->count <= hdr->max_count && hdr->str_used <= hdr->str_size;
+}
+
+static int timeline_add(struct bootstage_timeline_hdr *hdr,
+			enum bootstage_timeline_type type, enum u_boot_phase phase,
+			const char *name, u64 start, u64 end)
+{
+	struct bootstage_timeline_event *event;
+	int len = strlen(name) + 1;
+
+	if (hdr->count == hdr->max_count ||
+	    hdr->str_used + len > hdr->str_size) {
+		hdr->dropped++;
+		return -ENOSPC;
+	}
+	event = &timeline_events(hdr)[hdr->count++];
+	event->start = start;
+	event->end = end;
+	event->name = hdr->str_used;
+	event->type = type;
+	event->phase = phase;
+	event->reserved = 0;
+	memcpy(timeline_strings(hdr) + hdr->str_used, name, len);
+	hdr->str_used += len;
+
+	return 0;
+}
+
+void bootstage_timeline_add(enum bootstage_timeline_type type,
+			    const char *name, u64 start, u64 end)
+{
+	if (timeline)
+		timeline_add(timeline, type, spl_phase(), name, start, end);
+}
+
+int bootstage_timeline_init(void)
+{
+	ulong size = CONFIG_BOOTSTAGE_TIMELINE_SIZE;
+
+	if (timeline)
+		return 0;
+	if (spl_phase() == PHASE_SPL) {
+		size = CONFIG_VAL(BOOTSTAGE_TIMELINE_SIZE);
+		timeline = malloc(size);
+		if (!timeline)
+			return -ENOMEM;
+		timeline_setup(timeline, size);
+
+		return 0;
+	}
+
+	timeline = map_sysmem(CONFIG_BOOTSTAGE_TIMELINE_ADDR, size);
+	if (!IS_ENABLED(CONFIG_SPL_BOOTSTAGE_TIMELINE) ||
+	    !timeline_valid(timeline, size))
+		timeline_setup(timeline, size);
+
+	return 0;
+}
+
+int bootstage_timeline_flush(void)
+{
+	struct bootstage_timeline_hdr *hdr;
+	struct bootstage_timeline_event *event;
+	int ret = 0;
+	int i;
+
+	if (!timeline || spl_phase() != PHASE_SPL)
+		return 0;
+
+	hdr = map_sysmem(CONFIG_BOOTSTAGE_TIMELINE_ADDR,
+			 CONFIG_BOOTSTAGE_TIMELINE_SIZE);
+	timeline_setup(hdr, CONFIG_BOOTSTAGE_TIMELINE_SIZE);
+	for (i = 0, event = timeline_events(timeline); i < timeline->count;
+	     i++, event++) {
+		if (timeline_add(hdr, event->type, event->phase,
+				 timeline_strings(timeline) + event->name,
+				 event->start, event->end))
+			ret = -ENOSPC;
+	}
+	hdr->dropped += timeline->dropped;
+	log_debug("Flushed %d timeline events, %d dropped\n", hdr->count,
+		  hdr->dropped);
+	unmap_sysmem(hdr);
+
+	return ret;
+}
+
+#ifdef CONFIG_OF_LIBFDT
+int bootstage_timeline_fdt_add(void *blob)
+{
+	struct fdt_memory region;
+	const char *compat = "u-boot,bootstage-timeline";
+	u32 phandle;
+	int chosen;
+	int ret;
+
+	region.start = CONFIG_BOOTSTAGE_TIMELINE_ADDR;
+	region.end = region.start + CONFIG_BOOTSTAGE_TIMELINE_SIZE - 1;
+	ret = fdtdec_add_reserved_memory(blob, "bootstage-timeline", &region,
+					 &compat, 1, &phandle,
+					 FDTDEC_RESERVED_MEMORY_NO_MAP);
+	if (ret)
+		return ret;
+
+	chosen = fdt_find_or_add_subnode(blob, 0, "chosen");
+	if (chosen < 0)
+		return chosen;
+
+	return fdt_setprop_u32(blob, chosen, compat, phandle);
+}
+#endif
@@ -9,11 +9,13 @@
  */
 
 #include <common.h>
+#include <bootstage_timeline.h>
 #include <compiler.h>
 #include <command.h>
 #include <console.h>
 #include <env.h>
 #include <log.h>
+#include <time.h>
 #include <asm/global_data.h>
 #include <linux/ctype.h>
 
@@ -575,11 +577,17 @@ int cmd_discard_repeatable(struct cmd_tbl *cmdtp, int flag, int argc,
 static int cmd_call(struct cmd_tbl *cmdtp, int flag, int argc,
 		    char *const argv[], int *repeatable)
 {
+	u64 start = 0;
 	int result;
 
+	if (CONFIG_IS_ENABLED(BOOTSTAGE_TIMELINE))
+		start = get_ticks();
 	result = cmdtp->cmd_rep(cmdtp, flag, argc, argv, repeatable);
 	if (result)
 		debug("Command failed, result=%d\n", result);
+	if (CONFIG_IS_ENABLED(BOOTSTAGE_TIMELINE))
+		bootstage_timeline_add(BOOTSTAGE_TL_COMMAND, cmdtp->name,
+				       start, get_ticks());
 	return result;
 }
 
@@ -9,8 +9,10 @@
 #include <common.h>
 #include <env.h>
 #include <log.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <net.h>
+#include <sort.h>
 #include <stdio_dev.h>
 #include <linux/ctype.h>
 #include <linux/types.h>
@@ -336,6 +338,7 @@ void do_fixup_by_prop(void *fdt,
 		      const char *prop, const void *val, int len,
 		      int create)
 {
+	struct fdt_batch batch;
 	int off;
 #if defined(DEBUG)
 	int i;
@@ -344,12 +347,14 @@ void do_fixup_by_prop(void *fdt,
 		debug(" %.2x", *(u8*)(val+i));
 	debug("\n");
 #endif
+	fdt_batch_init(&batch, fdt);
 	off = fdt_node_offset_by_prop_value(fdt, -1, pname, pval, plen);
 	while (off != -FDT_ERR_NOTFOUND) {
 		if (create || (fdt_get_property(fdt, off, prop, NULL) != NULL))
-			fdt_setprop(fdt, off, prop, val, len);
+			fdt_batch_setprop(&batch, off, prop, val, len);
 		off = fdt_node_offset_by_prop_value(fdt, off, pname, pval, plen);
 	}
+	fdt_batch_apply(&batch);
 }
 
 void do_fixup_by_prop_u32(void *fdt,
@@ -363,6 +368,7 @@ void do_fixup_by_prop_u32(void *fdt,
 void do_fixup_by_compat(void *fdt, const char *compat,
 			const char *prop, const void *val, int len, int create)
 {
+	struct fdt_batch batch;
 	int off = -1;
 #if defined(DEBUG)
 	int i;
@@ -371,12 +377,14 @@ void do_fixup_by_compat(void *fdt, const char *compat,
 		debug(" %.2x", *(u8*)(val+i));
 	debug("\n");
 #endif
+	fdt_batch_init(&batch, fdt);
 	off = fdt_node_offset_by_compatible(fdt, -1, compat);
 	while (off != -FDT_ERR_NOTFOUND) {
 		if (create || (fdt_get_property(fdt, off, prop, NULL) != NULL))
-			fdt_setprop(fdt, off, prop, val, len);
+			fdt_batch_setprop(&batch, off, prop, val, len);
 		off = fdt_node_offset_by_compatible(fdt, off, compat);
 	}
+	fdt_batch_apply(&batch);
 }
 
 void do_fixup_by_compat_u32(void *fdt, const char *compat,
@@ -386,6 +394,336 @@ void do_fixup_by_compat_u32(void *fdt, const char *compat,
 	do_fixup_by_compat(fdt, compat, prop, &tmp, 4, create);
 }
 
+/**
+ * struct fdt_batch_edit - a property change waiting in a batch
+ *
+ * @node: Offset of the node, in the blob as it was when the batch started
+ * @seq: Order in which the edit was added, so new properties keep that order
+ * @name: Name of the property (points into @val's allocation)
+ * @val: Value of the property
+ * @len: Length of @val in bytes
+ */
+struct fdt_batch_edit {
+	int node;
+	int seq;
+	const char *name;
+	void *val;
+	int len;
+};
+
+void fdt_batch_init(struct fdt_batch *batch, void *blob)
+{
+	memset(batch, '\0', sizeof(*batch));
+	batch->blob = blob;
+}
+
+int fdt_batch_setprop(struct fdt_batch *batch, int node, const char *name,
+		      const void *val, int len)
+{
+	struct fdt_batch_edit *edit;
+	int oldlen, namelen, i;
+	const void *old;
+	void *buf;
+
+	if (batch->err)
+		return batch->err;
+
+	for (i = 0; i < batch->count; i++) {
+		edit = &batch->edit[i];
+		if (edit->node == node && !strcmp(edit->name, name))
+			break;
+	}
+
+	/* A property which keeps its size can be updated straight away */
+	if (i == batch->count) {
+		old = fdt_getprop(batch->blob, node, name, &oldlen);
+		if (old && oldlen == len)
+			return fdt_setprop_inplace(batch->blob, node, name, val,
+						   len);
+		if (!old && oldlen != -FDT_ERR_NOTFOUND)
+			return oldlen;
+	}
+
+	/* Allocate first, so that a failure leaves the batch as it was */
+	namelen = strlen(name) + 1;
+	buf = malloc(len + namelen);
+	if (!buf)
+		goto nomem;
+
+	if (i == batch->count) {
+		if (batch->count == batch->alloc) {
+			int alloc = batch->alloc ? batch->alloc * 2 : 16;
+
+			edit = realloc(batch->edit, alloc * sizeof(*edit));
+			if (!edit) {
+				free(buf);
+				goto nomem;
+			}
+			batch->edit = edit;
+			batch->alloc = alloc;
+		}
+		batch->count++;
+	} else {
+		free(batch->edit[i].val);
+	}
+
+	edit = &batch->edit[i];
+	edit->val = buf;
+	memcpy(edit->val, val, len);
+	edit->name = memcpy(edit->val + len, name, namelen);
+	edit->node = node;
+	edit->seq = i;
+	edit->len = len;
+
+	return 0;
+
+nomem:
+	batch->err = -FDT_ERR_NOSPACE;
+
+	return batch->err;
+}
+
+static int fdt_batch_cmp(const void *a, const void *b)
+{
+	const struct fdt_batch_edit *ea = a, *eb = b;
+
+	if (ea->node != eb->node)
+		return ea->node - eb->node;
+
+	return ea->seq - eb->seq;
+}
+
+/* Find the offset of a string in a strings block, or -1 */
+static int fdt_batch_find_string(const char *strtab, int size, const char *s)
+{
+	int len = strlen(s) + 1;
+	const char *p;
+
+	for (p = strtab; p + len <= strtab + size; p += strlen(p) + 1) {
+		if (!memcmp(p, s, len))
+			return p - strtab;
+	}
+
+	return -1;
+}
+
+/**
+ * fdt_batch_write_prop() - write a property into the new structure block
+ *
+ * @buf: Buffer holding the new blob
+ * @posp: Position to write at, updated on exit
+ * @end: End of @buf
+ * @nameoff: Offset of the property name in the strings block
+ * @val: Value of the property
+ * @len: Length of @val in bytes
+ * Return: 0 if OK, -FDT_ERR_NOSPACE if there is no room
+ */
+static int fdt_batch_write_prop(char *buf, int *posp, int end, int nameoff,
+				const void *val, int len)
+{
+	struct fdt_property *prop = (struct fdt_property *)(buf + *posp);
+	int size = sizeof(*prop) + ALIGN(len, FDT_TAGSIZE);
+
+	if (*posp + size > end)
+		return -FDT_ERR_NOSPACE;
+	prop->tag = cpu_to_fdt32(FDT_PROP);
+	prop->len = cpu_to_fdt32(len);
+	prop->nameoff = cpu_to_fdt32(nameoff);
+	memcpy(prop->data, val, len);
+	memset(prop->data + len, '\0', ALIGN(len, FDT_TAGSIZE) - len);
+	*posp += size;
+
+	return 0;
+}
+
+/**
+ * fdt_batch_rewrite() - apply the edits in a single pass over the blob
+ *
+ * This builds a new copy of the structure block with the changed properties
+ * in place and the new ones added at the end of each node's properties, then
+ * copies it back over the blob. The strings block follows, with any new
+ * property names added at the end. NOP tags are dropped along the way.
+ *
+ * @batch: Batch to apply, with the edits sorted by node offset
+ * @buf: Buffer of fdt_totalsize(blob) bytes to build the new blob in
+ * Return: 0 if OK, -ve FDT_ERR_... on error
+ */
+static int fdt_batch_rewrite(struct fdt_batch *batch, char *buf)
+{
+	const void *blob = batch->blob;
+	int struct_start = fdt_off_dt_struct(blob);
+	int size = fdt_totalsize(blob);
+	int offset, next, pos, i;
+	int strsize, strtab;
+	int first = 0, last = 0;	/* edits for the current node */
+	bool in_node = false;
+	uint32_t tag;
+	int ret;
+
+	/*
+	 * Leave room at the end of the buffer for the strings, which are
+	 * copied in afterwards
+	 */
+	strsize = fdt_size_dt_strings(blob);
+	for (i = 0; i < batch->count; i++)
+		strsize += strlen(batch->edit[i].name) + 1;
+	if (struct_start + strsize > size)
+		return -FDT_ERR_NOSPACE;
+	strtab = size - strsize;
+	memcpy(buf + strtab, blob + fdt_off_dt_strings(blob),
+	       fdt_size_dt_strings(blob));
+	strsize = fdt_size_dt_strings(blob);
+
+	memcpy(buf, blob, struct_start);
+	pos = struct_start;
+	for (offset = 0; ; offset = next) {
+		tag = fdt_next_tag(blob, offset, &next);
+		if (next < 0)
+			return next;
+
+		/* Add any new properties before the node's first subnode */
+		if (in_node && tag != FDT_PROP && tag != FDT_NOP) {
+			for (i = first; i < last; i++) {
+				struct fdt_batch_edit *edit = &batch->edit[i];
+				int nameoff;
+
+				if (edit->node < 0)
+					continue;
+				nameoff = fdt_batch_find_string(buf + strtab,
+								strsize,
+								edit->name);
+				if (nameoff < 0) {
+					nameoff = strsize;
+					strcpy(buf + strtab + strsize,
+					       edit->name);
+					strsize += strlen(edit->name) + 1;
+				}
+				ret = fdt_batch_write_prop(buf, &pos, strtab,
+							   nameoff, edit->val,
+							   edit->len);
+				if (ret)
+					return ret;
+			}
+			in_node = false;
+		}
+
+		switch (tag) {
+		case FDT_BEGIN_NODE:
+			if (last < batch->count &&
+			    batch->edit[last].node == offset) {
+				first = last;
+				while (last < batch->count &&
+				       batch->edit[last].node == offset)
+					last++;
+				in_node = true;
+			}
+			break;
+		case FDT_PROP:
+			if (in_node) {
+				const struct fdt_property *prop;
+				const char *name;
+
+				prop = fdt_offset_ptr(blob, offset,
+						      sizeof(*prop));
+				name = fdt_string(blob,
+						  fdt32_to_cpu(prop->nameoff));
+				for (i = first; i < last; i++) {
+					struct fdt_batch_edit *edit;
+
+					edit = &batch->edit[i];
+					if (edit->node < 0 ||
+					    strcmp(edit->name, name))
+						continue;
+					ret = fdt_batch_write_prop(buf, &pos,
+						strtab,
+						fdt32_to_cpu(prop->nameoff),
+						edit->val, edit->len);
+					if (ret)
+						return ret;
+					edit->node = -1;	/* done */
+					break;
+				}
+				if (i < last)
+					continue;
+			}
+			break;
+		case FDT_NOP:
+			continue;
+		case FDT_END_NODE:
+		case FDT_END:
+			break;
+		default:
+			return -FDT_ERR_BADSTRUCTURE;
+		}
+
+		/* Copy the tag as it is */
+		if (pos + next - offset > strtab)
+			return -FDT_ERR_NOSPACE;
+		memcpy(buf + pos, fdt_offset_ptr(blob, offset, next - offset),
+		       next - offset);
+		pos += next - offset;
+		if (tag == FDT_END)
+			break;
+	}
+
+	/* Every edit must have been for a node in the blob */
+	if (last != batch->count)
+		return -FDT_ERR_BADOFFSET;
+
+	/* Move the strings down to follow the structure block */
+	memmove(buf + pos, buf + strtab, strsize);
+	memcpy(batch->blob, buf, pos + strsize);
+	fdt_set_off_dt_strings(batch->blob, pos);
+	fdt_set_size_dt_struct(batch->blob, pos - struct_start);
+	fdt_set_size_dt_strings(batch->blob, strsize);
+
+	return 0;
+}
+
+int fdt_batch_apply(struct fdt_batch *batch)
+{
+	void *blob = batch->blob;
+	char *buf = NULL;
+	int ret = batch->err;
+	int i;
+
+	if (ret || !batch->count)
+		goto out;
+
+	qsort(batch->edit, batch->count, sizeof(*batch->edit), fdt_batch_cmp);
+
+	/*
+	 * A single pass needs a buffer and a blob with the usual block order
+	 * (as left by fdt_open_into()). Otherwise fall back to fdt_setprop(),
+	 * working from the end of the blob so the offsets stay valid.
+	 */
+	if (batch->count > 1 && fdt_version(blob) >= 17 &&
+	    fdt_off_dt_struct(blob) + fdt_size_dt_struct(blob) <=
+	    fdt_off_dt_strings(blob))
+		buf = malloc(fdt_totalsize(blob));
+	if (buf) {
+		ret = fdt_batch_rewrite(batch, buf);
+		free(buf);
+	} else {
+		for (i = batch->count - 1; i >= 0; i--) {
+			struct fdt_batch_edit *edit = &batch->edit[i];
+
+			ret = fdt_setprop(blob, edit->node, edit->name,
+					  edit->val, edit->len);
+			if (ret)
+				break;
+		}
+	}
+
+out:
+	for (i = 0; i < batch->count; i++)
+		free(batch->edit[i].val);
+	free(batch->edit);
+	fdt_batch_init(batch, blob);
+
+	return ret;
+}
+
 #ifdef CONFIG_ARCH_FIXUP_FDT_MEMORY
 /*
  * fdt_pack_reg - pack address and size array into the "reg"-suitable stream
@@ -534,34 +872,29 @@ int fdt_fixup_memory(void *blob, u64 start, u64 size)
 
 void fdt_fixup_ethernet(void *fdt)
 {
-	int i = 0, j, prop;
+	int i = 0, j, ret;
 	char *tmp, *end;
 	char mac[16];
 	const char *path;
 	unsigned char mac_addr[ARP_HLEN];
-	int offset;
-#ifdef FDT_SEQ_MACADDR_FROM_ENV
+	struct fdt_batch batch;
+	int aliases, offset;
 	int nodeoff;
+#ifdef FDT_SEQ_MACADDR_FROM_ENV
 	const struct fdt_property *fdt_prop;
 #endif
 
-	if (fdt_path_offset(fdt, "/aliases") < 0)
+	aliases = fdt_path_offset(fdt, "/aliases");
+	if (aliases < 0)
 		return;
 
+	/* The changes are batched, so the offsets stay valid until the end */
+	fdt_batch_init(&batch, fdt);
+
 	/* Cycle through all aliases */
-	for (prop = 0; ; prop++) {
+	fdt_for_each_property_offset(offset, fdt, aliases) {
 		const char *name;
 
-		/* FDT might have been edited, recompute the offset */
-		offset = fdt_first_property_offset(fdt,
-			fdt_path_offset(fdt, "/aliases"));
-		/* Select property number 'prop' */
-		for (j = 0; j < prop; j++)
-			offset = fdt_next_property_offset(fdt, offset);
-
-		if (offset < 0)
-			break;
-
 		path = fdt_getprop_by_offset(fdt, offset, &name, NULL);
 		if (!strncmp(name, "ethernet", 8)) {
 			/* Treat plain "ethernet" same as "ethernet0". */
@@ -583,8 +916,8 @@ void fdt_fixup_ethernet(void *fdt)
 			} else {
 				continue;
 			}
-#ifdef FDT_SEQ_MACADDR_FROM_ENV
 			nodeoff = fdt_path_offset(fdt, path);
+#ifdef FDT_SEQ_MACADDR_FROM_ENV
 			fdt_prop = fdt_get_property(fdt, nodeoff, "status",
 						    NULL);
 			if (fdt_prop && !strcmp(fdt_prop->data, "disabled"))
@@ -602,12 +935,21 @@ void fdt_fixup_ethernet(void *fdt)
 					tmp = (*end) ? end + 1 : end;
 			}
 
-			do_fixup_by_path(fdt, path, "mac-address",
-					 &mac_addr, 6, 0);
-			do_fixup_by_path(fdt, path, "local-mac-address",
-					 &mac_addr, 6, 1);
+			/* Skip aliases to nodes which are not present */
+			if (nodeoff < 0)
+				continue;
+			if (fdt_get_property(fdt, nodeoff, "mac-address", NULL))
+				fdt_batch_setprop(&batch, nodeoff,
+						  "mac-address", mac_addr, 6);
+			fdt_batch_setprop(&batch, nodeoff, "local-mac-address",
+					  mac_addr, 6);
 		}
 	}
+
+	ret = fdt_batch_apply(&batch);
+	if (ret)
+		printf("Unable to update MAC addresses, err=%s\n",
+		       fdt_strerror(ret));
 }
 
 int fdt_record_loadable(void *blob, u32 index, const char *name,
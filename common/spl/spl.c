@@ -10,6 +10,7 @@
 #include <bloblist.h>
 #include <binman_sym.h>
 #include <bootstage.h>
+#include <bootstage_timeline.h>
 #include <dm.h>
 #include <handoff.h>
 #include <hang.h>
@@ -820,6 +821,9 @@ void board_init_r(gd_t *dummy1, ulong dummy2)
 	if (ret)
 		debug("Failed to stash bootstage: err=%d\n", ret);
 #endif
+	ret = bootstage_timeline_flush();
+	if (ret)
+		debug("Failed to flush bootstage timeline: err=%d\n", ret);
 
 	spl_board_prepare_for_boot();
 	jump_to_image_no_args(&spl_image);
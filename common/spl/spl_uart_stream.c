@@ -0,0 +1,473 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Loading images over the console UART with the stream protocol
+ *
+ * Unlike YMODEM, which waits for an acknowledgement after every 1KB block,
+ * data is streamed in large frames which are only acknowledged once per
+ * window. The baud rate is raised to the fastest the UART supports and the
+ * payload may be LZ4-compressed. See uart_stream.h for the protocol and
+ * tools/uartboot.c for the sender.
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <errno.h>
+#include <image.h>
+#include <log.h>
+#include <serial.h>
+#include <spl.h>
+#include <uart_stream.h>
+#include <watchdog.h>
+#include <asm/global_data.h>
+#include <linux/delay.h>
+#include <linux/libfdt.h>
+#include <u-boot/crc.h>
+#include <u-boot/lz4.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Time allowed between two bytes of the same frame */
+#define USTREAM_BYTE_MS		100
+
+/* Time to wait for the next data frame before asking for it again */
+#define USTREAM_DATA_MS		500
+#define USTREAM_DATA_TRIES	10
+
+/*
+ * The payload is checked in pieces this size as it arrives, so that the
+ * receive FIFO does not overflow at high baud rates while a whole frame is
+ * being checked
+ */
+#define USTREAM_CRC_CHUNK	64
+
+/**
+ * struct ustream - state of a transfer
+ *
+ * @dev: Serial device being used (the console)
+ * @ops: Its operations
+ * @baud: Baud rate it is set to
+ * @crc: CRC32 of the current frame so far
+ */
+struct ustream {
+	struct udevice *dev;
+	struct dm_serial_ops *ops;
+	uint baud;
+	u32 crc;
+};
+
+static int us_getc(struct ustream *us, ulong timeout_ms)
+{
+	bool waiting = false;
+	ulong start = 0;
+	int ch;
+
+	for (;;) {
+		ch = us->ops->getc(us->dev);
+		if (ch != -EAGAIN)
+			return ch;
+		if (!waiting) {
+			start = get_timer(0);
+			waiting = true;
+		} else if (get_timer(start) > timeout_ms) {
+			return -ETIMEDOUT;
+		}
+		WATCHDOG_RESET();
+	}
+}
+
+static int us_read(struct ustream *us, u8 *buf, uint len)
+{
+	int ch;
+
+	while (len--) {
+		ch = us_getc(us, USTREAM_BYTE_MS);
+		if (ch < 0)
+			return ch;
+		if (buf)
+			*buf++ = ch;
+	}
+
+	return 0;
+}
+
+static void us_write(struct ustream *us, const u8 *buf, uint len)
+{
+	while (len--) {
+		while (us->ops->putc(us->dev, *buf) == -EAGAIN)
+			;
+		buf++;
+	}
+}
+
+static void us_send(struct ustream *us, enum ustream_type type, u32 arg)
+{
+	struct ustream_hdr hdr = {
+		.magic = cpu_to_le32(USTREAM_MAGIC),
+		.type = type,
+		.arg = cpu_to_le32(arg),
+	};
+
+	hdr.crc = cpu_to_le32(crc32(0, (u8 *)&hdr,
+				    offsetof(struct ustream_hdr, crc)));
+	us_write(us, (u8 *)&hdr, sizeof(hdr));
+}
+
+/**
+ * us_recv_hdr() - receive the header of the next frame
+ *
+ * Anything before the magic number is skipped. The header is converted to
+ * CPU byte order. The caller must then call us_recv_data() for the payload,
+ * which also checks the CRC.
+ *
+ * @us: Transfer state
+ * @hdr: Returns the header
+ * @timeout_ms: Time to wait for the start of a frame
+ * Return: 0 if OK, -ETIMEDOUT if no frame arrived, -EBADMSG if the header
+ *	is not valid
+ */
+static int us_recv_hdr(struct ustream *us, struct ustream_hdr *hdr,
+		       ulong timeout_ms)
+{
+	ulong start = get_timer(0);
+	u32 magic = 0;
+	int ch, ret;
+
+	do {
+		ch = us_getc(us, timeout_ms);
+		if (ch < 0)
+			return ch;
+		magic = magic >> 8 | (u32)ch << 24;
+		if (magic != USTREAM_MAGIC && get_timer(start) > timeout_ms)
+			return -ETIMEDOUT;
+	} while (magic != USTREAM_MAGIC);
+
+	hdr->magic = cpu_to_le32(magic);
+	ret = us_read(us, (u8 *)hdr + sizeof(magic),
+		      sizeof(*hdr) - sizeof(magic));
+	if (ret)
+		return ret;
+	us->crc = crc32(0, (u8 *)hdr, offsetof(struct ustream_hdr, crc));
+	hdr->len = le16_to_cpu(hdr->len);
+	hdr->arg = le32_to_cpu(hdr->arg);
+	hdr->crc = le32_to_cpu(hdr->crc);
+	if (hdr->len > USTREAM_BLOCK)
+		return -EBADMSG;
+
+	return 0;
+}
+
+/**
+ * us_recv_data() - receive the payload of a frame
+ *
+ * @us: Transfer state
+ * @hdr: Header returned by us_recv_hdr()
+ * @buf: Place to put the payload, or NULL to drop it without checking it
+ * Return: 0 if OK, -ETIMEDOUT if the payload did not arrive, -EBADMSG if
+ *	the CRC does not match
+ */
+static int us_recv_data(struct ustream *us, const struct ustream_hdr *hdr,
+			u8 *buf)
+{
+	uint pos, len;
+	int ret;
+
+	if (!buf)
+		return us_read(us, NULL, hdr->len);
+
+	for (pos = 0; pos < hdr->len; pos += len) {
+		len = min_t(uint, hdr->len - pos, USTREAM_CRC_CHUNK);
+		ret = us_read(us, buf + pos, len);
+		if (ret)
+			return ret;
+		us->crc = crc32(us->crc, buf + pos, len);
+	}
+
+	return us->crc == hdr->crc ? 0 : -EBADMSG;
+}
+
+/* Drop the payload of a frame, checking it if it is small */
+static int us_skip_data(struct ustream *us, const struct ustream_hdr *hdr)
+{
+	u8 buf[sizeof(struct ustream_start)];
+
+	if (hdr->len > sizeof(buf))
+		return us_recv_data(us, hdr, NULL);
+
+	return us_recv_data(us, hdr, buf);
+}
+
+static void us_set_baud(struct ustream *us, uint baud)
+{
+	int ret;
+
+	/* Let the last frame go out at the old rate */
+	if (us->ops->pending) {
+		while (us->ops->pending(us->dev, false) > 0)
+			;
+	}
+	udelay(20 * 1000000 / us->baud + 1);
+
+	ret = us->ops->setbrg(us->dev, baud);
+	if (ret)
+		log_debug("Cannot set baud rate %u (err=%d)\n", baud, ret);
+	else
+		us->baud = baud;
+}
+
+static uint us_max_baud(struct ustream *us)
+{
+	struct serial_device_info info;
+
+	if (serial_getinfo(us->dev, &info) || !info.clock)
+		return 0;
+
+	return info.clock / 16;
+}
+
+/* Wait for the sender to confirm the new baud rate */
+static int us_sync(struct ustream *us)
+{
+	ulong start = get_timer(0);
+	struct ustream_hdr hdr;
+	int ret;
+
+	while (get_timer(start) < USTREAM_SYNC_MS) {
+		ret = us_recv_hdr(us, &hdr, USTREAM_SYNC_MS);
+		if (!ret)
+			ret = us_skip_data(us, &hdr);
+		if (!ret && hdr.type == USTREAM_SYNC) {
+			us_send(us, USTREAM_ACK, 0);
+			return 0;
+		}
+	}
+
+	return -ETIMEDOUT;
+}
+
+static bool us_check_start(const struct ustream_start *start)
+{
+	if (!start->size || start->size > CONFIG_SPL_UART_STREAM_SIZE)
+		return false;
+	if (start->flags & ~USTREAM_F_LZ4)
+		return false;
+	if ((start->flags & USTREAM_F_LZ4) && !IS_ENABLED(CONFIG_SPL_LZ4))
+		return false;
+
+	return true;
+}
+
+/**
+ * us_handshake() - wait for a sender and agree the baud rate
+ *
+ * @us: Transfer state
+ * @start: Returns the description of the payload, in CPU byte order
+ * Return: 0 if OK, -ETIMEDOUT if no sender appeared within
+ *	CONFIG_SPL_UART_STREAM_WAIT seconds
+ */
+static int us_handshake(struct ustream *us, struct ustream_start *start)
+{
+	uint old_baud = us->baud, max_baud = us_max_baud(us);
+	ulong wait = get_timer(0);
+	struct ustream_hdr hdr;
+	uint baud;
+	int ret;
+
+	for (;;) {
+		if (CONFIG_SPL_UART_STREAM_WAIT &&
+		    get_timer(wait) > CONFIG_SPL_UART_STREAM_WAIT * 1000)
+			return -ETIMEDOUT;
+		us_send(us, USTREAM_HELLO, max_baud);
+		ret = us_recv_hdr(us, &hdr, USTREAM_HELLO_MS);
+		if (ret)
+			continue;
+		if (hdr.type != USTREAM_START || hdr.len != sizeof(*start)) {
+			us_skip_data(us, &hdr);
+			continue;
+		}
+		if (us_recv_data(us, &hdr, (u8 *)start))
+			continue;
+		start->size = le32_to_cpu(start->size);
+		start->crc = le32_to_cpu(start->crc);
+		start->flags = le32_to_cpu(start->flags);
+		if (!us_check_start(start)) {
+			us_send(us, USTREAM_NAK, 0);
+			continue;
+		}
+
+		baud = hdr.arg;
+		if (!baud || baud > max_baud)
+			baud = old_baud;
+		us_send(us, USTREAM_ACK, baud);
+		if (baud == old_baud)
+			return 0;
+
+		us_set_baud(us, baud);
+		if (us->baud == old_baud || !us_sync(us))
+			return 0;
+
+		/* The sender did not follow, so start again */
+		us_set_baud(us, old_baud);
+		wait = get_timer(0);
+	}
+}
+
+/**
+ * us_receive() - receive the payload
+ *
+ * @us: Transfer state
+ * @start: Description of the payload
+ * @buf: Place to put it
+ * Return: 0 if OK, -ETIMEDOUT if the sender stopped, -EIO if the payload
+ *	CRC does not match
+ */
+static int us_receive(struct ustream *us, const struct ustream_start *start,
+		      u8 *buf)
+{
+	ulong pos = 0, acked = 0, seen = 0, size = start->size;
+	struct ustream_hdr hdr;
+	bool nak_sent = false;
+	int tries = 0;
+	int ret;
+
+	while (pos < size) {
+		ret = us_recv_hdr(us, &hdr, USTREAM_DATA_MS);
+		if (!ret && hdr.type == USTREAM_DATA) {
+			/* The sender went back, so ask again if still wrong */
+			if (hdr.arg <= seen)
+				nak_sent = false;
+			seen = hdr.arg;
+		}
+		if (!ret && hdr.type == USTREAM_DATA && hdr.arg == pos &&
+		    hdr.len <= size - pos) {
+			ret = us_recv_data(us, &hdr, buf + pos);
+			if (!ret) {
+				pos += hdr.len;
+				tries = 0;
+				nak_sent = false;
+				if (pos - acked >= USTREAM_WINDOW / 2 &&
+				    pos < size) {
+					us_send(us, USTREAM_ACK, pos);
+					acked = pos;
+				}
+				continue;
+			}
+		} else if (!ret) {
+			ret = us_skip_data(us, &hdr);
+			/* Our ACK of the baud rate change was lost */
+			if (!ret && hdr.type == USTREAM_SYNC) {
+				us_send(us, USTREAM_ACK, pos);
+				continue;
+			}
+			/* Data sent again after going back, or stray frames */
+			if (!ret && (hdr.type != USTREAM_DATA || hdr.arg < pos))
+				continue;
+		}
+
+		/* Something was lost, so ask for it once per pass */
+		if (ret == -ETIMEDOUT) {
+			if (++tries > USTREAM_DATA_TRIES)
+				return ret;
+			nak_sent = false;
+		}
+		if (!nak_sent) {
+			us_send(us, USTREAM_NAK, pos);
+			nak_sent = true;
+		}
+	}
+
+	if (crc32(0, buf, size) != start->crc) {
+		us_send(us, USTREAM_NAK, size);
+		return -EIO;
+	}
+	us_send(us, USTREAM_ACK, size);
+
+	return 0;
+}
+
+static ulong us_load_read(struct spl_load_info *load, ulong offset,
+			  ulong size, void *buf)
+{
+	memcpy(buf, load->priv + offset, size);
+
+	return size;
+}
+
+static int us_load(struct spl_image_info *spl_image, void *addr, ulong size)
+{
+	struct image_header *header = addr;
+	struct spl_load_info load;
+	int ret;
+
+	load.priv = addr;
+	load.bl_len = 1;
+	load.read = us_load_read;
+
+	if (IS_ENABLED(CONFIG_SPL_LOAD_FIT) &&
+	    image_get_magic(header) == FDT_MAGIC)
+		return spl_load_simple_fit(spl_image, &load, 0, header);
+	if (IS_ENABLED(CONFIG_SPL_LEGACY_IMAGE_SUPPORT) &&
+	    image_get_magic(header) == IH_MAGIC)
+		return spl_load_legacy_img(spl_image, &load, 0);
+
+	ret = spl_parse_image_header(spl_image, header);
+	if (ret)
+		return ret;
+
+	/* A full FIT is loaded in place, anything else is copied as it is */
+	if (image_get_magic(header) != FDT_MAGIC &&
+	    spl_image->load_addr != (ulong)addr)
+		memmove((void *)spl_image->load_addr, addr, size);
+
+	return 0;
+}
+
+static int spl_uart_stream_load_image(struct spl_image_info *spl_image,
+				      struct spl_boot_device *bootdev)
+{
+	void *addr = (void *)CONFIG_SPL_UART_STREAM_ADDR;
+	struct ustream_start start;
+	struct ustream us;
+	size_t size;
+	u8 *buf;
+	int ret;
+
+	us.dev = gd->cur_serial_dev;
+	if (!us.dev)
+		return -ENODEV;
+	us.ops = serial_get_ops(us.dev);
+	us.baud = gd->baudrate;
+
+	ret = us_handshake(&us, &start);
+	if (ret == -ETIMEDOUT && IS_ENABLED(CONFIG_SPL_YMODEM_SUPPORT)) {
+		puts("No UART stream sender, trying YMODEM\n");
+		return spl_ymodem_load_image(spl_image, bootdev);
+	}
+	if (ret)
+		return ret;
+
+	/* Compressed data goes after the space for the image */
+	buf = addr;
+	if (start.flags & USTREAM_F_LZ4)
+		buf += CONFIG_SPL_UART_STREAM_SIZE;
+	ret = us_receive(&us, &start, buf);
+	if (us.baud != gd->baudrate)
+		us_set_baud(&us, gd->baudrate);
+	if (ret) {
+		printf("UART stream failed (err=%d)\n", ret);
+		return ret;
+	}
+	debug("Received %x bytes at %p\n", start.size, buf);
+
+	size = start.size;
+	if (start.flags & USTREAM_F_LZ4) {
+		size = CONFIG_SPL_UART_STREAM_SIZE;
+		ret = ulz4fn(buf, start.size, addr, &size);
+		if (ret) {
+			printf("LZ4 decompression failed (err=%d)\n", ret);
+			return ret;
+		}
+	}
+
+	return us_load(spl_image, addr, size);
+}
+SPL_LOAD_IMAGE_METHOD("UART", 0, BOOT_DEVICE_UART, spl_uart_stream_load_image);
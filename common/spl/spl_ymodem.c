@@ -178,4 +178,7 @@ end_stream:
 
 	return ret;
 }
+/* The stream protocol falls back to YMODEM itself */
+#if !CONFIG_IS_ENABLED(UART_STREAM)
 SPL_LOAD_IMAGE_METHOD("UART", 0, BOOT_DEVICE_UART, spl_ymodem_load_image);
+#endif
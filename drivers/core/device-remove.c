@@ -254,6 +254,7 @@ int device_remove(struct udevice *dev, uint flags)
 	device_free(dev);
 
 	dev_bic_flags(dev, DM_FLAG_ACTIVATED);
+	dm_stats_add(dev, remove_count, 1);
 
 	return 0;
 
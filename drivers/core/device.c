@@ -9,6 +9,8 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
+#include <bootstage_timeline.h>
 #include <cpu_func.h>
 #include <log.h>
 #include <asm/global_data.h>
@@ -32,9 +34,35 @@
 #include <linux/err.h>
 #include <linux/list.h>
 #include <power-domain.h>
+#include <time.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* Depth of nested device_probe() calls, for the bootstage accumulator */
+static int probe_depth __section(".data");
+
+/**
+ * dm_probe_ticks() - read the timer for probe timing
+ *
+ * Reading a driver-model timer before it is set up would probe it, which
+ * would recurse back into device_probe(). Avoid that by returning 0 until
+ * the timer is ready; callers ignore intervals which start at 0.
+ *
+ * Return: current timer value, or 0 if timing is not needed or not possible
+ */
+static u64 dm_probe_ticks(void)
+{
+	if (!CONFIG_IS_ENABLED(DM_STATS) &&
+	    !CONFIG_IS_ENABLED(BOOTSTAGE_TIMELINE))
+		return 0;
+#if CONFIG_IS_ENABLED(TIMER) && !defined(CONFIG_TIMER_EARLY)
+	if (!gd->timer)
+		return 0;
+#endif
+
+	return get_ticks();
+}
+
 static int device_bind_common(struct udevice *parent, const struct driver *drv,
 			      const char *name, void *plat,
 			      ulong driver_data, ofnode node,
@@ -363,6 +391,7 @@ static int device_alloc_priv(struct udevice *dev)
 		if (!ptr)
 			return -ENOMEM;
 		dev_set_priv(dev, ptr);
+		dm_stats_add(dev, priv_bytes, drv->priv_auto);
 	}
 
 	/* Allocate private data if requested and not reentered */
@@ -372,6 +401,7 @@ static int device_alloc_priv(struct udevice *dev)
 		if (!ptr)
 			return -ENOMEM;
 		dev_set_uclass_priv(dev, ptr);
+		dm_stats_add(dev, priv_bytes, size);
 	}
 
 	/* Allocate parent data for this child */
@@ -384,6 +414,7 @@ static int device_alloc_priv(struct udevice *dev)
 			if (!ptr)
 				return -ENOMEM;
 			dev_set_parent_priv(dev, ptr);
+			dm_stats_add(dev, priv_bytes, size);
 		}
 	}
 
@@ -431,7 +462,17 @@ int device_of_to_plat(struct udevice *dev)
 
 	if (drv->of_to_plat &&
 	    (CONFIG_IS_ENABLED(OF_PLATDATA) || dev_has_ofnode(dev))) {
+		u64 start = dm_probe_ticks();
+
+		if (CONFIG_IS_ENABLED(DM_STATS))
+			bootstage_start(BOOTSTAGE_ID_ACCUM_DM_OF_TO_PLAT,
+					"dm_of_to_plat");
 		ret = drv->of_to_plat(dev);
+		if (CONFIG_IS_ENABLED(DM_STATS))
+			bootstage_accum(BOOTSTAGE_ID_ACCUM_DM_OF_TO_PLAT);
+		if (start)
+			dm_stats_add(dev, of_to_plat_ticks,
+				     dm_probe_ticks() - start);
 		if (ret)
 			goto fail;
 	}
@@ -485,6 +526,8 @@ static int device_get_dma_constraints(struct udevice *dev)
 int device_probe(struct udevice *dev)
 {
 	const struct driver *drv;
+	bool counted = false;
+	u64 start = 0;
 	int ret;
 
 	if (!dev)
@@ -516,6 +559,14 @@ int device_probe(struct udevice *dev)
 			return 0;
 	}
 
+	start = dm_probe_ticks();
+	if (CONFIG_IS_ENABLED(DM_STATS)) {
+		/* Only count the outermost probe, to avoid double-counting */
+		if (!probe_depth++)
+			bootstage_start(BOOTSTAGE_ID_ACCUM_DM_PROBE,
+					"dm_probe");
+		counted = true;
+	}
 	dev_or_flags(dev, DM_FLAG_ACTIVATED);
 
 	/*
@@ -589,6 +640,18 @@ int device_probe(struct udevice *dev)
 	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
 		pinctrl_select_state(dev, "default");
 
+	if (counted && !--probe_depth)
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_DM_PROBE);
+	dm_stats_add(dev, probe_count, 1);
+	if (start) {
+		u64 end = dm_probe_ticks();
+
+		dm_stats_add(dev, probe_ticks, end - start);
+		if (CONFIG_IS_ENABLED(BOOTSTAGE_TIMELINE))
+			bootstage_timeline_add(BOOTSTAGE_TL_DEVICE, dev->name,
+					       start, end);
+	}
+
 	return 0;
 fail_uclass:
 	if (device_remove(dev, DM_REMOVE_NORMAL)) {
@@ -596,6 +659,8 @@ fail_uclass:
 			__func__, dev->name);
 	}
 fail:
+	if (counted && !--probe_depth)
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_DM_PROBE);
 	dev_bic_flags(dev, DM_FLAG_ACTIVATED);
 
 	device_free(dev);
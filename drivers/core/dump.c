@@ -5,22 +5,52 @@
 
 #include <common.h>
 #include <dm.h>
+#include <div64.h>
+#include <fdtdec.h>
 #include <mapmem.h>
+#include <time.h>
 #include <dm/root.h>
 #include <dm/util.h>
 #include <dm/uclass-internal.h>
 
-static void show_devices(struct udevice *dev, int depth, int last_flag)
+#if CONFIG_IS_ENABLED(DM_STATS)
+static ulong ticks_to_us(u64 ticks)
+{
+	return lldiv(ticks * 1000000, get_tbclk());
+}
+
+static void show_stats(const struct dm_stats *stats)
+{
+	printf(" %6u %6u %9lu %9lu %7lu  ", stats->probe_count,
+	       stats->remove_count, ticks_to_us(stats->of_to_plat_ticks),
+	       ticks_to_us(stats->probe_ticks), stats->priv_bytes);
+}
+#endif
+
+static void show_device_info(struct udevice *dev, bool stats)
 {
-	int i, is_last;
-	struct udevice *child;
 	u32 flags = dev_get_flags(dev);
 
+#if CONFIG_IS_ENABLED(DM_STATS)
+	if (stats) {
+		show_stats(&dev->stats);
+		return;
+	}
+#endif
 	/* print the first 20 characters to not break the tree-format. */
 	printf(IS_ENABLED(CONFIG_SPL_BUILD) ? " %s  %d  [ %c ]   %s  " :
 	       " %-10.10s  %3d  [ %c ]   %-20.20s  ", dev->uclass->uc_drv->name,
 	       dev_get_uclass_index(dev, NULL),
 	       flags & DM_FLAG_ACTIVATED ? '+' : ' ', dev->driver->name);
+}
+
+static void show_devices(struct udevice *dev, int depth, int last_flag,
+			 bool stats)
+{
+	int i, is_last;
+	struct udevice *child;
+
+	show_device_info(dev, stats);
 
 	for (i = depth; i >= 0; i--) {
 		is_last = (last_flag >> i) & 1;
@@ -41,7 +71,8 @@ static void show_devices(struct udevice *dev, int depth, int last_flag)
 
 	list_for_each_entry(child, &dev->child_head, sibling_node) {
 		is_last = list_is_last(&child->sibling_node, &dev->child_head);
-		show_devices(child, depth + 1, (last_flag << 1) | is_last);
+		show_devices(child, depth + 1, (last_flag << 1) | is_last,
+			     stats);
 	}
 }
 
@@ -53,9 +84,60 @@ void dm_dump_all(void)
 	if (root) {
 		printf(" Class     Index  Probed  Driver                Name\n");
 		printf("-----------------------------------------------------------\n");
-		show_devices(root, -1, 0);
+		show_devices(root, -1, 0, false);
+	}
+}
+
+#if CONFIG_IS_ENABLED(DM_STATS)
+void dm_dump_stats(void)
+{
+	struct udevice *root;
+
+	root = dm_root();
+	if (root) {
+		printf(" Probes Removes  ToPlat us  Probe us    Priv  Name\n");
+		printf("-----------------------------------------------------------\n");
+		show_devices(root, -1, 0, true);
+	}
+}
+
+void dm_dump_uclass_stats(void)
+{
+	struct dm_stats total = {};
+	struct uclass *uc;
+	int ret;
+	int id;
+
+	printf(" Probes Removes  ToPlat us  Probe us    Priv  Uclass\n");
+	printf("-----------------------------------------------------------\n");
+	for (id = 0; id < UCLASS_COUNT; id++) {
+		ret = uclass_get(id, &uc);
+		if (ret || !uc->stats.probe_count)
+			continue;
+		show_stats(&uc->stats);
+		printf("%s\n", uc->uc_drv->name);
+		total.probe_count += uc->stats.probe_count;
+		total.remove_count += uc->stats.remove_count;
+		total.of_to_plat_ticks += uc->stats.of_to_plat_ticks;
+		total.probe_ticks += uc->stats.probe_ticks;
+		total.priv_bytes += uc->stats.priv_bytes;
+	}
+	printf("-----------------------------------------------------------\n");
+	show_stats(&total);
+	printf("(total)\n");
+
+	if (CONFIG_IS_ENABLED(OF_CONTROL) && !of_live_active()) {
+		struct fdtdec_index_stats fstats;
+
+		fdtdec_get_index_stats(&fstats);
+		printf("\nFDT lookups: %u by path (%u indexed), ",
+		       fstats.path_lookups, fstats.path_hits);
+		printf("%u by phandle (%u indexed), %u index builds\n",
+		       fstats.phandle_lookups, fstats.phandle_hits,
+		       fstats.builds);
 	}
 }
+#endif
 
 /**
  * dm_display_line() - Display information about a single device
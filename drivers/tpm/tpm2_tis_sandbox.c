@@ -38,7 +38,7 @@ enum tpm2_cap_tpm_property {
 	TPM2_PROPERTY_NB,
 };
 
-#define SANDBOX_TPM_PCR_NB 1
+#define SANDBOX_TPM_PCR_NB TPM2_MAX_PCRS
 
 /*
  * Information about our TPM emulation. This is preserved in the sandbox
@@ -188,6 +188,9 @@ static int sandbox_tpm2_write_state(void *blob, int node)
 	for (i = 0; i < SANDBOX_TPM_PCR_NB; i++) {
 		int subnode;
 
+		/* Unused PCRs are all zeroes, so leave them out */
+		if (!state->pcr_extensions[i])
+			continue;
 		snprintf(prop_name, sizeof(prop_name), "pcr%d", i);
 		subnode = fdt_add_subnode(blob, node, prop_name);
 		fdt_setprop(blob, subnode, "value", state->pcr[i],
@@ -692,6 +695,7 @@ static int sandbox_tpm2_xfer(struct udevice *dev, const u8 *sendbuf,
 			printf("Invalid index %d, sandbox TPM handles up to %d PCR(s)\n",
 			       pcr_index, SANDBOX_TPM_PCR_NB);
 			rc = TPM2_RC_VALUE;
+			return sandbox_tpm2_fill_buf(recv, recv_len, tag, rc);
 		}
 
 		/* Check the number of hashes */
@@ -288,6 +288,34 @@ int env_set_default_vars(int nvars, char * const vars[], int flags)
 				flags, 0, nvars, vars);
 }
 
+/* CRC of the environment in storage, if env_stored_valid is true */
+static u32 env_stored_crc;
+static bool env_stored_valid;
+
+void env_set_stored(const u32 *crc)
+{
+	env_stored_valid = crc != NULL;
+	if (crc)
+		env_stored_crc = *crc;
+}
+
+int env_is_stored(u32 *crcp)
+{
+	char *res;
+
+	res = malloc(ENV_SIZE);
+	if (!res)
+		return -ENOMEM;
+	if (hexport_r(&env_htab, '\0', 0, &res, ENV_SIZE, 0, NULL) < 0) {
+		free(res);
+		return -EIO;
+	}
+	*crcp = crc32(0, (uchar *)res, ENV_SIZE);
+	free(res);
+
+	return env_stored_valid && *crcp == env_stored_crc;
+}
+
 /*
  * Check if CRC is valid and (if yes) import the environment.
  * Note that "buf" may or may not be aligned.
@@ -310,6 +338,14 @@ int env_import(const char *buf, int check, int flags)
 	if (himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0', flags, 0,
 			0, NULL)) {
 		gd->flags |= GD_FLG_ENV_READY;
+		if (check) {
+			uint32_t crc;
+
+			memcpy(&crc, &ep->crc, sizeof(crc));
+			env_set_stored(&crc);
+		} else {
+			env_set_stored(NULL);
+		}
 		return 0;
 	}
 
@@ -374,7 +410,8 @@ int env_import_redund(const char *buf1, int buf1_read_fail,
 		      const char *buf2, int buf2_read_fail,
 		      int flags)
 {
-	env_t *ep;
+	env_t *ep, *other;
+	int other_fail;
 	int ret;
 
 	ret = env_check_redund(buf1, buf1_read_fail, buf2, buf2_read_fail);
@@ -387,14 +424,36 @@ int env_import_redund(const char *buf1, int buf1_read_fail,
 		return -ENOMSG;
 	}
 
-	if (gd->env_valid == ENV_VALID)
+	if (gd->env_valid == ENV_VALID) {
 		ep = (env_t *)buf1;
-	else
+		other = (env_t *)buf2;
+		other_fail = buf2_read_fail;
+	} else {
 		ep = (env_t *)buf2;
+		other = (env_t *)buf1;
+		other_fail = buf1_read_fail;
+	}
 
 	env_flags = ep->flags;
 
-	return env_import((char *)ep, 0, flags);
+	ret = env_import((char *)ep, 0, flags);
+
+	/*
+	 * Only skip saving an unchanged environment if both copies are good,
+	 * so that the next save still repairs a bad copy
+	 */
+	if (!ret && !other_fail) {
+		uint32_t crc;
+
+		/* As in env_import(), the buffers may not be aligned */
+		memcpy(&crc, &other->crc, sizeof(crc));
+		if (crc32(0, other->data, ENV_SIZE) == crc) {
+			memcpy(&crc, &ep->crc, sizeof(crc));
+			env_set_stored(&crc);
+		}
+	}
+
+	return ret;
 }
 #endif /* CONFIG_SYS_REDUNDAND_ENVIRONMENT */
 
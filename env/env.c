@@ -254,6 +254,8 @@ int env_save(void)
 
 	drv = env_driver_lookup(ENVOP_SAVE, gd->env_load_prio);
 	if (drv) {
+		int stored = -ENOSYS;
+		u32 crc;
 		int ret;
 
 		printf("Saving Environment to %s... ", drv->name);
@@ -267,11 +269,20 @@ int env_save(void)
 			return -ENODEV;
 		}
 
+		if (IS_ENABLED(CONFIG_ENV_SAVE_SKIP_UNCHANGED)) {
+			stored = env_is_stored(&crc);
+			if (stored > 0) {
+				printf("unchanged\n");
+				return 0;
+			}
+		}
+
 		ret = drv->save();
 		if (ret)
 			printf("Failed (%d)\n", ret);
 		else
 			printf("OK\n");
+		env_set_stored(!ret && !stored ? &crc : NULL);
 
 		if (!ret)
 			return 0;
@@ -296,6 +307,7 @@ int env_erase(void)
 
 		printf("Erasing Environment on %s... ", drv->name);
 		ret = drv->erase();
+		env_set_stored(NULL);
 		if (ret)
 			printf("Failed (%d)\n", ret);
 		else
@@ -372,6 +384,8 @@ int env_select(const char *name)
 				gd->env_load_prio = prio;
 				gd->env_valid = ENV_INVALID;
 				gd->flags &= ~GD_FLG_ENV_DEFAULT;
+				/* Nothing is known about the new location yet */
+				env_set_stored(NULL);
 			}
 			printf("OK\n");
 			return 0;
@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Log-structured environment storage, see include/env_log.h
+ *
+ * This is shared with tools/env so that fw_setenv can append to the log.
+ */
+
+#ifdef USE_HOSTCC
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#else
+#include <common.h>
+#include <errno.h>
+#include <linux/string.h>
+#endif
+#include <env_log.h>
+#include <u-boot/crc.h>
+
+int env_log_list_len(const char *list, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		if (!list[i] && (!i || !list[i - 1]))
+			return i + 1;
+	}
+
+	return -EINVAL;
+}
+
+/* Find the entry in @list for the variable named by the first @klen chars */
+static const char *env_log_find(const char *list, const char *name,
+				size_t klen)
+{
+	const char *p;
+
+	for (p = list; *p; p += strlen(p) + 1) {
+		if (!strncmp(p, name, klen) && (p[klen] == '=' || !p[klen]))
+			return p;
+	}
+
+	return NULL;
+}
+
+/* Apply the changes in @delta to @list, which is @len bytes long */
+static int env_log_apply(char *list, size_t size, size_t len,
+			 const char *delta)
+{
+	const char *d;
+
+	for (d = delta; *d; d += strlen(d) + 1) {
+		size_t klen = strcspn(d, "=");
+		size_t dlen = strlen(d) + 1;
+		char *p;
+
+		p = (char *)env_log_find(list, d, klen);
+		if (p) {
+			size_t plen = strlen(p) + 1;
+
+			memmove(p, p + plen, list + len - (p + plen));
+			len -= plen;
+		}
+
+		/* An empty value deletes the variable */
+		if (d[klen] == '=' && d[klen + 1]) {
+			if (len + dlen > size)
+				return -ENOSPC;
+			memcpy(list + len - 1, d, dlen);
+			len += dlen;
+			list[len - 1] = '\0';
+		}
+	}
+
+	return len;
+}
+
+static bool env_log_erased(const char *p, size_t size)
+{
+	while (size--) {
+		if (*p++ != (char)0xff)
+			return false;
+	}
+
+	return true;
+}
+
+int env_log_replay(const void *area, size_t size, char *list,
+		   size_t list_size, size_t *endp)
+{
+	const char *base = area;
+	size_t off = 0;
+	int len = -ENOENT;
+
+	while (off + sizeof(struct env_log_hdr) <= size) {
+		const struct env_log_hdr *hdr = (const void *)(base + off);
+		const char *data = (const char *)(hdr + 1);
+		uint32_t magic = off ? ENV_LOG_MAGIC_DELTA : ENV_LOG_MAGIC_FULL;
+
+		if (off && hdr->magic == ENV_LOG_ERASED &&
+		    env_log_erased(base + off, size - off)) {
+			*endp = off;
+			return len;
+		}
+		if (hdr->magic != magic ||
+		    hdr->len > size - off - sizeof(*hdr) ||
+		    crc32(0, (const unsigned char *)data, hdr->len) !=
+		    hdr->crc || env_log_list_len(data, hdr->len) != hdr->len)
+			break;
+
+		if (!off) {
+			if (hdr->len > list_size)
+				return -ENOSPC;
+			memcpy(list, data, hdr->len);
+			len = hdr->len;
+		} else {
+			len = env_log_apply(list, list_size, len, data);
+			if (len < 0)
+				return len;
+		}
+		off += ENV_LOG_REC_SIZE(hdr->len);
+	}
+	if (!off)
+		return -ENOENT;
+
+	/* Nothing can be appended after a damaged record, so compact */
+	*endp = size;
+
+	return len;
+}
+
+int env_log_diff(const char *old, const char *new, char *out, size_t size)
+{
+	const char *p, *q;
+	size_t len = 0;
+
+	/* Variables which were created or changed, leaving room for the NUL */
+	for (p = new; *p; p += strlen(p) + 1) {
+		size_t plen = strlen(p) + 1;
+
+		q = env_log_find(old, p, strcspn(p, "="));
+		if (q && !strcmp(p, q))
+			continue;
+		if (len + plen >= size)
+			return -ENOSPC;
+		memcpy(out + len, p, plen);
+		len += plen;
+	}
+
+	/* Variables which were deleted */
+	for (p = old; *p; p += strlen(p) + 1) {
+		size_t klen = strcspn(p, "=");
+
+		if (env_log_find(new, p, klen))
+			continue;
+		if (len + klen + 2 >= size)
+			return -ENOSPC;
+		memcpy(out + len, p, klen);
+		out[len + klen] = '=';
+		out[len + klen + 1] = '\0';
+		len += klen + 2;
+	}
+	if (!len)
+		return 0;
+	out[len++] = '\0';
+
+	return len;
+}
+
+size_t env_log_seal(struct env_log_hdr *rec, uint32_t magic, uint32_t len)
+{
+	unsigned char *data = (unsigned char *)(rec + 1);
+	size_t size = ENV_LOG_REC_SIZE(len);
+
+	memset(data + len, 0xff, size - sizeof(*rec) - len);
+	rec->magic = magic;
+	rec->len = len;
+	rec->crc = crc32(0, data, len);
+
+	return size;
+}
@@ -189,13 +189,47 @@ static inline int write_env(struct mmc *mmc, unsigned long size,
 {
 	uint blk_start, blk_cnt, n;
 	struct blk_desc *desc = mmc_get_blk_desc(mmc);
+	uint bl_len = mmc->write_bl_len;
+	const u_char *buf = buffer;
+	u_char *old;
+	uint i;
+	int ret = 0;
 
 	blk_start	= ALIGN(offset, mmc->write_bl_len) / mmc->write_bl_len;
 	blk_cnt		= ALIGN(size, mmc->write_bl_len) / mmc->write_bl_len;
 
-	n = blk_dwrite(desc, blk_start, blk_cnt, (u_char *)buffer);
+	/*
+	 * Only write the blocks which differ from what is there already. If
+	 * that cannot be read, write everything.
+	 */
+	old = memalign(ARCH_DMA_MINALIGN, blk_cnt * bl_len);
+	if (!old || blk_dread(desc, blk_start, blk_cnt, old) != blk_cnt) {
+		free(old);
+		n = blk_dwrite(desc, blk_start, blk_cnt, (u_char *)buffer);
 
-	return (n == blk_cnt) ? 0 : -1;
+		return (n == blk_cnt) ? 0 : -1;
+	}
+
+	for (i = 0; i < blk_cnt; i += n) {
+		for (n = 0; i + n < blk_cnt; n++) {
+			if (!memcmp(old + (i + n) * bl_len,
+				    buf + (i + n) * bl_len, bl_len))
+				break;
+		}
+		if (!n) {
+			n = 1;
+			continue;
+		}
+		debug("%s: writing %u blocks at %u\n", __func__, n,
+		      blk_start + i);
+		if (blk_dwrite(desc, blk_start + i, n, buf + i * bl_len) != n) {
+			ret = -1;
+			break;
+		}
+	}
+	free(old);
+
+	return ret;
 }
 
 static int env_mmc_save(void)
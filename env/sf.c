@@ -12,6 +12,7 @@
 #include <dm.h>
 #include <env.h>
 #include <env_internal.h>
+#include <env_log.h>
 #include <flash.h>
 #include <malloc.h>
 #include <spi.h>
@@ -201,6 +202,183 @@ out:
 
 	return ret;
 }
+#elif defined(CONFIG_ENV_SF_LOG)
+/*
+ * Erase the environment and write the full record @rec of @size bytes, keeping
+ * any other data in the erased sectors
+ */
+static int env_sf_log_compact(struct spi_flash *env_flash, void *rec,
+			      size_t size)
+{
+	u32	saved_size = 0, saved_offset = 0, sector;
+	u32	sect_size = CONFIG_ENV_SECT_SIZE;
+	char	*saved_buffer = NULL;
+	int	ret;
+
+	if (IS_ENABLED(CONFIG_ENV_SECT_SIZE_AUTO))
+		sect_size = env_flash->mtd.erasesize;
+
+	/* Is the sector larger than the env (i.e. embedded) */
+	if (sect_size > CONFIG_ENV_SIZE) {
+		saved_size = sect_size - CONFIG_ENV_SIZE;
+		saved_offset = env_sf_get_env_offset() + CONFIG_ENV_SIZE;
+		saved_buffer = malloc(saved_size);
+		if (!saved_buffer)
+			return -ENOMEM;
+
+		ret = spi_flash_read(env_flash, saved_offset,
+			saved_size, saved_buffer);
+		if (ret)
+			goto done;
+	}
+
+	sector = DIV_ROUND_UP(CONFIG_ENV_SIZE, sect_size);
+
+	puts("Erasing SPI flash...");
+	ret = spi_flash_erase(env_flash, env_sf_get_env_offset(),
+		sector * sect_size);
+	if (ret)
+		goto done;
+
+	puts("Writing to SPI flash...");
+	ret = spi_flash_write(env_flash, env_sf_get_env_offset(), size, rec);
+	if (ret)
+		goto done;
+
+	if (sect_size > CONFIG_ENV_SIZE)
+		ret = spi_flash_write(env_flash, saved_offset,
+			saved_size, saved_buffer);
+
+done:
+	free(saved_buffer);
+
+	return ret;
+}
+
+static int env_sf_save(void)
+{
+	struct env_log_hdr *full, *delta;
+	char *old, *res;
+	size_t end = 0, avail;
+	int len, ret;
+	struct spi_flash *env_flash;
+
+	full = memalign(ARCH_DMA_MINALIGN, CONFIG_ENV_SIZE);
+	delta = memalign(ARCH_DMA_MINALIGN, CONFIG_ENV_SIZE);
+	old = malloc(CONFIG_ENV_SIZE);
+	if (!full || !delta || !old) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	res = (char *)(full + 1);
+	if (hexport_r(&env_htab, '\0', 0, &res,
+		      CONFIG_ENV_SIZE - sizeof(*full), 0, NULL) < 0) {
+		pr_err("Cannot export environment: errno = %d\n", errno);
+		ret = -EIO;
+		goto out;
+	}
+	len = env_log_list_len(res, CONFIG_ENV_SIZE - sizeof(*full));
+
+	ret = setup_flash_device(&env_flash);
+	if (ret)
+		goto out;
+
+	/* The log is read into the buffer later used for the new record */
+	ret = spi_flash_read(env_flash, env_sf_get_env_offset(),
+			     CONFIG_ENV_SIZE, delta);
+	if (ret)
+		goto done;
+
+	ret = env_log_replay(delta, CONFIG_ENV_SIZE, old, CONFIG_ENV_SIZE,
+			     &end);
+	if (ret >= 0) {
+		avail = CONFIG_ENV_SIZE - min_t(size_t, CONFIG_ENV_SIZE,
+						end + sizeof(*delta));
+		ret = env_log_diff(old, res, (char *)(delta + 1), avail);
+		if (!ret) {
+			puts("No changes...");
+			goto done;
+		}
+	}
+	if (ret > 0 && end + ENV_LOG_REC_SIZE(ret) <= CONFIG_ENV_SIZE) {
+		puts("Appending to SPI flash...");
+		ret = spi_flash_write(env_flash, env_sf_get_env_offset() + end,
+				      env_log_seal(delta, ENV_LOG_MAGIC_DELTA,
+						   ret), delta);
+	} else {
+		ret = env_sf_log_compact(env_flash, full,
+					 env_log_seal(full, ENV_LOG_MAGIC_FULL,
+						      len));
+	}
+	if (!ret)
+		puts("done\n");
+
+done:
+	spi_flash_free(env_flash);
+out:
+	free(old);
+	free(delta);
+	free(full);
+
+	return ret;
+}
+
+static int env_sf_load(void)
+{
+	int ret;
+	int len;
+	char *buf, *list;
+	size_t end;
+	struct spi_flash *env_flash;
+
+	buf = (char *)memalign(ARCH_DMA_MINALIGN, CONFIG_ENV_SIZE);
+	list = malloc(CONFIG_ENV_SIZE);
+	if (!buf || !list) {
+		env_set_default("malloc() failed", 0);
+		ret = -EIO;
+		goto out;
+	}
+
+	ret = setup_flash_device(&env_flash);
+	if (ret)
+		goto out;
+
+	ret = spi_flash_read(env_flash,
+		env_sf_get_env_offset(), CONFIG_ENV_SIZE, buf);
+	if (ret) {
+		env_set_default("spi_flash_read() failed", 0);
+		goto err_read;
+	}
+
+	len = env_log_replay(buf, CONFIG_ENV_SIZE, list, CONFIG_ENV_SIZE,
+			     &end);
+	if (len == -ENOENT) {
+		/* Not written as a log yet, so try the usual format */
+		ret = env_import(buf, 1, H_EXTERNAL);
+	} else if (len < 0) {
+		env_set_default("bad log", 0);
+		ret = len;
+	} else if (himport_r(&env_htab, list, len, '\0', H_EXTERNAL, 0, 0,
+			     NULL)) {
+		gd->flags |= GD_FLG_ENV_READY;
+		ret = 0;
+	} else {
+		pr_err("Cannot import environment: errno = %d\n", errno);
+		env_set_default("import failed", 0);
+		ret = -EIO;
+	}
+	if (!ret)
+		gd->env_valid = ENV_VALID;
+
+err_read:
+	spi_flash_free(env_flash);
+out:
+	free(list);
+	free(buf);
+
+	return ret;
+}
 #else
 static int env_sf_save(void)
 {
@@ -411,18 +411,33 @@ int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 /* set current blk device w/ blk_desc + partition # */
 int fs_set_blk_dev_with_part(struct blk_desc *desc, int part)
 {
-	struct fstype_info *info;
-	int ret, i;
+	struct disk_partition info;
+	int ret;
 
 	if (part >= 1)
-		ret = part_get_info(desc, part, &fs_partition);
+		ret = part_get_info(desc, part, &info);
 	else
-		ret = part_get_info_whole_disk(desc, &fs_partition);
+		ret = part_get_info_whole_disk(desc, &info);
 	if (ret)
 		return ret;
+
+	return fs_set_blk_dev_with_part_info(desc, part, &info, FS_TYPE_ANY);
+}
+
+int fs_set_blk_dev_with_part_info(struct blk_desc *desc, int part,
+				  struct disk_partition *part_info, int fstype)
+{
+	struct fstype_info *info;
+	int i;
+
+	fs_partition = *part_info;
 	fs_dev_desc = desc;
 
 	for (i = 0, info = fstypes; i < ARRAY_SIZE(fstypes); i++, info++) {
+		if (fstype != FS_TYPE_ANY && info->fstype != FS_TYPE_ANY &&
+		    fstype != info->fstype)
+			continue;
+
 		if (!info->probe(fs_dev_desc, &fs_partition)) {
 			fs_type = info->fstype;
 			fs_dev_part = part;
@@ -515,11 +530,14 @@ static int fs_read_lmb_check(const char *filename, ulong addr, loff_t offset,
 	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
 	lmb_dump_all(&lmb);
 
-	if (lmb_alloc_addr(&lmb, addr, read_len) == addr)
-		return 0;
+	ret = 0;
+	if (lmb_alloc_addr(&lmb, addr, read_len) != addr) {
+		log_err("** Reading file would overwrite reserved memory **\n");
+		ret = -ENOSPC;
+	}
+	lmb_uninit(&lmb);
 
-	log_err("** Reading file would overwrite reserved memory **\n");
-	return -ENOSPC;
+	return ret;
 }
 #endif
 
@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Microbenchmarks for library functions, run with the 'bench' command
+ */
+
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#include <linker_lists.h>
+#include <linux/bitops.h>
+#include <linux/types.h>
+
+/**
+ * struct bench_state - state passed to each benchmark
+ *
+ * @src: Source buffer of @src_size bytes. With BENCHF_BUF this is provided,
+ *	filled with non-zero data, otherwise the setup() method may set it
+ * @src_size: Size of @src in bytes
+ * @dst: Destination buffer of @size bytes. With BENCHF_BUF this is provided,
+ *	otherwise the setup() method may set it
+ * @size: Number of bytes processed by each operation. This is set by the
+ *	'bench' command for BENCHF_BUF benchmarks, otherwise the setup()
+ *	method may set it, or leave it as 0 if throughput is not meaningful
+ * @priv: Private data for use by the benchmark
+ * @result: Somewhere to store results, so the compiler cannot drop the work
+ */
+struct bench_state {
+	const void *src;
+	ulong src_size;
+	void *dst;
+	ulong size;
+	void *priv;
+	ulong result;
+};
+
+/* Flags for each benchmark */
+enum {
+	BENCHF_BUF	= BIT(0),	/* needs source / destination buffers */
+	BENCHF_NO_COLD	= BIT(1),	/* cache-cold results are meaningless */
+};
+
+/**
+ * struct bench_entry - information about a benchmark
+ *
+ * @file: File containing the benchmark
+ * @name: Name of the benchmark, starting with "bench_"
+ * @flags: Flags for the benchmark (BENCHF_...)
+ * @setup: Called once before the benchmark runs, or NULL. Return 0 if OK,
+ *	-ENOSYS to skip the benchmark, other -ve value on error
+ * @run: Performs a single operation. Return 0 if OK, -ve on error. For the
+ *	cache-cold variant, @src and @dst are flushed from the cache before
+ *	each call
+ * @teardown: Called once after the benchmark runs, or NULL
+ */
+struct bench_entry {
+	const char *file;
+	const char *name;
+	int flags;
+	int (*setup)(struct bench_state *bs);
+	int (*run)(struct bench_state *bs);
+	void (*teardown)(struct bench_state *bs);
+};
+
+/**
+ * BENCH() - create a linker-generated list entry for a benchmark
+ *
+ * Use BENCH(bench_foo, flags, setup, teardown) for a benchmark called 'foo'
+ * which is implemented in function bench_foo(). It can be run with
+ * 'bench run foo'.
+ *
+ * @_name:	"bench_" followed by the name of the benchmark
+ * @_flags:	Flags for the benchmark (BENCHF_...)
+ * @_setup:	Setup function, or NULL
+ * @_teardown:	Teardown function, or NULL
+ */
+#define BENCH(_name, _flags, _setup, _teardown)			\
+	ll_entry_declare(struct bench_entry, _name, bench) = {	\
+		.file = __FILE__,					\
+		.name = #_name,						\
+		.flags = _flags,					\
+		.setup = _setup,					\
+		.run = _name,						\
+		.teardown = _teardown,					\
+	}
+
+#define BENCH_START()	ll_entry_start(struct bench_entry, bench)
+#define BENCH_COUNT()	ll_entry_count(struct bench_entry, bench)
+
+#endif /* __BENCH_H */
@@ -207,6 +207,11 @@ enum bootstage_id {
 	BOOTSTAGE_ID_ACCUM_FSP_M,
 	BOOTSTAGE_ID_ACCUM_FSP_S,
 	BOOTSTAGE_ID_ACCUM_MMAP_SPI,
+	BOOTSTAGE_ID_ACCUM_DM_PROBE,
+	BOOTSTAGE_ID_ACCUM_DM_OF_TO_PLAT,
+	BOOTSTAGE_ID_ACCUM_FDT_FIXUP,
+	BOOTSTAGE_ID_ACCUM_DRAM_SCRUB,
+	BOOTSTAGE_ID_ACCUM_MEASURE,
 
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
@@ -0,0 +1,157 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Bootstage timeline, a high-resolution record of boot events which is
+ * handed over to the OS
+ *
+ * See doc/develop/bootstage_timeline.rst for a description of the format.
+ */
+
+#ifndef __BOOTSTAGE_TIMELINE_H
+#define __BOOTSTAGE_TIMELINE_H
+
+#include <linux/types.h>
+
+enum {
+	BOOTSTAGE_TIMELINE_MAGIC	= 0x4c545342,	/* "BSTL" */
+	BOOTSTAGE_TIMELINE_VERSION	= 1,
+};
+
+/**
+ * enum bootstage_timeline_type - type of a timeline event
+ *
+ * @BOOTSTAGE_TL_MARK:		A bootstage mark (start == end)
+ * @BOOTSTAGE_TL_DEVICE:	Probe of a device, named after the device
+ * @BOOTSTAGE_TL_COMMAND:	Execution of a command, named after the command
+ * @BOOTSTAGE_TL_SPAN:		Any other interval
+ */
+enum bootstage_timeline_type {
+	BOOTSTAGE_TL_MARK,
+	BOOTSTAGE_TL_DEVICE,
+	BOOTSTAGE_TL_COMMAND,
+	BOOTSTAGE_TL_SPAN,
+};
+
+/**
+ * struct bootstage_timeline_hdr - header at the start of the timeline region
+ *
+ * The header is followed by @max_count struct bootstage_timeline_event
+ * records, of which the first @count are valid, and then by a table of
+ * @str_size bytes holding nul-terminated event names. All fields are
+ * little-endian.
+ *
+ * @magic:	BOOTSTAGE_TIMELINE_MAGIC
+ * @version:	BOOTSTAGE_TIMELINE_VERSION
+ * @hdr_size:	Size of this header in bytes
+ * @size:	Total size of the region in bytes
+ * @tick_rate:	Frequency of the event timestamps in Hz
+ * @count:	Number of events recorded
+ * @max_count:	Number of event slots in the region
+ * @str_used:	Number of bytes of the string table in use
+ * @str_size:	Size of the string table in bytes
+ * @dropped:	Number of events which did not fit
+ * @reserved:	Reserved, set to 0
+ */
+struct bootstage_timeline_hdr {
+	u32 magic;
+	u32 version;
+	u32 hdr_size;
+	u32 size;
+	u64 tick_rate;
+	u32 count;
+	u32 max_count;
+	u32 str_used;
+	u32 str_size;
+	u32 dropped;
+	u32 reserved;
+};
+
+/**
+ * struct bootstage_timeline_event - a single timeline event
+ *
+ * @start:	Timer value at the start of the event
+ * @end:	Timer value at the end of the event
+ * @name:	Offset of the event name within the string table
+ * @type:	Event type (enum bootstage_timeline_type)
+ * @phase:	U-Boot phase which recorded the event (enum u_boot_phase)
+ * @reserved:	Reserved, set to 0
+ */
+struct bootstage_timeline_event {
+	u64 start;
+	u64 end;
+	u32 name;
+	u8 type;
+	u8 phase;
+	u16 reserved;
+};
+
+#if !defined(USE_HOSTCC) && CONFIG_IS_ENABLED(BOOTSTAGE_TIMELINE)
+
+/**
+ * bootstage_timeline_init() - set up the timeline for this phase
+ *
+ * In SPL this allocates a small buffer with malloc(), which is copied to the
+ * timeline region by bootstage_timeline_flush(). In U-Boot proper the
+ * timeline region is used directly; if SPL has already written a valid
+ * timeline there, further events are appended to it.
+ *
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+int bootstage_timeline_init(void);
+
+/**
+ * bootstage_timeline_add() - add an event to the timeline
+ *
+ * The name is copied, so it need not remain valid after this call.
+ *
+ * @type:	Event type
+ * @name:	Event name
+ * @start:	Timer value at start of event, from get_ticks()
+ * @end:	Timer value at end of event, from get_ticks()
+ */
+void bootstage_timeline_add(enum bootstage_timeline_type type,
+			    const char *name, u64 start, u64 end);
+
+/**
+ * bootstage_timeline_flush() - write out the SPL timeline
+ *
+ * This copies the events recorded by SPL into the timeline region, ready for
+ * U-Boot proper to continue. It does nothing in U-Boot proper.
+ *
+ * Return: 0 if OK, -ENOSPC if some events did not fit
+ */
+int bootstage_timeline_flush(void);
+
+/**
+ * bootstage_timeline_fdt_add() - describe the timeline region in a devicetree
+ *
+ * Adds a reserved-memory node covering the region and points the
+ * 'u-boot,bootstage-timeline' property in /chosen at it.
+ *
+ * @blob:	Devicetree to update
+ * Return: 0 if OK, -ve on error
+ */
+int bootstage_timeline_fdt_add(void *blob);
+
+#else
+static inline int bootstage_timeline_init(void)
+{
+	return 0;
+}
+
+static inline void bootstage_timeline_add(enum bootstage_timeline_type type,
+					  const char *name, u64 start, u64 end)
+{
+}
+
+static inline int bootstage_timeline_flush(void)
+{
+	return 0;
+}
+
+static inline int bootstage_timeline_fdt_add(void *blob)
+{
+	return 0;
+}
+#endif
+
+#endif
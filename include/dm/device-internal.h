@@ -394,6 +394,24 @@ fdt_addr_t simple_bus_translate(struct udevice *dev, fdt_addr_t addr);
 #define DM_UCLASS_ROOT_NON_CONST	(((gd_t *)gd)->uclass_root)
 #define DM_UCLASS_ROOT_S_NON_CONST	(((gd_t *)gd)->uclass_root_s)
 
+/**
+ * dm_stats_add() - add to a statistic of a device and of its uclass
+ *
+ * This does nothing unless CONFIG_DM_STATS is enabled.
+ *
+ * @dev:	Device to update
+ * @field:	Member of struct dm_stats to update
+ * @val:	Value to add
+ */
+#if CONFIG_IS_ENABLED(DM_STATS)
+#define dm_stats_add(dev, field, val)	do { \
+		(dev)->stats.field += (val); \
+		(dev)->uclass->stats.field += (val); \
+	} while (0)
+#else
+#define dm_stats_add(dev, field, val)	do { (void)(val); } while (0)
+#endif
+
 /* device resource management */
 #ifdef CONFIG_DEVRES
 
@@ -108,6 +108,27 @@ enum {
 	DM_REMOVE_NO_PD		= 1 << 1,
 };
 
+/**
+ * struct dm_stats - driver model statistics for a device or uclass
+ *
+ * Times are in timer ticks (see get_tbclk()). The probe time includes the
+ * time taken to probe any devices that the probe method causes to be probed,
+ * but not the time taken to probe the device's parents.
+ *
+ * @probe_count: Number of times the device was probed
+ * @remove_count: Number of times the device was removed
+ * @priv_bytes: Number of bytes of private data allocated by driver model
+ * @of_to_plat_ticks: Time spent in the of_to_plat() method
+ * @probe_ticks: Time spent probing the device
+ */
+struct dm_stats {
+	uint probe_count;
+	uint remove_count;
+	ulong priv_bytes;
+	u64 of_to_plat_ticks;
+	u64 probe_ticks;
+};
+
 /**
  * struct udevice - An instance of a driver
  *
@@ -161,6 +182,7 @@ enum {
  *		automatically when the device is removed / unbound
  * @dma_offset: Offset between the physical address space (CPU's) and the
  *		device's bus address space
+ * @stats: Driver model statistics for this device (see CONFIG_DM_STATS)
  */
 struct udevice {
 	const struct driver *driver;
@@ -190,6 +212,9 @@ struct udevice {
 #if CONFIG_IS_ENABLED(DM_DMA)
 	ulong dma_offset;
 #endif
+#if CONFIG_IS_ENABLED(DM_STATS)
+	struct dm_stats stats;
+#endif
 };
 
 /**
@@ -9,6 +9,7 @@
 #ifndef _DM_UCLASS_H
 #define _DM_UCLASS_H
 
+#include <dm/device.h>
 #include <dm/ofnode.h>
 #include <dm/uclass-id.h>
 #include <linker_lists.h>
@@ -30,12 +31,17 @@
  * @dev_head: List of devices in this uclass (devices are attached to their
  * uclass when their bind method is called)
  * @sibling_node: Next uclass in the linked list of uclasses
+ * @stats: Driver model statistics, totalled over all devices in the uclass
+ *	(see CONFIG_DM_STATS)
  */
 struct uclass {
 	void *priv_;
 	struct uclass_driver *uc_drv;
 	struct list_head dev_head;
 	struct list_head sibling_node;
+#if CONFIG_IS_ENABLED(DM_STATS)
+	struct dm_stats stats;
+#endif
 };
 
 struct driver;
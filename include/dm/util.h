@@ -30,6 +30,22 @@ void dm_dump_all(void);
 /* Dump out a list of uclasses and their devices */
 void dm_dump_uclass(void);
 
+#if CONFIG_IS_ENABLED(DM_STATS)
+/* Dump out a tree of all devices with their probe statistics */
+void dm_dump_stats(void);
+
+/* Dump out the probe statistics for each uclass */
+void dm_dump_uclass_stats(void);
+#else
+static inline void dm_dump_stats(void)
+{
+}
+
+static inline void dm_dump_uclass_stats(void)
+{
+}
+#endif
+
 #ifdef CONFIG_DEBUG_DEVRES
 /* Dump out a list of device resources */
 void dm_dump_devres(void);
@@ -537,6 +537,42 @@ int efi_disk_create_partitions(efi_handle_t parent, struct blk_desc *desc,
 			       const char *pdevname);
 /* Check if it is EFI system partition */
 bool efi_disk_is_system_part(efi_handle_t handle);
+
+/**
+ * struct efi_disk_cache_stats - statistics of a block device read-ahead cache
+ *
+ * @desc:	block device
+ * @reads:	number of reads through the cache
+ * @hits:	number of reads served entirely from the cache
+ * @fills:	number of times the cache was filled
+ * @blocks:	number of blocks read from the block device
+ */
+struct efi_disk_cache_stats {
+	struct blk_desc *desc;
+	ulong reads;
+	ulong hits;
+	ulong fills;
+	u64 blocks;
+};
+
+/**
+ * efi_disk_cache_invalidate() - drop the read-ahead cache of a block device
+ *
+ * This must be called when the block device is written other than through
+ * the EFI_BLOCK_IO_PROTOCOL.
+ *
+ * @desc:	block device, or NULL for all block devices
+ */
+void efi_disk_cache_invalidate(struct blk_desc *desc);
+
+/**
+ * efi_disk_get_cache_stats() - get the statistics of a read-ahead cache
+ *
+ * @index:	index of the cache, starting at 0
+ * @stats:	returns the statistics
+ * Return:	0 if OK, -ENOENT if there is no cache with this index
+ */
+int efi_disk_get_cache_stats(int index, struct efi_disk_cache_stats *stats);
 /* Called by bootefi to make GOP (graphical) interface available */
 efi_status_t efi_gop_register(void);
 /* Called by bootefi to make the network interface available */
@@ -658,6 +694,14 @@ struct efi_simple_file_system_protocol *efi_simple_file_system(
 /* open file from device-path: */
 struct efi_file_handle *efi_file_from_path(struct efi_device_path *fp);
 
+/**
+ * efi_file_modified() - drop the data cached by open EFI file handles
+ *
+ * This must be called when a file system is written other than through
+ * the EFI_FILE_PROTOCOL.
+ */
+void efi_file_modified(void);
+
 /* Registers a callback function for a notification event. */
 efi_status_t EFIAPI efi_register_protocol_notify(const efi_guid_t *protocol,
 						 struct efi_event *event,
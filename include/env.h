@@ -308,6 +308,27 @@ int env_import(const char *buf, int check, int flags);
  */
 int env_export(struct environment_s *env_out);
 
+/**
+ * env_set_stored() - Record what the environment in storage holds
+ *
+ * This is used by env_save() to avoid writing an environment which has not
+ * changed since it was loaded or saved. It is called by env_import() and
+ * env_import_redund(), so drivers do not normally need to call it.
+ *
+ * @crc: CRC of the environment in storage, as in struct environment_s, or
+ *	NULL if it is not known
+ */
+void env_set_stored(const u32 *crc);
+
+/**
+ * env_is_stored() - Check whether the environment is the same as in storage
+ *
+ * @crcp: Returns the CRC of the environment, as env_export() calculates it
+ * @return 1 if the environment matches the one recorded by env_set_stored(),
+ *	0 if not, -ve on error
+ */
+int env_is_stored(u32 *crcp);
+
 /**
  * env_check_redund() - check the two redundant environments
  *   and find out, which is the valid one.
@@ -0,0 +1,104 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Log-structured environment storage
+ *
+ * The environment area holds a sequence of records, each made of a header
+ * and a list of "name=value" strings, in the same form as the data of an
+ * env_t: each string is terminated by a NUL and the list by an empty string.
+ *
+ * The first record is a full copy of the environment. Each following record
+ * holds only the variables which changed since the previous one, with a
+ * deleted variable written as "name=". New records are written into the
+ * erased space after the last one, so most updates need no erase. When the
+ * area is full, or a record is found to be damaged, the whole area is erased
+ * and rewritten with a single full record.
+ *
+ * Headers are stored in the CPU's byte order, like the CRC of an env_t.
+ */
+
+#ifndef __ENV_LOG_H
+#define __ENV_LOG_H
+
+#ifdef USE_HOSTCC
+#include <stddef.h>
+#include <stdint.h>
+#else
+#include <linux/types.h>
+#endif
+
+#define ENV_LOG_MAGIC_FULL	0x4c564e45	/* "ENVL" */
+#define ENV_LOG_MAGIC_DELTA	0x44564e45	/* "ENVD" */
+#define ENV_LOG_ERASED		0xffffffff
+
+/**
+ * struct env_log_hdr - header of a record in an environment log
+ *
+ * @magic: ENV_LOG_MAGIC_FULL for the first record, else ENV_LOG_MAGIC_DELTA
+ * @len: Number of bytes of data following the header
+ * @crc: CRC32 of the data
+ */
+struct env_log_hdr {
+	uint32_t magic;
+	uint32_t len;
+	uint32_t crc;
+};
+
+/* Records start on a 4-byte boundary; padding is left erased (0xff) */
+#define ENV_LOG_REC_SIZE(len) \
+	(sizeof(struct env_log_hdr) + (((len) + 3) & ~3))
+
+/**
+ * env_log_list_len() - get the length of a list of variables
+ *
+ * @list: List of NUL-terminated strings, terminated by an empty string
+ * @size: Maximum number of bytes to look at
+ * Return: number of bytes in the list, including the final NUL, or -EINVAL
+ *	if it is not terminated within @size bytes
+ */
+int env_log_list_len(const char *list, size_t size);
+
+/**
+ * env_log_replay() - rebuild the environment stored in a log
+ *
+ * This applies each record in turn, stopping at the first erased header. If
+ * a damaged record is found, the records before it are used and *@endp is set
+ * to @size so that the next update compacts the log.
+ *
+ * @area: Contents of the environment area
+ * @size: Size of @area in bytes
+ * @list: Returns the list of variables
+ * @list_size: Size of @list in bytes
+ * @endp: Returns the offset at which the next record may be written
+ * Return: length of the list (see env_log_list_len()), -ENOENT if @area does
+ *	not start with a valid full record, -ENOSPC if @list is too small
+ */
+int env_log_replay(const void *area, size_t size, char *list,
+		   size_t list_size, size_t *endp);
+
+/**
+ * env_log_diff() - work out the changes between two lists of variables
+ *
+ * @old: Previous list of variables
+ * @new: New list of variables
+ * @out: Returns the changes, as data for an ENV_LOG_MAGIC_DELTA record. This
+ *	may be NULL if @size is 0, to just check whether anything changed
+ * @size: Size of @out in bytes
+ * Return: length of the data written to @out, 0 if the lists hold the same
+ *	variables, -ENOSPC if @out is too small
+ */
+int env_log_diff(const char *old, const char *new, char *out, size_t size);
+
+/**
+ * env_log_seal() - fill in the header of a record
+ *
+ * The data must already follow the header. Any padding up to the record
+ * size is set to 0xff.
+ *
+ * @rec: Record to fill in
+ * @magic: ENV_LOG_MAGIC_FULL or ENV_LOG_MAGIC_DELTA
+ * @len: Length of the data
+ * Return: size of the record in bytes
+ */
+size_t env_log_seal(struct env_log_hdr *rec, uint32_t magic, uint32_t len);
+
+#endif /* __ENV_LOG_H */
@@ -70,6 +70,65 @@ static inline void do_fixup_by_path_string(void *fdt, const char *path,
 	do_fixup_by_path(fdt, path, prop, status, strlen(status) + 1, 1);
 }
 
+/**
+ * struct fdt_batch - a set of property changes to make to a device tree
+ *
+ * Each fdt_setprop() which changes the size of a property moves the rest of
+ * the blob, so making many such changes to a large tree is slow. A batch
+ * collects the changes and makes them all in a single pass. Properties which
+ * keep their size are updated at once, since that moves nothing.
+ *
+ * Node offsets refer to the blob as it was when the batch was started, so the
+ * blob must not be changed in other ways until fdt_batch_apply() is called.
+ *
+ * @blob: Device tree to change
+ * @edit: Changes waiting to be made
+ * @count: Number of entries in @edit
+ * @alloc: Number of entries allocated in @edit
+ * @err: First error seen, or 0
+ */
+struct fdt_batch {
+	void *blob;
+	struct fdt_batch_edit *edit;
+	int count;
+	int alloc;
+	int err;
+};
+
+/**
+ * fdt_batch_init() - start a batch of property changes
+ *
+ * @batch: Batch to set up
+ * @blob: Device tree to change
+ */
+void fdt_batch_init(struct fdt_batch *batch, void *blob);
+
+/**
+ * fdt_batch_setprop() - add a property change to a batch
+ *
+ * This works like fdt_setprop(), creating the property if needed.
+ *
+ * @batch: Batch to update
+ * @node: Offset of the node to change
+ * @name: Name of the property
+ * @val: Value to set (this is copied)
+ * @len: Length of @val in bytes
+ * Return: 0 if OK, -ve FDT_ERR_... on error
+ */
+int fdt_batch_setprop(struct fdt_batch *batch, int node, const char *name,
+		      const void *val, int len);
+
+/**
+ * fdt_batch_apply() - make the changes in a batch
+ *
+ * The batch is emptied, whether this succeeds or not, and may be used again.
+ *
+ * @batch: Batch to apply
+ * Return: 0 if OK, -ve FDT_ERR_... on error, including any error from
+ *	fdt_batch_setprop()
+ */
+int fdt_batch_apply(struct fdt_batch *batch);
+
 void do_fixup_by_prop(void *fdt,
 		      const char *pname, const void *pval, int plen,
 		      const char *prop, const void *val, int len,
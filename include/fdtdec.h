@@ -651,6 +651,58 @@ const char *fdtdec_get_chosen_prop(const void *blob, const char *name);
  */
 int fdtdec_get_chosen_node(const void *blob, const char *name);
 
+/**
+ * fdtdec_path_offset() - find a node by its path or alias
+ *
+ * This works like fdt_path_offset(). With CONFIG_OF_PATH_INDEX, paths in the
+ * control FDT are looked up using an index which is built when first needed,
+ * avoiding a walk of the tree each time.
+ *
+ * @param blob		Device tree blob
+ * @param path		Full path of the node, or an alias
+ * @return offset of the node, or -ve FDT_ERR_... on error
+ */
+int fdtdec_path_offset(const void *blob, const char *path);
+
+/**
+ * fdtdec_phandle_offset() - find a node by its phandle
+ *
+ * This works like fdt_node_offset_by_phandle(). With CONFIG_OF_PHANDLE_INDEX,
+ * phandles in the control FDT are looked up in a table which is built when
+ * first needed, avoiding a scan of the whole tree each time.
+ *
+ * @param blob		Device tree blob
+ * @param phandle	Phandle to look up
+ * @return offset of the node, or -ve FDT_ERR_... on error
+ */
+int fdtdec_phandle_offset(const void *blob, u32 phandle);
+
+/**
+ * struct fdtdec_index_stats - statistics for the control FDT indexes
+ *
+ * These are only collected with CONFIG_DM_STATS, apart from @builds.
+ *
+ * @path_lookups: Number of calls to fdtdec_path_offset()
+ * @path_hits: Number of those answered from the path index
+ * @phandle_lookups: Number of calls to fdtdec_phandle_offset()
+ * @phandle_hits: Number of those answered from the phandle table
+ * @builds: Number of times an index was built
+ */
+struct fdtdec_index_stats {
+	uint path_lookups;
+	uint path_hits;
+	uint phandle_lookups;
+	uint phandle_hits;
+	uint builds;
+};
+
+/**
+ * fdtdec_get_index_stats() - get statistics for the control FDT indexes
+ *
+ * @param stats		Returns the statistics
+ */
+void fdtdec_get_index_stats(struct fdtdec_index_stats *stats);
+
 /*
  * Get the name for a compatible ID
  *
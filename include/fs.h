@@ -19,6 +19,7 @@ struct cmd_tbl;
 #define FS_TYPE_SQUASHFS 6
 
 struct blk_desc;
+struct disk_partition;
 
 /**
  * do_fat_fsload - Run the fatload command
@@ -66,6 +67,23 @@ int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype);
  */
 int fs_set_blk_dev_with_part(struct blk_desc *desc, int part);
 
+/**
+ * fs_set_blk_dev_with_part_info() - Set current block device + partition
+ *
+ * Similar to fs_set_blk_dev_with_part(), but for callers which keep the
+ * partition information and the filesystem type from an earlier call, so
+ * that the partition table is not read again and only one filesystem is
+ * probed.
+ *
+ * @desc: Block device descriptor
+ * @part: Partition number, 0 for the whole device
+ * @part_info: Partition information
+ * @fstype: Filesystem type to probe (FS_TYPE_...), or FS_TYPE_ANY to try all
+ * Return: 0 on success, -1 if no filesystem was recognised
+ */
+int fs_set_blk_dev_with_part_info(struct blk_desc *desc, int part,
+				  struct disk_partition *part_info, int fstype);
+
 /**
  * fs_close() - Unset current block device and partition
  *
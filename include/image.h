@@ -21,6 +21,7 @@
 
 /* Define this to avoid #ifdefs later on */
 struct lmb;
+struct lmb_property;
 struct fdt_region;
 
 #ifdef USE_HOSTCC
@@ -675,6 +676,20 @@ int boot_get_fdt(int flag, int argc, char *const argv[], uint8_t arch,
 		 bootm_headers_t *images,
 		 char **of_flat_tree, ulong *of_size);
 void boot_fdt_add_mem_rsv_regions(struct lmb *lmb, void *fdt_blob);
+
+/**
+ * boot_fdt_get_mem_rsv_regions() - list the reserved regions in a devicetree
+ *
+ * This finds the same regions as boot_fdt_add_mem_rsv_regions(), in the same
+ * order and without merging them, so that they can later be reserved in an
+ * lmb exactly as that function would.
+ *
+ * @fdt_blob: pointer to fdt blob base address
+ * @rsvp: returns a list of the regions allocated with malloc(), or NULL if
+ *	there are none
+ * Return: number of regions, or -ENOMEM if out of memory
+ */
+int boot_fdt_get_mem_rsv_regions(void *fdt_blob, struct lmb_property **rsvp);
 int boot_relocate_fdt(struct lmb *lmb, char **of_flat_tree, ulong *of_size);
 
 int boot_ramdisk_high(struct lmb *lmb, ulong rd_data, ulong rd_len,
@@ -1122,6 +1137,27 @@ int fit_check_ramdisk(const void *fit, int os_noffset,
 int calculate_hash(const void *data, int data_len, const char *algo,
 			uint8_t *value, int *value_len);
 
+#ifdef USE_HOSTCC
+/**
+ * fit_image_hash_value() - Calculate the value for an image hash node
+ *
+ * This returns the value calculated in advance by mkimage or fit_check_sign,
+ * which hash images in parallel, or else calls calculate_hash()
+ *
+ * @fit: FIT containing the hash node
+ * @noffset: Offset of the hash node
+ * @algo: Hash algorithm
+ * @data: Image data
+ * @size: Size of image data in bytes
+ * @value: Returns the hash value, FIT_MAX_HASH_LEN bytes or less
+ * @value_len: Returns the length of the hash value in bytes
+ * Return: 0 if OK, -ve on error
+ */
+int fit_image_hash_value(const void *fit, int noffset, const char *algo,
+			 const void *data, size_t size, uint8_t *value,
+			 int *value_len);
+#endif
+
 /*
  * At present we only support signing on the host, and verification on the
  * device
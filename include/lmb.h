@@ -38,19 +38,28 @@ struct lmb_property {
 /**
  * struct lmb_region - Description of a set of region.
  *
+ * The regions are kept sorted by base address and do not overlap.
+ *
  * @cnt: Number of regions.
  * @max: Size of the region array, max value of cnt.
  * @region: Array of the region properties
+ * @allocated: true if @region was allocated with malloc(), once the array
+ *	   in struct lmb became full
  */
 struct lmb_region {
 	unsigned long cnt;
 	unsigned long max;
+	struct lmb_property *region;
+	bool allocated;
+};
+
 #if IS_ENABLED(CONFIG_LMB_USE_MAX_REGIONS)
-	struct lmb_property region[CONFIG_LMB_MAX_REGIONS];
+#define LMB_MEMORY_REGIONS	CONFIG_LMB_MAX_REGIONS
+#define LMB_RESERVED_REGIONS	CONFIG_LMB_MAX_REGIONS
 #else
-	struct lmb_property *region;
+#define LMB_MEMORY_REGIONS	CONFIG_LMB_MEMORY_REGIONS
+#define LMB_RESERVED_REGIONS	CONFIG_LMB_RESERVED_REGIONS
 #endif
-};
 
 /**
  * struct lmb - Logical memory block handle.
@@ -62,19 +71,28 @@ struct lmb_region {
  *
  * @memory: Description of memory regions.
  * @reserved: Description of reserved regions.
- * @memory_regions: Array of the memory regions (statically allocated)
- * @reserved_regions: Array of the reserved regions (statically allocated)
+ * @memory_regions: Initial array of the memory regions
+ * @reserved_regions: Initial array of the reserved regions
  */
 struct lmb {
 	struct lmb_region memory;
 	struct lmb_region reserved;
-#if !IS_ENABLED(CONFIG_LMB_USE_MAX_REGIONS)
-	struct lmb_property memory_regions[CONFIG_LMB_MEMORY_REGIONS];
-	struct lmb_property reserved_regions[CONFIG_LMB_RESERVED_REGIONS];
-#endif
+	struct lmb_property memory_regions[LMB_MEMORY_REGIONS];
+	struct lmb_property reserved_regions[LMB_RESERVED_REGIONS];
 };
 
 void lmb_init(struct lmb *lmb);
+
+/**
+ * lmb_uninit() - free the memory used by an lmb
+ *
+ * When more regions are added than fit in the arrays in struct lmb, larger
+ * arrays are allocated. This frees them and leaves @lmb empty. It must be
+ * called before a struct lmb set up after relocation goes out of scope.
+ *
+ * @lmb: the logical memory block struct
+ */
+void lmb_uninit(struct lmb *lmb);
 void lmb_init_and_reserve(struct lmb *lmb, struct bd_info *bd, void *fdt_blob);
 void lmb_init_and_reserve_range(struct lmb *lmb, phys_addr_t base,
 				phys_size_t size, void *fdt_blob);
@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Fast memory test, for checking large amounts of DRAM
+ */
+
+#ifndef __MEMTEST_H
+#define __MEMTEST_H
+
+#include <linux/bitops.h>
+#include <linux/types.h>
+
+/* The region to test must start and end on this boundary */
+#define MEMTEST_ALIGN		64
+
+/* Most cores which can share a test */
+#define MEMTEST_MAX_CPUS	16
+
+/**
+ * enum memtest_pattern - patterns written by memtest_run()
+ *
+ * Each pattern writes the whole region and then reads it back. The value of
+ * each 64-bit word depends only on its address, not on how the region is
+ * split between cores.
+ *
+ * @MEMTEST_WALK_ONES: A single bit set, moving along by one bit in each word
+ * @MEMTEST_WALK_ZEROS: A single bit clear, moving along by one bit in each
+ *	word
+ * @MEMTEST_ADDRESS: Each word holds its own address, then the inverse of it,
+ *	to find address lines which are stuck or shorted
+ * @MEMTEST_MOVING_INV: Moving inversions: write a pattern, then going up
+ *	check it and write the inverse, going down check that and write the
+ *	pattern again, and finally check the pattern
+ * @MEMTEST_ALL: All of the above
+ */
+enum memtest_pattern {
+	MEMTEST_WALK_ONES	= BIT(0),
+	MEMTEST_WALK_ZEROS	= BIT(1),
+	MEMTEST_ADDRESS		= BIT(2),
+	MEMTEST_MOVING_INV	= BIT(3),
+
+	MEMTEST_ALL		= BIT(4) - 1,
+};
+
+/**
+ * enum memtest_cache - how the test uses the data cache
+ *
+ * @MEMTEST_CACHED: Leave the cache as it is. This is fastest, but the cache
+ *	may hide errors in the region if it is small enough to fit
+ * @MEMTEST_FLUSH: Flush the cache after each pass which writes, so that the
+ *	data is always read back from DRAM
+ * @MEMTEST_UNCACHED: Map the region uncached while testing. This is slow,
+ *	but each access goes to DRAM. Only available on ARM, where the region
+ *	must also be aligned to MMU_SECTION_SIZE
+ */
+enum memtest_cache {
+	MEMTEST_CACHED,
+	MEMTEST_FLUSH,
+	MEMTEST_UNCACHED,
+};
+
+/**
+ * struct memtest_result - results of a test
+ *
+ * @errors: Number of 64-bit words which read back wrongly
+ * @first_error: Lowest address which read back wrongly, if @errors is not 0
+ * @bit_errors: Each bit is set if it was wrong in any word
+ * @bytes: Number of bytes written and read
+ * @time_us: Time taken in microseconds
+ * @cpus: Number of cores which ran the test
+ * @aborted: true if the test was stopped with Ctrl-C
+ */
+struct memtest_result {
+	ulong errors;
+	ulong first_error;
+	u64 bit_errors;
+	u64 bytes;
+	ulong time_us;
+	uint cpus;
+	bool aborted;
+};
+
+/**
+ * memtest_run() - test a region of memory with one pattern
+ *
+ * The region is split into chunks, which are shared between up to
+ * @max_cpus cores if smp_run() is available. Words are written and read
+ * in groups of four to make good use of the memory bus.
+ *
+ * The previous contents of the region are lost.
+ *
+ * @start: Start address of the region
+ * @size: Size of the region in bytes
+ * @pattern: Pattern to use (MEMTEST_...), a single bit
+ * @cache: How to use the data cache
+ * @max_cpus: Most cores to use, including the boot core
+ * @res: Returns the results
+ * Return: 0 if the test ran, even if it found errors, -EINVAL if the region
+ *	or @pattern is not valid, -ENOSYS if @cache is not supported
+ */
+int memtest_run(ulong start, ulong size, uint pattern,
+		enum memtest_cache cache, uint max_cpus,
+		struct memtest_result *res);
+
+/**
+ * memtest_pattern_name() - get the name of a pattern
+ *
+ * @pattern: Pattern (MEMTEST_...), a single bit
+ * Return: name of the pattern, or "unknown"
+ */
+const char *memtest_pattern_name(uint pattern);
+
+#if CONFIG_IS_ENABLED(UNIT_TEST)
+/**
+ * struct memtest_test - hooks for testing memtest_run() on sandbox
+ *
+ * @cpus: Number of cores to pretend to have when smp_run() is not available.
+ *	The boot core tests the chunks in turn as each of them
+ * @corrupt: Called with each chunk after a pass which writes it and before
+ *	the pass which checks it, to simulate bad memory
+ */
+struct memtest_test {
+	uint cpus;
+	void (*corrupt)(u64 *p, ulong size);
+};
+
+/**
+ * memtest_set_test() - set the hooks used by memtest_run()
+ *
+ * @test: Hooks to use, or NULL to go back to normal
+ */
+void memtest_set_test(const struct memtest_test *test);
+#endif
+
+#endif /* __MEMTEST_H */
@@ -25,6 +25,52 @@ void tftp_start_server(void);	/* Wait for incoming TFTP put */
 extern ulong tftp_timeout_ms;
 extern int tftp_timeout_count_max;
 
+/* tftp_multi.c */
+
+/* Maximum number of files which can be fetched at once */
+#define TFTP_MULTI_MAX	16
+
+/**
+ * struct tftp_file - a file to fetch with tftp_get_files()
+ *
+ * @name: Name of the file on the server
+ * @addr: Address to load the file to
+ * @size: Returns the size of the file in bytes
+ * @ret: Returns 0 if the file was fetched, -ENOENT or -EACCES if the server
+ *	refused it, -ETIMEDOUT if the server stopped responding, -ENOSPC if
+ *	the file does not fit in free memory, -ECANCELED if it was not needed
+ *	or -EINTR if the transfer did not finish
+ */
+struct tftp_file {
+	const char *name;
+	ulong addr;
+	ulong size;
+	int ret;
+};
+
+/**
+ * tftp_get_files() - fetch several files from the server at once
+ *
+ * Each file is fetched in its own TFTP session, with its own UDP port at our
+ * end, so that the server handles them in parallel. The requests are all
+ * sent together.
+ *
+ * With @first set, the files are alternatives in order of preference, e.g.
+ * the candidate names of a config file, and are all loaded to the same
+ * address. A file is only accepted once every file before it has been
+ * refused, so the result is the same as trying them one at a time.
+ *
+ * @files: Files to fetch
+ * @count: Number of files, at most TFTP_MULTI_MAX
+ * @first: true to stop at the first file (in order) which the server has
+ * Return: if @first, the index of the file fetched or -ENOENT if there was
+ *	none, else 0 if all files were fetched or the first error from @files.
+ *	Other -ve values come from net_loop(), e.g. -EINTR if cancelled
+ */
+int tftp_get_files(struct tftp_file *files, int count, bool first);
+
+void tftp_multi_start(void);	/* Begin fetching the files */
+
 /**********************************************************************/
 
 #endif /* __TFTP_H__ */
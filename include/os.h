@@ -462,6 +462,27 @@ int os_setup_signal_handlers(void);
  */
 void os_signal_action(int sig, unsigned long pc);
 
+struct os_thread;
+
+/**
+ * os_thread_create() - start a thread
+ *
+ * @threadp:	returns the thread
+ * @fn:		function to run in the thread
+ * @arg:	argument to pass to @fn
+ * Return:	0 if OK, -ve on error
+ */
+int os_thread_create(struct os_thread **threadp, void (*fn)(void *arg),
+		     void *arg);
+
+/**
+ * os_thread_join() - wait for a thread to finish, then free it
+ *
+ * @thread:	thread to wait for
+ * Return:	0 if OK, -ve on error
+ */
+int os_thread_join(struct os_thread *thread);
+
 /**
  * os_get_time_offset() - get time offset
  *
@@ -79,16 +79,41 @@ struct pxe_context;
 typedef int (*pxe_getfile_func)(struct pxe_context *ctx, const char *file_path,
 				char *file_addr, ulong *filesizep);
 
+/**
+ * struct pxe_file - a file to read with the getfiles() function
+ *
+ * @path: Path to the file
+ * @addr: Address to load the file to
+ * @size: Returns the file size in bytes
+ * @ret: Returns 0 if the file was read, else -ve error
+ */
+struct pxe_file {
+	char *path;
+	ulong addr;
+	ulong size;
+	int ret;
+};
+
+typedef int (*pxe_getfiles_func)(struct pxe_context *ctx,
+				 struct pxe_file *files, int count, bool first);
+
+/* Maximum number of files read together for a label */
+#define PXE_PREFETCH_MAX	3
+
 /**
  * struct pxe_context - context information for PXE parsing
  *
  * @cmdtp: Pointer to command table to use when calling other commands
  * @getfile: Function called by PXE to read a file
+ * @getfiles: Function called by PXE to read several files at once, or NULL
+ *	to read them one at a time with @getfile
  * @userdata: Data the caller requires for @getfile
  * @allow_abs_path: true to allow absolute paths
  * @bootdir: Directory that files are loaded from ("" if no directory). This is
  *	allocated
  * @pxe_file_size: Size of the PXE file
+ * @prefetch: Files already read for the label being booted
+ * @prefetch_count: Number of files in @prefetch
  */
 struct pxe_context {
 	struct cmd_tbl *cmdtp;
@@ -104,10 +129,26 @@ struct pxe_context {
 	 */
 	pxe_getfile_func getfile;
 
+	/**
+	 * getfiles() - read several files at once
+	 *
+	 * @ctx: PXE context
+	 * @files: Files to read. The results are returned in each file
+	 * @count: Number of files
+	 * @first: true if the files are alternatives in order of preference,
+	 *	all with the same address, so only the first one which exists
+	 *	is read
+	 * Return: if @first, the index of the file read, else 0 if all the
+	 *	files were read; -ve on error
+	 */
+	pxe_getfiles_func getfiles;
+
 	void *userdata;
 	bool allow_abs_path;
 	char *bootdir;
 	ulong pxe_file_size;
+	struct pxe_file prefetch[PXE_PREFETCH_MAX];
+	int prefetch_count;
 };
 
 /**
@@ -149,6 +190,23 @@ int get_pxe_file(struct pxe_context *ctx, const char *file_path,
 int get_pxelinux_path(struct pxe_context *ctx, const char *file,
 		      ulong pxefile_addr_r);
 
+/**
+ * get_pxelinux_paths() - Read the first of several files in pxelinux.cfg
+ *
+ * This tries each file with get_pxelinux_path() until one is found. If the
+ * context has a getfiles() function, all the files are asked for at once
+ * instead, still preferring them in the order given.
+ *
+ * @ctx: PXE context
+ * @files: Relative paths to the files, in order of preference
+ * @count: Number of files
+ * @pxefile_addr_r: Address to load the file
+ * Returns 1 on success, -ENOENT if none of the files was found or other value
+ * < 0 on error
+ */
+int get_pxelinux_paths(struct pxe_context *ctx, const char *const files[],
+		       int count, ulong pxefile_addr_r);
+
 /**
  * handle_pxe_menu() - Boot the system as prescribed by a pxe_menu.
  *
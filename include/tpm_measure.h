@@ -0,0 +1,155 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Measuring boot images into a TPMv2
+ *
+ * Each measurement is added to an event log and the matching PCR is extended
+ * with the same digest, so that the OS can check the log against the PCRs.
+ *
+ * Hashing large images is the slow part. FIT verification has usually hashed
+ * the same data already, so the digests it calculates are remembered and
+ * used again when the data is measured. Extending PCRs is deferred until
+ * tpm_measure_flush(), which sends all the pending extends together.
+ */
+
+#ifndef __TPM_MEASURE_H
+#define __TPM_MEASURE_H
+
+#include <linux/types.h>
+#include <u-boot/sha256.h>
+
+struct udevice;
+
+/**
+ * struct tpm_measure_event - an event in the log
+ *
+ * This is a TCG_PCR_EVENT2 record with a single SHA-256 digest. All fields
+ * are little-endian.
+ *
+ * @pcr_index: PCR which was extended
+ * @event_type: Type of event, e.g. EV_COMPACT_HASH
+ * @count: Number of digests, always 1
+ * @alg: Algorithm of the digest, always TPM2_ALG_SHA256
+ * @digest: Digest which was extended into the PCR
+ * @event_size: Size of @event in bytes
+ * @event: Event data, e.g. the name of the image
+ */
+struct tpm_measure_event {
+	__le32 pcr_index;
+	__le32 event_type;
+	__le32 count;
+	__le16 alg;
+	u8 digest[SHA256_SUM_LEN];
+	__le32 event_size;
+	u8 event[];
+} __packed;
+
+/* PCRs used when measuring images for the OS */
+enum tpm_measure_pcr {
+	TPM_MEASURE_PCR_CONFIG	= 1,
+	TPM_MEASURE_PCR_KERNEL	= 8,
+	TPM_MEASURE_PCR_DATA	= 9,
+};
+
+#if CONFIG_IS_ENABLED(MEASURED_BOOT) && !defined(USE_HOSTCC)
+/**
+ * tpm_measure_note_digest() - remember a digest calculated for some data
+ *
+ * Only SHA-256 digests are kept, since that is the PCR bank used. Others are
+ * ignored. If the cache is full, the oldest digest is dropped.
+ *
+ * The caller must make sure that the data does not change afterwards,
+ * unless it calls tpm_measure_forget() first.
+ *
+ * @data: Data which was hashed
+ * @size: Size of data in bytes
+ * @algo: Name of the hash algorithm, e.g. "sha256"
+ * @digest: Digest of the data
+ * @digest_len: Length of @digest in bytes
+ */
+void tpm_measure_note_digest(const void *data, ulong size, const char *algo,
+			     const u8 *digest, int digest_len);
+
+/**
+ * tpm_measure_move() - note that data has been copied
+ *
+ * Any digests for memory overlapping the destination are dropped. If there
+ * is a digest for the source, it is also used for the destination.
+ *
+ * @from: Source of the copy
+ * @to: Destination of the copy
+ * @size: Number of bytes copied
+ */
+void tpm_measure_move(const void *from, const void *to, ulong size);
+
+/**
+ * tpm_measure_forget() - drop digests for memory which is about to change
+ *
+ * @data: Start of memory
+ * @size: Size of memory in bytes
+ */
+void tpm_measure_forget(const void *data, ulong size);
+
+/**
+ * tpm_measure_forget_all() - drop all remembered digests
+ */
+void tpm_measure_forget_all(void);
+
+/**
+ * tpm_measure_data() - measure some data
+ *
+ * This adds an event to the log, using a remembered digest if there is
+ * one, or hashing the data otherwise. The PCR is extended by the next
+ * tpm_measure_flush().
+ *
+ * @pcr: PCR to extend
+ * @event_type: Type of event, e.g. EV_COMPACT_HASH
+ * @data: Data to measure
+ * @size: Size of @data in bytes
+ * @event: Event data to put in the log, e.g. the name of the image
+ * @event_size: Size of @event in bytes
+ * Return: 0 if OK, -ENOMEM if the log could not be grown, -EINVAL if @pcr
+ *	is not valid
+ */
+int tpm_measure_data(u32 pcr, u32 event_type, const void *data, ulong size,
+		     const void *event, u32 event_size);
+
+/**
+ * tpm_measure_flush() - extend the PCRs for all pending measurements
+ *
+ * @dev: TPMv2 device to use, or NULL to use the first one
+ * Return: 0 if OK, -ENODEV if there is no TPMv2, -EIO if the TPM reported an
+ *	error. In that case the extends which failed stay pending
+ */
+int tpm_measure_flush(struct udevice *dev);
+
+/**
+ * tpm_measure_get_log() - get the event log
+ *
+ * The log is a list of struct tpm_measure_event records.
+ *
+ * @sizep: Returns the size of the log in bytes
+ * Return: pointer to the log, or NULL if nothing has been measured
+ */
+const void *tpm_measure_get_log(ulong *sizep);
+#else
+static inline void tpm_measure_note_digest(const void *data, ulong size,
+					   const char *algo, const u8 *digest,
+					   int digest_len)
+{
+}
+
+static inline void tpm_measure_move(const void *from, const void *to,
+				    ulong size)
+{
+}
+
+static inline void tpm_measure_forget(const void *data, ulong size)
+{
+}
+
+static inline void tpm_measure_forget_all(void)
+{
+}
+#endif
+
+#endif /* __TPM_MEASURE_H */
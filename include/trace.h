@@ -28,6 +28,7 @@ enum {
 enum trace_chunk_type {
 	TRACE_CHUNK_FUNCS,
 	TRACE_CHUNK_CALLS,
+	TRACE_CHUNK_SAMPLES,
 };
 
 /* A trace record for a function, as written to the profile output file */
@@ -90,6 +91,68 @@ void trace_set_enabled(int enabled);
 
 int trace_early_init(void);
 
+/* A single profiling sample, as written to the profile output file */
+struct trace_sample {
+	uint32_t pc;		/* Interrupted PC, as offset into code */
+	uint32_t lr;		/* Link register, as offset into code */
+	uint32_t time;		/* Timestamp in microseconds */
+};
+
+/**
+ * trace_sample_start() - start the sampling profiler
+ *
+ * The sample buffer is allocated on first use. Any samples already in the
+ * buffer are kept.
+ *
+ * @period_us:	Interval between samples in microseconds
+ * Return: 0 if ok, -ENOMEM if no buffer could be allocated, other -ve on
+ *	error from the architecture code
+ */
+int trace_sample_start(uint period_us);
+
+/**
+ * trace_sample_stop() - stop the sampling profiler
+ *
+ * This is safe to call even if sampling was never started.
+ */
+void trace_sample_stop(void);
+
+/**
+ * trace_sample_record() - record a sample
+ *
+ * This is called from the architecture's timer interrupt handler.
+ *
+ * @pc:		Program counter at the time of the interrupt
+ * @lr:		Link register at the time of the interrupt
+ */
+void trace_sample_record(ulong pc, ulong lr);
+
+/**
+ * trace_list_samples() - dump the recorded samples into a buffer
+ *
+ * Samples are written oldest first, after a struct trace_output_hdr.
+ *
+ * @buff:	Buffer in which to place data
+ * @buff_size:	Size of buffer
+ * @needed:	Returns number of bytes used / needed
+ * Return: 0 if ok, -ENOSPC if space was exhausted
+ */
+int trace_list_samples(void *buff, size_t buff_size, size_t *needed);
+
+/* Print statistics about the sampling profiler */
+void trace_sample_print_stats(void);
+
+/**
+ * arch_trace_sample_start() - start the periodic sampling interrupt
+ *
+ * @period_us:	Interval between samples in microseconds
+ * Return: 0 if ok, -ENOSYS if not supported, other -ve on error
+ */
+int arch_trace_sample_start(uint period_us);
+
+/* arch_trace_sample_stop() - stop the periodic sampling interrupt */
+void arch_trace_sample_stop(void);
+
 /**
  * Init the trace system
  *
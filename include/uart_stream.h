@@ -0,0 +1,86 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * UART stream protocol, for loading images into SPL over a serial line
+ *
+ * This is shared between SPL (common/spl/spl_uart_stream.c) and the sender
+ * (tools/uartboot.c). Every frame is a struct ustream_hdr followed by @len
+ * bytes of payload. All values are little-endian.
+ *
+ * 1. The target sends USTREAM_HELLO every USTREAM_HELLO_MS, with the
+ *    fastest baud rate its UART can run at in @arg
+ * 2. The sender replies with USTREAM_START, with the baud rate it would like
+ *    to use in @arg and a struct ustream_start describing the payload. The
+ *    target replies with USTREAM_ACK at the old baud rate, with the baud
+ *    rate it is switching to in @arg, or USTREAM_NAK if it cannot accept the
+ *    payload
+ * 3. If the baud rate changes, the sender sends USTREAM_SYNC at the new rate
+ *    until the target replies with USTREAM_ACK. If that does not happen
+ *    within USTREAM_SYNC_MS, both sides go back to the old rate and start
+ *    again from step 1
+ * 4. The sender streams USTREAM_DATA frames, with the payload offset in
+ *    @arg, staying no more than USTREAM_WINDOW bytes ahead of the last
+ *    USTREAM_ACK. The target does not reply to each frame: it sends
+ *    USTREAM_ACK with the offset it has reached every half window, and
+ *    USTREAM_NAK with the offset it expects when a frame is lost or
+ *    corrupted. The sender then goes back to that offset
+ * 5. Once the whole payload has arrived, the target checks its CRC32 and
+ *    replies with USTREAM_ACK (or USTREAM_NAK) with the payload size in
+ *    @arg, then goes back to the original baud rate. It does not wait for
+ *    anything more, so if this reply is lost the sender can only warn that
+ *    the payload has probably arrived
+ */
+
+#ifndef __UART_STREAM_H
+#define __UART_STREAM_H
+
+#define USTREAM_MAGIC		0x52545355	/* "USTR" */
+#define USTREAM_BLOCK		4096		/* Maximum data frame payload */
+#define USTREAM_WINDOW		(64 << 10)	/* Maximum data not acked */
+#define USTREAM_HELLO_MS	250
+#define USTREAM_SYNC_MS		1000
+
+/* The payload is in the LZ4 frame format and is decompressed by the target */
+#define USTREAM_F_LZ4		(1 << 0)
+
+enum ustream_type {
+	USTREAM_HELLO		= 1,
+	USTREAM_START,
+	USTREAM_SYNC,
+	USTREAM_DATA,
+	USTREAM_ACK,
+	USTREAM_NAK,
+};
+
+/**
+ * struct ustream_hdr - header of a frame
+ *
+ * @magic: USTREAM_MAGIC
+ * @type: Frame type (enum ustream_type)
+ * @reserved: Must be 0
+ * @len: Number of bytes of payload after the header
+ * @arg: Argument, depending on @type
+ * @crc: CRC32 of the header up to this field and then the payload
+ */
+struct ustream_hdr {
+	uint32_t magic;
+	uint8_t type;
+	uint8_t reserved;
+	uint16_t len;
+	uint32_t arg;
+	uint32_t crc;
+};
+
+/**
+ * struct ustream_start - payload of a USTREAM_START frame
+ *
+ * @size: Number of bytes which will be sent
+ * @crc: CRC32 of those bytes
+ * @flags: USTREAM_F_...
+ */
+struct ustream_start {
+	uint32_t size;
+	uint32_t crc;
+	uint32_t flags;
+};
+
+#endif /* __UART_STREAM_H */
@@ -0,0 +1,155 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Running jobs on the secondary cores
+ *
+ * The secondary cores are normally idle while U-Boot runs. This allows work
+ * which splits easily, such as hashing or clearing large buffers, to be
+ * handed to them. The boot core submits jobs, which are queued and run by
+ * whichever core is free, then waits for each one to finish.
+ */
+
+#ifndef __WORKER_H
+#define __WORKER_H
+
+#include <linux/types.h>
+#include <asm/cache.h>
+
+/**
+ * struct worker_job - a job to run on another core
+ *
+ * Each job is in its own cache line, so that the core running it does not
+ * share a line with the boot core, which may be setting up the next job.
+ * The caller owns the job and must keep it until worker_wait() returns.
+ *
+ * @fn: Function to run. It must not use the console, driver model or
+ *	malloc(), since it may run on a secondary core at the same time as
+ *	U-Boot runs on the boot core
+ * @arg: Argument to pass to @fn
+ * @ret: Value returned by @fn, once @done is set
+ * @done: Set when @fn has returned
+ */
+struct worker_job {
+	int (*fn)(void *arg);
+	void *arg;
+	int ret;
+	u32 done;
+} __aligned(ARCH_DMA_MINALIGN);
+
+#if CONFIG_IS_ENABLED(WORKER)
+/**
+ * worker_submit() - queue a job
+ *
+ * This starts the workers if needed. If there are none, or the queue is
+ * full, the job runs immediately on the boot core.
+ *
+ * This must only be called on the boot core.
+ *
+ * @job: Job to run, with @fn and @arg set up
+ */
+void worker_submit(struct worker_job *job);
+
+/**
+ * worker_wait() - wait for a job to finish
+ *
+ * While waiting, the boot core runs any jobs which are still queued, so
+ * jobs always finish even if no secondary core ever starts.
+ *
+ * @job: Job to wait for, previously passed to worker_submit()
+ * Return: value returned by the job's function
+ */
+int worker_wait(struct worker_job *job);
+
+/**
+ * worker_count() - get the number of workers
+ *
+ * Return: number of secondary cores or threads taking jobs, 0 if none
+ */
+uint worker_count(void);
+
+/**
+ * worker_stop() - stop the workers
+ *
+ * This runs any queued jobs, waits for the workers to finish and sends the
+ * secondary cores back to where they came from, e.g. to wait on the spin
+ * table. It must be called before the OS is started. A later
+ * worker_submit() starts the workers again.
+ */
+void worker_stop(void);
+
+/**
+ * worker_loop() - take and run jobs until the workers are stopped
+ *
+ * This is called by the backend on each worker.
+ *
+ * @id: Number of the worker, from 1
+ */
+void worker_loop(uint id);
+#else
+static inline void worker_submit(struct worker_job *job)
+{
+	job->ret = job->fn(job->arg);
+	job->done = 1;
+}
+
+static inline int worker_wait(struct worker_job *job)
+{
+	return job->ret;
+}
+
+static inline uint worker_count(void)
+{
+	return 0;
+}
+
+static inline void worker_stop(void)
+{
+}
+#endif
+
+/*
+ * Backend, provided by the architecture
+ */
+
+/**
+ * arch_worker_start() - start the workers
+ *
+ * Each worker calls worker_loop() and returns when that does.
+ *
+ * @max: Most workers to start, not counting the boot core
+ * Return: number of workers started, 0 if none
+ */
+uint arch_worker_start(uint max);
+
+/**
+ * arch_worker_stop() - wait for the workers to return from worker_loop()
+ *
+ * This puts them back to where they were before arch_worker_start().
+ */
+void arch_worker_stop(void);
+
+/**
+ * arch_worker_cmpxchg() - atomically compare and exchange, with a barrier
+ *
+ * @ptr: Value to update
+ * @old: Value which *@ptr must have
+ * @new: Value to write if *@ptr is @old
+ * Return: previous value of *@ptr
+ */
+u32 arch_worker_cmpxchg(u32 *ptr, u32 old, u32 new);
+
+/**
+ * arch_worker_sync() - order memory accesses between cores
+ */
+void arch_worker_sync(void);
+
+/**
+ * arch_worker_idle() - wait a little for something to happen
+ */
+void arch_worker_idle(void);
+
+/**
+ * arch_worker_wake() - wake any cores in arch_worker_idle()
+ */
+void arch_worker_wake(void);
+
+#endif /* __WORKER_H */
@@ -16,9 +16,11 @@
 #include <malloc.h>
 #include <pe.h>
 #include <time.h>
+#include <trace.h>
 #include <u-boot/crc.h>
 #include <usb.h>
 #include <watchdog.h>
+#include <worker.h>
 #include <asm/global_data.h>
 #include <asm/setjmp.h>
 #include <linux/libfdt_env.h>
@@ -2166,6 +2168,13 @@ static efi_status_t EFIAPI efi_exit_boot_services(efi_handle_t image_handle,
 			list_del(&evt->link);
 	}
 
+	/* The OS starts the secondary cores itself */
+	worker_stop();
+
+	/* The OS does not expect the sampling timer interrupt to be armed */
+	if (IS_ENABLED(CONFIG_TRACE_SAMPLE))
+		trace_sample_stop();
+
 	if (!efi_st_keep_devices) {
 		bootm_disable_interrupts();
 		if (IS_ENABLED(CONFIG_USB_DEVICE))
@@ -3026,6 +3035,9 @@ efi_status_t EFIAPI efi_start_image(efi_handle_t image_handle,
 		}
 	}
 
+	/* U-Boot may have written to the block devices since the last image */
+	efi_disk_cache_invalidate(NULL);
+
 	/* call the image! */
 	if (setjmp(&exit_jmp)) {
 		/*
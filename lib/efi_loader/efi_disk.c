@@ -15,6 +15,7 @@
 #include <log.h>
 #include <part.h>
 #include <malloc.h>
+#include <asm/cache.h>
 
 struct efi_system_partition efi_system_partition;
 
@@ -34,6 +35,7 @@ const efi_guid_t efi_system_partition_guid = PARTITION_SYSTEM_GUID;
  * @volume:	simple file system protocol of the partition
  * @offset:	offset into disk for simple partition
  * @desc:	internal block device descriptor
+ * @cache:	read-ahead cache of the block device
  */
 struct efi_disk_obj {
 	struct efi_object header;
@@ -46,8 +48,157 @@ struct efi_disk_obj {
 	struct efi_simple_file_system_protocol *volume;
 	lbaint_t offset;
 	struct blk_desc *desc;
+	struct efi_disk_cache *cache;
 };
 
+/**
+ * struct efi_disk_cache - read-ahead cache of a block device
+ *
+ * A block device and its partitions share one cache. When a read starts
+ * where the previous one ended, the blocks following it are read as well,
+ * up to EFI_DISK_READ_AHEAD_SIZE bytes, so that the following small
+ * reads are served from memory.
+ *
+ * @link:	link in efi_disk_caches
+ * @desc:	block device
+ * @buf:	cached blocks, or NULL if not allocated yet
+ * @start:	first block in @buf
+ * @count:	number of valid blocks in @buf
+ * @next:	block following the last read
+ * @stats:	statistics
+ */
+struct efi_disk_cache {
+	struct list_head link;
+	struct blk_desc *desc;
+	void *buf;
+	lbaint_t start;
+	lbaint_t count;
+	lbaint_t next;
+	struct efi_disk_cache_stats stats;
+};
+
+#ifdef CONFIG_EFI_DISK_READ_AHEAD
+#define EFI_DISK_READ_AHEAD_SIZE	CONFIG_EFI_DISK_READ_AHEAD_SIZE
+#else
+#define EFI_DISK_READ_AHEAD_SIZE	0
+#endif
+
+static LIST_HEAD(efi_disk_caches);
+
+/**
+ * efi_disk_get_cache() - get the read-ahead cache of a block device
+ *
+ * @desc:	block device
+ * Return:	cache, or NULL if out of memory
+ */
+static struct efi_disk_cache *efi_disk_get_cache(struct blk_desc *desc)
+{
+	struct efi_disk_cache *cache;
+
+	list_for_each_entry(cache, &efi_disk_caches, link) {
+		if (cache->desc == desc)
+			return cache;
+	}
+
+	cache = calloc(1, sizeof(*cache));
+	if (!cache)
+		return NULL;
+	cache->desc = desc;
+	cache->stats.desc = desc;
+	list_add_tail(&cache->link, &efi_disk_caches);
+
+	return cache;
+}
+
+void efi_disk_cache_invalidate(struct blk_desc *desc)
+{
+	struct efi_disk_cache *cache;
+
+	list_for_each_entry(cache, &efi_disk_caches, link) {
+		if (!desc || cache->desc == desc) {
+			cache->count = 0;
+			cache->next = 0;
+		}
+	}
+}
+
+int efi_disk_get_cache_stats(int index, struct efi_disk_cache_stats *stats)
+{
+	struct efi_disk_cache *cache;
+
+	list_for_each_entry(cache, &efi_disk_caches, link) {
+		if (!index--) {
+			*stats = cache->stats;
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+/**
+ * efi_disk_cache_read() - read blocks through the read-ahead cache
+ *
+ * @cache:	cache of the block device
+ * @lba:	first block to read
+ * @blocks:	number of blocks to read
+ * @buffer:	buffer to read into
+ * Return:	number of blocks read
+ */
+static ulong efi_disk_cache_read(struct efi_disk_cache *cache, lbaint_t lba,
+				 lbaint_t blocks, void *buffer)
+{
+	struct blk_desc *desc = cache->desc;
+	lbaint_t size = EFI_DISK_READ_AHEAD_SIZE / desc->blksz;
+	lbaint_t done = 0;
+	ulong n;
+
+	cache->stats.reads++;
+
+	/* Use what is already in the cache */
+	if (lba >= cache->start && lba < cache->start + cache->count) {
+		done = min(blocks, cache->start + cache->count - lba);
+		memcpy(buffer, cache->buf + (lba - cache->start) * desc->blksz,
+		       done * desc->blksz);
+		if (done == blocks) {
+			cache->stats.hits++;
+			cache->next = lba + blocks;
+			return blocks;
+		}
+		lba += done;
+		blocks -= done;
+		buffer += done * desc->blksz;
+	}
+
+	/* Only read ahead once the device is being read sequentially */
+	if (size && blocks < size && (done || lba == cache->next)) {
+		if (!cache->buf)
+			cache->buf = memalign(ARCH_DMA_MINALIGN,
+					      size * desc->blksz);
+		if (cache->buf) {
+			size = min(size, desc->lba - lba);
+			cache->count = 0;
+			n = blk_dread(desc, lba, size, cache->buf);
+			if (n < blocks)
+				return done;
+			cache->start = lba;
+			cache->count = n;
+			cache->next = lba + blocks;
+			cache->stats.fills++;
+			cache->stats.blocks += n;
+			memcpy(buffer, cache->buf, blocks * desc->blksz);
+
+			return done + blocks;
+		}
+	}
+
+	n = blk_dread(desc, lba, blocks, buffer);
+	cache->next = lba + n;
+	cache->stats.blocks += n;
+
+	return done + n;
+}
+
 /**
  * efi_disk_reset() - reset block device
  *
@@ -98,10 +249,18 @@ static efi_status_t efi_disk_rw_blocks(struct efi_block_io *this,
 	if (buffer_size & (blksz - 1))
 		return EFI_BAD_BUFFER_SIZE;
 
-	if (direction == EFI_DISK_READ)
-		n = blk_dread(desc, lba, blocks, buffer);
-	else
+	if (direction == EFI_DISK_READ) {
+		if (IS_ENABLED(CONFIG_EFI_DISK_READ_AHEAD) && diskobj->cache)
+			n = efi_disk_cache_read(diskobj->cache, lba, blocks,
+						buffer);
+		else
+			n = blk_dread(desc, lba, blocks, buffer);
+	} else {
+		/* A file system on the device may change under open files */
+		efi_disk_cache_invalidate(desc);
+		efi_file_modified();
 		n = blk_dwrite(desc, lba, blocks, buffer);
+	}
 
 	/* We don't do interrupts, so check for timers cooperatively */
 	efi_timer_check();
@@ -444,6 +603,8 @@ static efi_status_t efi_disk_add_dev(
 	diskobj->ifname = if_typename;
 	diskobj->dev_index = dev_index;
 	diskobj->desc = desc;
+	if (IS_ENABLED(CONFIG_EFI_DISK_READ_AHEAD))
+		diskobj->cache = efi_disk_get_cache(desc);
 
 	/* Fill in EFI IO Media info (for read/write callbacks) */
 	diskobj->media.removable_media = desc->removable;
@@ -25,6 +25,9 @@ struct file_system {
 	struct efi_device_path *dp;
 	struct blk_desc *desc;
 	int part;
+	/* partition information, valid once fstype is set */
+	struct disk_partition part_info;
+	int fstype;
 };
 #define to_fs(x) container_of(x, struct file_system, base)
 
@@ -39,12 +42,23 @@ struct file_handle {
 	struct fs_dir_stream *dirs;
 	struct fs_dirent *dent;
 
+	/* for reading a file, valid while gen matches efi_file_gen: */
+	uint gen;
+	loff_t size;		/* file size, or -1 if not known */
+	loff_t last_end;	/* file position after the last read */
+	void *ra_buf;		/* read-ahead buffer, allocated when needed */
+	loff_t ra_offset;	/* file position of ra_buf */
+	loff_t ra_len;		/* number of valid bytes in ra_buf */
+
 	char path[0];
 };
 #define to_fh(x) container_of(x, struct file_handle, base)
 
 static const struct efi_file_handle efi_file_handle_protocol;
 
+/* incremented whenever a file system may have been modified */
+static uint efi_file_gen;
+
 static char *basename(struct file_handle *fh)
 {
 	char *s = strrchr(fh->path, '/');
@@ -53,9 +67,71 @@ static char *basename(struct file_handle *fh)
 	return fh->path;
 }
 
+/**
+ * set_blk_dev() - open the file system of a file handle
+ *
+ * The partition information and file system type found the first time are
+ * kept, so that later calls only need to probe a single file system.
+ *
+ * @fh:		file handle
+ * Return:	0 for success
+ */
 static int set_blk_dev(struct file_handle *fh)
 {
-	return fs_set_blk_dev_with_part(fh->fs->desc, fh->fs->part);
+	struct file_system *fs = fh->fs;
+	int ret;
+
+	if (fs->fstype != FS_TYPE_ANY &&
+	    !fs_set_blk_dev_with_part_info(fs->desc, fs->part, &fs->part_info,
+					   fs->fstype))
+		return 0;
+
+	if (fs->part >= 1)
+		ret = part_get_info(fs->desc, fs->part, &fs->part_info);
+	else
+		ret = part_get_info_whole_disk(fs->desc, &fs->part_info);
+	if (!ret)
+		ret = fs_set_blk_dev_with_part_info(fs->desc, fs->part,
+						    &fs->part_info,
+						    FS_TYPE_ANY);
+	fs->fstype = ret ? FS_TYPE_ANY : fs_get_type();
+
+	return ret;
+}
+
+void efi_file_modified(void)
+{
+	efi_file_gen++;
+}
+
+/**
+ * fs_modified() - note that a file system is about to be modified
+ *
+ * This drops the data cached by open file handles and by the block device.
+ *
+ * @fs:		file system
+ */
+static void fs_modified(struct file_system *fs)
+{
+	efi_file_modified();
+	efi_disk_cache_invalidate(fs->desc);
+}
+
+/**
+ * check_cache() - drop the cached state of a file if it may be stale
+ *
+ * @fh:		file handle
+ */
+static void check_cache(struct file_handle *fh)
+{
+	if (fh->gen == efi_file_gen)
+		return;
+	fh->gen = efi_file_gen;
+	fh->size = -1;
+	/* the buffer is sized to the file, which may have changed */
+	free(fh->ra_buf);
+	fh->ra_buf = NULL;
+	fh->ra_len = 0;
 }
 
 /**
@@ -199,6 +275,9 @@ static struct efi_file_handle *file_open(struct file_system *fs,
 	fh->open_mode = open_mode;
 	fh->base = efi_file_handle_protocol;
 	fh->fs = fs;
+	fh->gen = efi_file_gen;
+	fh->size = -1;
+	fh->last_end = -1;
 
 	if (parent) {
 		char *p = fh->path;
@@ -225,8 +304,10 @@ static struct efi_file_handle *file_open(struct file_system *fs,
 			goto error;
 
 		if (!exists) {
-			if (!(open_mode & EFI_FILE_MODE_CREATE) ||
-			    efi_create_file(fh, attributes))
+			if (!(open_mode & EFI_FILE_MODE_CREATE))
+				goto error;
+			fs_modified(fs);
+			if (efi_create_file(fh, attributes))
 				goto error;
 			if (set_blk_dev(fh))
 				goto error;
@@ -365,6 +446,7 @@ out:
 static efi_status_t file_close(struct file_handle *fh)
 {
 	fs_closedir(fh->dirs);
+	free(fh->ra_buf);
 	free(fh);
 	return EFI_SUCCESS;
 }
@@ -383,6 +465,7 @@ static efi_status_t EFIAPI efi_file_delete(struct efi_file_handle *file)
 
 	EFI_ENTRY("%p", file);
 
+	fs_modified(fh->fs);
 	if (set_blk_dev(fh) || fs_unlink(fh->path))
 		ret = EFI_WARN_DELETE_FAILURE;
 
@@ -400,11 +483,17 @@ static efi_status_t EFIAPI efi_file_delete(struct efi_file_handle *file)
 static efi_status_t efi_get_file_size(struct file_handle *fh,
 				      loff_t *file_size)
 {
-	if (set_blk_dev(fh))
-		return EFI_DEVICE_ERROR;
+	check_cache(fh);
+	if (fh->size < 0) {
+		if (set_blk_dev(fh))
+			return EFI_DEVICE_ERROR;
 
-	if (fs_size(fh->path, file_size))
-		return EFI_DEVICE_ERROR;
+		if (fs_size(fh->path, &fh->size)) {
+			fh->size = -1;
+			return EFI_DEVICE_ERROR;
+		}
+	}
+	*file_size = fh->size;
 
 	return EFI_SUCCESS;
 }
@@ -448,12 +537,52 @@ out:
 	return ret;
 }
 
+/**
+ * read_ahead() - read from a file through the read-ahead buffer
+ *
+ * The buffer is refilled from @pos with a single file system read. It is
+ * allocated on first use, no larger than the file.
+ *
+ * @fh:		file handle
+ * @pos:	file position to read from
+ * @len:	number of bytes to read
+ * @buffer:	buffer to read into
+ * @actread:	returns the number of bytes read
+ * Return:	0 for success, -ENOMEM if there is no buffer, other -ve on error
+ */
+static int read_ahead(struct file_handle *fh, loff_t pos, loff_t len,
+		      void *buffer, loff_t *actread)
+{
+	loff_t fill = min_t(loff_t, CONFIG_EFI_FILE_READ_AHEAD,
+			    fh->size - pos);
+
+	if (!fh->ra_buf) {
+		fh->ra_buf = malloc(min_t(loff_t, CONFIG_EFI_FILE_READ_AHEAD,
+					  fh->size));
+		if (!fh->ra_buf)
+			return -ENOMEM;
+	}
+
+	fh->ra_len = 0;
+	if (set_blk_dev(fh) ||
+	    fs_read(fh->path, map_to_sysmem(fh->ra_buf), pos, fill,
+		    &fh->ra_len))
+		return -EIO;
+	fh->ra_offset = pos;
+
+	*actread = min(len, fh->ra_len);
+	memcpy(buffer, fh->ra_buf, *actread);
+
+	return 0;
+}
+
 static efi_status_t file_read(struct file_handle *fh, u64 *buffer_size,
 		void *buffer)
 {
-	loff_t actread;
+	loff_t actread = 0;
 	efi_status_t ret;
 	loff_t file_size;
+	loff_t len, done = 0;
 
 	if (!buffer) {
 		ret = EFI_INVALID_PARAMETER;
@@ -468,14 +597,42 @@ static efi_status_t file_read(struct file_handle *fh, u64 *buffer_size,
 		return ret;
 	}
 
-	if (set_blk_dev(fh))
-		return EFI_DEVICE_ERROR;
-	if (fs_read(fh->path, map_to_sysmem(buffer), fh->offset,
-		    *buffer_size, &actread))
-		return EFI_DEVICE_ERROR;
+	len = min_t(u64, *buffer_size, file_size - fh->offset);
+
+	/* Use what is already in the read-ahead buffer */
+	if (len && fh->offset >= fh->ra_offset &&
+	    fh->offset < fh->ra_offset + fh->ra_len) {
+		done = min(len, fh->ra_offset + fh->ra_len - fh->offset);
+		memcpy(buffer, fh->ra_buf + (fh->offset - fh->ra_offset), done);
+	}
+
+	if (done < len) {
+		loff_t pos = fh->offset + done;
+		loff_t rest = len - done;
+		bool ahead;
+		int err;
+
+		/* Only read ahead once the file is being read sequentially */
+		ahead = rest < CONFIG_EFI_FILE_READ_AHEAD &&
+			(done || fh->offset == fh->last_end);
+		if (ahead) {
+			err = read_ahead(fh, pos, rest, buffer + done,
+					 &actread);
+			if (err && err != -ENOMEM)
+				return EFI_DEVICE_ERROR;
+			ahead = !err;
+		}
+		if (!ahead &&
+		    (set_blk_dev(fh) ||
+		     fs_read(fh->path, map_to_sysmem(buffer + done), pos, rest,
+			     &actread)))
+			return EFI_DEVICE_ERROR;
+		done += actread;
+	}
 
-	*buffer_size = actread;
-	fh->offset += actread;
+	*buffer_size = done;
+	fh->offset += done;
+	fh->last_end = fh->offset;
 
 	return EFI_SUCCESS;
 }
@@ -668,6 +825,7 @@ static efi_status_t efi_file_write_int(struct efi_file_handle *this,
 	if (!*buffer_size)
 		goto out;
 
+	fs_modified(fh->fs);
 	if (set_blk_dev(fh)) {
 		ret = EFI_DEVICE_ERROR;
 		goto out;
@@ -13,7 +13,6 @@
 #include <watchdog.h>
 #include <asm/cache.h>
 #include <asm/global_data.h>
-#include <linux/list_sort.h>
 #include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -23,17 +22,14 @@ DECLARE_GLOBAL_DATA_PTR;
 
 efi_uintn_t efi_memory_map_key;
 
-struct efi_mem_list {
-	struct list_head link;
-	struct efi_mem_desc desc;
-};
-
-#define EFI_CARVE_NO_OVERLAP		-1
-#define EFI_CARVE_LOOP_AGAIN		-2
-#define EFI_CARVE_OVERLAPS_NONRAM	-3
-
-/* This list contains all memory map items */
-LIST_HEAD(efi_mem);
+/*
+ * The memory map, sorted by ascending address. Entries do not overlap and
+ * adjacent entries with the same type and attributes are merged, so lookups
+ * can use a binary search.
+ */
+static struct efi_mem_desc *efi_mem;
+static int efi_mem_count;
+static int efi_mem_alloc;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 void *efi_bounce_buffer;
@@ -46,9 +42,10 @@ void *efi_bounce_buffer;
  * @checksum:	checksum
  * @data:	allocated pool memory
  *
- * U-Boot services each UEFI AllocatePool() request as a separate
- * (multiple) page allocation. We have to track the number of pages
- * to be able to free the correct amount later.
+ * Pool requests which are too large for a pool chunk (see struct
+ * efi_pool_chunk) are serviced as a separate (multiple) page allocation. We
+ * have to track the number of pages to be able to free the correct amount
+ * later.
  *
  * The checksum calculated in function checksum() is used in FreePool() to avoid
  * freeing memory not allocated by AllocatePool() and duplicate freeing.
@@ -62,6 +59,64 @@ struct efi_pool_allocation {
 	char data[] __aligned(ARCH_DMA_MINALIGN);
 };
 
+/*
+ * Smaller pool requests are served from chunks of EFI_POOL_CHUNK_PAGES pages,
+ * each divided into slots of a single size. Slot sizes are powers of two from
+ * EFI_POOL_MIN_SLOT to EFI_POOL_MAX_SLOT, so every slot keeps the alignment
+ * given by struct efi_pool_allocation.
+ */
+#define EFI_POOL_CHUNK_PAGES	16
+#define EFI_POOL_CHUNK_SIZE	(EFI_POOL_CHUNK_PAGES << EFI_PAGE_SHIFT)
+#define EFI_POOL_MIN_SLOT	(ARCH_DMA_MINALIGN > 64 ? ARCH_DMA_MINALIGN : 64)
+#define EFI_POOL_MAX_SLOT	2048
+#define EFI_POOL_MAX_CLASSES	6	/* 64 to 2048 bytes */
+#define EFI_POOL_MAX_SLOTS	(EFI_POOL_CHUNK_SIZE / EFI_POOL_MIN_SLOT)
+#define EFI_POOL_BIT(slot)	(1UL << ((slot) % BITS_PER_LONG))
+
+/**
+ * struct efi_pool_chunk - pages divided into pool slots of one size
+ *
+ * This is held in U-Boot's malloc() area, so a payload which writes outside
+ * its buffers cannot corrupt it.
+ *
+ * @link:	link in @partial while the chunk has free slots
+ * @partial:	the arena's list of chunks with free slots of this size
+ * @start:	address of the first page
+ * @slot_size:	size of each slot in bytes
+ * @num_slots:	number of slots
+ * @used:	number of slots in use
+ * @bitmap:	bit set for each slot in use
+ */
+struct efi_pool_chunk {
+	struct list_head link;
+	struct list_head *partial;
+	u64 start;
+	uint slot_size;
+	uint num_slots;
+	uint used;
+	ulong bitmap[BITS_TO_LONGS(EFI_POOL_MAX_SLOTS)];
+};
+
+/**
+ * struct efi_pool_arena - pool chunks for one memory type
+ *
+ * @link:	link in efi_pool_arenas
+ * @type:	memory type of the chunks
+ * @partial:	chunks which have free slots, for each slot size
+ */
+struct efi_pool_arena {
+	struct list_head link;
+	int type;
+	struct list_head partial[EFI_POOL_MAX_CLASSES];
+};
+
+static LIST_HEAD(efi_pool_arenas);
+
+/* All pool chunks, sorted by address, to find the chunk for a pointer */
+static struct efi_pool_chunk **efi_pool_chunks;
+static int efi_pool_chunk_count;
+static int efi_pool_chunk_alloc;
+
 /**
  * checksum() - calculate checksum for memory allocated from pool
  *
@@ -78,156 +133,95 @@ static u64 checksum(struct efi_pool_allocation *alloc)
 	return ret;
 }
 
-/*
- * Sorts the memory list from highest address to lowest address
- *
- * When allocating memory we should always start from the highest
- * address chunk, so sort the memory list such that the first list
- * iterator gets the highest address and goes lower from there.
- */
-static int efi_mem_cmp(void *priv, struct list_head *a, struct list_head *b)
-{
-	struct efi_mem_list *mema = list_entry(a, struct efi_mem_list, link);
-	struct efi_mem_list *memb = list_entry(b, struct efi_mem_list, link);
-
-	if (mema->desc.physical_start == memb->desc.physical_start)
-		return 0;
-	else if (mema->desc.physical_start < memb->desc.physical_start)
-		return 1;
-	else
-		return -1;
-}
-
 static uint64_t desc_get_end(struct efi_mem_desc *desc)
 {
 	return desc->physical_start + (desc->num_pages << EFI_PAGE_SHIFT);
 }
 
-static void efi_mem_sort(void)
+/**
+ * efi_mem_search() - find the first memory map entry ending after an address
+ *
+ * @addr:	address to look for
+ * Return:	index of the entry, or efi_mem_count if there is none
+ */
+static int efi_mem_search(u64 addr)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *prevmem = NULL;
-	bool merge_again = true;
-
-	list_sort(NULL, &efi_mem, efi_mem_cmp);
-
-	/* Now merge entries that can be merged */
-	while (merge_again) {
-		merge_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			struct efi_mem_desc *prev = &prevmem->desc;
-			struct efi_mem_desc *cur;
-			uint64_t pages;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			if (!prevmem) {
-				prevmem = lmem;
-				continue;
-			}
-
-			cur = &lmem->desc;
-
-			if ((desc_get_end(cur) == prev->physical_start) &&
-			    (prev->type == cur->type) &&
-			    (prev->attribute == cur->attribute)) {
-				/* There is an existing map before, reuse it */
-				pages = cur->num_pages;
-				prev->num_pages += pages;
-				prev->physical_start -= pages << EFI_PAGE_SHIFT;
-				prev->virtual_start -= pages << EFI_PAGE_SHIFT;
-				list_del(&lmem->link);
-				free(lmem);
-
-				merge_again = true;
-				break;
-			}
-
-			prevmem = lmem;
-		}
+	int lo = 0, hi = efi_mem_count;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (desc_get_end(&efi_mem[mid]) <= addr)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
+
+	return lo;
 }
 
-/** efi_mem_carve_out - unmap memory region
- *
- * @map:		memory map
- * @carve_desc:		memory region to unmap
- * @overlap_only_ram:	the carved out region may only overlap RAM
- * Return Value:	the number of overlapping pages which have been
- *			removed from the map,
- *			EFI_CARVE_NO_OVERLAP, if the regions don't overlap,
- *			EFI_CARVE_OVERLAPS_NONRAM, if the carve and map overlap,
- *			and the map contains anything but free ram
- *			(only when overlap_only_ram is true),
- *			EFI_CARVE_LOOP_AGAIN, if the mapping list should be
- *			traversed again, as it has been altered.
- *
- * Unmaps all memory occupied by the carve_desc region from the list entry
- * pointed to by map.
- *
- * In case of EFI_CARVE_OVERLAPS_NONRAM it is the callers responsibility
- * to re-add the already carved out pages to the mapping.
- */
-static s64 efi_mem_carve_out(struct efi_mem_list *map,
-			     struct efi_mem_desc *carve_desc,
-			     bool overlap_only_ram)
+/* Check whether two memory map entries can be combined into one */
+static bool efi_mem_can_merge(struct efi_mem_desc *prev,
+			      struct efi_mem_desc *cur)
 {
-	struct efi_mem_list *newmap;
-	struct efi_mem_desc *map_desc = &map->desc;
-	uint64_t map_start = map_desc->physical_start;
-	uint64_t map_end = map_start + (map_desc->num_pages << EFI_PAGE_SHIFT);
-	uint64_t carve_start = carve_desc->physical_start;
-	uint64_t carve_end = carve_start +
-			     (carve_desc->num_pages << EFI_PAGE_SHIFT);
-
-	/* check whether we're overlapping */
-	if ((carve_end <= map_start) || (carve_start >= map_end))
-		return EFI_CARVE_NO_OVERLAP;
-
-	/* We're overlapping with non-RAM, warn the caller if desired */
-	if (overlap_only_ram && (map_desc->type != EFI_CONVENTIONAL_MEMORY))
-		return EFI_CARVE_OVERLAPS_NONRAM;
-
-	/* Sanitize carve_start and carve_end to lie within our bounds */
-	carve_start = max(carve_start, map_start);
-	carve_end = min(carve_end, map_end);
-
-	/* Carving at the beginning of our map? Just move it! */
-	if (carve_start == map_start) {
-		if (map_end == carve_end) {
-			/* Full overlap, just remove map */
-			list_del(&map->link);
-			free(map);
-		} else {
-			map->desc.physical_start = carve_end;
-			map->desc.virtual_start = carve_end;
-			map->desc.num_pages = (map_end - carve_end)
-					      >> EFI_PAGE_SHIFT;
-		}
-
-		return (carve_end - carve_start) >> EFI_PAGE_SHIFT;
-	}
+	return desc_get_end(prev) == cur->physical_start &&
+		prev->type == cur->type && prev->attribute == cur->attribute;
+}
 
-	/*
-	 * Overlapping maps, just split the list map at carve_start,
-	 * it will get moved or removed in the next iteration.
-	 *
-	 * [ map_desc |__carve_start__| newmap ]
-	 */
+/**
+ * efi_mem_splice() - replace entries in the memory map
+ *
+ * Entries @start to @end - 1 are replaced by the @count entries in @desc,
+ * which must lie between the neighbouring entries. These are then merged
+ * with their neighbours where possible.
+ *
+ * @start:	index of the first entry to replace
+ * @end:	index after the last entry to replace
+ * @desc:	new entries
+ * @count:	number of new entries
+ * Return:	status code
+ */
+static efi_status_t efi_mem_splice(int start, int end,
+				   struct efi_mem_desc *desc, int count)
+{
+	int new_count = efi_mem_count - (end - start) + count;
+	int i, first, last;
 
-	/* Create a new map from [ carve_start ... map_end ] */
-	newmap = calloc(1, sizeof(*newmap));
-	newmap->desc = map->desc;
-	newmap->desc.physical_start = carve_start;
-	newmap->desc.virtual_start = carve_start;
-	newmap->desc.num_pages = (map_end - carve_start) >> EFI_PAGE_SHIFT;
-	/* Insert before current entry (descending address order) */
-	list_add_tail(&newmap->link, &map->link);
+	if (new_count > efi_mem_alloc) {
+		int alloc = max(new_count, efi_mem_alloc * 2);
+		struct efi_mem_desc *map;
 
-	/* Shrink the map to [ map_start ... carve_start ] */
-	map_desc->num_pages = (carve_start - map_start) >> EFI_PAGE_SHIFT;
+		alloc = max(alloc, 32);
+		map = realloc(efi_mem, alloc * sizeof(*map));
+		if (!map)
+			return EFI_OUT_OF_RESOURCES;
+		efi_mem = map;
+		efi_mem_alloc = alloc;
+	}
+	memmove(&efi_mem[start + count], &efi_mem[end],
+		(efi_mem_count - end) * sizeof(*efi_mem));
+	memcpy(&efi_mem[start], desc, count * sizeof(*efi_mem));
+	efi_mem_count = new_count;
+
+	/* Merge the new entries with each other and their neighbours */
+	first = max(start - 1, 0);
+	last = min(start + count, efi_mem_count - 1);
+	for (i = first; i < last; ) {
+		struct efi_mem_desc *prev = &efi_mem[i];
+		struct efi_mem_desc *cur = &efi_mem[i + 1];
+
+		if (!efi_mem_can_merge(prev, cur)) {
+			i++;
+			continue;
+		}
+		prev->num_pages += cur->num_pages;
+		memmove(cur, cur + 1,
+			(efi_mem_count - i - 2) * sizeof(*efi_mem));
+		efi_mem_count--;
+		last--;
+	}
 
-	return EFI_CARVE_LOOP_AGAIN;
+	return EFI_SUCCESS;
 }
 
 /**
@@ -243,11 +237,14 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 					  int memory_type,
 					  bool overlap_only_ram)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *newlist;
-	bool carve_again;
+	struct efi_mem_desc desc[3];
+	struct efi_mem_desc *newdesc;
 	uint64_t carved_pages = 0;
 	struct efi_event *evt;
+	u64 end = start + (pages << EFI_PAGE_SHIFT);
+	efi_status_t ret;
+	int first, last;
+	int count = 0;
 
 	EFI_PRINT("%s: 0x%llx 0x%llx %d %s\n", __func__,
 		  start, pages, memory_type, overlap_only_ram ? "yes" : "no");
@@ -259,79 +256,68 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 		return EFI_SUCCESS;
 
 	++efi_memory_map_key;
-	newlist = calloc(1, sizeof(*newlist));
-	newlist->desc.type = memory_type;
-	newlist->desc.physical_start = start;
-	newlist->desc.virtual_start = start;
-	newlist->desc.num_pages = pages;
 
+	/* Find the entries which overlap the new one */
+	first = efi_mem_search(start);
+	for (last = first; last < efi_mem_count &&
+	     efi_mem[last].physical_start < end; last++) {
+		struct efi_mem_desc *cur = &efi_mem[last];
+
+		/*
+		 * The user requested to only have RAM overlaps, but we hit a
+		 * non-RAM region. Error out.
+		 */
+		if (overlap_only_ram && cur->type != EFI_CONVENTIONAL_MEMORY)
+			return EFI_NO_MAPPING;
+		carved_pages += (min(end, desc_get_end(cur)) -
+				 max(start, cur->physical_start)) >>
+				EFI_PAGE_SHIFT;
+	}
+
+	if (overlap_only_ram && (carved_pages != pages)) {
+		/*
+		 * The payload wanted to have RAM overlaps, but we overlapped
+		 * with an unallocated region. Error out.
+		 */
+		return EFI_NO_MAPPING;
+	}
+
+	/* Keep the parts of the overlapped entries outside the new one */
+	if (first < last && efi_mem[first].physical_start < start) {
+		desc[count] = efi_mem[first];
+		desc[count++].num_pages = (start - efi_mem[first].physical_start)
+					  >> EFI_PAGE_SHIFT;
+	}
+
+	newdesc = &desc[count++];
+	newdesc->type = memory_type;
+	newdesc->physical_start = start;
+	newdesc->virtual_start = start;
+	newdesc->num_pages = pages;
 	switch (memory_type) {
 	case EFI_RUNTIME_SERVICES_CODE:
 	case EFI_RUNTIME_SERVICES_DATA:
-		newlist->desc.attribute = EFI_MEMORY_WB | EFI_MEMORY_RUNTIME;
+		newdesc->attribute = EFI_MEMORY_WB | EFI_MEMORY_RUNTIME;
 		break;
 	case EFI_MMAP_IO:
-		newlist->desc.attribute = EFI_MEMORY_RUNTIME;
+		newdesc->attribute = EFI_MEMORY_RUNTIME;
 		break;
 	default:
-		newlist->desc.attribute = EFI_MEMORY_WB;
+		newdesc->attribute = EFI_MEMORY_WB;
 		break;
 	}
 
-	/* Add our new map */
-	do {
-		carve_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			s64 r;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			r = efi_mem_carve_out(lmem, &newlist->desc,
-					      overlap_only_ram);
-			switch (r) {
-			case EFI_CARVE_OVERLAPS_NONRAM:
-				/*
-				 * The user requested to only have RAM overlaps,
-				 * but we hit a non-RAM region. Error out.
-				 */
-				return EFI_NO_MAPPING;
-			case EFI_CARVE_NO_OVERLAP:
-				/* Just ignore this list entry */
-				break;
-			case EFI_CARVE_LOOP_AGAIN:
-				/*
-				 * We split an entry, but need to loop through
-				 * the list again to actually carve it.
-				 */
-				carve_again = true;
-				break;
-			default:
-				/* We carved a number of pages */
-				carved_pages += r;
-				carve_again = true;
-				break;
-			}
-
-			if (carve_again) {
-				/* The list changed, we need to start over */
-				break;
-			}
-		}
-	} while (carve_again);
-
-	if (overlap_only_ram && (carved_pages != pages)) {
-		/*
-		 * The payload wanted to have RAM overlaps, but we overlapped
-		 * with an unallocated region. Error out.
-		 */
-		return EFI_NO_MAPPING;
+	if (first < last && desc_get_end(&efi_mem[last - 1]) > end) {
+		desc[count] = efi_mem[last - 1];
+		desc[count].physical_start = end;
+		desc[count].virtual_start = end;
+		desc[count++].num_pages = (desc_get_end(&efi_mem[last - 1]) -
+					   end) >> EFI_PAGE_SHIFT;
 	}
 
-	/* Add our new map */
-        list_add_tail(&newlist->link, &efi_mem);
-
-	/* And make sure memory is listed in descending order */
-	efi_mem_sort();
+	ret = efi_mem_splice(first, last, desc, count);
+	if (ret != EFI_SUCCESS)
+		return ret;
 
 	/* Notify that the memory map was changed */
 	list_for_each_entry(evt, &efi_events, link) {
@@ -385,19 +371,14 @@ efi_status_t efi_add_memory_map(u64 start, u64 size, int memory_type)
  */
 static efi_status_t efi_check_allocated(u64 addr, bool must_be_allocated)
 {
-	struct efi_mem_list *item;
-
-	list_for_each_entry(item, &efi_mem, link) {
-		u64 start = item->desc.physical_start;
-		u64 end = start + (item->desc.num_pages << EFI_PAGE_SHIFT);
-
-		if (addr >= start && addr < end) {
-			if (must_be_allocated ^
-			    (item->desc.type == EFI_CONVENTIONAL_MEMORY))
-				return EFI_SUCCESS;
-			else
-				return EFI_NOT_FOUND;
-		}
+	int i = efi_mem_search(addr);
+
+	if (i < efi_mem_count && addr >= efi_mem[i].physical_start) {
+		if (must_be_allocated ^
+		    (efi_mem[i].type == EFI_CONVENTIONAL_MEMORY))
+			return EFI_SUCCESS;
+		else
+			return EFI_NOT_FOUND;
 	}
 
 	return EFI_NOT_FOUND;
@@ -405,7 +386,7 @@ static efi_status_t efi_check_allocated(u64 addr, bool must_be_allocated)
 
 static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
 {
-	struct list_head *lhandle;
+	int i;
 
 	/*
 	 * Prealign input max address, so we simplify our matching
@@ -413,12 +394,10 @@ static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
 	 */
 	max_addr &= ~EFI_PAGE_MASK;
 
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem = list_entry(lhandle,
-			struct efi_mem_list, link);
-		struct efi_mem_desc *desc = &lmem->desc;
-		uint64_t desc_len = desc->num_pages << EFI_PAGE_SHIFT;
-		uint64_t desc_end = desc->physical_start + desc_len;
+	/* Start from the highest address */
+	for (i = efi_mem_count - 1; i >= 0; i--) {
+		struct efi_mem_desc *desc = &efi_mem[i];
+		uint64_t desc_end = desc_get_end(desc);
 		uint64_t curmax = min(max_addr, desc_end);
 		uint64_t ret = curmax - len;
 
@@ -601,6 +580,179 @@ void *efi_alloc_aligned_pages(u64 len, int memory_type, size_t align)
 	return (void *)(uintptr_t)aligned_mem;
 }
 
+/**
+ * efi_pool_find_chunk() - find the pool chunk containing an address
+ *
+ * @addr:	address to look for
+ * @indexp:	returns the index of the chunk in efi_pool_chunks, or where it
+ *		would be inserted if there is none
+ * Return:	chunk, or NULL if none
+ */
+static struct efi_pool_chunk *efi_pool_find_chunk(u64 addr, int *indexp)
+{
+	int lo = 0, hi = efi_pool_chunk_count;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (efi_pool_chunks[mid]->start + EFI_POOL_CHUNK_SIZE <= addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	*indexp = lo;
+	if (lo < efi_pool_chunk_count && addr >= efi_pool_chunks[lo]->start)
+		return efi_pool_chunks[lo];
+
+	return NULL;
+}
+
+static struct efi_pool_arena *efi_pool_get_arena(int type)
+{
+	struct efi_pool_arena *arena;
+	int i;
+
+	list_for_each_entry(arena, &efi_pool_arenas, link) {
+		if (arena->type == type)
+			return arena;
+	}
+	arena = malloc(sizeof(*arena));
+	if (!arena)
+		return NULL;
+	arena->type = type;
+	for (i = 0; i < EFI_POOL_MAX_CLASSES; i++)
+		INIT_LIST_HEAD(&arena->partial[i]);
+	list_add(&arena->link, &efi_pool_arenas);
+
+	return arena;
+}
+
+/**
+ * efi_pool_new_chunk() - allocate a new pool chunk
+ *
+ * @arena:	arena to add the chunk to
+ * @class:	size class of the slots
+ * Return:	new chunk, or NULL if out of memory
+ */
+static struct efi_pool_chunk *efi_pool_new_chunk(struct efi_pool_arena *arena,
+						 int class)
+{
+	struct efi_pool_chunk *chunk, **chunks;
+	efi_status_t ret;
+	u64 start;
+	int i;
+
+	if (efi_pool_chunk_count == efi_pool_chunk_alloc) {
+		int alloc = max(efi_pool_chunk_alloc * 2, 16);
+
+		chunks = realloc(efi_pool_chunks, alloc * sizeof(*chunks));
+		if (!chunks)
+			return NULL;
+		efi_pool_chunks = chunks;
+		efi_pool_chunk_alloc = alloc;
+	}
+	chunk = calloc(1, sizeof(*chunk));
+	if (!chunk)
+		return NULL;
+	ret = efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES, arena->type,
+				 EFI_POOL_CHUNK_PAGES, &start);
+	if (ret != EFI_SUCCESS) {
+		free(chunk);
+		return NULL;
+	}
+	chunk->start = start;
+	chunk->slot_size = EFI_POOL_MIN_SLOT << class;
+	chunk->num_slots = EFI_POOL_CHUNK_SIZE / chunk->slot_size;
+	chunk->partial = &arena->partial[class];
+
+	efi_pool_find_chunk(start, &i);
+	memmove(&efi_pool_chunks[i + 1], &efi_pool_chunks[i],
+		(efi_pool_chunk_count - i) * sizeof(*efi_pool_chunks));
+	efi_pool_chunks[i] = chunk;
+	efi_pool_chunk_count++;
+	list_add(&chunk->link, chunk->partial);
+
+	return chunk;
+}
+
+/**
+ * efi_pool_alloc_slot() - allocate a pool slot
+ *
+ * @pool_type:	memory type for the allocation
+ * @size:	number of bytes needed, at most EFI_POOL_MAX_SLOT
+ * Return:	allocated memory, or NULL if out of memory
+ */
+static void *efi_pool_alloc_slot(int pool_type, efi_uintn_t size)
+{
+	struct efi_pool_chunk *chunk;
+	struct efi_pool_arena *arena;
+	int class, w, i;
+
+	for (class = 0; (EFI_POOL_MIN_SLOT << class) < size; class++)
+		;
+	arena = efi_pool_get_arena(pool_type);
+	if (!arena)
+		return NULL;
+	if (list_empty(&arena->partial[class])) {
+		chunk = efi_pool_new_chunk(arena, class);
+		if (!chunk)
+			return NULL;
+	} else {
+		chunk = list_first_entry(&arena->partial[class],
+					 struct efi_pool_chunk, link);
+	}
+
+	for (w = 0; chunk->bitmap[w] == ~0UL; w++)
+		;
+	for (i = w * BITS_PER_LONG; chunk->bitmap[w] & EFI_POOL_BIT(i); i++)
+		;
+	chunk->bitmap[w] |= EFI_POOL_BIT(i);
+	if (++chunk->used == chunk->num_slots)
+		list_del_init(&chunk->link);
+
+	return (void *)(uintptr_t)(chunk->start + i * chunk->slot_size);
+}
+
+/**
+ * efi_pool_free_slot() - free a pool slot
+ *
+ * A chunk which becomes empty is given back, unless it is the only one with
+ * free slots of its size, to avoid allocating it again straight away.
+ *
+ * @chunk:	chunk containing the slot
+ * @index:	index of @chunk in efi_pool_chunks
+ * @addr:	address of the slot
+ * Return:	status code
+ */
+static efi_status_t efi_pool_free_slot(struct efi_pool_chunk *chunk, int index,
+				       u64 addr)
+{
+	u64 offset = addr - chunk->start;
+	int i = offset / chunk->slot_size;
+
+	ulong *word = &chunk->bitmap[i / BITS_PER_LONG];
+
+	if (offset % chunk->slot_size || !(*word & EFI_POOL_BIT(i))) {
+		printf("%s: illegal free 0x%llx\n", __func__, addr);
+		return EFI_INVALID_PARAMETER;
+	}
+	*word &= ~EFI_POOL_BIT(i);
+
+	if (chunk->used-- == chunk->num_slots)
+		list_add(&chunk->link, chunk->partial);
+	if (chunk->used || list_is_singular(chunk->partial))
+		return EFI_SUCCESS;
+
+	list_del(&chunk->link);
+	memmove(&efi_pool_chunks[index], &efi_pool_chunks[index + 1],
+		(efi_pool_chunk_count - index - 1) * sizeof(*efi_pool_chunks));
+	efi_pool_chunk_count--;
+	addr = chunk->start;
+	free(chunk);
+
+	return efi_free_pages(addr, EFI_POOL_CHUNK_PAGES);
+}
+
 /**
  * efi_allocate_pool - allocate memory from pool
  *
@@ -625,6 +777,16 @@ efi_status_t efi_allocate_pool(enum efi_memory_type pool_type, efi_uintn_t size,
 		return EFI_SUCCESS;
 	}
 
+	if (size <= EFI_POOL_MAX_SLOT) {
+		/* Check the memory type as efi_allocate_pages() does */
+		if (pool_type >= EFI_PERSISTENT_MEMORY_TYPE &&
+		    pool_type <= 0x6FFFFFFF)
+			return EFI_INVALID_PARAMETER;
+		*buffer = efi_pool_alloc_slot(pool_type, size);
+
+		return *buffer ? EFI_SUCCESS : EFI_OUT_OF_RESOURCES;
+	}
+
 	r = efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES, pool_type, num_pages,
 			       &addr);
 	if (r == EFI_SUCCESS) {
@@ -647,10 +809,16 @@ efi_status_t efi_free_pool(void *buffer)
 {
 	efi_status_t ret;
 	struct efi_pool_allocation *alloc;
+	struct efi_pool_chunk *chunk;
+	int index;
 
 	if (!buffer)
 		return EFI_INVALID_PARAMETER;
 
+	chunk = efi_pool_find_chunk((uintptr_t)buffer, &index);
+	if (chunk)
+		return efi_pool_free_slot(chunk, index, (uintptr_t)buffer);
+
 	ret = efi_check_allocated((uintptr_t)buffer, true);
 	if (ret != EFI_SUCCESS)
 		return ret;
@@ -689,8 +857,6 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 				uint32_t *descriptor_version)
 {
 	efi_uintn_t map_size = 0;
-	int map_entries = 0;
-	struct list_head *lhandle;
 	efi_uintn_t provided_map_size;
 
 	if (!memory_map_size)
@@ -698,10 +864,7 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 
 	provided_map_size = *memory_map_size;
 
-	list_for_each(lhandle, &efi_mem)
-		map_entries++;
-
-	map_size = map_entries * sizeof(struct efi_mem_desc);
+	map_size = efi_mem_count * sizeof(struct efi_mem_desc);
 
 	*memory_map_size = map_size;
 
@@ -717,16 +880,8 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 	if (!memory_map)
 		return EFI_INVALID_PARAMETER;
 
-	/* Copy list into array */
-	/* Return the list in ascending order */
-	memory_map = &memory_map[map_entries - 1];
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem;
-
-		lmem = list_entry(lhandle, struct efi_mem_list, link);
-		*memory_map = lmem->desc;
-		memory_map--;
-	}
+	/* The map is kept in ascending order, as the caller expects */
+	memcpy(memory_map, efi_mem, map_size);
 
 	if (map_key)
 		*map_key = efi_memory_map_key;
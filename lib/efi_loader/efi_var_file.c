@@ -141,6 +141,8 @@ efi_status_t efi_var_to_file(void)
 	if (ret != EFI_SUCCESS)
 		goto error;
 
+	efi_disk_cache_invalidate(NULL);
+	efi_file_modified();
 	r = fs_write(EFI_VAR_FILE_NAME, map_to_sysmem(buf), 0, len, &actlen);
 	if (r || len != actlen)
 		ret = EFI_DEVICE_ERROR;
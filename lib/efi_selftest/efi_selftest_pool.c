@@ -0,0 +1,265 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * efi_selftest_pool
+ *
+ * This unit test checks the following boottime services:
+ * AllocatePool, FreePool
+ *
+ * Many small buffers of different sizes and memory types are allocated and
+ * freed in an interleaved order. The contents of each buffer are checked to
+ * detect overlapping allocations, and the memory map is checked not to grow
+ * by one entry per allocation.
+ */
+
+#include <efi_selftest.h>
+
+#define EFI_ST_NUM_ALLOCS 2048
+
+/* Maximum number of memory map entries that the allocations may add */
+#define EFI_ST_MAX_NEW_ENTRIES 256
+
+static struct efi_boot_services *boottime;
+static u8 **buffers;
+
+static const enum efi_memory_type types[] = {
+	EFI_LOADER_DATA,
+	EFI_BOOT_SERVICES_DATA,
+	EFI_RUNTIME_SERVICES_DATA,
+};
+
+/**
+ * setup() - setup unit test
+ *
+ * @handle:	handle of the loaded image
+ * @systable:	system table
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int setup(const efi_handle_t handle,
+		 const struct efi_system_table *systable)
+{
+	efi_status_t ret;
+
+	boottime = systable->boottime;
+
+	ret = boottime->allocate_pool(EFI_LOADER_DATA,
+				      EFI_ST_NUM_ALLOCS * sizeof(*buffers),
+				      (void **)&buffers);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("AllocatePool did not return EFI_SUCCESS\n");
+		return EFI_ST_FAILURE;
+	}
+	boottime->set_mem(buffers, EFI_ST_NUM_ALLOCS * sizeof(*buffers), 0);
+
+	return EFI_ST_SUCCESS;
+}
+
+/**
+ * teardown() - tear down unit test
+ *
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int teardown(void)
+{
+	efi_status_t ret;
+	size_t i;
+
+	if (!buffers)
+		return EFI_ST_SUCCESS;
+	for (i = 0; i < EFI_ST_NUM_ALLOCS; ++i) {
+		if (buffers[i])
+			boottime->free_pool(buffers[i]);
+	}
+	ret = boottime->free_pool(buffers);
+	buffers = NULL;
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("FreePool did not return EFI_SUCCESS\n");
+		return EFI_ST_FAILURE;
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+/**
+ * alloc_size() - get the size of an allocation
+ *
+ * Sizes from 1 byte up to 2 KiB are used, so that all the pool size classes
+ * are hit. Every 64th allocation is larger and takes whole pages.
+ *
+ * @i:		index of the allocation
+ * Return:	size in bytes
+ */
+static efi_uintn_t alloc_size(size_t i)
+{
+	if (!(i % 64))
+		return 2049 + i % 2048;
+
+	return 1 + (i * 37) % 2048;
+}
+
+/**
+ * get_map_entries() - get the number of entries in the memory map
+ *
+ * @entries:	returns the number of entries
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int get_map_entries(efi_uintn_t *entries)
+{
+	efi_uintn_t map_size = 0;
+	efi_uintn_t map_key;
+	efi_uintn_t desc_size;
+	u32 desc_version;
+	efi_status_t ret;
+
+	ret = boottime->get_memory_map(&map_size, NULL, &map_key, &desc_size,
+				       &desc_version);
+	if (ret != EFI_BUFFER_TOO_SMALL) {
+		efi_st_error
+			("GetMemoryMap did not return EFI_BUFFER_TOO_SMALL\n");
+		return EFI_ST_FAILURE;
+	}
+	*entries = map_size / desc_size;
+
+	return EFI_ST_SUCCESS;
+}
+
+/**
+ * check_buffer() - check the contents of a buffer
+ *
+ * @i:		index of the allocation
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int check_buffer(size_t i)
+{
+	efi_uintn_t size = alloc_size(i);
+	efi_uintn_t j;
+
+	for (j = 0; j < size; ++j) {
+		if (buffers[i][j] != (u8)(i + j)) {
+			efi_st_error("Buffer %u overwritten at offset %u\n",
+				     (unsigned int)i, (unsigned int)j);
+			return EFI_ST_FAILURE;
+		}
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+/**
+ * free_buffer() - check and free a buffer
+ *
+ * @i:		index of the allocation
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int free_buffer(size_t i)
+{
+	efi_status_t ret;
+
+	if (check_buffer(i) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+	ret = boottime->free_pool(buffers[i]);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("FreePool did not return EFI_SUCCESS\n");
+		return EFI_ST_FAILURE;
+	}
+	buffers[i] = NULL;
+
+	return EFI_ST_SUCCESS;
+}
+
+/*
+ * execute() - execute unit test
+ *
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int execute(void)
+{
+	efi_uintn_t entries_before;
+	efi_uintn_t entries_after;
+	efi_status_t ret;
+	size_t i;
+	size_t j;
+	void *freed;
+
+	if (get_map_entries(&entries_before) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+
+	for (i = 0; i < EFI_ST_NUM_ALLOCS; ++i) {
+		efi_uintn_t size = alloc_size(i);
+
+		ret = boottime->allocate_pool(types[i % ARRAY_SIZE(types)],
+					      size, (void **)&buffers[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("AllocatePool did not return EFI_SUCCESS\n");
+			return EFI_ST_FAILURE;
+		}
+		if ((uintptr_t)buffers[i] & 7) {
+			efi_st_error("Buffer %p is not 8-byte aligned\n",
+				     buffers[i]);
+			return EFI_ST_FAILURE;
+		}
+		for (j = 0; j < size; ++j)
+			buffers[i][j] = i + j;
+	}
+
+	if (get_map_entries(&entries_after) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+	if (entries_after > entries_before + EFI_ST_MAX_NEW_ENTRIES) {
+		efi_st_error("Memory map grew from %u to %u entries\n",
+			     (unsigned int)entries_before,
+			     (unsigned int)entries_after);
+		return EFI_ST_FAILURE;
+	}
+
+	/* Free every third buffer, then check that a double free fails */
+	for (i = 0; i < EFI_ST_NUM_ALLOCS; i += 3) {
+		if (free_buffer(i) != EFI_ST_SUCCESS)
+			return EFI_ST_FAILURE;
+	}
+	freed = buffers[1];
+	if (free_buffer(1) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+	ret = boottime->free_pool(freed);
+	if (ret == EFI_SUCCESS) {
+		efi_st_error("Double FreePool returned EFI_SUCCESS\n");
+		return EFI_ST_FAILURE;
+	}
+
+	/* Reuse the freed slots and check nothing else was disturbed */
+	for (i = 0; i < EFI_ST_NUM_ALLOCS; i += 3) {
+		efi_uintn_t size = alloc_size(i);
+
+		ret = boottime->allocate_pool(EFI_BOOT_SERVICES_DATA, size,
+					      (void **)&buffers[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("AllocatePool did not return EFI_SUCCESS\n");
+			return EFI_ST_FAILURE;
+		}
+		for (j = 0; j < size; ++j)
+			buffers[i][j] = i + j;
+	}
+
+	/* Free the rest, from the top down */
+	for (i = EFI_ST_NUM_ALLOCS; i--;) {
+		if (buffers[i] && free_buffer(i) != EFI_ST_SUCCESS)
+			return EFI_ST_FAILURE;
+	}
+
+	if (get_map_entries(&entries_after) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+	if (entries_after > entries_before + EFI_ST_MAX_NEW_ENTRIES) {
+		efi_st_error("Memory map grew from %u to %u entries\n",
+			     (unsigned int)entries_before,
+			     (unsigned int)entries_after);
+		return EFI_ST_FAILURE;
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+EFI_UNIT_TEST(pool) = {
+	.name = "pool",
+	.phase = EFI_EXECUTE_BEFORE_BOOTTIME_EXIT,
+	.setup = setup,
+	.execute = execute,
+	.teardown = teardown,
+};
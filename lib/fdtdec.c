@@ -19,6 +19,7 @@
 #include <fdt_support.h>
 #include <gzip.h>
 #include <mapmem.h>
+#include <sort.h>
 #include <linux/libfdt.h>
 #include <serial.h>
 #include <asm/global_data.h>
@@ -328,6 +329,472 @@ int fdtdec_next_compatible_subnode(const void *blob, int node,
 	return -FDT_ERR_NOTFOUND;
 }
 
+/*
+ * Index of the node paths in the control FDT
+ *
+ * Looking up a path with fdt_path_offset() scans every node between the root
+ * and the target, comparing names as it goes, which adds up when drivers look
+ * up the same few paths (/aliases, /chosen, etc.) over and over. The index
+ * holds a hash of the full path of each node, sorted so that it can be
+ * searched quickly. It is built when first needed and rebuilt if the blob
+ * changes size. A match is always checked against the node names in the blob,
+ * and anything the index cannot answer is passed on to fdt_path_offset().
+ */
+
+/* Nodes deeper than this are not indexed; the blob is handled the slow way */
+#define PATH_INDEX_MAX_DEPTH	32
+
+#define FNV_OFFSET_BASIS	0x811c9dc5
+#define FNV_PRIME		0x01000193
+
+/**
+ * struct path_index_node - information about a node in the path index
+ *
+ * @hash: Hash of the full path of the node
+ * @offset: Offset of the node in the blob
+ * @parent: Index of the parent node, or -1 for the root node
+ * @shadowed: true if an earlier sibling called "name@unit" matches the path
+ *	of this node, in which case fdt_path_offset() returns that sibling
+ */
+struct path_index_node {
+	u32 hash;
+	int offset;
+	int parent;
+	bool shadowed;
+};
+
+/**
+ * struct path_index - index of the node paths in the control FDT
+ *
+ * @blob: Blob which was indexed, or NULL if none
+ * @struct_size: Size of the structure block of @blob when it was indexed
+ * @count: Number of nodes indexed, 0 if the blob could not be indexed
+ * @node: Information about each node, in the order they appear in the blob
+ * @by_hash: Indices into @node, sorted by hash and then by offset
+ */
+struct path_index {
+	const void *blob;
+	int struct_size;
+	int count;
+	struct path_index_node *node;
+	int *by_hash;
+};
+
+static struct path_index path_index;
+
+/* Lookup counts, for 'dm uclass -t' */
+static struct fdtdec_index_stats fdt_index_stats;
+
+/* The indexes are only kept for the control FDT, once malloc() is ready */
+static bool fdt_index_usable(const void *blob)
+{
+	return blob && blob == gd->fdt_blob &&
+		(gd->flags & GD_FLG_FULL_MALLOC_INIT);
+}
+
+/* Add "/name" to the FNV-1a hash of a path */
+static u32 path_index_hash(u32 hash, const char *name, int len)
+{
+	hash = (hash ^ '/') * FNV_PRIME;
+	while (len--)
+		hash = (hash ^ (u8)*name++) * FNV_PRIME;
+
+	return hash;
+}
+
+static int path_index_cmp(const void *a, const void *b)
+{
+	const struct path_index_node *na = &path_index.node[*(const int *)a];
+	const struct path_index_node *nb = &path_index.node[*(const int *)b];
+
+	if (na->hash != nb->hash)
+		return na->hash < nb->hash ? -1 : 1;
+
+	return na->offset - nb->offset;
+}
+
+/* Find the first entry in by_hash[] with the given hash */
+static int path_index_search(u32 hash)
+{
+	int lo = 0, hi = path_index.count;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (path_index.node[path_index.by_hash[mid]].hash < hash)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/*
+ * fdt_path_offset() lets "name" match a node called "name@unit", taking the
+ * first sibling which matches. Mark nodes which are hidden by such a sibling
+ * so that lookups of their path go the slow way.
+ */
+static void path_index_mark_shadowed(const void *blob)
+{
+	int i, j;
+
+	for (i = 1; i < path_index.count; i++) {
+		const struct path_index_node *node = &path_index.node[i];
+		const char *name, *at;
+		u32 hash;
+		int len;
+
+		name = fdt_get_name(blob, node->offset, &len);
+		at = name ? memchr(name, '@', len) : NULL;
+		if (!at)
+			continue;
+		hash = path_index_hash(path_index.node[node->parent].hash, name,
+				       at - name);
+
+		/* A hash collision just makes a node slower to find */
+		for (j = path_index_search(hash); j < path_index.count; j++) {
+			struct path_index_node *other;
+
+			other = &path_index.node[path_index.by_hash[j]];
+			if (other->hash != hash)
+				break;
+			if (other->parent == node->parent &&
+			    other->offset > node->offset)
+				other->shadowed = true;
+		}
+	}
+}
+
+static int path_index_build(const void *blob)
+{
+	int stack[PATH_INDEX_MAX_DEPTH + 1];
+	int offset, depth, count, i;
+
+	free(path_index.node);
+	free(path_index.by_hash);
+	memset(&path_index, '\0', sizeof(path_index));
+
+	/* Record the blob even on failure, so we don't keep retrying */
+	path_index.blob = blob;
+	path_index.struct_size = fdt_size_dt_struct(blob);
+	fdt_index_stats.builds++;
+
+	for (offset = 0, depth = 0, count = 0; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(blob, offset, &depth), count++) {
+		if (depth > PATH_INDEX_MAX_DEPTH)
+			return -E2BIG;
+	}
+	if (offset < 0 && offset != -FDT_ERR_NOTFOUND)
+		return offset;
+
+	path_index.node = malloc(count * sizeof(*path_index.node));
+	path_index.by_hash = malloc(count * sizeof(*path_index.by_hash));
+	if (!path_index.node || !path_index.by_hash)
+		return -ENOMEM;
+
+	for (offset = 0, depth = 0, i = 0; i < count;
+	     offset = fdt_next_node(blob, offset, &depth), i++) {
+		struct path_index_node *node = &path_index.node[i];
+		const char *name;
+		int len;
+
+		if (offset < 0 || depth < 0)
+			return -EINVAL;
+		name = fdt_get_name(blob, offset, &len);
+		if (!name)
+			return -EINVAL;
+		node->offset = offset;
+		node->shadowed = false;
+		if (depth) {
+			node->parent = stack[depth - 1];
+			node->hash = path_index_hash(
+				path_index.node[node->parent].hash, name, len);
+		} else {
+			node->parent = -1;
+			node->hash = FNV_OFFSET_BASIS;
+		}
+		stack[depth] = i;
+		path_index.by_hash[i] = i;
+	}
+	path_index.count = count;
+	qsort(path_index.by_hash, count, sizeof(*path_index.by_hash),
+	      path_index_cmp);
+	path_index_mark_shadowed(blob);
+	debug("%s: Indexed %d nodes\n", __func__, count);
+
+	return 0;
+}
+
+/* Check that a node really has the given path */
+static bool path_index_match(const void *blob, int idx, const char *path)
+{
+	int chain[PATH_INDEX_MAX_DEPTH];
+	const char *p = path;
+	int n;
+
+	for (n = 0; path_index.node[idx].parent >= 0;
+	     idx = path_index.node[idx].parent) {
+		if (path_index.node[idx].shadowed)
+			return false;
+		chain[n++] = idx;
+	}
+	while (n--) {
+		const char *name;
+		int len, plen;
+
+		while (*p == '/')
+			p++;
+		plen = strchrnul(p, '/') - p;
+		name = fdt_get_name(blob, path_index.node[chain[n]].offset,
+				    &len);
+		if (!name || len != plen || memcmp(name, p, len))
+			return false;
+		p += plen;
+	}
+	while (*p == '/')
+		p++;
+
+	return !*p;
+}
+
+/**
+ * path_index_find() - look up a path using the index
+ *
+ * @blob: FDT blob to search
+ * @path: Path to look up
+ * @offsetp: Returns the offset of the node, or -ve FDT_ERR_... value
+ * Return: true if *@offsetp is set, false if fdt_path_offset() must be used
+ */
+static bool path_index_find(const void *blob, const char *path, int *offsetp)
+{
+	const char *p;
+	u32 hash;
+	int i;
+
+	if (!fdt_index_usable(blob))
+		return false;
+	if (blob != path_index.blob ||
+	    fdt_size_dt_struct(blob) != path_index.struct_size)
+		path_index_build(blob);
+	if (!path_index.count)
+		return false;
+
+	if (*path != '/') {
+		int aliases;
+
+		/* An alias followed by a path is left to fdt_path_offset() */
+		if (!*path || strchr(path, '/') ||
+		    !path_index_find(blob, "/aliases", &aliases))
+			return false;
+		p = aliases < 0 ? NULL : fdt_getprop(blob, aliases, path, NULL);
+		if (!p) {
+			*offsetp = -FDT_ERR_BADPATH;
+			return true;
+		}
+		if (*p != '/')
+			return false;
+		path = p;
+	}
+
+	hash = FNV_OFFSET_BASIS;
+	for (p = path; *p; ) {
+		const char *end;
+
+		if (*p == '/') {
+			p++;
+			continue;
+		}
+		end = strchrnul(p, '/');
+		hash = path_index_hash(hash, p, end - p);
+		p = end;
+	}
+
+	for (i = path_index_search(hash); i < path_index.count; i++) {
+		int idx = path_index.by_hash[i];
+
+		if (path_index.node[idx].hash != hash)
+			break;
+		if (path_index_match(blob, idx, path)) {
+			*offsetp = path_index.node[idx].offset;
+			return true;
+		}
+	}
+
+	/* This may be a path using "name" to refer to "name@unit" */
+	return false;
+}
+
+int fdtdec_path_offset(const void *blob, const char *path)
+{
+	int offset;
+
+	if (CONFIG_IS_ENABLED(DM_STATS))
+		fdt_index_stats.path_lookups++;
+	if (CONFIG_IS_ENABLED(OF_PATH_INDEX) &&
+	    path_index_find(blob, path, &offset)) {
+		if (CONFIG_IS_ENABLED(DM_STATS))
+			fdt_index_stats.path_hits++;
+		return offset;
+	}
+
+	return fdt_path_offset(blob, path);
+}
+
+/*
+ * Table of the phandles in the control FDT
+ *
+ * fdt_node_offset_by_phandle() scans the whole blob, and driver model follows
+ * phandles for clocks, resets, pinctrl, mailboxes and so on. The table holds
+ * the offset of each node with a phandle, sorted by phandle. Like the path
+ * index, it is rebuilt if the blob changes size, and each hit is checked
+ * against the blob.
+ */
+
+/**
+ * struct phandle_index - table of the phandles in the control FDT
+ *
+ * @blob: Blob which was indexed, or NULL if none
+ * @struct_size: Size of the structure block of @blob when it was indexed
+ * @count: Number of entries in @entry
+ * @entry: Phandle and offset of each node with a phandle, sorted by phandle
+ *	and then by offset
+ */
+struct phandle_index {
+	const void *blob;
+	int struct_size;
+	int count;
+	struct phandle_index_entry {
+		u32 phandle;
+		int offset;
+	} *entry;
+};
+
+static struct phandle_index phandle_index;
+
+static int phandle_index_cmp(const void *a, const void *b)
+{
+	const struct phandle_index_entry *ea = a, *eb = b;
+
+	if (ea->phandle != eb->phandle)
+		return ea->phandle < eb->phandle ? -1 : 1;
+
+	return ea->offset - eb->offset;
+}
+
+static int phandle_index_build(const void *blob)
+{
+	int offset, count, i;
+
+	free(phandle_index.entry);
+	memset(&phandle_index, '\0', sizeof(phandle_index));
+	phandle_index.blob = blob;
+	phandle_index.struct_size = fdt_size_dt_struct(blob);
+	fdt_index_stats.builds++;
+
+	for (offset = 0, count = 0; offset >= 0;
+	     offset = fdt_next_node(blob, offset, NULL)) {
+		if (fdt_get_phandle(blob, offset))
+			count++;
+	}
+	if (!count)
+		return 0;
+
+	phandle_index.entry = malloc(count * sizeof(*phandle_index.entry));
+	if (!phandle_index.entry)
+		return -ENOMEM;
+	for (offset = 0, i = 0; offset >= 0 && i < count;
+	     offset = fdt_next_node(blob, offset, NULL)) {
+		u32 phandle = fdt_get_phandle(blob, offset);
+
+		if (phandle) {
+			phandle_index.entry[i].phandle = phandle;
+			phandle_index.entry[i++].offset = offset;
+		}
+	}
+	phandle_index.count = i;
+	qsort(phandle_index.entry, i, sizeof(*phandle_index.entry),
+	      phandle_index_cmp);
+	debug("%s: Indexed %d phandles\n", __func__, i);
+
+	return 0;
+}
+
+/* Returns the offset of the node, or -1 if not in the table */
+static int phandle_index_search(u32 phandle)
+{
+	int lo = 0, hi = phandle_index.count;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (phandle_index.entry[mid].phandle < phandle)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == phandle_index.count ||
+	    phandle_index.entry[lo].phandle != phandle)
+		return -1;
+
+	return phandle_index.entry[lo].offset;
+}
+
+/**
+ * phandle_index_find() - look up a phandle using the index
+ *
+ * A table entry which no longer matches the blob means that it was changed
+ * without its size changing, so the table is rebuilt.
+ *
+ * @blob: FDT blob to search
+ * @phandle: Phandle to look up
+ * @offsetp: Returns the offset of the node
+ * Return: true if *@offsetp is set, false if fdt_node_offset_by_phandle()
+ *	must be used
+ */
+static bool phandle_index_find(const void *blob, u32 phandle, int *offsetp)
+{
+	int offset;
+
+	if (!fdt_index_usable(blob))
+		return false;
+	if (blob != phandle_index.blob ||
+	    fdt_size_dt_struct(blob) != phandle_index.struct_size)
+		phandle_index_build(blob);
+
+	offset = phandle_index_search(phandle);
+	if (offset >= 0 && fdt_get_phandle(blob, offset) != phandle) {
+		phandle_index_build(blob);
+		offset = phandle_index_search(phandle);
+	}
+	if (offset < 0 || fdt_get_phandle(blob, offset) != phandle)
+		return false;
+	*offsetp = offset;
+
+	return true;
+}
+
+int fdtdec_phandle_offset(const void *blob, u32 phandle)
+{
+	int offset;
+
+	if (CONFIG_IS_ENABLED(DM_STATS))
+		fdt_index_stats.phandle_lookups++;
+	if (CONFIG_IS_ENABLED(OF_PHANDLE_INDEX) && phandle &&
+	    phandle != (u32)-1 && phandle_index_find(blob, phandle, &offset)) {
+		if (CONFIG_IS_ENABLED(DM_STATS))
+			fdt_index_stats.phandle_hits++;
+		return offset;
+	}
+
+	return fdt_node_offset_by_phandle(blob, phandle);
+}
+
+void fdtdec_get_index_stats(struct fdtdec_index_stats *stats)
+{
+	*stats = fdt_index_stats;
+}
+
 int fdtdec_next_alias(const void *blob, const char *name, enum fdt_compat_id id,
 		      int *upto)
 {
@@ -338,7 +805,7 @@ int fdtdec_next_alias(const void *blob, const char *name, enum fdt_compat_id id,
 	/* snprintf() is not available */
 	assert(strlen(name) < MAX_STR_LEN);
 	sprintf(str, "%.*s%d", MAX_STR_LEN, name, *upto);
-	node = fdt_path_offset(blob, str);
+	node = fdtdec_path_offset(blob, str);
 	if (node < 0)
 		return node;
 	err = fdt_node_check_compatible(blob, node, compat_names[id]);
@@ -373,7 +840,7 @@ int fdtdec_add_aliases_for_id(const void *blob, const char *name,
 	int i, j;
 
 	/* find the alias node if present */
-	alias_node = fdt_path_offset(blob, "/aliases");
+	alias_node = fdtdec_path_offset(blob, "/aliases");
 
 	/*
 	 * start with nothing, and we can assume that the root node can't
@@ -404,7 +871,7 @@ int fdtdec_add_aliases_for_id(const void *blob, const char *name,
 		prop = fdt_get_property_by_offset(blob, offset, NULL);
 		path = fdt_string(blob, fdt32_to_cpu(prop->nameoff));
 		if (prop->len && 0 == strncmp(path, name, name_len))
-			node = fdt_path_offset(blob, prop->data);
+			node = fdtdec_path_offset(blob, prop->data);
 		if (node <= 0)
 			continue;
 
@@ -487,7 +954,7 @@ int fdtdec_get_alias_seq(const void *blob, const char *base, int offset,
 	find_name = fdt_get_name(blob, offset, &find_namelen);
 	debug("Looking for '%s' at %d, name %s\n", base, offset, find_name);
 
-	aliases = fdt_path_offset(blob, "/aliases");
+	aliases = fdtdec_path_offset(blob, "/aliases");
 	for (prop_offset = fdt_first_property_offset(blob, aliases);
 	     prop_offset > 0;
 	     prop_offset = fdt_next_property_offset(blob, prop_offset)) {
@@ -512,7 +979,7 @@ int fdtdec_get_alias_seq(const void *blob, const char *base, int offset,
 		 */
 		if (IS_ENABLED(CONFIG_PHANDLE_CHECK_SEQ)) {
 			if (fdt_get_phandle(blob, offset) !=
-			    fdt_get_phandle(blob, fdt_path_offset(blob, prop)))
+			    fdt_get_phandle(blob, fdtdec_path_offset(blob, prop)))
 				continue;
 		}
 
@@ -537,7 +1004,7 @@ int fdtdec_get_alias_highest_id(const void *blob, const char *base)
 
 	debug("Looking for highest alias id for '%s'\n", base);
 
-	aliases = fdt_path_offset(blob, "/aliases");
+	aliases = fdtdec_path_offset(blob, "/aliases");
 	for (prop_offset = fdt_first_property_offset(blob, aliases);
 	     prop_offset > 0;
 	     prop_offset = fdt_next_property_offset(blob, prop_offset)) {
@@ -567,7 +1034,7 @@ const char *fdtdec_get_chosen_prop(const void *blob, const char *name)
 
 	if (!blob)
 		return NULL;
-	chosen_node = fdt_path_offset(blob, "/chosen");
+	chosen_node = fdtdec_path_offset(blob, "/chosen");
 	return fdt_getprop(blob, chosen_node, name, NULL);
 }
 
@@ -578,7 +1045,7 @@ int fdtdec_get_chosen_node(const void *blob, const char *name)
 	prop = fdtdec_get_chosen_prop(blob, name);
 	if (!prop)
 		return -FDT_ERR_NOTFOUND;
-	return fdt_path_offset(blob, prop);
+	return fdtdec_path_offset(blob, prop);
 }
 
 int fdtdec_check_fdt(void)
@@ -630,7 +1097,7 @@ int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 	if (!phandle)
 		return -FDT_ERR_NOTFOUND;
 
-	lookup = fdt_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
+	lookup = fdtdec_phandle_offset(blob, fdt32_to_cpu(*phandle));
 	return lookup;
 }
 
@@ -761,8 +1228,7 @@ int fdtdec_parse_phandle_with_args(const void *blob, int src_node,
 			 * below.
 			 */
 			if (cells_name || cur_index == index) {
-				node = fdt_node_offset_by_phandle(blob,
-								  phandle);
+				node = fdtdec_phandle_offset(blob, phandle);
 				if (node < 0) {
 					debug("%s: could not find phandle\n",
 					      fdt_get_name(blob, src_node,
@@ -1247,7 +1713,7 @@ int fdtdec_set_ethernet_mac_address(void *fdt, const u8 *mac, size_t size)
 
 	debug("ethernet alias found: %s\n", path);
 
-	offset = fdt_path_offset(fdt, path);
+	offset = fdtdec_path_offset(fdt, path);
 	if (offset < 0) {
 		debug("ethernet alias points to absent node %s\n", path);
 		return -ENOENT;
@@ -1306,7 +1772,7 @@ int fdtdec_add_reserved_memory(void *blob, const char *basename,
 	char name[64];
 
 	/* create an empty /reserved-memory node if one doesn't exist */
-	parent = fdt_path_offset(blob, "/reserved-memory");
+	parent = fdtdec_path_offset(blob, "/reserved-memory");
 	if (parent < 0) {
 		parent = fdtdec_init_reserved_memory(blob);
 		if (parent < 0)
@@ -1443,7 +1909,7 @@ int fdtdec_get_carveout(const void *blob, const char *node,
 	int offset, len;
 	fdt_size_t size;
 
-	offset = fdt_path_offset(blob, node);
+	offset = fdtdec_path_offset(blob, node);
 	if (offset < 0)
 		return offset;
 
@@ -1465,7 +1931,7 @@ int fdtdec_get_carveout(const void *blob, const char *node,
 
 	phandle = fdt32_to_cpu(prop[index]);
 
-	offset = fdt_node_offset_by_phandle(blob, phandle);
+	offset = fdtdec_phandle_offset(blob, phandle);
 	if (offset < 0) {
 		debug("failed to find node for phandle %u\n", phandle);
 		return offset;
@@ -1550,7 +2016,7 @@ int fdtdec_set_carveout(void *blob, const char *node, const char *prop_name,
 		return err;
 	}
 
-	offset = fdt_path_offset(blob, node);
+	offset = fdtdec_path_offset(blob, node);
 	if (offset < 0) {
 		debug("failed to find offset for node %s: %d\n", node, offset);
 		return offset;
@@ -1703,7 +2169,7 @@ int fdtdec_decode_ram_size(const void *blob, const char *area, int board_id,
 	debug("%s: board_id=%d\n", __func__, board_id);
 	if (!area)
 		area = "/memory";
-	node = fdt_path_offset(blob, area);
+	node = fdtdec_path_offset(blob, area);
 	if (node < 0) {
 		debug("No %s node found\n", area);
 		return -ENOENT;
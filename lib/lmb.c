@@ -11,6 +11,7 @@
 #include <lmb.h>
 #include <log.h>
 #include <malloc.h>
+#include <linux/libfdt.h>
 
 #include <asm/global_data.h>
 #include <asm/sections.h>
@@ -72,35 +73,68 @@ static long lmb_addrs_adjacent(phys_addr_t base1, phys_size_t size1,
 	return 0;
 }
 
-static long lmb_regions_adjacent(struct lmb_region *rgn, unsigned long r1,
-				 unsigned long r2)
+/**
+ * lmb_search() - find the first region which ends at or after an address
+ *
+ * The regions are sorted and do not overlap, so a binary search can be used.
+ *
+ * @rgn:	regions to search
+ * @addr:	address to look for
+ * Return:	index of the region, or rgn->cnt if there is none
+ */
+static unsigned long lmb_search(struct lmb_region *rgn, phys_addr_t addr)
 {
-	phys_addr_t base1 = rgn->region[r1].base;
-	phys_size_t size1 = rgn->region[r1].size;
-	phys_addr_t base2 = rgn->region[r2].base;
-	phys_size_t size2 = rgn->region[r2].size;
+	unsigned long lo = 0, hi = rgn->cnt;
+
+	while (lo < hi) {
+		unsigned long mid = (lo + hi) / 2;
+		struct lmb_property *r = &rgn->region[mid];
+
+		if (r->base + r->size - 1 < addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
 
-	return lmb_addrs_adjacent(base1, size1, base2, size2);
+	return lo;
 }
 
 static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
 {
-	unsigned long i;
-
-	for (i = r; i < rgn->cnt - 1; i++) {
-		rgn->region[i].base = rgn->region[i + 1].base;
-		rgn->region[i].size = rgn->region[i + 1].size;
-		rgn->region[i].flags = rgn->region[i + 1].flags;
-	}
+	memmove(&rgn->region[r], &rgn->region[r + 1],
+		(rgn->cnt - r - 1) * sizeof(*rgn->region));
 	rgn->cnt--;
 }
 
-/* Assumption: base addr of region 1 < base addr of region 2 */
-static void lmb_coalesce_regions(struct lmb_region *rgn, unsigned long r1,
-				 unsigned long r2)
+/**
+ * lmb_grow_region() - make room for more regions
+ *
+ * The regions start off in the arrays inside struct lmb. Once these are full
+ * the regions are moved to an array twice the size, allocated with malloc().
+ * This is not possible before relocation.
+ *
+ * @rgn:	regions to grow
+ * Return:	0 if OK, -ENOSPC if malloc() is not available, -ENOMEM if out
+ *		of memory
+ */
+static int lmb_grow_region(struct lmb_region *rgn)
 {
-	rgn->region[r1].size += rgn->region[r2].size;
-	lmb_remove_region(rgn, r2);
+	struct lmb_property *region;
+	unsigned long max = rgn->max * 2;
+
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return -ENOSPC;
+	region = malloc(max * sizeof(*region));
+	if (!region)
+		return -ENOMEM;
+	memcpy(region, rgn->region, rgn->cnt * sizeof(*region));
+	if (rgn->allocated)
+		free(rgn->region);
+	rgn->region = region;
+	rgn->max = max;
+	rgn->allocated = true;
+
+	return 0;
 }
 
 void lmb_init(struct lmb *lmb)
@@ -111,13 +145,24 @@ void lmb_init(struct lmb *lmb)
 #else
 	lmb->memory.max = CONFIG_LMB_MEMORY_REGIONS;
 	lmb->reserved.max = CONFIG_LMB_RESERVED_REGIONS;
+#endif
 	lmb->memory.region = lmb->memory_regions;
 	lmb->reserved.region = lmb->reserved_regions;
-#endif
+	lmb->memory.allocated = false;
+	lmb->reserved.allocated = false;
 	lmb->memory.cnt = 0;
 	lmb->reserved.cnt = 0;
 }
 
+void lmb_uninit(struct lmb *lmb)
+{
+	if (lmb->memory.allocated)
+		free(lmb->memory.region);
+	if (lmb->reserved.allocated)
+		free(lmb->reserved.region);
+	lmb_init(lmb);
+}
+
 void arch_lmb_reserve_generic(struct lmb *lmb, ulong sp, ulong end, ulong align)
 {
 	ulong bank_end;
@@ -153,13 +198,71 @@ void arch_lmb_reserve_generic(struct lmb *lmb, ulong sp, ulong end, ulong align)
 	}
 }
 
+/*
+ * Regions reserved by the control devicetree. These are found once and then
+ * kept, so that commands which check their load address with lmb do not need
+ * to parse the devicetree each time. They are kept as listed in the
+ * devicetree, not merged, so that reserving them gives the same result as
+ * boot_fdt_add_mem_rsv_regions().
+ */
+static struct {
+	const void *blob;
+	int totalsize;
+	int size_dt_struct;
+	struct lmb_property *rsv;
+	int count;
+} lmb_fdt_rsv;
+
+/**
+ * lmb_add_fdt_rsv_regions() - reserve the regions given in a devicetree
+ *
+ * @lmb:	the logical memory block struct
+ * @fdt_blob:	devicetree
+ */
+static void lmb_add_fdt_rsv_regions(struct lmb *lmb, void *fdt_blob)
+{
+	int i;
+
+	if (fdt_blob != gd->fdt_blob ||
+	    !(gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
+		boot_fdt_add_mem_rsv_regions(lmb, fdt_blob);
+		return;
+	}
+
+	if (lmb_fdt_rsv.blob != fdt_blob ||
+	    lmb_fdt_rsv.totalsize != fdt_totalsize(fdt_blob) ||
+	    lmb_fdt_rsv.size_dt_struct != fdt_size_dt_struct(fdt_blob)) {
+		free(lmb_fdt_rsv.rsv);
+		lmb_fdt_rsv.blob = NULL;
+		lmb_fdt_rsv.count = boot_fdt_get_mem_rsv_regions(fdt_blob,
+							&lmb_fdt_rsv.rsv);
+		if (lmb_fdt_rsv.count < 0) {
+			lmb_fdt_rsv.count = 0;
+			boot_fdt_add_mem_rsv_regions(lmb, fdt_blob);
+			return;
+		}
+		lmb_fdt_rsv.blob = fdt_blob;
+		lmb_fdt_rsv.totalsize = fdt_totalsize(fdt_blob);
+		lmb_fdt_rsv.size_dt_struct = fdt_size_dt_struct(fdt_blob);
+	}
+
+	for (i = 0; i < lmb_fdt_rsv.count; i++) {
+		struct lmb_property *r = &lmb_fdt_rsv.rsv[i];
+
+		if (lmb_reserve_flags(lmb, r->base, r->size, r->flags) < 0)
+			printf("ERROR: reserving fdt memory region failed (addr=%llx size=%llx flags=%x)\n",
+			       (unsigned long long)r->base,
+			       (unsigned long long)r->size, r->flags);
+	}
+}
+
 static void lmb_reserve_common(struct lmb *lmb, void *fdt_blob)
 {
 	arch_lmb_reserve(lmb);
 	board_lmb_reserve(lmb);
 
 	if (CONFIG_IS_ENABLED(OF_LIBFDT) && fdt_blob)
-		boot_fdt_add_mem_rsv_regions(lmb, fdt_blob);
+		lmb_add_fdt_rsv_regions(lmb, fdt_blob);
 }
 
 /* Initialize the struct, add memory and call arch/board reserve functions */
@@ -192,83 +295,55 @@ void lmb_init_and_reserve_range(struct lmb *lmb, phys_addr_t base,
 static long lmb_add_region_flags(struct lmb_region *rgn, phys_addr_t base,
 				 phys_size_t size, enum lmb_flags flags)
 {
-	unsigned long coalesced = 0;
-	long adjacent, i;
-
-	if (rgn->cnt == 0) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-		rgn->region[0].flags = flags;
-		rgn->cnt = 1;
-		return 0;
-	}
-
-	/* First try and coalesce this LMB with another. */
-	for (i = 0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-		phys_size_t rgnflags = rgn->region[i].flags;
+	struct lmb_property *prev = NULL, *next = NULL;
+	unsigned long i;
 
-		if (rgnbase == base && rgnsize == size) {
-			if (flags == rgnflags)
+	i = lmb_search(rgn, base);
+	if (i < rgn->cnt) {
+		next = &rgn->region[i];
+		if (next->base == base && next->size == size) {
+			if (flags == next->flags)
 				/* Already have this region, so we're done */
 				return 0;
 			else
 				return -1; /* regions with new flags */
 		}
-
-		adjacent = lmb_addrs_adjacent(base, size, rgnbase, rgnsize);
-		if (adjacent > 0) {
-			if (flags != rgnflags)
-				break;
-			rgn->region[i].base -= size;
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		} else if (adjacent < 0) {
-			if (flags != rgnflags)
-				break;
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		} else if (lmb_addrs_overlap(base, size, rgnbase, rgnsize)) {
-			/* regions overlap */
+		if (lmb_addrs_overlap(base, size, next->base, next->size))
 			return -1;
-		}
+		if (next->flags != flags ||
+		    lmb_addrs_adjacent(base, size, next->base, next->size) <= 0)
+			next = NULL;
+	}
+	if (i > 0) {
+		prev = &rgn->region[i - 1];
+		if (prev->flags != flags ||
+		    lmb_addrs_adjacent(base, size, prev->base, prev->size) >= 0)
+			prev = NULL;
 	}
 
-	if ((i < rgn->cnt - 1) && lmb_regions_adjacent(rgn, i, i + 1)) {
-		if (rgn->region[i].flags == rgn->region[i + 1].flags) {
-			lmb_coalesce_regions(rgn, i, i + 1);
-			coalesced++;
-		}
+	/* First try and coalesce this LMB with its neighbours */
+	if (prev && next) {
+		prev->size += size + next->size;
+		lmb_remove_region(rgn, i);
+		return 2;
+	} else if (prev) {
+		prev->size += size;
+		return 1;
+	} else if (next) {
+		next->base = base;
+		next->size += size;
+		return 1;
 	}
 
-	if (coalesced)
-		return coalesced;
-	if (rgn->cnt >= rgn->max)
+	if (rgn->cnt >= rgn->max && lmb_grow_region(rgn))
 		return -1;
 
 	/* Couldn't coalesce the LMB, so add it to the sorted table. */
-	for (i = rgn->cnt-1; i >= 0; i--) {
-		if (base < rgn->region[i].base) {
-			rgn->region[i + 1].base = rgn->region[i].base;
-			rgn->region[i + 1].size = rgn->region[i].size;
-			rgn->region[i + 1].flags = rgn->region[i].flags;
-		} else {
-			rgn->region[i + 1].base = base;
-			rgn->region[i + 1].size = size;
-			rgn->region[i + 1].flags = flags;
-			break;
-		}
-	}
-
-	if (base < rgn->region[0].base) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-		rgn->region[0].flags = flags;
-	}
-
+	memmove(&rgn->region[i + 1], &rgn->region[i],
+		(rgn->cnt - i) * sizeof(*rgn->region));
+	rgn->region[i].base = base;
+	rgn->region[i].size = size;
+	rgn->region[i].flags = flags;
 	rgn->cnt++;
 
 	return 0;
@@ -293,21 +368,17 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	struct lmb_region *rgn = &(lmb->reserved);
 	phys_addr_t rgnbegin, rgnend;
 	phys_addr_t end = base + size - 1;
-	int i;
-
-	rgnbegin = rgnend = 0; /* supress gcc warnings */
+	unsigned long i;
 
 	/* Find the region where (base, size) belongs to */
-	for (i = 0; i < rgn->cnt; i++) {
-		rgnbegin = rgn->region[i].base;
-		rgnend = rgnbegin + rgn->region[i].size - 1;
-
-		if ((rgnbegin <= base) && (end <= rgnend))
-			break;
-	}
+	i = lmb_search(rgn, base);
+	if (i == rgn->cnt)
+		return -1;
+	rgnbegin = rgn->region[i].base;
+	rgnend = rgnbegin + rgn->region[i].size - 1;
 
 	/* Didn't find the region */
-	if (i == rgn->cnt)
+	if (rgnbegin > base || end > rgnend)
 		return -1;
 
 	/* Check to see if we are removing entire region */
@@ -354,16 +425,13 @@ long lmb_reserve(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 static long lmb_overlaps_region(struct lmb_region *rgn, phys_addr_t base,
 				phys_size_t size)
 {
-	unsigned long i;
+	unsigned long i = lmb_search(rgn, base);
 
-	for (i = 0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-		if (lmb_addrs_overlap(base, size, rgnbase, rgnsize))
-			break;
-	}
+	if (i < rgn->cnt && lmb_addrs_overlap(base, size, rgn->region[i].base,
+					      rgn->region[i].size))
+		return i;
 
-	return (i < rgn->cnt) ? i : -1;
+	return -1;
 }
 
 phys_addr_t lmb_alloc(struct lmb *lmb, phys_size_t size, ulong align)
@@ -459,22 +527,20 @@ phys_addr_t lmb_alloc_addr(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 /* Return number of bytes from a given address that are free */
 phys_size_t lmb_get_free_size(struct lmb *lmb, phys_addr_t addr)
 {
-	int i;
+	unsigned long i;
 	long rgn;
 
 	/* check if the requested address is in the memory regions */
 	rgn = lmb_overlaps_region(&lmb->memory, addr, 1);
 	if (rgn >= 0) {
-		for (i = 0; i < lmb->reserved.cnt; i++) {
+		i = lmb_search(&lmb->reserved, addr);
+		if (i < lmb->reserved.cnt) {
 			if (addr < lmb->reserved.region[i].base) {
 				/* first reserved range > requested address */
 				return lmb->reserved.region[i].base - addr;
 			}
-			if (lmb->reserved.region[i].base +
-			    lmb->reserved.region[i].size > addr) {
-				/* requested addr is in this reserved range */
-				return 0;
-			}
+			/* requested addr is in this reserved range */
+			return 0;
 		}
 		/* if we come here: no reserved ranges above requested addr */
 		return lmb->memory.region[lmb->memory.cnt - 1].base +
@@ -485,14 +551,11 @@ phys_size_t lmb_get_free_size(struct lmb *lmb, phys_addr_t addr)
 
 int lmb_is_reserved_flags(struct lmb *lmb, phys_addr_t addr, int flags)
 {
-	int i;
+	unsigned long i = lmb_search(&lmb->reserved, addr);
+
+	if (i < lmb->reserved.cnt && addr >= lmb->reserved.region[i].base)
+		return (lmb->reserved.region[i].flags & flags) == flags;
 
-	for (i = 0; i < lmb->reserved.cnt; i++) {
-		phys_addr_t upper = lmb->reserved.region[i].base +
-			lmb->reserved.region[i].size - 1;
-		if ((addr >= lmb->reserved.region[i].base) && (addr <= upper))
-			return (lmb->reserved.region[i].flags & flags) == flags;
-	}
 	return 0;
 }
 
@@ -0,0 +1,416 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Fast memory test, see memtest.h
+ *
+ * The region is split into chunks which the cores take in turn, so that all
+ * of them are kept busy however many actually start. Each chunk is tested
+ * with all passes of the pattern before moving on, so that the data is
+ * likely to still be in the cache for the flush in MEMTEST_FLUSH mode.
+ */
+
+#include <common.h>
+#include <console.h>
+#include <cpu_func.h>
+#include <mapmem.h>
+#include <memtest.h>
+#include <time.h>
+#include <watchdog.h>
+#include <asm/cache.h>
+#include <asm/system.h>
+#include <linux/compiler.h>
+#include <linux/sizes.h>
+#if CONFIG_IS_ENABLED(ARMV8_SMP_RUN)
+#include <asm/armv8/smp_run.h>
+#endif
+
+/* Amount of memory handed to a core at a time */
+#define MEMTEST_CHUNK		SZ_1M
+
+/* Value used for moving inversions */
+#define MEMTEST_INV_VALUE	0x5555555555555555ULL
+
+#if defined(CONFIG_ARM) && !CONFIG_IS_ENABLED(SYS_DCACHE_OFF)
+#define MEMTEST_HAVE_UNCACHED	1
+#ifdef CONFIG_ARM64
+#define MEMTEST_DCACHE_ON	DCACHE_WRITEBACK
+#else
+#define MEMTEST_DCACHE_ON	DCACHE_DEFAULT_OPTION
+#endif
+#endif
+
+/* What memtest_pass() does with each word */
+enum {
+	MEMTEST_CHECK	= BIT(0),	/* check the word */
+	MEMTEST_WRITE	= BIT(1),	/* write the word (after checking) */
+	MEMTEST_DOWN	= BIT(2),	/* go from the top down */
+};
+
+/**
+ * struct memtest_cpu - results from one core
+ *
+ * This is kept in its own cache line, since each core updates its own.
+ *
+ * @errors: Number of words which read back wrongly
+ * @first_error: Lowest address which read back wrongly
+ * @bit_errors: Bits which were wrong in any word
+ * @bytes: Number of bytes written and read
+ */
+struct memtest_cpu {
+	ulong errors;
+	ulong first_error;
+	u64 bit_errors;
+	u64 bytes;
+} __aligned(ARCH_DMA_MINALIGN);
+
+/**
+ * struct memtest_state - a test shared between the cores
+ *
+ * @buf: Region being tested
+ * @size: Size of the region in bytes
+ * @pattern: Pattern being used (MEMTEST_...)
+ * @flush: true to flush the cache after each pass which writes
+ * @smp: true if running on more than one core
+ * @abort: Set by the boot core to stop the test
+ * @chunks: Number of chunks in the region
+ * @next: Next chunk to test
+ * @cpu: Results from each core
+ */
+struct memtest_state {
+	u64 *buf;
+	ulong size;
+	uint pattern;
+	bool flush;
+	bool smp;
+	bool abort;
+	u32 chunks;
+	u32 next;
+	struct memtest_cpu cpu[MEMTEST_MAX_CPUS];
+};
+
+static const char *const memtest_names[] = {
+	"walking-ones",
+	"walking-zeros",
+	"address",
+	"moving-inversions",
+};
+
+#if CONFIG_IS_ENABLED(UNIT_TEST)
+static const struct memtest_test *memtest_test;
+
+void memtest_set_test(const struct memtest_test *test)
+{
+	memtest_test = test;
+}
+#endif
+
+const char *memtest_pattern_name(uint pattern)
+{
+	if (hweight32(pattern) != 1 || pattern & ~MEMTEST_ALL)
+		return "unknown";
+
+	return memtest_names[__ffs(pattern)];
+}
+
+/* Number of times that each pattern reads or writes the whole region */
+static uint memtest_passes(uint pattern)
+{
+	switch (pattern) {
+	case MEMTEST_ADDRESS:
+		return 4;
+	case MEMTEST_MOVING_INV:
+		return 6;
+	default:
+		return 2;
+	}
+}
+
+/**
+ * memtest_value() - get the value for a word
+ *
+ * @pattern: Pattern in use (MEMTEST_...)
+ * @index: Index of the word from address 0, i.e. its address / 8
+ * @inv: Value to XOR with the result, 0 or ~0ULL
+ * Return: value that the word should hold
+ */
+static __always_inline u64 memtest_value(uint pattern, u64 index, u64 inv)
+{
+	switch (pattern) {
+	case MEMTEST_WALK_ONES:
+		return BIT_ULL(index & 63) ^ inv;
+	case MEMTEST_WALK_ZEROS:
+		return ~BIT_ULL(index & 63) ^ inv;
+	case MEMTEST_ADDRESS:
+		return (index * sizeof(u64)) ^ inv;
+	default:
+		return MEMTEST_INV_VALUE ^ inv;
+	}
+}
+
+/* Get the bits which are wrong in word @k of a group */
+static __always_inline u64 memtest_diff(const u64 *q, int k, u64 idx,
+					uint pattern, u64 check)
+{
+	return q[k] ^ memtest_value(pattern, idx + k, check);
+}
+
+/* Record the errors in a group of four words, given what was wrong in each */
+static noinline void memtest_bad(struct memtest_cpu *cpu, u64 index, u64 d0,
+				 u64 d1, u64 d2, u64 d3)
+{
+	const u64 diff[4] = { d0, d1, d2, d3 };
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		ulong addr = (index + i) * sizeof(u64);
+
+		if (!diff[i])
+			continue;
+		if (!cpu->errors || addr < cpu->first_error)
+			cpu->first_error = addr;
+		cpu->errors++;
+		cpu->bit_errors |= diff[i];
+	}
+}
+
+/**
+ * memtest_pass() - make one pass over a chunk
+ *
+ * This is always inlined with constant @pattern and @mode, so that each pass
+ * becomes a simple loop. Words are handled four at a time so that the
+ * compiler can use paired loads and stores.
+ *
+ * @cpu: Results for this core
+ * @p: Start of the chunk
+ * @words: Number of words in the chunk, a multiple of 4
+ * @index: Index of the first word, see memtest_value()
+ * @pattern: Pattern in use (MEMTEST_...)
+ * @mode: What to do (MEMTEST_CHECK, etc.)
+ * @check: Inversion of the value to check, 0 or ~0ULL
+ * @write: Inversion of the value to write, 0 or ~0ULL
+ */
+static __always_inline void memtest_pass(struct memtest_cpu *cpu, u64 *p,
+					 ulong words, u64 index, uint pattern,
+					 uint mode, u64 check, u64 write)
+{
+	ulong i, j;
+
+	for (j = 0; j < words; j += 4) {
+		u64 *q;
+		u64 idx;
+
+		i = mode & MEMTEST_DOWN ? words - 4 - j : j;
+		q = p + i;
+		idx = index + i;
+		if (mode & MEMTEST_CHECK) {
+			u64 d0, d1, d2, d3;
+
+			if (mode & MEMTEST_DOWN) {
+				d3 = memtest_diff(q, 3, idx, pattern, check);
+				d2 = memtest_diff(q, 2, idx, pattern, check);
+				d1 = memtest_diff(q, 1, idx, pattern, check);
+				d0 = memtest_diff(q, 0, idx, pattern, check);
+			} else {
+				d0 = memtest_diff(q, 0, idx, pattern, check);
+				d1 = memtest_diff(q, 1, idx, pattern, check);
+				d2 = memtest_diff(q, 2, idx, pattern, check);
+				d3 = memtest_diff(q, 3, idx, pattern, check);
+			}
+			if (unlikely(d0 | d1 | d2 | d3))
+				memtest_bad(cpu, idx, d0, d1, d2, d3);
+		}
+		if (mode & MEMTEST_WRITE) {
+			if (mode & MEMTEST_DOWN) {
+				q[3] = memtest_value(pattern, idx + 3, write);
+				q[2] = memtest_value(pattern, idx + 2, write);
+				q[1] = memtest_value(pattern, idx + 1, write);
+				q[0] = memtest_value(pattern, idx, write);
+			} else {
+				q[0] = memtest_value(pattern, idx, write);
+				q[1] = memtest_value(pattern, idx + 1, write);
+				q[2] = memtest_value(pattern, idx + 2, write);
+				q[3] = memtest_value(pattern, idx + 3, write);
+			}
+		}
+	}
+}
+
+/* Make sure that the next pass reads what this one wrote from memory */
+static void memtest_sync(struct memtest_state *st, u64 *p, ulong size)
+{
+	if (st->flush)
+		flush_dcache_range((ulong)p, (ulong)p + size);
+#if CONFIG_IS_ENABLED(UNIT_TEST)
+	if (memtest_test && memtest_test->corrupt)
+		memtest_test->corrupt(p, size);
+#endif
+	barrier();
+}
+
+/* Write a pattern, or its inverse, then check it */
+#define MEMTEST_WRITE_CHECK(_pattern, _inv) do {			\
+	memtest_pass(cpu, p, words, index, _pattern, MEMTEST_WRITE,	\
+		     0, _inv);						\
+	memtest_sync(st, p, size);					\
+	memtest_pass(cpu, p, words, index, _pattern, MEMTEST_CHECK,	\
+		     _inv, 0);						\
+} while (0)
+
+static void memtest_chunk(struct memtest_state *st, struct memtest_cpu *cpu,
+			  u32 chunk)
+{
+	ulong offset = (ulong)chunk * MEMTEST_CHUNK;
+	ulong size = min_t(ulong, st->size - offset, MEMTEST_CHUNK);
+	u64 *p = st->buf + offset / sizeof(u64);
+	ulong words = size / sizeof(u64);
+	u64 index = map_to_sysmem(p) / sizeof(u64);
+
+	switch (st->pattern) {
+	case MEMTEST_WALK_ONES:
+		MEMTEST_WRITE_CHECK(MEMTEST_WALK_ONES, 0);
+		break;
+	case MEMTEST_WALK_ZEROS:
+		MEMTEST_WRITE_CHECK(MEMTEST_WALK_ZEROS, 0);
+		break;
+	case MEMTEST_ADDRESS:
+		MEMTEST_WRITE_CHECK(MEMTEST_ADDRESS, 0);
+		MEMTEST_WRITE_CHECK(MEMTEST_ADDRESS, ~0ULL);
+		break;
+	case MEMTEST_MOVING_INV:
+		memtest_pass(cpu, p, words, index, MEMTEST_MOVING_INV,
+			     MEMTEST_WRITE, 0, 0);
+		memtest_sync(st, p, size);
+		memtest_pass(cpu, p, words, index, MEMTEST_MOVING_INV,
+			     MEMTEST_CHECK | MEMTEST_WRITE, 0, ~0ULL);
+		memtest_sync(st, p, size);
+		memtest_pass(cpu, p, words, index, MEMTEST_MOVING_INV,
+			     MEMTEST_CHECK | MEMTEST_WRITE | MEMTEST_DOWN,
+			     ~0ULL, 0);
+		memtest_sync(st, p, size);
+		memtest_pass(cpu, p, words, index, MEMTEST_MOVING_INV,
+			     MEMTEST_CHECK, 0, 0);
+		break;
+	}
+	cpu->bytes += (u64)size * memtest_passes(st->pattern);
+}
+
+static u32 memtest_claim(struct memtest_state *st)
+{
+#if CONFIG_IS_ENABLED(ARMV8_SMP_RUN)
+	if (st->smp)
+		return smp_run_claim(&st->next);
+#endif
+
+	return st->next++;
+}
+
+/* Test chunks until there are none left; runs on each core */
+static void memtest_worker(void *arg, uint cpu_num)
+{
+	struct memtest_state *st = arg;
+	struct memtest_cpu *cpu = &st->cpu[cpu_num];
+	u32 chunk;
+
+	while (!READ_ONCE(st->abort) &&
+	       (chunk = memtest_claim(st)) < st->chunks) {
+		memtest_chunk(st, cpu, chunk);
+
+		/* Only the boot core may use the console */
+		if (!cpu_num) {
+			WATCHDOG_RESET();
+			if (ctrlc())
+				WRITE_ONCE(st->abort, true);
+		}
+	}
+}
+
+static uint memtest_start(struct memtest_state *st, uint max_cpus)
+{
+#if CONFIG_IS_ENABLED(ARMV8_SMP_RUN)
+	/* smp_run_claim() uses exclusive accesses, which need the cache */
+	if (max_cpus > 1 && dcache_status()) {
+		st->smp = true;
+		return smp_run(memtest_worker, st,
+			       min_t(uint, max_cpus, MEMTEST_MAX_CPUS));
+	}
+#endif
+#if CONFIG_IS_ENABLED(UNIT_TEST)
+	if (memtest_test && memtest_test->cpus > 1) {
+		uint cpus = min3(memtest_test->cpus, max_cpus,
+				 (uint)MEMTEST_MAX_CPUS);
+		u32 chunk;
+
+		for (chunk = 0; chunk < st->chunks; chunk++)
+			memtest_chunk(st, &st->cpu[chunk % cpus], chunk);
+
+		return cpus;
+	}
+#endif
+	memtest_worker(st, 0);
+
+	return 1;
+}
+
+int memtest_run(ulong start, ulong size, uint pattern,
+		enum memtest_cache cache, uint max_cpus,
+		struct memtest_result *res)
+{
+	struct memtest_state st;
+	bool uncached __maybe_unused = false;
+	ulong start_us;
+	int i;
+
+	if (!size || !IS_ALIGNED(start | size, MEMTEST_ALIGN) ||
+	    hweight32(pattern) != 1 || pattern & ~MEMTEST_ALL)
+		return -EINVAL;
+	if (cache == MEMTEST_UNCACHED) {
+#ifdef MEMTEST_HAVE_UNCACHED
+		if (!IS_ALIGNED(start | size, MMU_SECTION_SIZE))
+			return -EINVAL;
+		uncached = dcache_status();
+#else
+		return -ENOSYS;
+#endif
+	}
+
+	memset(&st, '\0', sizeof(st));
+	st.buf = map_sysmem(start, size);
+	st.size = size;
+	st.pattern = pattern;
+	st.flush = cache == MEMTEST_FLUSH;
+	st.chunks = DIV_ROUND_UP(size, MEMTEST_CHUNK);
+
+#ifdef MEMTEST_HAVE_UNCACHED
+	if (uncached) {
+		/* Don't let dirty lines be written back over the test */
+		flush_dcache_range(start, start + size);
+		mmu_set_region_dcache_behaviour(start, size, DCACHE_OFF);
+	}
+#endif
+	start_us = timer_get_us();
+	res->cpus = memtest_start(&st, max_cpus);
+	res->time_us = timer_get_us() - start_us;
+#ifdef MEMTEST_HAVE_UNCACHED
+	if (uncached)
+		mmu_set_region_dcache_behaviour(start, size,
+						MEMTEST_DCACHE_ON);
+#endif
+	unmap_sysmem(st.buf);
+
+	res->errors = 0;
+	res->first_error = 0;
+	res->bit_errors = 0;
+	res->bytes = 0;
+	res->aborted = st.abort;
+	for (i = 0; i < MEMTEST_MAX_CPUS; i++) {
+		struct memtest_cpu *cpu = &st.cpu[i];
+
+		if (cpu->errors &&
+		    (!res->errors || cpu->first_error < res->first_error))
+			res->first_error = cpu->first_error;
+		res->errors += cpu->errors;
+		res->bit_errors |= cpu->bit_errors;
+		res->bytes += cpu->bytes;
+	}
+
+	return 0;
+}
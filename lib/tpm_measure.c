@@ -0,0 +1,279 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Measuring boot images into a TPMv2, see tpm_measure.h
+ *
+ * The event log doubles as the list of pending PCR extends: records after
+ * @flushed have been logged but not yet extended into the TPM.
+ */
+
+#define LOG_CATEGORY UCLASS_TPM
+
+#include <common.h>
+#include <bootstage.h>
+#include <dm.h>
+#include <hash.h>
+#include <log.h>
+#include <malloc.h>
+#include <tpm-common.h>
+#include <tpm-v2.h>
+#include <tpm_measure.h>
+#include <asm/byteorder.h>
+
+/* Number of digests remembered from FIT verification */
+#define MEASURE_DIGESTS		8
+
+/**
+ * struct measure_digest - a remembered digest
+ *
+ * @data: Data which was hashed
+ * @size: Size of data in bytes, 0 if this entry is not in use
+ * @digest: SHA-256 digest of the data
+ */
+struct measure_digest {
+	const void *data;
+	ulong size;
+	u8 digest[TPM2_SHA256_DIGEST_SIZE];
+};
+
+/**
+ * struct measure_state - measurement state
+ *
+ * @digests: Remembered digests
+ * @next_digest: Index of the next entry in @digests to replace
+ * @log: Event log, NULL if not allocated yet
+ * @log_size: Number of bytes used in @log
+ * @log_alloc: Number of bytes allocated for @log
+ * @flushed: Number of bytes of @log whose PCR extends have been sent
+ */
+static struct measure_state {
+	struct measure_digest digests[MEASURE_DIGESTS];
+	uint next_digest;
+	u8 *log;
+	ulong log_size;
+	ulong log_alloc;
+	ulong flushed;
+} measure_state;
+
+static bool measure_overlaps(const struct measure_digest *md,
+			     const void *data, ulong size)
+{
+	return md->size && data < md->data + md->size &&
+		md->data < data + size;
+}
+
+static struct measure_digest *measure_find(const void *data, ulong size)
+{
+	struct measure_state *ms = &measure_state;
+	int i;
+
+	for (i = 0; i < MEASURE_DIGESTS; i++) {
+		struct measure_digest *md = &ms->digests[i];
+
+		if (md->size == size && md->data == data)
+			return md;
+	}
+
+	return NULL;
+}
+
+static void measure_add(const void *data, ulong size, const u8 *digest)
+{
+	struct measure_state *ms = &measure_state;
+	struct measure_digest *md;
+
+	md = measure_find(data, size);
+	if (!md) {
+		md = &ms->digests[ms->next_digest];
+		ms->next_digest = (ms->next_digest + 1) % MEASURE_DIGESTS;
+	}
+	md->data = data;
+	md->size = size;
+	memcpy(md->digest, digest, TPM2_SHA256_DIGEST_SIZE);
+}
+
+void tpm_measure_note_digest(const void *data, ulong size, const char *algo,
+			     const u8 *digest, int digest_len)
+{
+	if (!size || strcmp(algo, "sha256") ||
+	    digest_len != TPM2_SHA256_DIGEST_SIZE)
+		return;
+	measure_add(data, size, digest);
+}
+
+void tpm_measure_forget(const void *data, ulong size)
+{
+	struct measure_state *ms = &measure_state;
+	int i;
+
+	for (i = 0; i < MEASURE_DIGESTS; i++) {
+		if (measure_overlaps(&ms->digests[i], data, size))
+			ms->digests[i].size = 0;
+	}
+}
+
+void tpm_measure_move(const void *from, const void *to, ulong size)
+{
+	struct measure_digest *md = measure_find(from, size);
+	u8 digest[TPM2_SHA256_DIGEST_SIZE];
+
+	if (md)
+		memcpy(digest, md->digest, sizeof(digest));
+	tpm_measure_forget(to, size);
+	if (md)
+		measure_add(to, size, digest);
+}
+
+void tpm_measure_forget_all(void)
+{
+	struct measure_state *ms = &measure_state;
+
+	memset(ms->digests, '\0', sizeof(ms->digests));
+	ms->next_digest = 0;
+}
+
+/**
+ * measure_hash() - get the SHA-256 digest of some data
+ *
+ * @data: Data to hash
+ * @size: Size of @data in bytes
+ * @digest: Returns the digest
+ * Return: 0 if OK, -ve on error
+ */
+static int measure_hash(const void *data, ulong size, u8 *digest)
+{
+	struct measure_digest *md = measure_find(data, size);
+	struct hash_algo *algo;
+	int ret;
+
+	if (md) {
+		log_debug("Using digest for %p size %lx\n", data, size);
+		memcpy(digest, md->digest, TPM2_SHA256_DIGEST_SIZE);
+		return 0;
+	}
+
+	ret = hash_lookup_algo("sha256", &algo);
+	if (ret)
+		return log_msg_ret("alg", ret);
+	algo->hash_func_ws(data, size, digest, algo->chunk_size);
+
+	return 0;
+}
+
+int tpm_measure_data(u32 pcr, u32 event_type, const void *data, ulong size,
+		     const void *event, u32 event_size)
+{
+	struct measure_state *ms = &measure_state;
+	ulong rec_size = sizeof(struct tpm_measure_event) + event_size;
+	struct tpm_measure_event *rec;
+	int ret;
+
+	if (pcr >= TPM2_MAX_PCRS)
+		return log_msg_ret("pcr", -EINVAL);
+	if (ms->log_size + rec_size > ms->log_alloc) {
+		ulong alloc = max(ms->log_alloc * 2,
+				  (ulong)CONFIG_MEASURED_BOOT_LOG_SIZE);
+		u8 *log;
+
+		alloc = max(alloc, ms->log_size + rec_size);
+		log = realloc(ms->log, alloc);
+		if (!log)
+			return log_msg_ret("log", -ENOMEM);
+		ms->log = log;
+		ms->log_alloc = alloc;
+	}
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_MEASURE, "measure");
+	rec = (struct tpm_measure_event *)(ms->log + ms->log_size);
+	ret = measure_hash(data, size, rec->digest);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_MEASURE);
+	if (ret)
+		return ret;
+
+	rec->pcr_index = cpu_to_le32(pcr);
+	rec->event_type = cpu_to_le32(event_type);
+	rec->count = cpu_to_le32(1);
+	rec->alg = cpu_to_le16(TPM2_ALG_SHA256);
+	rec->event_size = cpu_to_le32(event_size);
+	memcpy(rec->event, event, event_size);
+	ms->log_size += rec_size;
+
+	return 0;
+}
+
+static int measure_get_tpm(struct udevice **devp)
+{
+	struct udevice *dev;
+
+	for_each_tpm_device(dev) {
+		if (tpm_get_version(dev) == TPM_V2) {
+			*devp = dev;
+			return 0;
+		}
+	}
+
+	return -ENODEV;
+}
+
+/*
+ * Make sure that the TPM is ready to accept PCR extends. This is harmless if
+ * it has already been started, e.g. with the 'tpm2' command
+ */
+static int measure_start(struct udevice *dev)
+{
+	u32 rc;
+
+	/* This fails if the TPM is already open, which is fine */
+	tpm_init(dev);
+
+	rc = tpm2_startup(dev, TPM2_SU_CLEAR);
+	if (!rc)
+		rc = tpm2_self_test(dev, TPMI_NO);
+	if (rc) {
+		log_err("TPM startup failed (rc=%#x)\n", rc);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+int tpm_measure_flush(struct udevice *dev)
+{
+	struct measure_state *ms = &measure_state;
+	int ret = 0;
+
+	if (ms->flushed == ms->log_size)
+		return 0;
+	if (!dev && measure_get_tpm(&dev))
+		return log_msg_ret("dev", -ENODEV);
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_MEASURE, "measure");
+	ret = measure_start(dev);
+	while (!ret && ms->flushed < ms->log_size) {
+		const struct tpm_measure_event *rec;
+		u32 pcr;
+		u32 rc;
+
+		rec = (struct tpm_measure_event *)(ms->log + ms->flushed);
+		pcr = le32_to_cpu(rec->pcr_index);
+		rc = tpm2_pcr_extend(dev, pcr, TPM2_ALG_SHA256, rec->digest,
+				     TPM2_SHA256_DIGEST_SIZE);
+		if (rc) {
+			log_err("Cannot extend PCR %u (rc=%#x)\n", pcr, rc);
+			ret = -EIO;
+			break;
+		}
+		ms->flushed += sizeof(*rec) + le32_to_cpu(rec->event_size);
+	}
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_MEASURE);
+
+	return ret;
+}
+
+const void *tpm_measure_get_log(ulong *sizep)
+{
+	struct measure_state *ms = &measure_state;
+
+	*sizep = ms->log_size;
+
+	return ms->log_size ? ms->log : NULL;
+}
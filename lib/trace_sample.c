@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Sampling profiler
+ *
+ * A periodic timer interrupt records the interrupted PC and LR into a ring
+ * buffer. This has far lower overhead than function tracing and needs no
+ * special build, at the cost of only being statistically accurate.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <time.h>
+#include <trace.h>
+#include <asm/global_data.h>
+#include <asm/sections.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/**
+ * struct trace_sample_state - state of the sampling profiler
+ *
+ * @samples:	Ring buffer of samples
+ * @size:	Number of samples we have space for
+ * @count:	Total number of samples taken, including overwritten ones
+ * @period_us:	Current sampling period in microseconds
+ * @running:	true if the sampling interrupt is active
+ */
+struct trace_sample_state {
+	struct trace_sample *samples;
+	ulong size;
+	ulong count;
+	uint period_us;
+	bool running;
+};
+
+static struct trace_sample_state state __section(".data");
+
+static inline uint32_t __attribute__((no_instrument_function))
+		sample_addr_to_offset(ulong addr)
+{
+#ifdef CONFIG_SANDBOX
+	return addr - (ulong)&_init;
+#else
+	if (gd->flags & GD_FLG_RELOC)
+		return addr - gd->relocaddr;
+
+	return addr - CONFIG_SYS_TEXT_BASE;
+#endif
+}
+
+void __attribute__((no_instrument_function)) trace_sample_record(ulong pc,
+								  ulong lr)
+{
+	struct trace_sample *rec;
+
+	if (!state.running)
+		return;
+
+	rec = &state.samples[state.count % state.size];
+	rec->pc = sample_addr_to_offset(pc);
+	rec->lr = sample_addr_to_offset(lr);
+	rec->time = timer_get_us() & FUNCF_TIMESTAMP_MASK;
+	state.count++;
+}
+
+int trace_sample_start(uint period_us)
+{
+	int ret;
+
+	if (state.running)
+		return 0;
+	if (!state.samples) {
+		state.size = CONFIG_TRACE_SAMPLE_BUFFER_SIZE /
+			sizeof(struct trace_sample);
+		state.samples = malloc(state.size *
+				       sizeof(struct trace_sample));
+		if (!state.samples)
+			return -ENOMEM;
+	}
+
+	state.period_us = period_us;
+	state.running = true;
+	ret = arch_trace_sample_start(period_us);
+	if (ret) {
+		state.running = false;
+		return ret;
+	}
+
+	return 0;
+}
+
+void trace_sample_stop(void)
+{
+	if (!state.running)
+		return;
+	arch_trace_sample_stop();
+	state.running = false;
+}
+
+int trace_list_samples(void *buff, size_t buff_size, size_t *needed)
+{
+	struct trace_output_hdr *output_hdr = NULL;
+	void *end, *ptr = buff;
+	ulong first, rec, upto;
+	ulong count;
+
+	end = buff ? buff + buff_size : NULL;
+
+	/* Place some header information */
+	if (ptr + sizeof(struct trace_output_hdr) < end)
+		output_hdr = ptr;
+	ptr += sizeof(struct trace_output_hdr);
+
+	/* Write out the samples oldest first */
+	count = min(state.count, state.size);
+	first = state.count - count;
+	for (rec = upto = 0; rec < count; rec++) {
+		if (ptr + sizeof(struct trace_sample) < end) {
+			struct trace_sample *out = ptr;
+
+			*out = state.samples[(first + rec) % state.size];
+			upto++;
+		}
+		ptr += sizeof(struct trace_sample);
+	}
+
+	/* Update the header */
+	if (output_hdr) {
+		output_hdr->rec_count = upto;
+		output_hdr->type = TRACE_CHUNK_SAMPLES;
+	}
+
+	/* Work out how must of the buffer we used */
+	*needed = ptr - buff;
+	if (ptr > end)
+		return -ENOSPC;
+
+	return 0;
+}
+
+void trace_sample_print_stats(void)
+{
+	if (!state.samples) {
+		printf("Sampling has not been started\n");
+		return;
+	}
+	printf("%15s sampling\n", state.running ? "active" : "stopped");
+	printf("%15u us sample period\n", state.period_us);
+	print_grouped_ull(min(state.count, state.size), 10);
+	puts(" samples recorded");
+	if (state.count > state.size)
+		printf(" (%lu overwritten)", state.count - state.size);
+	puts("\n");
+}
+
+__weak int arch_trace_sample_start(uint period_us)
+{
+	return -ENOSYS;
+}
+
+__weak void arch_trace_sample_stop(void)
+{
+}
@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Running jobs on the secondary cores, see worker.h
+ *
+ * Jobs are kept in a ring of pointers. Only the boot core adds to it, at
+ * @head, so that needs no locking. Any core may take from it, at @tail,
+ * which is claimed with a compare-and-exchange.
+ */
+
+#include <common.h>
+#include <log.h>
+#include <worker.h>
+#include <linux/compiler.h>
+
+/* Number of jobs which can be queued; must be a power of two */
+#define WORKER_QUEUE_LEN	32
+
+/**
+ * struct worker_state - the queue shared by all cores
+ *
+ * @queue: Jobs waiting to run
+ * @head: Index of the next slot to fill, written only by the boot core
+ * @tail: Index of the next job to take
+ * @stop: Set to make the workers return from worker_loop()
+ * @count: Number of workers started
+ * @started: true if arch_worker_start() has been called
+ */
+static struct worker_state {
+	struct worker_job *queue[WORKER_QUEUE_LEN];
+	u32 head;
+	u32 tail;
+	u32 stop;
+	uint count;
+	bool started;
+} worker_state;
+
+static void worker_run(struct worker_job *job)
+{
+	job->ret = job->fn(job->arg);
+	arch_worker_sync();
+	WRITE_ONCE(job->done, 1);
+	arch_worker_wake();
+}
+
+static struct worker_job *worker_take(struct worker_state *ws)
+{
+	struct worker_job *job;
+	u32 tail;
+
+	do {
+		tail = READ_ONCE(ws->tail);
+		if (tail == READ_ONCE(ws->head))
+			return NULL;
+		arch_worker_sync();
+		job = READ_ONCE(ws->queue[tail % WORKER_QUEUE_LEN]);
+	} while (arch_worker_cmpxchg(&ws->tail, tail, tail + 1) != tail);
+
+	return job;
+}
+
+void worker_loop(uint id)
+{
+	struct worker_state *ws = &worker_state;
+
+	for (;;) {
+		struct worker_job *job = worker_take(ws);
+
+		if (job)
+			worker_run(job);
+		else if (READ_ONCE(ws->stop))
+			break;
+		else
+			arch_worker_idle();
+	}
+}
+
+void worker_submit(struct worker_job *job)
+{
+	struct worker_state *ws = &worker_state;
+
+	job->done = 0;
+	if (!ws->started) {
+		ws->stop = 0;
+		arch_worker_sync();
+		ws->count = arch_worker_start(UINT_MAX);
+		ws->started = true;
+		log_debug("%u workers\n", ws->count);
+	}
+	if (!ws->count ||
+	    ws->head - READ_ONCE(ws->tail) == WORKER_QUEUE_LEN) {
+		worker_run(job);
+		return;
+	}
+
+	ws->queue[ws->head % WORKER_QUEUE_LEN] = job;
+	arch_worker_sync();
+	WRITE_ONCE(ws->head, ws->head + 1);
+	arch_worker_wake();
+}
+
+int worker_wait(struct worker_job *job)
+{
+	struct worker_state *ws = &worker_state;
+
+	while (!READ_ONCE(job->done)) {
+		struct worker_job *other = worker_take(ws);
+
+		if (other)
+			worker_run(other);
+		else
+			arch_worker_idle();
+	}
+	arch_worker_sync();
+
+	return job->ret;
+}
+
+uint worker_count(void)
+{
+	return worker_state.count;
+}
+
+void worker_stop(void)
+{
+	struct worker_state *ws = &worker_state;
+	struct worker_job *job;
+
+	if (!ws->started)
+		return;
+	while ((job = worker_take(ws)))
+		worker_run(job);
+
+	WRITE_ONCE(ws->stop, 1);
+	arch_worker_sync();
+	arch_worker_wake();
+	if (ws->count)
+		arch_worker_stop();
+	ws->count = 0;
+	ws->started = false;
+}
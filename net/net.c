@@ -466,6 +466,11 @@ restart:
 			tftp_start_server();
 			break;
 #endif
+#ifdef CONFIG_TFTP_MULTI
+		case TFTPMULTI:
+			tftp_multi_start();
+			break;
+#endif
 #ifdef CONFIG_UDP_FUNCTION_FASTBOOT
 		case FASTBOOT:
 			fastboot_start_server();
@@ -1359,6 +1364,7 @@ static int net_check_prereq(enum proto_t protocol)
 		/* Fall through */
 	case TFTPGET:
 	case TFTPPUT:
+	case TFTPMULTI:
 		if (net_server_ip.s_addr == 0 && !is_serverip_in_cmd()) {
 			puts("*** ERROR: `serverip' not set\n");
 			return 1;
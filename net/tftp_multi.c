@@ -0,0 +1,557 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Fetching several files over TFTP at once, see tftp_get_files()
+ *
+ * Each file has a session with its own UDP port at our end, so the server
+ * sees separate transfers and serves them in parallel. All sessions share
+ * the net_loop() timer, which ticks often enough to retransmit for each of
+ * them, and the single transmit buffer: while an ARP request is outstanding
+ * that buffer holds the packet waiting for the reply, so other sessions hold
+ * back their packets until the server's address is known.
+ */
+
+#include <common.h>
+#include <env.h>
+#include <errno.h>
+#include <lmb.h>
+#include <log.h>
+#include <mapmem.h>
+#include <net.h>
+#include <asm/global_data.h>
+#include <net/tftp.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Well known TFTP port # */
+#define WELL_KNOWN_PORT	69
+
+/* TFTP operations */
+#define TFTP_RRQ	1
+#define TFTP_DATA	3
+#define TFTP_ACK	4
+#define TFTP_ERROR	5
+#define TFTP_OACK	6
+
+#define TFTP_ERR_UNDEFINED		0
+#define TFTP_ERR_FILE_NOT_FOUND		1
+#define TFTP_ERR_ACCESS_DENIED		2
+#define TFTP_ERR_DISK_FULL		3
+#define TFTP_ERR_OPTION_NEGOTIATION	8
+
+/* Block size used if the server does not accept the blksize option */
+#define TFTP_BLOCK_SIZE		512
+
+/* Interval for checking the sessions for retransmits, in ms */
+#define TICK_MS			10
+
+/* Print a hash mark each time this many bytes have been received */
+#define HASH_BYTES		(64 << 10)
+
+/**
+ * enum session_state - state of a TFTP session
+ *
+ * @SESSION_RRQ: Read request sent, waiting for the server
+ * @SESSION_HELD: Server has the file, but an earlier file may be used instead
+ * @SESSION_DATA: Receiving data
+ * @SESSION_DONE: File received
+ * @SESSION_FAILED: File could not be received
+ */
+enum session_state {
+	SESSION_RRQ,
+	SESSION_HELD,
+	SESSION_DATA,
+	SESSION_DONE,
+	SESSION_FAILED,
+};
+
+/**
+ * struct tftp_session - a transfer of one file
+ *
+ * @file: File being fetched
+ * @state: Current state
+ * @send_pending: true if a packet is waiting for the ARP reply
+ * @oack: true if the server acknowledged our options (used when held)
+ * @our_port: UDP port at our end
+ * @remote_port: UDP port at the server's end, WELL_KNOWN_PORT until it
+ *	replies
+ * @blksize: Block size in use
+ * @block: Number of the last block received (wraps at 16 bits)
+ * @offset: Number of bytes received
+ * @max_size: Maximum number of bytes which can be stored at the load address
+ * @sent_at: Time the last packet was sent, in ms
+ * @timeouts: Number of timeouts since the server last responded
+ */
+struct tftp_session {
+	struct tftp_file *file;
+	enum session_state state;
+	bool send_pending;
+	bool oack;
+	int our_port;
+	int remote_port;
+	ushort blksize;
+	ushort block;
+	ulong offset;
+	ulong max_size;
+	ulong sent_at;
+	int timeouts;
+};
+
+/**
+ * struct tftp_multi_state - state of all the sessions
+ *
+ * @sessions: Sessions, one for each file
+ * @count: Number of sessions
+ * @first: true to stop at the first file found, see tftp_get_files()
+ * @winner: Index of the file found if @first, -1 if none yet
+ * @remote_ip: IP address of the server
+ * @received: Total number of bytes received, for progress
+ * @time_start: Time the transfers started, in ms
+ */
+static struct tftp_multi_state {
+	struct tftp_session sessions[TFTP_MULTI_MAX];
+	int count;
+	bool first;
+	int winner;
+	struct in_addr remote_ip;
+	ulong received;
+	ulong time_start;
+} tftp_multi;
+
+static bool session_active(const struct tftp_session *s)
+{
+	return s->state != SESSION_DONE && s->state != SESSION_FAILED;
+}
+
+/* Get the session which is allowed to receive data in 'first' mode */
+static struct tftp_session *top_session(void)
+{
+	struct tftp_multi_state *tm = &tftp_multi;
+	int i;
+
+	for (i = 0; i < tm->count; i++) {
+		if (tm->sessions[i].state != SESSION_FAILED)
+			return &tm->sessions[i];
+	}
+
+	return NULL;
+}
+
+static void session_send(struct tftp_session *s)
+{
+	struct tftp_multi_state *tm = &tftp_multi;
+	uchar *pkt, *xp;
+	__be16 *p;
+	int len;
+
+	/* The transmit buffer holds the packet waiting for the ARP reply */
+	if (is_zero_ethaddr(net_server_ethaddr) && arp_is_waiting()) {
+		s->send_pending = true;
+		return;
+	}
+
+	pkt = net_tx_packet + net_eth_hdr_size() + IP_UDP_HDR_SIZE;
+	xp = pkt;
+	p = (__be16 *)pkt;
+	if (s->state == SESSION_RRQ) {
+		*p++ = htons(TFTP_RRQ);
+		pkt = (uchar *)p;
+		pkt += sprintf((char *)pkt, "%s%c", s->file->name, 0);
+		pkt += sprintf((char *)pkt, "octet%c", 0);
+		pkt += sprintf((char *)pkt, "blksize%c%d%c", 0,
+			       CONFIG_TFTP_BLOCKSIZE, 0);
+	} else {
+		*p++ = htons(TFTP_ACK);
+		*p++ = htons(s->block);
+		pkt = (uchar *)p;
+	}
+	len = pkt - xp;
+
+	net_send_udp_packet(net_server_ethaddr, tm->remote_ip, s->remote_port,
+			    s->our_port, len);
+	s->send_pending = false;
+	s->sent_at = get_timer(0);
+}
+
+/* Tell the server to stop sending, e.g. because the file is not needed */
+static void session_send_error(struct tftp_session *s, int code,
+			       const char *msg)
+{
+	struct tftp_multi_state *tm = &tftp_multi;
+	uchar *pkt, *xp;
+	__be16 *p;
+
+	if (s->remote_port == WELL_KNOWN_PORT)
+		return;
+	pkt = net_tx_packet + net_eth_hdr_size() + IP_UDP_HDR_SIZE;
+	xp = pkt;
+	p = (__be16 *)pkt;
+	*p++ = htons(TFTP_ERROR);
+	*p++ = htons(code);
+	pkt = (uchar *)p;
+	pkt += sprintf((char *)pkt, "%s%c", msg, 0);
+
+	net_send_udp_packet(net_server_ethaddr, tm->remote_ip, s->remote_port,
+			    s->our_port, pkt - xp);
+}
+
+/* Ask for the file again, from the start */
+static void session_restart(struct tftp_session *s)
+{
+	s->state = SESSION_RRQ;
+	s->remote_port = WELL_KNOWN_PORT;
+	s->blksize = TFTP_BLOCK_SIZE;
+	s->block = 0;
+	s->offset = 0;
+	session_send(s);
+}
+
+static void tftp_multi_finish(void)
+{
+	struct tftp_multi_state *tm = &tftp_multi;
+	ulong elapsed;
+
+	elapsed = get_timer(tm->time_start);
+	if (tm->received && elapsed) {
+		puts("\n\t ");	/* Line up with "Loading: " */
+		print_size(tm->received / elapsed * 1000, "/s");
+	}
+	puts("\ndone\n");
+	net_set_state(NETLOOP_SUCCESS);
+}
+
+/* Stop if all the files needed have been received or have failed */
+static void check_done(void)
+{
+	struct tftp_multi_state *tm = &tftp_multi;
+	int i;
+
+	for (i = 0; i < tm->count; i++) {
+		struct tftp_session *s = &tm->sessions[i];
+
+		if (tm->first && s->state == SESSION_DONE) {
+			tm->winner = i;
+			break;
+		}
+		if (session_active(s))
+			return;
+	}
+
+	/* Tell the server to drop any other files it is still offering */
+	for (i = 0; i < tm->count; i++) {
+		struct tftp_session *s = &tm->sessions[i];
+
+		if (session_active(s)) {
+			session_send_error(s, TFTP_ERR_UNDEFINED,
+					   "File not needed");
+			s->state = SESSION_FAILED;
+			s->file->ret = -ECANCELED;
+		}
+	}
+	tftp_multi_finish();
+}
+
+/*
+ * Start receiving data for a session. In 'first' mode this waits until all
+ * the earlier files have failed, since they all share the load address.
+ */
+static void session_accept(struct tftp_session *s)
+{
+	if (tftp_multi.first && s != top_session()) {
+		s->state = SESSION_HELD;
+		return;
+	}
+
+	s->state = SESSION_DATA;
+	s->block = 0;
+	s->offset = 0;
+	s->timeouts = 0;
+}
+
+static void session_fail(struct tftp_session *s, int ret)
+{
+	struct tftp_session *top;
+
+	s->state = SESSION_FAILED;
+	s->file->ret = ret;
+
+	top = tftp_multi.first ? top_session() : NULL;
+	if (top && top->state == SESSION_HELD) {
+		/*
+		 * The data sent before the server saw our options was not
+		 * kept, so ask again
+		 */
+		if (top->oack) {
+			session_accept(top);
+			session_send(top);
+		} else {
+			session_restart(top);
+		}
+	}
+	check_done();
+}
+
+static void session_timeout(struct tftp_session *s)
+{
+	if (++s->timeouts > tftp_timeout_count_max) {
+		printf("\nTFTP timeout for '%s'\n", s->file->name);
+		session_fail(s, -ETIMEDOUT);
+		return;
+	}
+	puts("T ");
+
+	/* The server may have given up on a session which was held */
+	if (s->state == SESSION_DATA && !s->offset && !s->block)
+		session_restart(s);
+	else
+		session_send(s);
+}
+
+static void tftp_multi_tick(void)
+{
+	struct tftp_multi_state *tm = &tftp_multi;
+	int i;
+
+	for (i = 0; i < tm->count; i++) {
+		struct tftp_session *s = &tm->sessions[i];
+
+		if (s->send_pending)
+			session_send(s);
+		else if ((s->state == SESSION_RRQ ||
+			  s->state == SESSION_DATA) &&
+			 get_timer(s->sent_at) > tftp_timeout_ms)
+			session_timeout(s);
+	}
+
+	if (net_state == NETLOOP_CONTINUE)
+		net_set_timeout_handler(TICK_MS, tftp_multi_tick);
+}
+
+static void session_oack(struct tftp_session *s, uchar *pkt, unsigned len)
+{
+	int i;
+
+	s->blksize = TFTP_BLOCK_SIZE;
+	for (i = 0; i + 8 < len; i++) {
+		if (!strcasecmp((char *)pkt + i, "blksize"))
+			s->blksize = dectoul((char *)pkt + i + 8, NULL);
+	}
+	if (!s->blksize || s->blksize > CONFIG_TFTP_BLOCKSIZE) {
+		printf("\nInvalid blk size(=%d) for '%s'\n", s->blksize,
+		       s->file->name);
+		session_send_error(s, TFTP_ERR_OPTION_NEGOTIATION,
+				   "Option Negotiation Failed");
+		session_fail(s, -EPROTO);
+		return;
+	}
+	s->oack = true;
+	session_accept(s);
+}
+
+static void session_data(struct tftp_session *s, ushort block, uchar *data,
+			 unsigned len)
+{
+	struct tftp_multi_state *tm = &tftp_multi;
+	void *ptr;
+
+	if (block != (ushort)(s->block + 1)) {
+		/* Our ACK was lost, so send it again */
+		if (block == s->block)
+			session_send(s);
+		return;
+	}
+
+	if (s->offset + len > s->max_size) {
+		printf("\nTFTP error: '%s' would overwrite reserved memory\n",
+		       s->file->name);
+		session_send_error(s, TFTP_ERR_DISK_FULL, "File too large");
+		session_fail(s, -ENOSPC);
+		return;
+	}
+	ptr = map_sysmem(s->file->addr + s->offset, len);
+	memcpy(ptr, data, len);
+	unmap_sysmem(ptr);
+
+	if ((tm->received + len) / HASH_BYTES != tm->received / HASH_BYTES)
+		putc('#');
+	tm->received += len;
+	s->offset += len;
+	s->block = block;
+	s->timeouts = 0;
+	session_send(s);
+
+	if (len < s->blksize) {
+		s->state = SESSION_DONE;
+		s->file->size = s->offset;
+		s->file->ret = 0;
+		check_done();
+	}
+}
+
+static void session_error(struct tftp_session *s, uchar *pkt, unsigned len)
+{
+	int code = ntohs(*(__be16 *)pkt);
+
+	switch (code) {
+	case TFTP_ERR_FILE_NOT_FOUND:
+	case TFTP_ERR_ACCESS_DENIED:
+		printf("\nTFTP error: '%s' (%d) for '%s'\n", pkt + 2, code,
+		       s->file->name);
+		session_fail(s, code == TFTP_ERR_FILE_NOT_FOUND ? -ENOENT :
+			     -EACCES);
+		break;
+	default:
+		/* Start again, counting it as a timeout to avoid looping */
+		if (++s->timeouts > tftp_timeout_count_max) {
+			printf("\nTFTP error: '%s' (%d) for '%s'\n", pkt + 2,
+			       code, s->file->name);
+			session_fail(s, -EIO);
+		} else {
+			session_restart(s);
+		}
+		break;
+	}
+}
+
+static void tftp_multi_handler(uchar *pkt, unsigned dest, struct in_addr sip,
+			       unsigned src, unsigned len)
+{
+	struct tftp_multi_state *tm = &tftp_multi;
+	struct tftp_session *s = NULL;
+	ushort opcode;
+	int i;
+
+	if (sip.s_addr != tm->remote_ip.s_addr)
+		return;
+	for (i = 0; i < tm->count; i++) {
+		if (tm->sessions[i].our_port == dest) {
+			s = &tm->sessions[i];
+			break;
+		}
+	}
+	if (!s || !session_active(s) || len < 4)
+		return;
+	if (s->state != SESSION_RRQ && src != s->remote_port)
+		return;
+
+	opcode = ntohs(*(__be16 *)pkt);
+	pkt += 2;
+	len -= 2;
+	switch (opcode) {
+	case TFTP_OACK:
+		if (s->state != SESSION_RRQ) {
+			/* Our ACK of the options was lost */
+			if (s->state == SESSION_DATA && !s->block)
+				session_send(s);
+			break;
+		}
+		s->remote_port = src;
+		session_oack(s, pkt, len);
+		if (s->state == SESSION_DATA)
+			session_send(s);
+		break;
+	case TFTP_DATA:
+		if (s->state == SESSION_RRQ) {
+			/* The server ignored our options */
+			if (ntohs(*(__be16 *)pkt) != 1)
+				break;
+			s->remote_port = src;
+			s->blksize = TFTP_BLOCK_SIZE;
+			s->oack = false;
+			session_accept(s);
+		}
+		if (s->state == SESSION_DATA)
+			session_data(s, ntohs(*(__be16 *)pkt), pkt + 2,
+				     len - 2);
+		break;
+	case TFTP_ERROR:
+		session_error(s, pkt, len);
+		break;
+	}
+}
+
+void tftp_multi_start(void)
+{
+	struct tftp_multi_state *tm = &tftp_multi;
+	struct lmb lmb;
+	int base, i;
+
+	printf("Using %s device\n", eth_get_name());
+	printf("TFTP from server %pI4; our IP address is %pI4\n",
+	       &net_server_ip, &net_ip);
+
+	if (IS_ENABLED(CONFIG_LMB))
+		lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
+
+	tm->remote_ip = net_server_ip;
+	tm->winner = -1;
+	tm->received = 0;
+	tm->time_start = get_timer(0);
+	/* Use pseudo-random ports, one for each session */
+	base = 1024 + (get_timer(0) % 3072);
+	for (i = 0; i < tm->count; i++) {
+		struct tftp_session *s = &tm->sessions[i];
+
+		s->our_port = base + i;
+		s->timeouts = 0;
+		s->oack = false;
+		s->send_pending = false;
+		s->state = SESSION_RRQ;
+		s->file->ret = -EINTR;
+		s->max_size = ULONG_MAX;
+		if (IS_ENABLED(CONFIG_LMB)) {
+			s->max_size = lmb_get_free_size(&lmb, s->file->addr);
+			if (!s->max_size) {
+				printf("TFTP error: '%s' would overwrite reserved memory\n",
+				       s->file->name);
+				s->state = SESSION_FAILED;
+				s->file->ret = -ENOSPC;
+			}
+		}
+	}
+	if (IS_ENABLED(CONFIG_LMB))
+		lmb_uninit(&lmb);
+
+	/* zero out server ether in case the server ip has changed */
+	memset(net_server_ethaddr, 0, 6);
+	net_set_udp_handler(tftp_multi_handler);
+	net_set_timeout_handler(TICK_MS, tftp_multi_tick);
+	puts("Loading: *\b");
+
+	for (i = 0; i < tm->count; i++) {
+		struct tftp_session *s = &tm->sessions[i];
+
+		if (s->state == SESSION_RRQ)
+			session_restart(s);
+	}
+	check_done();
+}
+
+int tftp_get_files(struct tftp_file *files, int count, bool first)
+{
+	struct tftp_multi_state *tm = &tftp_multi;
+	int ret, i;
+
+	if (count > TFTP_MULTI_MAX)
+		return log_msg_ret("cnt", -E2BIG);
+
+	tm->count = count;
+	tm->first = first;
+	for (i = 0; i < count; i++) {
+		files[i].size = 0;
+		files[i].ret = -EINTR;
+		tm->sessions[i].file = &files[i];
+	}
+
+	ret = net_loop(TFTPMULTI);
+	if (ret < 0)
+		return ret;
+
+	if (first)
+		return tm->winner >= 0 ? tm->winner : -ENOENT;
+	for (i = 0; i < count; i++) {
+		if (files[i].ret)
+			return files[i].ret;
+	}
+
+	return 0;
+}
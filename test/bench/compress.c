@@ -0,0 +1,587 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Decompression benchmarks
+ *
+ * Each benchmark decompresses the same BENCH_TEXT_SIZE bytes of text, which
+ * is created by bench_make_text() and was compressed on the host with the
+ * usual tool for each format (gzip -9, lz4, zstd -19 and lzma -9).
+ */
+
+#include <common.h>
+#include <abuf.h>
+#include <bench.h>
+#include <gzip.h>
+#include <malloc.h>
+#include <lzma/LzmaTypes.h>
+#include <lzma/LzmaDec.h>
+#include <lzma/LzmaTools.h>
+#include <linux/zstd.h>
+#include <u-boot/lz4.h>
+
+#define BENCH_TEXT_SIZE	4096
+
+/**
+ * bench_make_text() - create the text which the data below decompresses to
+ *
+ * This is BENCH_TEXT_SIZE bytes of words chosen by a simple pseudo-random
+ * generator, so it compresses roughly as well as typical text.
+ *
+ * @buf: Buffer to fill, of at least BENCH_TEXT_SIZE bytes
+ */
+static __maybe_unused void bench_make_text(char *buf)
+{
+	static const char *const words[] = {
+		"the", "boot", "loader", "device", "driver", "memory", "image",
+		"kernel", "flash", "load", "read", "write", "block", "cache",
+		"timer", "clock",
+	};
+	char *end = buf + BENCH_TEXT_SIZE;
+	u32 seed = 1;
+
+	while (buf < end) {
+		const char *word;
+
+		seed = seed * 1103515245 + 12345;
+		for (word = words[(seed >> 16) & 15]; *word && buf < end;)
+			*buf++ = *word++;
+		if (buf < end)
+			*buf++ = (seed >> 24) & 7 ? ' ' : '\n';
+	}
+}
+
+/**
+ * bench_decomp_setup() - set up a decompression benchmark
+ *
+ * This allocates the output buffer and checks that the data decompresses
+ * correctly.
+ *
+ * @bs: Benchmark state
+ * @data: Compressed data
+ * @len: Length of compressed data in bytes
+ * @run: Function to decompress the data
+ * Return: 0 if OK, -ve on error
+ */
+static __maybe_unused int bench_decomp_setup(struct bench_state *bs,
+					     const u8 *data, ulong len,
+					     int (*run)(struct bench_state *bs))
+{
+	char *expect;
+	int ret;
+
+	bs->src = data;
+	bs->src_size = len;
+	bs->size = BENCH_TEXT_SIZE;
+	bs->dst = malloc(BENCH_TEXT_SIZE);
+	expect = malloc(BENCH_TEXT_SIZE);
+	if (!bs->dst || !expect) {
+		ret = -ENOMEM;
+		goto err;
+	}
+	bench_make_text(expect);
+	ret = run(bs);
+	if (!ret && memcmp(bs->dst, expect, BENCH_TEXT_SIZE))
+		ret = -EBADMSG;
+	if (ret)
+		goto err;
+	free(expect);
+
+	return 0;
+err:
+	free(expect);
+	free(bs->dst);
+
+	return ret;
+}
+
+static __maybe_unused void bench_decomp_teardown(struct bench_state *bs)
+{
+	free(bs->dst);
+}
+
+#if CONFIG_IS_ENABLED(GZIP)
+static const u8 bench_gzip_data[] = {
+	0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x6d, 0x97,
+	0x5d, 0x72, 0x22, 0x31, 0x10, 0x83, 0xdf, 0x7d, 0x0a, 0xae, 0x06, 0x93,
+	0xc9, 0x42, 0x05, 0x96, 0x2a, 0x36, 0x95, 0xad, 0xbd, 0xfd, 0x32, 0x2d,
+	0xd9, 0xfe, 0xc4, 0xf0, 0x32, 0x61, 0x7e, 0xdc, 0xdd, 0x56, 0x4b, 0x6a,
+	0xe7, 0x72, 0x3b, 0xfe, 0x5a, 0x0f, 0xdf, 0x97, 0xdb, 0xfa, 0x38, 0x9c,
+	0xee, 0xf7, 0xef, 0xc3, 0xdf, 0xc7, 0xe5, 0x7b, 0x8d, 0xeb, 0xf5, 0x7e,
+	0xfc, 0x78, 0xbe, 0xd5, 0xcd, 0xc7, 0xe3, 0xf2, 0xf3, 0xbc, 0xb9, 0xd4,
+	0xb2, 0xe5, 0xb8, 0x9c, 0x9f, 0xd7, 0xeb, 0x7d, 0xf9, 0x3a, 0x9c, 0x78,
+	0xdd, 0x02, 0x7d, 0xad, 0x8f, 0xdf, 0xeb, 0x55, 0xbf, 0x97, 0xf9, 0x58,
+	0xa9, 0xb4, 0xde, 0x91, 0xeb, 0x6d, 0xd3, 0xf7, 0xfe, 0xe3, 0x0f, 0x7c,
+	0xb3, 0x7d, 0x77, 0x78, 0xac, 0xcf, 0xcb, 0xe7, 0xf5, 0xf8, 0xe7, 0xec,
+	0x2c, 0xf3, 0xa9, 0x3e, 0xfe, 0x58, 0x7f, 0x2e, 0xcb, 0x4b, 0xd1, 0xb7,
+	0xf5, 0x76, 0x7f, 0xfc, 0x53, 0x66, 0xae, 0xf5, 0x36, 0xfc, 0x9a, 0x05,
+	0xb8, 0x40, 0xbf, 0x51, 0xb0, 0x4a, 0xe2, 0x88, 0x95, 0x15, 0xa1, 0x9a,
+	0xd2, 0x36, 0x14, 0xa2, 0x08, 0xcb, 0x28, 0xb2, 0xd5, 0x1a, 0x25, 0xd1,
+	0x53, 0x5d, 0xf1, 0x75, 0x8f, 0xa2, 0xc0, 0xc6, 0xb5, 0xae, 0x15, 0x97,
+	0xa0, 0xd5, 0x03, 0xd5, 0xdf, 0x98, 0x0f, 0xa0, 0x68, 0x25, 0xcb, 0xd0,
+	0x87, 0x6a, 0xc0, 0xf6, 0xea, 0xdc, 0x71, 0x42, 0x67, 0x94, 0xdb, 0x1b,
+	0xdf, 0xbe, 0xf0, 0xcf, 0xda, 0x82, 0x61, 0x13, 0xc4, 0xa8, 0x4c, 0x51,
+	0xb4, 0xb4, 0x72, 0x1b, 0x26, 0x7f, 0xd9, 0x3b, 0x5c, 0x0b, 0xaa, 0x08,
+	0x23, 0x50, 0x8b, 0x91, 0x60, 0x6c, 0x2f, 0x80, 0x60, 0xc4, 0xad, 0xc6,
+	0x86, 0xad, 0x36, 0x3f, 0x77, 0x2f, 0xb6, 0x1d, 0x4c, 0x08, 0x7a, 0xb8,
+	0x46, 0x02, 0x98, 0xb4, 0xf5, 0x51, 0xd0, 0x0c, 0xa0, 0x01, 0x63, 0x05,
+	0x0e, 0xa6, 0x34, 0x72, 0xa8, 0x13, 0x7c, 0x22, 0x58, 0x60, 0x34, 0x05,
+	0x02, 0xd9, 0x95, 0x71, 0x43, 0xb4, 0x12, 0x51, 0x18, 0x6c, 0x42, 0x80,
+	0x3b, 0x5a, 0xa5, 0xdb, 0x4e, 0xd4, 0x49, 0x8c, 0x66, 0x3d, 0x72, 0x91,
+	0xd2, 0x89, 0x50, 0x4e, 0x3a, 0x89, 0xa3, 0xda, 0x5b, 0x08, 0xb8, 0xf6,
+	0x59, 0xc0, 0x1a, 0x76, 0x87, 0x03, 0x1f, 0xcc, 0x34, 0x17, 0x0d, 0x3d,
+	0x98, 0x47, 0xad, 0xbe, 0xed, 0x65, 0x4c, 0x0e, 0x6e, 0xaf, 0x21, 0xdf,
+	0x49, 0x09, 0x10, 0x4c, 0x4d, 0x83, 0x59, 0x04, 0x21, 0x7a, 0xef, 0xac,
+	0x89, 0xea, 0xb9, 0xf6, 0xa6, 0x5d, 0x55, 0x9a, 0x70, 0xa5, 0x09, 0xb4,
+	0xf0, 0x28, 0xe6, 0x6a, 0xc9, 0x56, 0xb2, 0x21, 0xb3, 0x68, 0x2c, 0x83,
+	0x37, 0xa4, 0x38, 0x41, 0x32, 0xae, 0x61, 0x67, 0x3e, 0x0a, 0x35, 0x75,
+	0x64, 0xf7, 0xaa, 0x9a, 0x5c, 0xcd, 0x5b, 0x25, 0x28, 0x06, 0xd4, 0x15,
+	0x46, 0xe7, 0x67, 0xbe, 0x8b, 0x72, 0xb6, 0x25, 0x0e, 0x1c, 0x9d, 0xcf,
+	0x64, 0xea, 0x74, 0xef, 0x22, 0x68, 0xd5, 0x00, 0xad, 0x59, 0x51, 0x7b,
+	0x92, 0x9b, 0xe8, 0xfb, 0x09, 0x9c, 0x32, 0x80, 0xc2, 0x40, 0x3c, 0xc8,
+	0xaf, 0x27, 0x60, 0x00, 0xec, 0x8a, 0xd0, 0x45, 0x45, 0x50, 0x2c, 0x7c,
+	0x49, 0x39, 0x13, 0x01, 0x93, 0x6f, 0xf8, 0xef, 0x61, 0x6f, 0x9f, 0xde,
+	0xf8, 0xa8, 0x5d, 0x7c, 0xb4, 0x5c, 0xfd, 0x32, 0xc8, 0x9b, 0x93, 0x81,
+	0x0a, 0xa5, 0x03, 0xb0, 0xd7, 0x2f, 0xb8, 0x74, 0x09, 0xc1, 0x72, 0xc8,
+	0x81, 0xde, 0x91, 0x7e, 0x47, 0x81, 0x26, 0x25, 0x42, 0x8a, 0x34, 0xaa,
+	0x79, 0x51, 0x19, 0xba, 0x3a, 0xa0, 0x84, 0x20, 0xcc, 0x05, 0x4f, 0x58,
+	0xc4, 0x24, 0xe6, 0xc2, 0xf1, 0xe4, 0xb7, 0x60, 0x4b, 0x6c, 0x71, 0x37,
+	0x25, 0xd8, 0xb5, 0x24, 0x67, 0xa0, 0x68, 0xa5, 0xe6, 0xbe, 0x26, 0x6a,
+	0x08, 0x68, 0x77, 0xb7, 0x50, 0x89, 0x86, 0x4c, 0x48, 0xd3, 0xb1, 0x3a,
+	0x38, 0x57, 0x59, 0x4f, 0xa1, 0x20, 0x1c, 0x28, 0xd4, 0x0e, 0x4c, 0x5e,
+	0x78, 0x71, 0xcc, 0x02, 0x6d, 0xd5, 0x66, 0x5b, 0xb9, 0x5d, 0x48, 0xa9,
+	0x2a, 0x7c, 0x89, 0xb3, 0x1e, 0x26, 0x49, 0x56, 0xd8, 0xa1, 0x67, 0xae,
+	0xe0, 0x52, 0x52, 0x0f, 0x09, 0x78, 0x4e, 0xca, 0x9c, 0x71, 0x72, 0x81,
+	0x18, 0xc3, 0xf5, 0x79, 0x06, 0x18, 0xe6, 0x29, 0xbd, 0x23, 0x09, 0xd0,
+	0x41, 0x93, 0xa7, 0x7c, 0xdb, 0x18, 0xa9, 0x07, 0x4e, 0x88, 0x02, 0xbb,
+	0xd6, 0xc2, 0x55, 0xdf, 0x4c, 0x18, 0xea, 0x2f, 0x54, 0x1e, 0x7f, 0x1a,
+	0x91, 0xe6, 0x01, 0xf0, 0xa5, 0x3d, 0x83, 0x37, 0x6a, 0x46, 0x01, 0xbd,
+	0xc0, 0x22, 0xc2, 0x1b, 0xc1, 0x22, 0x4f, 0xb8, 0x11, 0x1e, 0x03, 0x61,
+	0x88, 0x39, 0x35, 0x16, 0x56, 0x3a, 0xa6, 0x5e, 0x12, 0x76, 0x22, 0x63,
+	0x33, 0x57, 0x11, 0x35, 0x39, 0x94, 0x8b, 0x8a, 0x19, 0x33, 0x50, 0xfb,
+	0x83, 0x6d, 0x4e, 0x5f, 0xdd, 0x75, 0x20, 0x44, 0xb0, 0x13, 0xec, 0x69,
+	0x0f, 0x6b, 0x74, 0x75, 0xc2, 0x19, 0x1e, 0xec, 0x39, 0x2d, 0x9d, 0x6f,
+	0x13, 0xb9, 0x1f, 0x64, 0xcf, 0x79, 0x9e, 0x9c, 0xfb, 0x43, 0xd4, 0x46,
+	0x11, 0x76, 0x87, 0xc1, 0xf1, 0xd3, 0xb5, 0xd2, 0x81, 0x34, 0x4b, 0x53,
+	0x94, 0xf0, 0x81, 0xec, 0xda, 0x82, 0xe3, 0x76, 0xc3, 0xdc, 0x99, 0xa3,
+	0x7a, 0x6f, 0x43, 0x0e, 0x36, 0x21, 0x8c, 0x24, 0xe3, 0x20, 0x35, 0xc6,
+	0x12, 0xbc, 0x30, 0x88, 0xc3, 0x89, 0x31, 0x4f, 0xac, 0x98, 0x3e, 0x18,
+	0x73, 0x61, 0x17, 0x04, 0x46, 0x2b, 0xbd, 0x73, 0xce, 0x16, 0xe5, 0x0e,
+	0xe9, 0x82, 0xdf, 0x69, 0x9d, 0xe8, 0x9f, 0x23, 0x45, 0x90, 0xe1, 0xf7,
+	0x8d, 0x4e, 0xd2, 0x70, 0x34, 0x69, 0x39, 0x17, 0x77, 0xc7, 0xd6, 0x6e,
+	0x67, 0x13, 0x60, 0xd5, 0x92, 0xb6, 0x8f, 0x6c, 0x71, 0xb6, 0xea, 0x88,
+	0x36, 0xc8, 0xb4, 0xbd, 0xfe, 0x8f, 0xf0, 0x6e, 0x5a, 0x21, 0x13, 0x4f,
+	0x3e, 0x34, 0x48, 0x12, 0x9f, 0x26, 0xed, 0x26, 0xb3, 0x18, 0x43, 0xc3,
+	0x13, 0x19, 0x86, 0x1d, 0x0c, 0xa8, 0xf1, 0x1c, 0xed, 0x55, 0xf4, 0x27,
+	0xe8, 0x30, 0x94, 0xc2, 0x41, 0x39, 0x8d, 0x50, 0xbf, 0x70, 0x2c, 0x8d,
+	0x09, 0x47, 0x6f, 0x0a, 0x9b, 0x89, 0xbd, 0xe2, 0xf5, 0x9e, 0xc3, 0x74,
+	0x53, 0x9e, 0xfa, 0x1a, 0x86, 0xd0, 0xc2, 0x76, 0xf1, 0x1f, 0xbd, 0x98,
+	0x1d, 0x13, 0x07, 0x69, 0x90, 0xc7, 0x5e, 0xc0, 0xdd, 0x16, 0xba, 0x2b,
+	0x8f, 0x6a, 0xd3, 0x1a, 0xfc, 0xf3, 0x3f, 0x55, 0x69, 0x85, 0x73, 0x00,
+	0x10, 0x00, 0x00,
+};
+
+static int bench_gunzip(struct bench_state *bs)
+{
+	ulong len = bs->src_size;
+
+	if (gunzip(bs->dst, bs->size, (uchar *)bs->src, &len))
+		return -EIO;
+
+	return len == bs->size ? 0 : -EIO;
+}
+
+static int bench_gunzip_setup(struct bench_state *bs)
+{
+	return bench_decomp_setup(bs, bench_gzip_data, sizeof(bench_gzip_data),
+				  bench_gunzip);
+}
+BENCH(bench_gunzip, 0, bench_gunzip_setup, bench_decomp_teardown);
+#endif
+
+#if CONFIG_IS_ENABLED(LZ4)
+static const u8 bench_lz4_data[] = {
+	0x04, 0x22, 0x4d, 0x18, 0x60, 0x40, 0x82, 0xee, 0x07, 0x00, 0x00, 0xf9,
+	0x07, 0x69, 0x6d, 0x61, 0x67, 0x65, 0x20, 0x74, 0x69, 0x6d, 0x65, 0x72,
+	0x20, 0x62, 0x6f, 0x6f, 0x74, 0x20, 0x77, 0x72, 0x69, 0x74, 0x65, 0x06,
+	0x00, 0x63, 0x6c, 0x6f, 0x61, 0x64, 0x65, 0x72, 0x13, 0x00, 0x72, 0x64,
+	0x72, 0x69, 0x76, 0x65, 0x72, 0x20, 0x37, 0x00, 0xd8, 0x63, 0x61, 0x63,
+	0x68, 0x65, 0x20, 0x63, 0x6c, 0x6f, 0x63, 0x6b, 0x20, 0x62, 0x06, 0x00,
+	0x00, 0x49, 0x00, 0x62, 0x6b, 0x65, 0x72, 0x6e, 0x65, 0x6c, 0x0c, 0x00,
+	0x03, 0x23, 0x00, 0x00, 0x17, 0x00, 0x02, 0x6b, 0x00, 0x02, 0x40, 0x00,
+	0x03, 0x5a, 0x00, 0x01, 0x1e, 0x00, 0x12, 0x0a, 0x30, 0x00, 0x03, 0x07,
+	0x00, 0x03, 0x61, 0x00, 0x02, 0x14, 0x00, 0x01, 0x28, 0x00, 0xb3, 0x20,
+	0x72, 0x65, 0x61, 0x64, 0x20, 0x66, 0x6c, 0x61, 0x73, 0x68, 0x6c, 0x00,
+	0x06, 0x16, 0x00, 0x02, 0x4e, 0x00, 0x54, 0x64, 0x65, 0x76, 0x69, 0x63,
+	0xbb, 0x00, 0x00, 0x1d, 0x00, 0x92, 0x65, 0x72, 0x20, 0x6d, 0x65, 0x6d,
+	0x6f, 0x72, 0x79, 0x7a, 0x00, 0x08, 0x3c, 0x00, 0x03, 0xc7, 0x00, 0x03,
+	0x1f, 0x00, 0x08, 0x81, 0x00, 0x03, 0x0c, 0x01, 0x03, 0x1a, 0x00, 0x02,
+	0x0e, 0x01, 0x01, 0x7b, 0x00, 0x03, 0x52, 0x00, 0x00, 0x07, 0x00, 0x08,
+	0x87, 0x00, 0x12, 0x0a, 0x77, 0x00, 0x11, 0x0a, 0x24, 0x00, 0x02, 0x89,
+	0x00, 0x02, 0xe3, 0x00, 0x01, 0x55, 0x00, 0x01, 0xbb, 0x00, 0x11, 0x0a,
+	0x34, 0x00, 0x01, 0x10, 0x00, 0x11, 0x0a, 0x06, 0x00, 0x03, 0x33, 0x01,
+	0x07, 0x2e, 0x00, 0x04, 0x46, 0x00, 0x02, 0xa4, 0x00, 0x03, 0x58, 0x01,
+	0x01, 0x5e, 0x01, 0x01, 0x58, 0x00, 0x02, 0x52, 0x00, 0x02, 0x30, 0x00,
+	0x01, 0x11, 0x00, 0x02, 0xc0, 0x00, 0x12, 0x0a, 0x12, 0x00, 0x02, 0x1e,
+	0x00, 0x02, 0x81, 0x01, 0x02, 0x6b, 0x00, 0x01, 0x3a, 0x00, 0x02, 0x17,
+	0x00, 0x02, 0x71, 0x00, 0x02, 0x29, 0x00, 0x01, 0xe1, 0x01, 0x31, 0x74,
+	0x68, 0x65, 0x04, 0x00, 0x02, 0xdb, 0x00, 0x02, 0x1f, 0x00, 0x01, 0x19,
+	0x00, 0x02, 0x7c, 0x00, 0x03, 0xf9, 0x00, 0x00, 0x22, 0x00, 0x03, 0x0b,
+	0x00, 0x00, 0x53, 0x00, 0x12, 0x0a, 0x5e, 0x00, 0x02, 0xec, 0x00, 0x03,
+	0x60, 0x00, 0x01, 0x89, 0x00, 0x02, 0x46, 0x00, 0x02, 0x3b, 0x00, 0x00,
+	0x29, 0x00, 0x01, 0xf1, 0x00, 0x24, 0x65, 0x72, 0x2a, 0x00, 0x00, 0x13,
+	0x00, 0x23, 0x65, 0x72, 0x31, 0x00, 0x01, 0x85, 0x00, 0x03, 0x02, 0x01,
+	0x01, 0x3d, 0x00, 0x07, 0x61, 0x00, 0x05, 0x54, 0x02, 0x02, 0x39, 0x00,
+	0x1e, 0x0a, 0x52, 0x00, 0x00, 0xa4, 0x00, 0x12, 0x0a, 0xd4, 0x00, 0x01,
+	0x8d, 0x00, 0x01, 0x56, 0x01, 0x24, 0x65, 0x72, 0x8c, 0x01, 0x00, 0x5c,
+	0x02, 0x01, 0x18, 0x00, 0x04, 0x82, 0x00, 0x02, 0x6e, 0x00, 0x03, 0x63,
+	0x00, 0x00, 0x3d, 0x00, 0x03, 0x54, 0x02, 0x02, 0xf2, 0x00, 0x03, 0x5a,
+	0x02, 0x01, 0x25, 0x00, 0x01, 0x32, 0x00, 0x08, 0xa4, 0x00, 0x08, 0x6c,
+	0x02, 0x02, 0x6a, 0x01, 0x03, 0x49, 0x02, 0x03, 0x97, 0x00, 0x02, 0x68,
+	0x00, 0x03, 0x43, 0x00, 0x02, 0x0d, 0x00, 0x01, 0x61, 0x00, 0x01, 0x0d,
+	0x01, 0x12, 0x0a, 0xbe, 0x01, 0x01, 0x11, 0x00, 0x02, 0xaf, 0x00, 0x02,
+	0x72, 0x00, 0x00, 0x52, 0x01, 0x00, 0x0f, 0x01, 0x05, 0x38, 0x00, 0x00,
+	0xb2, 0x00, 0x01, 0x32, 0x00, 0x03, 0x0f, 0x02, 0x02, 0xfa, 0x00, 0x03,
+	0x88, 0x00, 0x02, 0x3f, 0x00, 0x00, 0x5e, 0x03, 0x01, 0xcc, 0x01, 0x03,
+	0xc7, 0x00, 0x02, 0x5b, 0x00, 0x01, 0x06, 0x00, 0x12, 0x0a, 0x3b, 0x00,
+	0x09, 0x35, 0x00, 0x02, 0x6f, 0x00, 0x01, 0x06, 0x00, 0x03, 0x67, 0x01,
+	0x01, 0x0c, 0x00, 0x02, 0xf9, 0x00, 0x02, 0xbc, 0x00, 0x13, 0x0a, 0xd0,
+	0x00, 0x02, 0xf9, 0x00, 0x01, 0x86, 0x01, 0x00, 0x6b, 0x00, 0x04, 0x80,
+	0x02, 0x03, 0x4f, 0x00, 0x00, 0x13, 0x00, 0x03, 0x59, 0x01, 0x02, 0x30,
+	0x00, 0x04, 0x97, 0x03, 0x02, 0x75, 0x00, 0x01, 0x37, 0x00, 0x00, 0xd0,
+	0x00, 0x41, 0x74, 0x68, 0x65, 0x0a, 0x2c, 0x00, 0x03, 0x38, 0x00, 0x02,
+	0xea, 0x00, 0x01, 0xe6, 0x00, 0x00, 0x1f, 0x00, 0x03, 0xea, 0x00, 0x00,
+	0x10, 0x00, 0x06, 0x13, 0x02, 0x03, 0xcb, 0x00, 0x00, 0x20, 0x00, 0x01,
+	0x3b, 0x00, 0x01, 0x05, 0x00, 0x03, 0x2a, 0x00, 0x03, 0x1c, 0x00, 0x02,
+	0x31, 0x00, 0x13, 0x0a, 0x0e, 0x00, 0x02, 0x0b, 0x02, 0x01, 0x5b, 0x00,
+	0x02, 0x00, 0x02, 0x02, 0x06, 0x00, 0x02, 0xb6, 0x01, 0x02, 0x91, 0x00,
+	0x02, 0xa5, 0x00, 0x03, 0x48, 0x01, 0x00, 0x5a, 0x00, 0x01, 0x23, 0x01,
+	0x01, 0x22, 0x00, 0x02, 0x2d, 0x00, 0x01, 0x9f, 0x03, 0x03, 0x33, 0x01,
+	0x02, 0xfb, 0x00, 0x00, 0x26, 0x00, 0x00, 0x04, 0x00, 0x02, 0x0e, 0x00,
+	0x01, 0x5e, 0x00, 0x05, 0x9a, 0x01, 0x01, 0xcb, 0x04, 0x02, 0x19, 0x00,
+	0x03, 0x84, 0x00, 0x01, 0xf2, 0x00, 0x02, 0x89, 0x00, 0x02, 0xf0, 0x01,
+	0x02, 0x78, 0x00, 0x00, 0x41, 0x00, 0x02, 0x0a, 0x00, 0x02, 0xc1, 0x00,
+	0x01, 0x94, 0x02, 0x04, 0x8e, 0x00, 0x02, 0xc6, 0x00, 0x0b, 0x0a, 0x03,
+	0x02, 0x44, 0x00, 0x00, 0x38, 0x00, 0x03, 0x5a, 0x00, 0x02, 0x67, 0x00,
+	0x02, 0x3f, 0x00, 0x03, 0x66, 0x02, 0x04, 0x88, 0x00, 0x03, 0x15, 0x00,
+	0x02, 0x71, 0x00, 0x00, 0x33, 0x00, 0x03, 0x59, 0x00, 0x02, 0x72, 0x00,
+	0x03, 0x73, 0x01, 0x03, 0x14, 0x00, 0x03, 0x6d, 0x00, 0x01, 0x4e, 0x00,
+	0x03, 0xcd, 0x01, 0x03, 0xc8, 0x00, 0x02, 0x28, 0x00, 0x04, 0x4d, 0x01,
+	0x00, 0x28, 0x00, 0x03, 0xe3, 0x04, 0x01, 0xd4, 0x00, 0x01, 0x05, 0x00,
+	0x02, 0x23, 0x00, 0x07, 0x6f, 0x02, 0x02, 0x62, 0x00, 0x01, 0x9a, 0x01,
+	0x02, 0x42, 0x02, 0x02, 0x06, 0x00, 0x01, 0x3d, 0x00, 0x02, 0x8f, 0x00,
+	0x03, 0x9c, 0x00, 0x02, 0x12, 0x00, 0x00, 0xca, 0x02, 0x03, 0x44, 0x00,
+	0x01, 0x50, 0x00, 0x02, 0x2e, 0x00, 0x03, 0xe1, 0x00, 0x01, 0x12, 0x00,
+	0x03, 0x1e, 0x00, 0x02, 0x3c, 0x00, 0x02, 0x04, 0x01, 0x01, 0x5e, 0x00,
+	0x01, 0xb0, 0x00, 0x02, 0x41, 0x00, 0x02, 0x74, 0x00, 0x03, 0x35, 0x00,
+	0x03, 0x5f, 0x00, 0x02, 0xdd, 0x00, 0x01, 0xbd, 0x01, 0x01, 0xcd, 0x01,
+	0x03, 0xe2, 0x01, 0x02, 0xae, 0x01, 0x02, 0x3c, 0x00, 0x00, 0x82, 0x00,
+	0x26, 0x65, 0x72, 0xbc, 0x00, 0x02, 0x90, 0x02, 0x02, 0x47, 0x00, 0x01,
+	0x8f, 0x01, 0x24, 0x65, 0x72, 0x50, 0x01, 0x02, 0x62, 0x00, 0x03, 0x31,
+	0x00, 0x02, 0x22, 0x00, 0x03, 0x0b, 0x01, 0x02, 0x51, 0x00, 0x02, 0x35,
+	0x02, 0x02, 0x57, 0x00, 0x03, 0xa4, 0x00, 0x01, 0x0a, 0x02, 0x00, 0x7b,
+	0x01, 0x02, 0x1c, 0x00, 0x01, 0x42, 0x00, 0x04, 0x43, 0x03, 0x01, 0xc1,
+	0x00, 0x02, 0xd2, 0x00, 0x01, 0x18, 0x00, 0x04, 0x67, 0x00, 0x02, 0xb5,
+	0x00, 0x05, 0x0e, 0x00, 0x02, 0x96, 0x06, 0x02, 0x40, 0x00, 0x03, 0x7c,
+	0x00, 0x03, 0x0e, 0x01, 0x03, 0x29, 0x00, 0x02, 0x71, 0x00, 0x03, 0x90,
+	0x00, 0x02, 0x55, 0x00, 0x00, 0x51, 0x01, 0x01, 0x0a, 0x00, 0x02, 0x87,
+	0x00, 0x02, 0x06, 0x00, 0x03, 0x14, 0x01, 0x01, 0xac, 0x00, 0x02, 0xe6,
+	0x00, 0x02, 0x41, 0x00, 0x03, 0x71, 0x04, 0x03, 0x41, 0x00, 0x02, 0x8b,
+	0x00, 0x01, 0xb3, 0x00, 0x00, 0xbd, 0x00, 0x03, 0x0c, 0x02, 0x04, 0xff,
+	0x01, 0x02, 0x32, 0x00, 0x02, 0x4c, 0x01, 0x02, 0x56, 0x00, 0x02, 0xc1,
+	0x00, 0x01, 0x55, 0x00, 0x02, 0x28, 0x04, 0x02, 0x7e, 0x00, 0x08, 0xb6,
+	0x01, 0x03, 0x79, 0x00, 0x09, 0x61, 0x00, 0x03, 0xca, 0x00, 0x02, 0x07,
+	0x00, 0x04, 0x68, 0x01, 0x03, 0xd8, 0x00, 0x02, 0x53, 0x00, 0x00, 0x83,
+	0x00, 0x02, 0xdb, 0x00, 0x01, 0xca, 0x00, 0x02, 0x0b, 0x00, 0x03, 0x80,
+	0x00, 0x09, 0x0e, 0x01, 0x01, 0x6b, 0x00, 0x01, 0x34, 0x00, 0x02, 0xca,
+	0x00, 0x03, 0xd6, 0x06, 0x00, 0x36, 0x00, 0x01, 0x59, 0x00, 0x04, 0x43,
+	0x01, 0x02, 0x6c, 0x00, 0x02, 0x9f, 0x00, 0x02, 0xb0, 0x00, 0x01, 0xec,
+	0x00, 0x02, 0x1e, 0x02, 0x02, 0x5f, 0x00, 0x01, 0x46, 0x00, 0x02, 0x22,
+	0x00, 0x02, 0x0b, 0x00, 0x03, 0x34, 0x00, 0x02, 0xeb, 0x00, 0x01, 0x2f,
+	0x00, 0x03, 0x51, 0x05, 0x03, 0x89, 0x00, 0x00, 0xa5, 0x00, 0x03, 0xb6,
+	0x00, 0x03, 0xdf, 0x00, 0x01, 0x8e, 0x00, 0x03, 0x37, 0x00, 0x02, 0x55,
+	0x00, 0x01, 0x12, 0x00, 0x02, 0x0b, 0x00, 0x02, 0x48, 0x00, 0x02, 0xbe,
+	0x00, 0x02, 0x61, 0x00, 0x00, 0xa6, 0x00, 0x04, 0xb7, 0x03, 0x08, 0xf7,
+	0x02, 0x01, 0xba, 0x00, 0x03, 0x98, 0x02, 0x03, 0x61, 0x00, 0x02, 0xb4,
+	0x00, 0x02, 0x37, 0x00, 0x03, 0x13, 0x00, 0x03, 0x74, 0x00, 0x03, 0x0e,
+	0x00, 0x02, 0xa0, 0x00, 0x03, 0x0d, 0x00, 0x00, 0x9a, 0x00, 0x03, 0x1f,
+	0x00, 0x02, 0x70, 0x00, 0x02, 0x5e, 0x00, 0x02, 0x88, 0x00, 0x00, 0x1d,
+	0x00, 0x01, 0x7a, 0x00, 0x01, 0x0f, 0x00, 0x10, 0x0a, 0x0f, 0x00, 0x03,
+	0x37, 0x00, 0x01, 0x16, 0x00, 0x02, 0x6a, 0x00, 0x00, 0xc5, 0x00, 0x03,
+	0xc5, 0x05, 0x02, 0x3c, 0x00, 0x00, 0x11, 0x00, 0x01, 0x98, 0x00, 0x02,
+	0x00, 0x02, 0x02, 0x26, 0x00, 0x02, 0x1b, 0x00, 0x00, 0x37, 0x00, 0x02,
+	0x54, 0x02, 0x00, 0x25, 0x00, 0x03, 0xec, 0x09, 0x09, 0x90, 0x00, 0x02,
+	0x85, 0x00, 0x02, 0x34, 0x00, 0x02, 0x06, 0x00, 0x02, 0x3a, 0x00, 0x03,
+	0xa4, 0x00, 0x09, 0x07, 0x00, 0x03, 0x69, 0x05, 0x02, 0x33, 0x00, 0x00,
+	0x5b, 0x00, 0x02, 0x8c, 0x02, 0x03, 0x4f, 0x03, 0x01, 0x11, 0x00, 0x01,
+	0x07, 0x01, 0x01, 0x8d, 0x00, 0x00, 0x23, 0x05, 0x02, 0x55, 0x0a, 0x01,
+	0x69, 0x01, 0x02, 0x5c, 0x00, 0x02, 0x69, 0x01, 0x01, 0xde, 0x00, 0x04,
+	0x49, 0x03, 0x01, 0x37, 0x00, 0x02, 0x12, 0x00, 0x01, 0x7a, 0x00, 0x02,
+	0x2d, 0x02, 0x01, 0xed, 0x01, 0x02, 0xe4, 0x05, 0x01, 0xd6, 0x00, 0x05,
+	0x06, 0x06, 0x03, 0x10, 0x01, 0x03, 0xe8, 0x01, 0x03, 0xc3, 0x02, 0x01,
+	0x76, 0x00, 0x02, 0xde, 0x07, 0x01, 0x4f, 0x00, 0x03, 0x25, 0x00, 0x02,
+	0x17, 0x00, 0x01, 0xfa, 0x00, 0x01, 0x05, 0x00, 0x02, 0x2e, 0x00, 0x02,
+	0x31, 0x07, 0x01, 0x2e, 0x00, 0x03, 0x6c, 0x00, 0x02, 0x96, 0x00, 0x02,
+	0x2e, 0x00, 0x01, 0xad, 0x00, 0x00, 0x79, 0x01, 0x01, 0x49, 0x00, 0x02,
+	0xeb, 0x00, 0x02, 0x31, 0x01, 0x01, 0x1a, 0x00, 0x01, 0x05, 0x00, 0x01,
+	0x4d, 0x00, 0x02, 0x35, 0x00, 0x01, 0xb3, 0x00, 0x03, 0x61, 0x03, 0x03,
+	0x94, 0x00, 0x03, 0x33, 0x01, 0x02, 0x35, 0x00, 0x01, 0x4a, 0x00, 0x00,
+	0xb1, 0x03, 0x03, 0x92, 0x04, 0x03, 0x1d, 0x00, 0x04, 0xa1, 0x00, 0x00,
+	0x11, 0x04, 0x02, 0x64, 0x00, 0x01, 0x6f, 0x00, 0x02, 0x83, 0x00, 0x02,
+	0xa7, 0x00, 0x03, 0xe3, 0x01, 0x02, 0x2a, 0x00, 0x00, 0x0b, 0x02, 0x04,
+	0xac, 0x07, 0x00, 0x9d, 0x07, 0x02, 0x7d, 0x00, 0x02, 0x3a, 0x00, 0x01,
+	0x8e, 0x00, 0x01, 0x05, 0x00, 0x02, 0x2c, 0x00, 0x01, 0x56, 0x00, 0x04,
+	0x83, 0x01, 0x01, 0xb0, 0x00, 0x03, 0x51, 0x00, 0x02, 0x2f, 0x00, 0x02,
+	0x06, 0x00, 0x03, 0xac, 0x00, 0x02, 0x48, 0x00, 0x02, 0x20, 0x00, 0x01,
+	0x71, 0x03, 0x03, 0x58, 0x04, 0x04, 0x74, 0x01, 0x00, 0x57, 0x00, 0x03,
+	0x08, 0x04, 0x03, 0xe5, 0x00, 0x02, 0x2c, 0x00, 0x03, 0xf9, 0x01, 0x02,
+	0x46, 0x00, 0x03, 0xa7, 0x01, 0x01, 0x6b, 0x00, 0x02, 0xe7, 0x01, 0x00,
+	0xf6, 0x00, 0x02, 0x5b, 0x00, 0x02, 0xd2, 0x00, 0x02, 0x16, 0x00, 0x03,
+	0x4d, 0x00, 0x01, 0x28, 0x00, 0x00, 0x0c, 0x00, 0x0a, 0x65, 0x00, 0x01,
+	0xeb, 0x05, 0x00, 0x17, 0x00, 0x00, 0x0b, 0x00, 0x06, 0xb8, 0x0c, 0x02,
+	0x63, 0x00, 0x03, 0x0d, 0x01, 0x02, 0x27, 0x02, 0x00, 0x25, 0x00, 0x03,
+	0x81, 0x00, 0x02, 0xcd, 0x00, 0x01, 0x52, 0x00, 0x03, 0x70, 0x00, 0x00,
+	0x52, 0x01, 0x02, 0x7b, 0x01, 0x07, 0x52, 0x01, 0x00, 0x32, 0x00, 0x03,
+	0x63, 0x04, 0x04, 0x19, 0x01, 0x02, 0x3a, 0x00, 0x02, 0xce, 0x00, 0x02,
+	0x22, 0x03, 0x02, 0x9b, 0x01, 0x03, 0xcd, 0x00, 0x03, 0x4b, 0x01, 0x03,
+	0x4a, 0x00, 0x01, 0xc1, 0x01, 0x01, 0x50, 0x00, 0x03, 0x18, 0x00, 0x02,
+	0x38, 0x00, 0x02, 0x6e, 0x00, 0x09, 0x4a, 0x00, 0x09, 0x45, 0x00, 0x01,
+	0x32, 0x00, 0x00, 0x05, 0x00, 0x04, 0xa7, 0x05, 0x01, 0x2e, 0x02, 0x03,
+	0x08, 0x05, 0x01, 0x14, 0x01, 0x04, 0x19, 0x00, 0x03, 0x50, 0x00, 0x08,
+	0xe0, 0x00, 0x01, 0x20, 0x0a, 0x03, 0xfe, 0x00, 0x01, 0x38, 0x00, 0x01,
+	0xb2, 0x02, 0x03, 0x8c, 0x00, 0x02, 0x67, 0x00, 0x04, 0x61, 0x03, 0x02,
+	0x1f, 0x00, 0x00, 0x69, 0x00, 0x04, 0xb3, 0x04, 0x02, 0x0d, 0x01, 0x00,
+	0x87, 0x01, 0x00, 0xfb, 0x00, 0x03, 0x35, 0x0a, 0x01, 0x8c, 0x01, 0x00,
+	0x4a, 0x02, 0x03, 0x08, 0x04, 0x01, 0x82, 0x00, 0x04, 0x44, 0x00, 0x02,
+	0x7b, 0x00, 0x03, 0x58, 0x00, 0x01, 0x51, 0x01, 0x01, 0x2f, 0x00, 0x01,
+	0xa4, 0x01, 0x04, 0x24, 0x00, 0x02, 0xea, 0x00, 0x02, 0x18, 0x00, 0x02,
+	0x74, 0x00, 0x02, 0x36, 0x00, 0x02, 0x06, 0x00, 0x02, 0x18, 0x00, 0x00,
+	0x70, 0x00, 0x28, 0x65, 0x72, 0x52, 0x01, 0x03, 0xe9, 0x03, 0x08, 0xf7,
+	0x00, 0x02, 0xbe, 0x01, 0x02, 0x25, 0x00, 0x02, 0x55, 0x00, 0x01, 0x8c,
+	0x00, 0x01, 0x9c, 0x01, 0x03, 0x2f, 0x00, 0x03, 0x07, 0x00, 0x03, 0xa2,
+	0x03, 0x01, 0x1f, 0x00, 0x03, 0xb7, 0x00, 0x07, 0x9d, 0x00, 0x03, 0x37,
+	0x01, 0x02, 0x43, 0x00, 0x02, 0xbc, 0x00, 0x02, 0x44, 0x00, 0x00, 0x86,
+	0x00, 0x02, 0x0a, 0x00, 0x02, 0x16, 0x00, 0x01, 0x5d, 0x02, 0x02, 0xcd,
+	0x01, 0x00, 0x1b, 0x00, 0x0b, 0x9c, 0x04, 0x02, 0xcc, 0x00, 0x0a, 0x19,
+	0x00, 0x02, 0x54, 0x00, 0x01, 0x6c, 0x00, 0x02, 0x1f, 0x00, 0x02, 0x83,
+	0x00, 0x02, 0x25, 0x00, 0x01, 0x2b, 0x03, 0x03, 0x8f, 0x00, 0x02, 0x56,
+	0x00, 0x03, 0x67, 0x00, 0x01, 0x0a, 0x01, 0x04, 0x49, 0x08, 0x00, 0x7f,
+	0x01, 0x02, 0x36, 0x00, 0x08, 0x1e, 0x00, 0x02, 0xc7, 0x01, 0x03, 0x48,
+	0x02, 0x02, 0x1f, 0x00, 0x01, 0xba, 0x01, 0x06, 0x71, 0x00, 0x04, 0x40,
+	0x00, 0x03, 0x1d, 0x00, 0x01, 0x7d, 0x02, 0x01, 0x84, 0x00, 0x02, 0xc8,
+	0x01, 0x01, 0xd8, 0x00, 0x06, 0x89, 0x08, 0x00, 0x92, 0x00, 0x03, 0x2d,
+	0x01, 0xb0, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6b, 0x65, 0x72, 0x6e, 0x65,
+	0x6c, 0x00, 0x00, 0x00, 0x00,
+};
+
+static int bench_lz4(struct bench_state *bs)
+{
+	size_t len = bs->size;
+
+	if (ulz4fn(bs->src, bs->src_size, bs->dst, &len))
+		return -EIO;
+
+	return len == bs->size ? 0 : -EIO;
+}
+
+static int bench_lz4_setup(struct bench_state *bs)
+{
+	return bench_decomp_setup(bs, bench_lz4_data, sizeof(bench_lz4_data),
+				  bench_lz4);
+}
+BENCH(bench_lz4, 0, bench_lz4_setup, bench_decomp_teardown);
+#endif
+
+#if CONFIG_IS_ENABLED(ZSTD)
+static const u8 bench_zstd_data[] = {
+	0x28, 0xb5, 0x2f, 0xfd, 0x60, 0x00, 0x0f, 0x3d, 0x1a, 0x00, 0xa2, 0x06,
+	0x12, 0x11, 0xb0, 0x6b, 0x0c, 0x20, 0x09, 0xbc, 0xed, 0x36, 0x6e, 0x8a,
+	0xf6, 0x61, 0x18, 0xc5, 0xa0, 0x85, 0x0e, 0xbf, 0xfb, 0xff, 0xff, 0x8d,
+	0xfb, 0xdf, 0xbc, 0xf8, 0xb8, 0x4c, 0xa9, 0x12, 0xe7, 0xe9, 0x30, 0x0d,
+	0x24, 0x92, 0x03, 0xe8, 0xe6, 0x22, 0xe9, 0x5a, 0x45, 0x21, 0x91, 0x60,
+	0x49, 0xa4, 0x1a, 0x01, 0x44, 0xae, 0xbe, 0xb3, 0x63, 0x75, 0x00, 0x96,
+	0xd4, 0x9d, 0x85, 0xe9, 0x18, 0x0b, 0xb9, 0xaa, 0x8e, 0x4b, 0x2d, 0x40,
+	0x9d, 0x81, 0xac, 0xa8, 0x61, 0x97, 0x92, 0xa4, 0x34, 0xec, 0x06, 0x21,
+	0x08, 0x01, 0x04, 0x71, 0x38, 0x49, 0xad, 0x1e, 0x11, 0x20, 0x0c, 0x54,
+	0x11, 0xa2, 0x1c, 0x6a, 0x61, 0x25, 0x1d, 0xa0, 0xab, 0x37, 0x0d, 0x06,
+	0xa4, 0x06, 0xc0, 0x26, 0x58, 0xf4, 0x20, 0xd2, 0x51, 0xd5, 0x0a, 0x86,
+	0xb7, 0x81, 0x66, 0x9c, 0x11, 0x45, 0xe4, 0x47, 0x8a, 0xaa, 0xf8, 0x31,
+	0x43, 0x6c, 0xde, 0xb9, 0x1a, 0x13, 0x3f, 0xe1, 0xe7, 0x57, 0x07, 0x0d,
+	0x8b, 0x06, 0x69, 0x8c, 0xdb, 0x05, 0x49, 0x3a, 0x5d, 0x04, 0xcc, 0x77,
+	0x6a, 0x32, 0x52, 0x0c, 0xc0, 0xbb, 0xf5, 0x0b, 0x60, 0x59, 0x45, 0xdd,
+	0xd8, 0x38, 0xfc, 0x2e, 0x49, 0xb3, 0x7e, 0x64, 0x6b, 0x53, 0xac, 0x48,
+	0xdd, 0x09, 0xe5, 0xa2, 0x9a, 0x4c, 0x55, 0xc8, 0x57, 0x04, 0x32, 0x52,
+	0xbf, 0xf8, 0xa0, 0x93, 0x0d, 0xd5, 0x60, 0xea, 0x4a, 0x29, 0x4b, 0xc4,
+	0xb4, 0xd0, 0x68, 0x82, 0x71, 0x9b, 0xc3, 0x88, 0x6b, 0xd4, 0xbf, 0x60,
+	0xdb, 0xc7, 0x71, 0xdf, 0xf5, 0x57, 0xbe, 0x04, 0x51, 0x7a, 0xe6, 0x80,
+	0x43, 0x86, 0x63, 0xe7, 0x27, 0xf9, 0xef, 0xdd, 0xc1, 0xc3, 0x1b, 0xcb,
+	0x07, 0xac, 0x6c, 0xb1, 0x4a, 0xa2, 0x33, 0x3f, 0x0b, 0x2f, 0x53, 0xc4,
+	0x8a, 0xab, 0x27, 0xd5, 0x22, 0x91, 0x90, 0x83, 0xdc, 0x9c, 0x0b, 0xe4,
+	0xa3, 0x7c, 0x5a, 0x2d, 0x84, 0xb8, 0xf2, 0xcb, 0xc0, 0x9f, 0x20, 0x46,
+	0xd9, 0x7a, 0x5c, 0xa1, 0x55, 0x42, 0x07, 0xc0, 0x1e, 0x39, 0xb8, 0x5a,
+	0x49, 0x74, 0x98, 0x25, 0xf5, 0x66, 0x2f, 0xad, 0xe4, 0x64, 0xd0, 0x2e,
+	0x10, 0x66, 0x2c, 0x2c, 0x6d, 0xb5, 0x45, 0x60, 0x69, 0x31, 0x11, 0x96,
+	0xf9, 0x1b, 0x4f, 0xe4, 0x34, 0xeb, 0xd2, 0x39, 0x2f, 0x0e, 0x5c, 0x66,
+	0x2d, 0x4e, 0xa1, 0x9c, 0x25, 0x26, 0x25, 0xb5, 0x43, 0xd6, 0x96, 0x30,
+	0x9b, 0x93, 0x8f, 0x7c, 0xb1, 0x61, 0x6c, 0x06, 0x92, 0x18, 0xbf, 0x45,
+	0xdb, 0x8a, 0x64, 0xda, 0x78, 0x72, 0xa7, 0xff, 0x0c, 0xe6, 0x54, 0xe6,
+	0x99, 0xd5, 0xbd, 0x62, 0xc4, 0x3f, 0xba, 0xa7, 0xac, 0x2a, 0x12, 0x9e,
+	0x8b, 0xde, 0x42, 0x60, 0x47, 0x59, 0x59, 0x2e, 0x60, 0x16, 0xf0, 0x48,
+	0x13, 0xd8, 0xed, 0x5f, 0xcc, 0xdd, 0x3e, 0x57, 0xd2, 0xa4, 0xf5, 0x03,
+	0x3f, 0x19, 0x2f, 0x2b, 0x3a, 0x62, 0xec, 0x54, 0xaa, 0x96, 0xf5, 0x22,
+	0xeb, 0xc0, 0x18, 0xf3, 0x8f, 0xbc, 0x79, 0x29, 0x9c, 0x95, 0xa8, 0xbe,
+	0xad, 0xde, 0x0d, 0x54, 0x90, 0x8a, 0xb2, 0xa9, 0xe1, 0xec, 0x15, 0xab,
+	0x75, 0xd1, 0x0d, 0x23, 0xa2, 0x81, 0xe5, 0xa2, 0xa0, 0x39, 0x2c, 0xd8,
+	0xea, 0x95, 0x25, 0xa9, 0x03, 0xc5, 0xe7, 0x5e, 0x4c, 0xd1, 0x98, 0x7d,
+	0x8c, 0x5a, 0x01, 0x99, 0x59, 0x9c, 0x88, 0x09, 0x31, 0x22, 0x32, 0x8d,
+	0x5e, 0xa0, 0xa4, 0x13, 0x14, 0x49, 0x98, 0x56, 0x69, 0xc7, 0x63, 0x0b,
+	0x34, 0x69, 0x1b, 0x9f, 0x71, 0x25, 0x42, 0xa5, 0x24, 0x8c, 0xf2, 0xdd,
+	0x88, 0xdf, 0x53, 0x01, 0xa9, 0x34, 0xc5, 0x1d, 0xa6, 0xa2, 0x06, 0x50,
+	0xb2, 0xe1, 0xa4, 0xc3, 0x4f, 0xf1, 0xa5, 0x09, 0x35, 0xdd, 0x06, 0x76,
+	0x60, 0x61, 0x01, 0x76, 0x48, 0x67, 0x76, 0xed, 0x52, 0x81, 0x7d, 0x02,
+	0x59, 0xd2, 0x02, 0xa4, 0xd2, 0x00, 0xff, 0xba, 0x64, 0x2c, 0xcb, 0x5e,
+	0x1e, 0x33, 0x19, 0x98, 0xaf, 0x74, 0x86, 0x4e, 0xbc, 0xc2, 0xed, 0x30,
+	0xaf, 0xda, 0xcd, 0xb0, 0xea, 0x3f, 0x39, 0x2d, 0xdb, 0x24, 0x95, 0x42,
+	0x19, 0xc0, 0xd5, 0x0f, 0xab, 0x8f, 0x83, 0x86, 0x4a, 0xc4, 0xdb, 0x57,
+	0x7e, 0x5c, 0xfa, 0x9c, 0x15, 0x80, 0x98, 0x83, 0xcd, 0xb6, 0x6a, 0x0c,
+	0x06, 0x8b, 0x10, 0xf9, 0xc1, 0x60, 0xae, 0x68, 0x1a, 0xee, 0x16, 0xd8,
+	0x1c, 0x7f, 0x52, 0x26, 0x58, 0xad, 0x63, 0x06, 0x8c, 0x47, 0x8b, 0xbb,
+	0x5f, 0x85, 0x02, 0x87, 0xe1, 0xa8, 0x6f, 0x32, 0xfa, 0x16, 0x2c, 0xbc,
+	0x05, 0xe6, 0x3d, 0xd8, 0x1e, 0xfb, 0xbd, 0x4b, 0xee, 0xc4, 0x2c, 0x90,
+	0x9f, 0x01, 0x1e, 0xd0, 0x72, 0x8b, 0xe1, 0x32, 0xd7, 0xc2, 0xa7, 0xf2,
+	0x73, 0x3c, 0xa6, 0xda, 0x3d, 0x91, 0x61, 0x1c, 0xcf, 0x7f, 0x0e, 0x44,
+	0x00, 0x12, 0xdf, 0x15, 0x83, 0x1d, 0xc4, 0x89, 0x63, 0x12, 0x6c, 0xeb,
+	0x3c, 0xbc, 0x16, 0xb3, 0xf8, 0xb3, 0x04, 0x6a, 0x40, 0x0b, 0x4f, 0x5a,
+	0x70, 0xae, 0x9f, 0xf9, 0x38, 0xa4, 0x86, 0x1e, 0x38, 0xe9, 0x46, 0x40,
+	0x92, 0x1e, 0x54, 0x16, 0xe5, 0x5f, 0x6c, 0x4b, 0x74, 0x13, 0x9c, 0xfa,
+	0xca, 0x30, 0xa4, 0x11, 0x3b, 0xa4, 0x05, 0xa4, 0xc0, 0x23, 0x04, 0x4d,
+	0x12, 0x8d, 0x6d, 0x2a, 0xe0, 0x7f, 0x3c, 0x12, 0x78, 0xa7, 0x53, 0x4d,
+	0xe8, 0x8c, 0xc9, 0x76, 0xc5, 0xe3, 0xf3, 0x91, 0x59, 0x6c, 0xb5, 0x82,
+	0x11, 0x57, 0x42, 0xe0, 0x9e, 0xfa, 0xbb, 0x89, 0xe1, 0xaf, 0x50, 0xc3,
+	0x8a, 0x7c, 0x38, 0xf8, 0x5f, 0x71, 0x5b, 0x11, 0x1c, 0x56, 0x12, 0x8e,
+	0x74, 0xcc, 0x59, 0x68, 0x9d, 0x5f, 0xac, 0x82, 0x7a, 0x11, 0x50, 0x46,
+	0x69, 0xdd, 0x74, 0x24, 0x87, 0xca, 0xa3, 0x02, 0x41, 0x6a, 0x21, 0x05,
+	0x12, 0x74, 0x22, 0x2a, 0xdf, 0x3f, 0x6e, 0xdf, 0x93, 0xe2, 0x12, 0x98,
+	0xcf, 0x9a, 0xa5, 0xd5, 0x17, 0x0a, 0x3d, 0x64, 0x90, 0x2c, 0xa6, 0x13,
+	0xae, 0x83, 0x61, 0x5d, 0x88, 0xa0, 0xf2, 0x79, 0x33, 0x9e, 0xf3, 0x17,
+	0x55, 0x8f, 0x52, 0x70, 0x9d, 0x8a, 0xc4, 0x56, 0x01,
+};
+
+static int bench_zstd(struct bench_state *bs)
+{
+	struct abuf in, out;
+	int ret;
+
+	abuf_init_set(&in, (void *)bs->src, bs->src_size);
+	abuf_init_set(&out, bs->dst, bs->size);
+	ret = zstd_decompress(&in, &out);
+	if (ret < 0)
+		return ret;
+
+	return ret == bs->size ? 0 : -EIO;
+}
+
+static int bench_zstd_setup(struct bench_state *bs)
+{
+	return bench_decomp_setup(bs, bench_zstd_data, sizeof(bench_zstd_data),
+				  bench_zstd);
+}
+BENCH(bench_zstd, 0, bench_zstd_setup, bench_decomp_teardown);
+#endif
+
+#if CONFIG_IS_ENABLED(LZMA)
+static const u8 bench_lzma_data[] = {
+	0x5d, 0x00, 0x00, 0x01, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x00, 0x34, 0x9b, 0x48, 0x47, 0x57, 0x09, 0x1f, 0x79, 0xc0, 0xda,
+	0xd3, 0xb2, 0x9b, 0x7a, 0xdc, 0x9d, 0xb4, 0xfe, 0x4e, 0xd1, 0x93, 0xc7,
+	0x4f, 0xdf, 0x5f, 0xfc, 0x49, 0xa3, 0x3a, 0xb7, 0xbc, 0x34, 0x70, 0xf0,
+	0x83, 0x63, 0xfe, 0xfd, 0x7a, 0x03, 0x24, 0xc2, 0xcb, 0xea, 0x2e, 0xd1,
+	0x58, 0x43, 0x13, 0x64, 0x01, 0xab, 0xfa, 0xc0, 0xe9, 0x83, 0x38, 0x2f,
+	0x2a, 0xa0, 0x6b, 0x1e, 0x84, 0xa0, 0x1f, 0x0d, 0x82, 0xd0, 0xd8, 0x16,
+	0x5d, 0x26, 0xb7, 0x96, 0xad, 0x88, 0x89, 0xae, 0xa9, 0xd3, 0x0d, 0x06,
+	0x12, 0xf3, 0x1a, 0xd2, 0xd4, 0xcb, 0xd2, 0x68, 0x2f, 0xf1, 0x6a, 0x48,
+	0x8e, 0x83, 0x5d, 0x14, 0xc6, 0xe2, 0xfb, 0x02, 0xfe, 0x70, 0x65, 0x82,
+	0xe6, 0x03, 0x8d, 0x62, 0x7b, 0x2e, 0x45, 0x73, 0x99, 0x09, 0xef, 0x2c,
+	0xfc, 0x7c, 0x4b, 0xf7, 0x32, 0xaa, 0x09, 0xa8, 0xb5, 0xce, 0xa8, 0x64,
+	0xa7, 0x66, 0xf4, 0x09, 0x46, 0x70, 0x0c, 0x9d, 0xbe, 0x2a, 0xdf, 0xf3,
+	0x31, 0x77, 0xef, 0xbf, 0x4d, 0xcf, 0x03, 0x1d, 0x70, 0x8a, 0xda, 0x1b,
+	0xf2, 0x74, 0x14, 0xe3, 0xef, 0x45, 0x8a, 0x46, 0xef, 0xba, 0xa3, 0xb3,
+	0xfe, 0xd1, 0x2f, 0x64, 0x82, 0x25, 0xe6, 0xc1, 0x98, 0x83, 0x18, 0x4c,
+	0x6c, 0xa4, 0xe2, 0xa9, 0x11, 0x6a, 0x67, 0xb8, 0x19, 0x7a, 0x75, 0x35,
+	0xe8, 0xa1, 0xb0, 0x34, 0xb0, 0x4c, 0xf5, 0xeb, 0x4d, 0x0b, 0xc7, 0xf0,
+	0xeb, 0xeb, 0x55, 0x32, 0x0c, 0x60, 0x6e, 0xb7, 0x84, 0xa1, 0xc0, 0xcd,
+	0x8e, 0x13, 0x94, 0x84, 0xdc, 0xde, 0xa3, 0xeb, 0x10, 0x2b, 0x07, 0xd7,
+	0xa0, 0x6b, 0x89, 0xc4, 0x1f, 0x6c, 0x54, 0x8a, 0x83, 0xf2, 0x48, 0xf8,
+	0x26, 0xc7, 0x30, 0x95, 0xe6, 0xae, 0x68, 0xfe, 0x60, 0xbe, 0x51, 0x4c,
+	0xfa, 0x0d, 0x34, 0x99, 0x97, 0xb1, 0xfe, 0xfa, 0x6e, 0x3b, 0xeb, 0x35,
+	0x45, 0x4c, 0x70, 0xfe, 0x66, 0xe4, 0xe0, 0xac, 0x83, 0x5e, 0x4c, 0xef,
+	0x67, 0x97, 0x23, 0xc4, 0x45, 0x71, 0x7f, 0xd3, 0x61, 0xa5, 0xde, 0xe8,
+	0xc0, 0x77, 0x40, 0x7f, 0xbb, 0xdc, 0xf7, 0xbd, 0x39, 0x29, 0x9c, 0xd8,
+	0xa0, 0x0a, 0xce, 0xd9, 0xb0, 0xfd, 0x20, 0x5e, 0x35, 0x75, 0x88, 0x3d,
+	0x12, 0xfd, 0x05, 0x26, 0x27, 0x3e, 0xec, 0x1c, 0x02, 0x74, 0x16, 0x5b,
+	0x0d, 0x97, 0x2d, 0xc6, 0xad, 0x70, 0xc4, 0x46, 0x81, 0xf9, 0x1c, 0x3d,
+	0x78, 0x2c, 0x33, 0x42, 0xa3, 0x96, 0x79, 0xdb, 0xdc, 0x94, 0x6e, 0x71,
+	0x47, 0x1f, 0x77, 0xc0, 0xd2, 0x25, 0xfe, 0x20, 0xad, 0x68, 0x70, 0x80,
+	0xe6, 0x94, 0x11, 0x93, 0x1e, 0x4b, 0x39, 0x01, 0x8f, 0x2c, 0xc9, 0x32,
+	0xed, 0x9c, 0x2d, 0x02, 0x7d, 0x6f, 0x7e, 0x1e, 0xf1, 0xf3, 0xde, 0x8d,
+	0xb4, 0x43, 0xdf, 0x4c, 0x20, 0x2f, 0x51, 0xea, 0x8b, 0x7d, 0x80, 0x23,
+	0xb5, 0xef, 0x39, 0xc1, 0x60, 0x3b, 0xb4, 0x8f, 0xa7, 0x77, 0x83, 0x6b,
+	0xd6, 0x32, 0x86, 0xc9, 0x98, 0x8e, 0x84, 0x22, 0x64, 0x97, 0x82, 0x24,
+	0xdd, 0x58, 0xa0, 0x63, 0x14, 0x1e, 0x17, 0xc2, 0x8e, 0xcb, 0x1c, 0xcf,
+	0x0e, 0xc4, 0x02, 0xf0, 0x23, 0x66, 0xa1, 0x64, 0x78, 0x8b, 0xd0, 0x80,
+	0xdf, 0x69, 0x9d, 0x9c, 0xd5, 0xae, 0x74, 0x41, 0xf9, 0x70, 0x6a, 0x6a,
+	0xbb, 0xc7, 0x47, 0xc9, 0xc2, 0x14, 0x69, 0x14, 0x20, 0x89, 0xd1, 0x6c,
+	0xd4, 0xf9, 0x97, 0x6b, 0x2c, 0xf8, 0x17, 0xd6, 0x67, 0x2f, 0x68, 0xf2,
+	0xa0, 0x3d, 0x36, 0x23, 0x45, 0x4d, 0xd1, 0x13, 0xf6, 0xc8, 0x7f, 0x44,
+	0x95, 0xe9, 0x98, 0x35, 0x20, 0x5d, 0xf0, 0xdb, 0xe2, 0x4f, 0x1a, 0xd2,
+	0x16, 0x61, 0x86, 0xaf, 0x05, 0x11, 0x9f, 0x96, 0xad, 0xe8, 0x91, 0xfc,
+	0x99, 0x26, 0x34, 0x4e, 0xb7, 0x3f, 0xaa, 0x6d, 0xd7, 0xef, 0xaf, 0x51,
+	0x64, 0xe2, 0x82, 0x18, 0x27, 0x2d, 0x01, 0x21, 0xec, 0xc1, 0x91, 0x82,
+	0x02, 0xc1, 0x08, 0x15, 0xb0, 0x9e, 0x6a, 0x12, 0x3e, 0x45, 0xdf, 0xe2,
+	0x10, 0x25, 0x73, 0xf2, 0xe9, 0xa1, 0x92, 0x58, 0xb4, 0xb2, 0x56, 0xd4,
+	0x0e, 0x98, 0xbd, 0x77, 0x71, 0xfd, 0x22, 0x96, 0x05, 0x44, 0x85, 0xfb,
+	0xe9, 0xf1, 0x23, 0x80, 0x77, 0xf2, 0x0e, 0x95, 0x19, 0xb5, 0x7f, 0xb7,
+	0x21, 0x10, 0xa0, 0x2e, 0x28, 0x82, 0xdd, 0x7d, 0x11, 0xee, 0x40, 0x8a,
+	0x55, 0x96, 0xbc, 0xdd, 0x61, 0x18, 0x6b, 0x06, 0x01, 0xa0, 0x83, 0x3c,
+	0x1d, 0xb5, 0x5f, 0xf8, 0x17, 0x55, 0x70, 0xa3, 0xd6, 0x80, 0x4f, 0x21,
+	0xf0, 0xf4, 0x8c, 0xa8, 0x02, 0x2a, 0xad, 0xe1, 0xc6, 0x43, 0x6d, 0xad,
+	0xfe, 0xd4, 0xdc, 0x70, 0xed, 0xde, 0x27, 0x8f, 0xca, 0x58, 0x85, 0x83,
+	0x51, 0x84, 0x56, 0x54, 0x5d, 0x10, 0xfb, 0xc7, 0xf4, 0xf2, 0x9c, 0x94,
+	0xc4, 0xa3, 0x42, 0xb4, 0x45, 0x95, 0x34, 0xdf, 0x59, 0x92, 0xb4, 0x22,
+	0x28, 0x73, 0x1e, 0xe6, 0xeb, 0x24, 0x87, 0x55, 0x2e, 0x4d, 0xe5, 0x3a,
+	0x78, 0x5a, 0x2b, 0xd9, 0xee, 0xe5, 0x13, 0x88, 0x46, 0x80, 0x23, 0xd8,
+	0x22, 0x23, 0xab, 0xe4, 0xb8, 0xa7, 0x78, 0x01, 0xf3, 0x75, 0x76, 0x20,
+	0x59, 0xa7, 0xea, 0x4a, 0xe2, 0x6c, 0x54, 0xa4, 0x60, 0x2c, 0x04, 0x9f,
+	0xae, 0x4f, 0x87, 0x1f, 0x98, 0x00, 0x8f, 0x4d, 0x23, 0x43, 0xc0, 0x56,
+	0x06, 0x5e, 0x00, 0x69, 0x98, 0x55, 0x2d, 0x33, 0xbe, 0x2f, 0x21, 0xb2,
+	0xb5, 0x2b, 0x1a, 0x3f, 0x97, 0xfd, 0x29, 0x77, 0xf0, 0xec, 0x45, 0x8c,
+	0x71, 0x87, 0x83, 0xd5, 0x6c, 0x60, 0xda, 0x1c, 0x8e, 0xf6, 0x3a, 0xa6,
+	0x54, 0xc8, 0x4e, 0x7f, 0x8e, 0x02, 0x75, 0xcd, 0x89, 0x79, 0x63, 0xf9,
+	0xee, 0x8d, 0x42, 0x76, 0xc4, 0xe3, 0x7b, 0x74, 0x10, 0xbd, 0xc1, 0x58,
+	0x55, 0xdd, 0x7a, 0xdb, 0xaf, 0x11, 0x30, 0xf2, 0x8e, 0xad, 0x3b, 0xdd,
+	0x2e, 0x31, 0xe5, 0x70, 0x88, 0x0b, 0xa0, 0x5e, 0x69, 0x00, 0x2d, 0xe7,
+	0xf0, 0x30, 0x27, 0x55, 0xf8, 0x94, 0x9f, 0x5d, 0x8b, 0x73, 0x17, 0xc3,
+	0xcd, 0x8b, 0x18, 0x66, 0xb3, 0x08, 0x56, 0x4e, 0x08, 0x44, 0x3d, 0x46,
+	0xfd, 0x9f, 0x05, 0x15, 0x3f, 0x62, 0xef, 0x42, 0x72, 0xf1, 0xd7, 0x5e,
+	0xb2, 0xf3, 0x24, 0xf4, 0x7e, 0xa6, 0x8d, 0x50, 0xa7, 0x5f, 0x20, 0x97,
+	0x0c, 0xd8, 0x1b, 0x78, 0x85, 0xa7, 0xf9, 0x95, 0xe0, 0x95, 0x4c, 0xe9,
+	0xe1, 0x39, 0x02, 0x71, 0x90, 0xbd, 0x6a, 0xd7, 0xcb, 0x2a, 0x0e, 0x00,
+	0x6b, 0x7c, 0x01, 0xd8, 0xff, 0x3b, 0xe0, 0xf6, 0x00,
+};
+
+static int bench_lzma(struct bench_state *bs)
+{
+	SizeT len = bs->size;
+
+	if (lzmaBuffToBuffDecompress(bs->dst, &len, (uchar *)bs->src,
+				     bs->src_size))
+		return -EIO;
+
+	return len == bs->size ? 0 : -EIO;
+}
+
+static int bench_lzma_setup(struct bench_state *bs)
+{
+	return bench_decomp_setup(bs, bench_lzma_data, sizeof(bench_lzma_data),
+				  bench_lzma);
+}
+BENCH(bench_lzma, 0, bench_lzma_setup, bench_decomp_teardown);
+#endif
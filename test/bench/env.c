@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Environment benchmarks
+ *
+ * These use a temporary variable which is deleted afterwards. The time for
+ * env_get() depends on the number of variables in the environment.
+ */
+
+#include <common.h>
+#include <bench.h>
+#include <env.h>
+
+#define BENCH_ENV_VAR	"bench_var"
+
+static int bench_env_setup(struct bench_state *bs)
+{
+	return env_set(BENCH_ENV_VAR, "0");
+}
+
+static void bench_env_teardown(struct bench_state *bs)
+{
+	env_set(BENCH_ENV_VAR, NULL);
+}
+
+static int bench_env_get(struct bench_state *bs)
+{
+	if (!env_get(BENCH_ENV_VAR))
+		return -ENOENT;
+
+	return 0;
+}
+BENCH(bench_env_get, BENCHF_NO_COLD, bench_env_setup, bench_env_teardown);
+
+/* Alternate between two values so that each call changes the variable */
+static int bench_env_set(struct bench_state *bs)
+{
+	bs->result = !bs->result;
+
+	return env_set(BENCH_ENV_VAR, bs->result ? "1" : "0");
+}
+BENCH(bench_env_set, BENCHF_NO_COLD, bench_env_setup, bench_env_teardown);
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Devicetree benchmarks, using U-Boot's control devicetree
+ *
+ * These look up the last property of the last node in the tree, which is the
+ * slowest case for a flat devicetree since libfdt scans from the start.
+ */
+
+#include <common.h>
+#include <bench.h>
+#include <malloc.h>
+#include <asm/global_data.h>
+#include <linux/libfdt.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/**
+ * struct bench_fdt - information about the property to look up
+ *
+ * @path: Path to the node
+ * @node: Offset of the node
+ * @prop: Name of the property
+ */
+struct bench_fdt {
+	char path[256];
+	int node;
+	const char *prop;
+};
+
+static int bench_fdt_setup(struct bench_state *bs)
+{
+	const void *blob = gd->fdt_blob;
+	struct bench_fdt *priv;
+	int node, prop;
+
+	if (!blob)
+		return -ENOSYS;
+	priv = calloc(1, sizeof(*priv));
+	if (!priv)
+		return -ENOMEM;
+
+	/* Find the last property of the last node that has properties */
+	priv->node = -1;
+	for (node = 0; node >= 0; node = fdt_next_node(blob, node, NULL)) {
+		fdt_for_each_property_offset(prop, blob, node) {
+			priv->node = node;
+			fdt_getprop_by_offset(blob, prop, &priv->prop, NULL);
+		}
+	}
+	if (priv->node < 0 || !priv->prop ||
+	    fdt_get_path(blob, priv->node, priv->path, sizeof(priv->path))) {
+		free(priv);
+		return -ENOENT;
+	}
+	bs->src = blob;
+	bs->src_size = fdt_totalsize(blob);
+	bs->priv = priv;
+
+	return 0;
+}
+
+static void bench_fdt_teardown(struct bench_state *bs)
+{
+	free(bs->priv);
+}
+
+/* Look up a property in a node whose offset is known */
+static int bench_fdt_getprop(struct bench_state *bs)
+{
+	struct bench_fdt *priv = bs->priv;
+
+	if (!fdt_getprop(bs->src, priv->node, priv->prop, NULL))
+		return -ENOENT;
+
+	return 0;
+}
+BENCH(bench_fdt_getprop, 0, bench_fdt_setup, bench_fdt_teardown);
+
+/* Look up a node by path, then one of its properties */
+static int bench_fdt_path_getprop(struct bench_state *bs)
+{
+	struct bench_fdt *priv = bs->priv;
+	int node;
+
+	node = fdt_path_offset(bs->src, priv->path);
+	if (node < 0)
+		return node;
+	if (!fdt_getprop(bs->src, node, priv->prop, NULL))
+		return -ENOENT;
+
+	return 0;
+}
+BENCH(bench_fdt_path_getprop, 0, bench_fdt_setup, bench_fdt_teardown);
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Checksum and hash benchmarks
+ *
+ * The hashes use the same implementation as the 'hash' command and FIT
+ * verification, including any hardware acceleration.
+ */
+
+#include <common.h>
+#include <bench.h>
+#include <hash.h>
+#include <u-boot/crc.h>
+
+static int bench_crc32(struct bench_state *bs)
+{
+	bs->result = crc32(0, bs->src, bs->size);
+
+	return 0;
+}
+BENCH(bench_crc32, BENCHF_BUF, NULL, NULL);
+
+#if CONFIG_IS_ENABLED(HASH)
+
+/**
+ * bench_hash_setup() - look up the algorithm for a hash benchmark
+ *
+ * @bs: Benchmark state
+ * @name: Name of algorithm
+ * Return: 0 if OK, -ENOSYS if the algorithm is not enabled
+ */
+static int bench_hash_setup(struct bench_state *bs, const char *name)
+{
+	struct hash_algo *algo;
+
+	if (hash_lookup_algo(name, &algo))
+		return -ENOSYS;
+	bs->priv = algo;
+
+	return 0;
+}
+
+static int bench_hash(struct bench_state *bs)
+{
+	struct hash_algo *algo = bs->priv;
+	u8 output[HASH_MAX_DIGEST_SIZE];
+
+	algo->hash_func_ws(bs->src, bs->size, output, algo->chunk_size);
+	bs->result = output[0];
+
+	return 0;
+}
+
+static int bench_md5_setup(struct bench_state *bs)
+{
+	return bench_hash_setup(bs, "md5");
+}
+
+static int bench_md5(struct bench_state *bs)
+{
+	return bench_hash(bs);
+}
+BENCH(bench_md5, BENCHF_BUF, bench_md5_setup, NULL);
+
+static int bench_sha1_setup(struct bench_state *bs)
+{
+	return bench_hash_setup(bs, "sha1");
+}
+
+static int bench_sha1(struct bench_state *bs)
+{
+	return bench_hash(bs);
+}
+BENCH(bench_sha1, BENCHF_BUF, bench_sha1_setup, NULL);
+
+static int bench_sha256_setup(struct bench_state *bs)
+{
+	return bench_hash_setup(bs, "sha256");
+}
+
+static int bench_sha256(struct bench_state *bs)
+{
+	return bench_hash(bs);
+}
+BENCH(bench_sha256, BENCHF_BUF, bench_sha256_setup, NULL);
+
+static int bench_sha512_setup(struct bench_state *bs)
+{
+	return bench_hash_setup(bs, "sha512");
+}
+
+static int bench_sha512(struct bench_state *bs)
+{
+	return bench_hash(bs);
+}
+BENCH(bench_sha512, BENCHF_BUF, bench_sha512_setup, NULL);
+#endif
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Memory benchmarks: string functions and malloc()
+ */
+
+#include <common.h>
+#include <bench.h>
+#include <malloc.h>
+#include <linux/sizes.h>
+#if CONFIG_IS_ENABLED(ARMV8_DRAM_SCRUB)
+#include <asm/armv8/dram_scrub.h>
+#endif
+
+static int bench_memcpy(struct bench_state *bs)
+{
+	memcpy(bs->dst, bs->src, bs->size);
+
+	return 0;
+}
+BENCH(bench_memcpy, BENCHF_BUF, NULL, NULL);
+
+static int bench_memset(struct bench_state *bs)
+{
+	memset(bs->dst, 0x5a, bs->size);
+
+	return 0;
+}
+BENCH(bench_memset, BENCHF_BUF, NULL, NULL);
+
+static int bench_memcmp(struct bench_state *bs)
+{
+	bs->result = memcmp(bs->dst, bs->src, bs->size);
+
+	return 0;
+}
+
+static int bench_memcmp_setup(struct bench_state *bs)
+{
+	memcpy(bs->dst, bs->src, bs->size);
+
+	return 0;
+}
+BENCH(bench_memcmp, BENCHF_BUF, bench_memcmp_setup, NULL);
+
+/* Allocate and free a small block, as drivers do when probing */
+static int bench_malloc_free(struct bench_state *bs)
+{
+	void *ptr;
+
+	ptr = malloc(64);
+	if (!ptr)
+		return -ENOMEM;
+	free(ptr);
+
+	return 0;
+}
+BENCH(bench_malloc_free, BENCHF_NO_COLD, NULL, NULL);
+
+/* Allocate and free a larger block, e.g. for a sector buffer */
+static int bench_malloc_free_4k(struct bench_state *bs)
+{
+	void *ptr;
+
+	ptr = malloc(4096);
+	if (!ptr)
+		return -ENOMEM;
+	free(ptr);
+
+	return 0;
+}
+BENCH(bench_malloc_free_4k, BENCHF_NO_COLD, NULL, NULL);
+
+#if CONFIG_IS_ENABLED(ARMV8_DRAM_SCRUB)
+/* Clear memory on all cores, as is done for ECC; try with qemu -smp 4 */
+static int bench_dram_scrub(struct bench_state *bs)
+{
+	struct dram_scrub_region region;
+	int cpus;
+
+	region.base = (ulong)bs->dst;
+	region.size = bs->size;
+	cpus = dram_scrub(&region, 1, UINT_MAX);
+	if (cpus < 0)
+		return cpus;
+	bs->result = cpus;
+
+	return 0;
+}
+
+static int bench_dram_scrub_setup(struct bench_state *bs)
+{
+	bs->size = SZ_16M;
+	bs->dst = memalign(DRAM_SCRUB_ALIGN, bs->size);
+
+	return bs->dst ? 0 : -ENOMEM;
+}
+
+static void bench_dram_scrub_teardown(struct bench_state *bs)
+{
+	free(bs->dst);
+}
+BENCH(bench_dram_scrub, BENCHF_NO_COLD, bench_dram_scrub_setup,
+      bench_dram_scrub_teardown);
+#endif
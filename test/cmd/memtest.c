@@ -0,0 +1,179 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the fast memory test
+ */
+
+#include <common.h>
+#include <command.h>
+#include <console.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <memtest.h>
+#include <test/ut.h>
+#include <linux/sizes.h>
+
+/* Declare a new mem test */
+#define MEM_TEST(_name, _flags)	UNIT_TEST(_name, _flags, mem_test)
+
+#define TEST_SIZE	(SZ_1M + SZ_64K)
+
+/* Test memtest_run() with each pattern */
+static int mem_test_memtest_run(struct unit_test_state *uts)
+{
+	struct memtest_result res;
+	ulong addr;
+	u64 *buf;
+
+	buf = memalign(MEMTEST_ALIGN, TEST_SIZE);
+	ut_assertnonnull(buf);
+	addr = map_to_sysmem(buf);
+
+	ut_assertok(memtest_run(addr, TEST_SIZE, MEMTEST_WALK_ONES,
+				MEMTEST_CACHED, 1, &res));
+	ut_asserteq(0, res.errors);
+	ut_asserteq(0, res.bit_errors);
+	ut_asserteq(2 * TEST_SIZE, res.bytes);
+	ut_asserteq(1, res.cpus);
+	ut_assert(!res.aborted);
+	ut_asserteq_64(BIT_ULL(addr / 8 % 64), buf[0]);
+
+	ut_assertok(memtest_run(addr, TEST_SIZE, MEMTEST_WALK_ZEROS,
+				MEMTEST_FLUSH, 1, &res));
+	ut_asserteq(0, res.errors);
+	ut_asserteq_64(~BIT_ULL((addr / 8 + 1) % 64), buf[1]);
+
+	/* The address test finishes with each word holding ~address */
+	ut_assertok(memtest_run(addr, TEST_SIZE, MEMTEST_ADDRESS,
+				MEMTEST_CACHED, MEMTEST_MAX_CPUS, &res));
+	ut_asserteq(0, res.errors);
+	ut_asserteq(4 * TEST_SIZE, res.bytes);
+	ut_asserteq_64(~(u64)(addr + TEST_SIZE - 8),
+		       buf[TEST_SIZE / 8 - 1]);
+
+	ut_assertok(memtest_run(addr, TEST_SIZE, MEMTEST_MOVING_INV,
+				MEMTEST_CACHED, 1, &res));
+	ut_asserteq(0, res.errors);
+	ut_asserteq(6 * TEST_SIZE, res.bytes);
+	ut_asserteq_64(0x5555555555555555ULL, buf[12345]);
+
+	/* Bad arguments */
+	ut_asserteq(-EINVAL, memtest_run(addr + 8, TEST_SIZE - 64,
+					 MEMTEST_ADDRESS, MEMTEST_CACHED, 1,
+					 &res));
+	ut_asserteq(-EINVAL, memtest_run(addr, 0, MEMTEST_ADDRESS,
+					 MEMTEST_CACHED, 1, &res));
+	ut_asserteq(-EINVAL, memtest_run(addr, TEST_SIZE, MEMTEST_ALL,
+					 MEMTEST_CACHED, 1, &res));
+	ut_asserteq(-ENOSYS, memtest_run(addr, TEST_SIZE, MEMTEST_ADDRESS,
+					 MEMTEST_UNCACHED, 1, &res));
+
+	free(buf);
+
+	return 0;
+}
+MEM_TEST(mem_test_memtest_run, 0);
+
+/* Words to corrupt after they are written, and the bits to flip in each */
+static struct {
+	u64 *word;
+	u64 bits;
+} memtest_bad_words[2];
+
+static void memtest_corrupt(u64 *p, ulong size)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(memtest_bad_words); i++) {
+		u64 *word = memtest_bad_words[i].word;
+
+		if (word >= p && word < p + size / sizeof(u64))
+			*word ^= memtest_bad_words[i].bits;
+	}
+}
+
+/* Test that errors found by each core are recorded and merged */
+static int mem_test_memtest_errors(struct unit_test_state *uts)
+{
+	const struct memtest_test test = {
+		.cpus = 2,
+		.corrupt = memtest_corrupt,
+	};
+	struct memtest_result res;
+	ulong size = SZ_2M + SZ_64K;
+	ulong addr;
+	u64 *buf;
+
+	buf = memalign(MEMTEST_ALIGN, size);
+	ut_assertnonnull(buf);
+	addr = map_to_sysmem(buf);
+
+	/*
+	 * The first core tests the first and third chunks and the second
+	 * core tests the second, so the lowest error is found by the second
+	 */
+	memtest_bad_words[0].word = buf + (SZ_1M + 0x40) / 8;
+	memtest_bad_words[0].bits = BIT_ULL(3);
+	memtest_bad_words[1].word = buf + (SZ_2M + 0x8) / 8;
+	memtest_bad_words[1].bits = BIT_ULL(40) | BIT_ULL(63);
+	memtest_set_test(&test);
+
+	ut_assertok(memtest_run(addr, size, MEMTEST_WALK_ONES, MEMTEST_CACHED,
+				MEMTEST_MAX_CPUS, &res));
+	ut_asserteq(2, res.cpus);
+	ut_asserteq(2, res.errors);
+	ut_asserteq(addr + SZ_1M + 0x40, res.first_error);
+	ut_asserteq_64(BIT_ULL(3) | BIT_ULL(40) | BIT_ULL(63), res.bit_errors);
+	ut_asserteq(2 * size, res.bytes);
+
+	/* Each pass which writes is followed by a check */
+	ut_assertok(memtest_run(addr, size, MEMTEST_ADDRESS, MEMTEST_FLUSH, 1,
+				&res));
+	ut_asserteq(1, res.cpus);
+	ut_asserteq(4, res.errors);
+	ut_asserteq(addr + SZ_1M + 0x40, res.first_error);
+
+	memtest_set_test(NULL);
+	free(buf);
+
+	return 0;
+}
+MEM_TEST(mem_test_memtest_errors, 0);
+
+/* Test the 'memtest' command */
+static int mem_test_memtest_cmd(struct unit_test_state *uts)
+{
+	char cmd[80];
+	ulong addr;
+	void *buf;
+
+	buf = memalign(MEMTEST_ALIGN, SZ_64K);
+	ut_assertnonnull(buf);
+	addr = map_to_sysmem(buf);
+
+	ut_assertok(console_record_reset_enable());
+	snprintf(cmd, sizeof(cmd), "memtest -m flush -p 5 %lx 10000", addr);
+	ut_assertok(run_command(cmd, 0));
+	ut_assert_nextline("Testing %08lx size 10000, cache flush", addr);
+	ut_assert_nextlinen("walking-ones ");
+	ut_assert_nextlinen("address ");
+	ut_assert_nextline("Tested 1 iteration(s): OK");
+	ut_assert_console_end();
+
+	snprintf(cmd, sizeof(cmd), "memtest -n 2 %lx 10000", addr);
+	ut_assertok(run_command(cmd, 0));
+	ut_assert_skip_to_line("Tested 2 iteration(s): OK");
+	ut_assert_console_end();
+
+	/* Unaligned region */
+	snprintf(cmd, sizeof(cmd), "memtest -p 1 %lx 10000", addr + 4);
+	ut_asserteq(1, run_command(cmd, 0));
+	ut_assert_nextline("Testing %08lx size 10000, cache cached",
+			   addr + 4);
+	ut_assert_nextline("walking-ones      failed (err=%d)", -EINVAL);
+	ut_assert_console_end();
+
+	free(buf);
+
+	return 0;
+}
+MEM_TEST(mem_test_memtest_cmd, UT_TESTF_CONSOLE_REC);
@@ -492,6 +492,44 @@ static int dm_test_remove(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_remove, UT_TESTF_SCAN_PDATA | UT_TESTF_PROBE_TEST);
 
+#if CONFIG_IS_ENABLED(DM_STATS)
+/* Check that probe and remove statistics are collected */
+static int dm_test_stats(struct unit_test_state *uts)
+{
+	struct dm_stats before;
+	struct udevice *dev;
+	struct uclass *uc;
+
+	ut_assertok(uclass_get(UCLASS_TEST, &uc));
+	ut_assertok(uclass_find_device(UCLASS_TEST, 0, &dev));
+	ut_assert(!(dev_get_flags(dev) & DM_FLAG_ACTIVATED));
+	ut_asserteq(0, dev->stats.probe_count);
+	before = uc->stats;
+
+	ut_assertok(device_probe(dev));
+	ut_asserteq(1, dev->stats.probe_count);
+	ut_asserteq(0, dev->stats.remove_count);
+	ut_assert(dev->stats.priv_bytes > 0);
+	ut_asserteq(before.probe_count + 1, uc->stats.probe_count);
+	ut_asserteq(before.priv_bytes + dev->stats.priv_bytes,
+		    uc->stats.priv_bytes);
+
+	/* Probing again does nothing */
+	ut_assertok(device_probe(dev));
+	ut_asserteq(1, dev->stats.probe_count);
+
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_asserteq(1, dev->stats.remove_count);
+	ut_asserteq(before.remove_count + 1, uc->stats.remove_count);
+
+	ut_assertok(device_probe(dev));
+	ut_asserteq(2, dev->stats.probe_count);
+
+	return 0;
+}
+DM_TEST(dm_test_stats, UT_TESTF_SCAN_PDATA);
+#endif
+
 /* Remove and recreate everything, check for memory leaks */
 static int dm_test_leak(struct unit_test_state *uts)
 {
@@ -5,6 +5,7 @@
 
 #include <common.h>
 #include <dm.h>
+#include <fdt_support.h>
 #include <asm/global_data.h>
 #include <dm/of_extra.h>
 #include <dm/test.h>
@@ -130,3 +131,239 @@ static int dm_test_fdtdec_add_reserved_memory(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_fdtdec_add_reserved_memory,
 	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT | UT_TESTF_FLAT_TREE);
+
+/* Check that the path of every node gives the same result as libfdt */
+static int check_all_paths(struct unit_test_state *uts, const void *blob)
+{
+	char path[256];
+	int offset;
+
+	for (offset = 0; offset >= 0; offset = fdt_next_node(blob, offset,
+							       NULL)) {
+		ut_assertok(fdt_get_path(blob, offset, path, sizeof(path)));
+		ut_asserteq(fdt_path_offset(blob, path),
+			    fdtdec_path_offset(blob, path));
+	}
+
+	return 0;
+}
+
+static int dm_test_fdtdec_path_offset(struct unit_test_state *uts)
+{
+	const void *blob = gd->fdt_blob;
+
+	ut_assertok(check_all_paths(uts, blob));
+	ut_asserteq(0, fdtdec_path_offset(blob, "/"));
+	ut_asserteq(fdt_path_offset(blob, "/a-test"),
+		    fdtdec_path_offset(blob, "//a-test/"));
+
+	/* Aliases */
+	ut_assert(fdtdec_path_offset(blob, "ethernet0") > 0);
+	ut_asserteq(fdt_path_offset(blob, "/eth@10002000"),
+		    fdtdec_path_offset(blob, "ethernet0"));
+	ut_asserteq(fdt_path_offset(blob, "console"),
+		    fdtdec_path_offset(blob, "console"));
+	ut_asserteq(-FDT_ERR_BADPATH, fdtdec_path_offset(blob, "no-alias"));
+
+	/* A name without a unit address matches the first node with one */
+	ut_assert(fdtdec_path_offset(blob, "/i2c") > 0);
+	ut_asserteq(fdt_path_offset(blob, "/i2c@0"),
+		    fdtdec_path_offset(blob, "/i2c"));
+
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdtdec_path_offset(blob, "/no-node"));
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdtdec_path_offset(blob, "/a-test/no-node"));
+
+	return 0;
+}
+DM_TEST(dm_test_fdtdec_path_offset,
+	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT | UT_TESTF_FLAT_TREE);
+
+/* Check that lookups stay correct when the control FDT is changed */
+static int dm_test_fdtdec_path_offset_update(struct unit_test_state *uts)
+{
+	const void *old_blob = gd->fdt_blob;
+	int blob_sz, node, ret;
+	void *blob;
+
+	blob_sz = fdt_totalsize(gd->fdt_blob) + 4096;
+	blob = malloc(blob_sz);
+	ut_assertnonnull(blob);
+	ut_assertok(fdt_open_into(gd->fdt_blob, blob, blob_sz));
+
+	gd->fdt_blob = blob;
+	ret = check_all_paths(uts, blob);
+	node = fdtdec_path_offset(blob, "/a-test");
+	if (!ret && node > 0)
+		node = fdt_add_subnode(blob, node, "new");
+	if (!ret && node > 0) {
+		ret = check_all_paths(uts, blob);
+		if (!ret && fdtdec_path_offset(blob, "/a-test/new") != node)
+			ret = -EINVAL;
+	}
+
+	/* "shadow@1" is added before "shadow", so "/shadow" finds it */
+	if (!ret && node > 0)
+		node = fdt_add_subnode(blob, 0, "shadow");
+	if (!ret && node > 0)
+		node = fdt_add_subnode(blob, 0, "shadow@1");
+	if (!ret && node > 0) {
+		ret = check_all_paths(uts, blob);
+		if (!ret && fdtdec_path_offset(blob, "/shadow") != node)
+			ret = -EINVAL;
+	}
+	gd->fdt_blob = old_blob;
+	free(blob);
+
+	ut_assertok(ret);
+	ut_assert(node > 0);
+
+	return 0;
+}
+DM_TEST(dm_test_fdtdec_path_offset_update,
+	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT | UT_TESTF_FLAT_TREE);
+
+/* Check that every phandle gives the same result as libfdt */
+static int check_all_phandles(struct unit_test_state *uts, const void *blob)
+{
+	int offset, count = 0;
+
+	for (offset = 0; offset >= 0; offset = fdt_next_node(blob, offset,
+							       NULL)) {
+		u32 phandle = fdt_get_phandle(blob, offset);
+
+		if (!phandle)
+			continue;
+		ut_asserteq(fdt_node_offset_by_phandle(blob, phandle),
+			    fdtdec_phandle_offset(blob, phandle));
+		count++;
+	}
+	ut_assert(count > 0);
+
+	return 0;
+}
+
+static int dm_test_fdtdec_phandle_offset(struct unit_test_state *uts)
+{
+	struct fdtdec_index_stats before, after;
+	const void *blob = gd->fdt_blob;
+
+	fdtdec_get_index_stats(&before);
+	ut_assertok(check_all_phandles(uts, blob));
+	ut_asserteq(-FDT_ERR_BADPHANDLE, fdtdec_phandle_offset(blob, 0));
+	ut_asserteq(-FDT_ERR_BADPHANDLE, fdtdec_phandle_offset(blob, -1));
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdtdec_phandle_offset(blob, 0xfffffff0));
+
+	fdtdec_get_index_stats(&after);
+	if (CONFIG_IS_ENABLED(DM_STATS)) {
+		ut_assert(after.phandle_lookups > before.phandle_lookups);
+		if (CONFIG_IS_ENABLED(OF_PHANDLE_INDEX))
+			ut_assert(after.phandle_hits > before.phandle_hits);
+	}
+
+	return 0;
+}
+DM_TEST(dm_test_fdtdec_phandle_offset,
+	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT | UT_TESTF_FLAT_TREE);
+
+/* Check that phandle lookups stay correct when the control FDT is changed */
+static int dm_test_fdtdec_phandle_offset_update(struct unit_test_state *uts)
+{
+	const void *old_blob = gd->fdt_blob;
+	int blob_sz, node, ret;
+	u32 phandle;
+	void *blob;
+
+	blob_sz = fdt_totalsize(gd->fdt_blob) + 4096;
+	blob = malloc(blob_sz);
+	ut_assertnonnull(blob);
+	ut_assertok(fdt_open_into(gd->fdt_blob, blob, blob_sz));
+
+	gd->fdt_blob = blob;
+	ret = check_all_phandles(uts, blob);
+
+	/* Add a node with a new phandle, moving the nodes after it */
+	node = ret ? -1 : fdt_add_subnode(blob, 0, "new-node");
+	if (node > 0)
+		ret = fdt_generate_phandle(blob, &phandle);
+	if (node > 0 && !ret)
+		ret = fdt_setprop_u32(blob, node, "phandle", phandle);
+	if (node > 0 && !ret) {
+		ret = check_all_phandles(uts, blob);
+		node = fdt_path_offset(blob, "/new-node");
+		if (!ret && fdtdec_phandle_offset(blob, phandle) != node)
+			ret = -EINVAL;
+	}
+
+	/* Change the phandle without changing the size of the blob */
+	if (node > 0 && !ret)
+		ret = fdt_setprop_inplace_u32(blob, node, "phandle",
+					      phandle + 1);
+	if (node > 0 && !ret) {
+		if (fdtdec_phandle_offset(blob, phandle) != -FDT_ERR_NOTFOUND ||
+		    fdtdec_phandle_offset(blob, phandle + 1) != node)
+			ret = -EINVAL;
+		else
+			ret = check_all_phandles(uts, blob);
+	}
+	gd->fdt_blob = old_blob;
+	free(blob);
+
+	ut_assertok(ret);
+	ut_assert(node > 0);
+
+	return 0;
+}
+DM_TEST(dm_test_fdtdec_phandle_offset_update,
+	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT | UT_TESTF_FLAT_TREE);
+
+/* Check that a batch of property changes gives the same result as libfdt */
+static int dm_test_fdt_batch(struct unit_test_state *uts)
+{
+	const char *paths[] = { "/a-test", "/b-test", "/d-test", "/e-test" };
+	struct fdt_batch batch;
+	void *blob, *ref;
+	int blob_sz, i;
+
+	blob_sz = fdt_totalsize(gd->fdt_blob) + 4096;
+	blob = malloc(blob_sz);
+	ref = malloc(blob_sz);
+	ut_assertnonnull(blob);
+	ut_assertnonnull(ref);
+	ut_assertok(fdt_open_into(gd->fdt_blob, blob, blob_sz));
+	ut_assertok(fdt_open_into(gd->fdt_blob, ref, blob_sz));
+
+	fdt_batch_init(&batch, blob);
+	for (i = 0; i < ARRAY_SIZE(paths); i++) {
+		int node = fdt_path_offset(blob, paths[i]);
+
+		ut_assert(node > 0);
+		ut_assertok(fdt_batch_setprop(&batch, node, "batch-new",
+					      paths[i], strlen(paths[i]) + 1));
+		ut_assertok(fdt_batch_setprop(&batch, node, "compatible",
+					      "batch", 6));
+		ut_assertok(fdt_batch_setprop(&batch, node, "batch-u32",
+					      "abcd", 4));
+
+		node = fdt_path_offset(ref, paths[i]);
+		ut_assertok(fdt_setprop_string(ref, node, "batch-new",
+					       paths[i]));
+		ut_assertok(fdt_setprop_string(ref, node, "compatible",
+					       "batch"));
+		ut_assertok(fdt_setprop(ref, node, "batch-u32", "abcd", 4));
+	}
+	ut_assertok(fdt_batch_apply(&batch));
+	ut_assertok(fdt_check_header(blob));
+
+	/* The two blobs should now match, apart from any NOP tags */
+	fdt_pack(blob);
+	fdt_pack(ref);
+	ut_asserteq(fdt_totalsize(ref), fdt_totalsize(blob));
+	ut_asserteq_mem(ref, blob, fdt_totalsize(ref));
+
+	free(ref);
+	free(blob);
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_batch, UT_TESTF_SCAN_FDT | UT_TESTF_FLAT_TREE);
@@ -0,0 +1,346 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for fetching several files over TFTP at once
+ *
+ * The sandbox Ethernet driver passes each packet we send to a fake TFTP
+ * server, which queues its replies to be received.
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <env.h>
+#include <mapmem.h>
+#include <net.h>
+#include <asm/eth.h>
+#include <dm/test.h>
+#include <net/tftp.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define TFTP_PORT	69
+
+/* TFTP operations */
+#define TFTP_RRQ	1
+#define TFTP_DATA	3
+#define TFTP_ACK	4
+#define TFTP_ERROR	5
+#define TFTP_OACK	6
+
+#define LOAD_ADDR	0x100000
+
+/**
+ * struct tftp_test_file - a file offered by the fake server
+ *
+ * @name: Name of the file
+ * @size: Size of the file in bytes
+ * @missing: true to refuse the file
+ * @drop: Number of read requests to ignore
+ * @no_oack: true to ignore the blksize option
+ * @rrqs: Returns the number of read requests received
+ * @done: Returns true if the last block was acknowledged
+ * @aborted: Returns true if the client sent an error
+ * @client_port: Client's UDP port for the current transfer
+ * @server_port: Our UDP port for the current transfer
+ * @blksize: Block size of the current transfer
+ * @block: Last block sent
+ */
+struct tftp_test_file {
+	const char *name;
+	ulong size;
+	bool missing;
+	int drop;
+	bool no_oack;
+	int rrqs;
+	bool done;
+	bool aborted;
+	int client_port;
+	int server_port;
+	ushort blksize;
+	ushort block;
+};
+
+/**
+ * struct tftp_test_server - the fake server
+ *
+ * @files: Files offered
+ * @count: Number of files
+ * @next_port: UDP port to use for the next transfer
+ */
+struct tftp_test_server {
+	struct tftp_test_file *files;
+	int count;
+	int next_port;
+};
+
+static u8 tftp_test_byte(struct tftp_test_file *f, ulong offset)
+{
+	return offset * 7 + f->name[0];
+}
+
+/* Queue a UDP packet from the server in reply to @packet */
+static void tftp_test_reply(struct udevice *dev, void *packet, int sport,
+			    int dport, const void *data, int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	struct ethernet_hdr *eth_recv;
+	struct ip_udp_hdr *ipr;
+
+	/* Don't allow the buffer to overrun */
+	if (priv->recv_packets >= PKTBUFSRX)
+		return;
+
+	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_recv->et_protlen = htons(PROT_IP);
+
+	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
+	net_set_ip_header((uchar *)ipr, net_read_ip(&ip->ip_src),
+			  net_read_ip(&ip->ip_dst), IP_UDP_HDR_SIZE + len,
+			  IPPROTO_UDP);
+	ipr->udp_src = htons(sport);
+	ipr->udp_dst = htons(dport);
+	ipr->udp_len = htons(UDP_HDR_SIZE + len);
+	ipr->udp_xsum = 0;
+	memcpy((void *)ipr + IP_UDP_HDR_SIZE, data, len);
+
+	priv->recv_packet_length[priv->recv_packets] =
+		ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + len;
+	++priv->recv_packets;
+}
+
+static void tftp_test_send_block(struct udevice *dev, void *packet,
+				 struct tftp_test_file *f, ushort block)
+{
+	uchar buf[4 + CONFIG_TFTP_BLOCKSIZE];
+	ulong offset = (block - 1) * f->blksize;
+	int len, i;
+
+	len = min_t(ulong, f->blksize, f->size - offset);
+	*(__be16 *)buf = htons(TFTP_DATA);
+	*(__be16 *)(buf + 2) = htons(block);
+	for (i = 0; i < len; i++)
+		buf[4 + i] = tftp_test_byte(f, offset + i);
+	f->block = block;
+
+	tftp_test_reply(dev, packet, f->server_port, f->client_port, buf,
+			4 + len);
+}
+
+static void tftp_test_rrq(struct udevice *dev, void *packet,
+			  struct tftp_test_server *srv, int sport, uchar *pkt,
+			  int len)
+{
+	char *name = (char *)pkt + 2;
+	char *opt, *end = (char *)pkt + len;
+	struct tftp_test_file *f = NULL;
+	uchar buf[32];
+	int i;
+
+	for (i = 0; i < srv->count; i++) {
+		if (!strcmp(name, srv->files[i].name))
+			f = &srv->files[i];
+	}
+	if (!f)
+		return;
+	f->rrqs++;
+	if (f->drop) {
+		f->drop--;
+		return;
+	}
+
+	f->client_port = sport;
+	f->server_port = srv->next_port++;
+	f->blksize = 512;
+	if (f->missing) {
+		*(__be16 *)buf = htons(TFTP_ERROR);
+		*(__be16 *)(buf + 2) = htons(1);
+		strcpy((char *)buf + 4, "File not found");
+		tftp_test_reply(dev, packet, f->server_port, sport, buf,
+				4 + strlen("File not found") + 1);
+		return;
+	}
+	if (f->no_oack) {
+		tftp_test_send_block(dev, packet, f, 1);
+		return;
+	}
+
+	/* Skip the name and the mode to get to the options */
+	opt = name + strlen(name) + 1;
+	opt += strlen(opt) + 1;
+	if (opt < end && !strcasecmp(opt, "blksize"))
+		f->blksize = dectoul(opt + 8, NULL);
+	f->block = 0;
+	*(__be16 *)buf = htons(TFTP_OACK);
+	len = 2 + sprintf((char *)buf + 2, "blksize%c%d", 0, f->blksize) + 1;
+	tftp_test_reply(dev, packet, f->server_port, sport, buf, len);
+}
+
+static int sb_tftp_handler(struct udevice *dev, void *packet,
+			   unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct tftp_test_server *srv = priv->priv;
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	struct tftp_test_file *f = NULL;
+	int sport, dport, i;
+	ushort block;
+	uchar *pkt;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len))
+		return 0;
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP)
+		return 0;
+
+	pkt = (uchar *)ip + IP_UDP_HDR_SIZE;
+	len = ntohs(ip->udp_len) - UDP_HDR_SIZE;
+	sport = ntohs(ip->udp_src);
+	dport = ntohs(ip->udp_dst);
+	if (dport == TFTP_PORT) {
+		if (ntohs(*(__be16 *)pkt) == TFTP_RRQ)
+			tftp_test_rrq(dev, packet, srv, sport, pkt, len);
+		return 0;
+	}
+
+	for (i = 0; i < srv->count; i++) {
+		if (srv->files[i].server_port == dport &&
+		    srv->files[i].client_port == sport)
+			f = &srv->files[i];
+	}
+	if (!f)
+		return 0;
+
+	switch (ntohs(*(__be16 *)pkt)) {
+	case TFTP_ACK:
+		block = ntohs(*(__be16 *)(pkt + 2));
+		if (block != f->block || f->done)
+			break;
+		if (block && f->size - (block - 1) * f->blksize < f->blksize)
+			f->done = true;
+		else
+			tftp_test_send_block(dev, packet, f, block + 1);
+		break;
+	case TFTP_ERROR:
+		f->aborted = true;
+		break;
+	}
+
+	return 0;
+}
+
+static int tftp_test_check(struct unit_test_state *uts,
+			   struct tftp_test_file *f, struct tftp_file *file)
+{
+	u8 *buf;
+	ulong i;
+
+	ut_assertok(file->ret);
+	ut_asserteq(f->size, file->size);
+	ut_assert(f->done);
+	buf = map_sysmem(file->addr, file->size);
+	for (i = 0; i < file->size; i++)
+		ut_asserteq(tftp_test_byte(f, i), buf[i]);
+	unmap_sysmem(buf);
+
+	return 0;
+}
+
+static int tftp_test_run(struct unit_test_state *uts,
+			 struct tftp_test_server *srv, struct tftp_file *files,
+			 bool first, int expect)
+{
+	ulong timeout_ms = tftp_timeout_ms;
+	int ret;
+
+	srv->next_port = 2000;
+	sandbox_eth_set_tx_handler(0, sb_tftp_handler);
+	sandbox_eth_set_priv(0, srv);
+	env_set("ethact", "eth@10002000");
+	env_set("serverip", "1.2.3.5");
+	/* Retransmit quickly when the server ignores a request */
+	tftp_timeout_ms = 100;
+
+	ret = tftp_get_files(files, srv->count, first);
+
+	tftp_timeout_ms = timeout_ms;
+	env_set("serverip", NULL);
+	sandbox_eth_set_tx_handler(0, NULL);
+	ut_asserteq(expect, ret);
+
+	return 0;
+}
+
+/* Test that only the first file the server has is accepted */
+static int dm_test_tftp_multi_first(struct unit_test_state *uts)
+{
+	struct tftp_test_file tfiles[] = {
+		/* Answer late, so the other files are offered meanwhile */
+		{ .name = "pxelinux.cfg/01-00-00-11-22-33-44", .missing = true,
+		  .drop = 1 },
+		{ .name = "pxelinux.cfg/01020304", .size = 3000,
+		  .no_oack = true },
+		{ .name = "pxelinux.cfg/default", .size = 100 },
+	};
+	struct tftp_test_server srv = {
+		.files = tfiles,
+		.count = ARRAY_SIZE(tfiles),
+	};
+	struct tftp_file files[ARRAY_SIZE(tfiles)];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tfiles); i++) {
+		files[i].name = tfiles[i].name;
+		files[i].addr = LOAD_ADDR;
+	}
+	ut_assertok(tftp_test_run(uts, &srv, files, true, 1));
+
+	ut_asserteq(-ENOENT, files[0].ret);
+	ut_asserteq(2, tfiles[0].rrqs);
+
+	/* The data sent while this file was held was dropped, so ask again */
+	ut_assertok(tftp_test_check(uts, &tfiles[1], &files[1]));
+	ut_asserteq(2, tfiles[1].rrqs);
+
+	/* The server was told to stop offering the last file */
+	ut_asserteq(-ECANCELED, files[2].ret);
+	ut_asserteq(1, tfiles[2].rrqs);
+	ut_assert(tfiles[2].aborted);
+	ut_assert(!tfiles[2].done);
+
+	return 0;
+}
+DM_TEST(dm_test_tftp_multi_first, UT_TESTF_SCAN_FDT);
+
+/* Test fetching several files at once */
+static int dm_test_tftp_multi_all(struct unit_test_state *uts)
+{
+	struct tftp_test_file tfiles[] = {
+		{ .name = "fdt", .size = 100 },
+		/* Ends with an empty block */
+		{ .name = "initrd", .size = 2 * CONFIG_TFTP_BLOCKSIZE },
+		{ .name = "kernel", .size = 5000, .no_oack = true },
+	};
+	struct tftp_test_server srv = {
+		.files = tfiles,
+		.count = ARRAY_SIZE(tfiles),
+	};
+	struct tftp_file files[ARRAY_SIZE(tfiles)];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tfiles); i++) {
+		files[i].name = tfiles[i].name;
+		files[i].addr = LOAD_ADDR + i * 0x100000;
+	}
+	ut_assertok(tftp_test_run(uts, &srv, files, false, 0));
+
+	for (i = 0; i < ARRAY_SIZE(tfiles); i++) {
+		ut_assertok(tftp_test_check(uts, &tfiles[i], &files[i]));
+		ut_asserteq(1, tfiles[i].rrqs);
+	}
+
+	return 0;
+}
+DM_TEST(dm_test_tftp_multi_all, UT_TESTF_SCAN_FDT);
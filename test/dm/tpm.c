@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for measuring boot images into the sandbox TPM
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <tpm-common.h>
+#include <tpm-v2.h>
+#include <tpm_measure.h>
+#include <dm/test.h>
+#include <test/ut.h>
+#include <u-boot/sha256.h>
+
+#define TEST_SIZE	4096
+
+/* Work out the new value of a PCR after it is extended with @digest */
+static void test_extend(u8 *pcr, const u8 *digest)
+{
+	sha256_context ctx;
+
+	sha256_starts(&ctx);
+	sha256_update(&ctx, pcr, SHA256_SUM_LEN);
+	sha256_update(&ctx, digest, SHA256_SUM_LEN);
+	sha256_finish(&ctx, pcr);
+}
+
+static int read_pcr(struct unit_test_state *uts, struct udevice *dev,
+		    u32 index, u8 *value)
+{
+	ut_assertok(tpm2_pcr_read(dev, index, 2, TPM2_ALG_SHA256, value,
+				  SHA256_SUM_LEN, NULL));
+
+	return 0;
+}
+
+/* Check the next event in the log and move on to the one after */
+static int check_event(struct unit_test_state *uts,
+		       const struct tpm_measure_event **evp, u32 pcr,
+		       const u8 *digest, const char *name)
+{
+	const struct tpm_measure_event *ev = *evp;
+
+	ut_asserteq(pcr, le32_to_cpu(ev->pcr_index));
+	ut_asserteq(EV_COMPACT_HASH, le32_to_cpu(ev->event_type));
+	ut_asserteq(1, le32_to_cpu(ev->count));
+	ut_asserteq(TPM2_ALG_SHA256, le16_to_cpu(ev->alg));
+	ut_asserteq_mem(digest, ev->digest, SHA256_SUM_LEN);
+	ut_asserteq(strlen(name) + 1, le32_to_cpu(ev->event_size));
+	ut_asserteq_str(name, (char *)ev->event);
+	*evp = (void *)ev + sizeof(*ev) + le32_to_cpu(ev->event_size);
+
+	return 0;
+}
+
+static int measure(u32 pcr, const void *data, const char *name)
+{
+	return tpm_measure_data(pcr, EV_COMPACT_HASH, data, TEST_SIZE, name,
+				strlen(name) + 1);
+}
+
+/* Test measuring data, using digests from FIT verification where possible */
+static int dm_test_tpm_measure(struct unit_test_state *uts)
+{
+	u8 pcr8[SHA256_SUM_LEN], pcr9[SHA256_SUM_LEN], val[SHA256_SUM_LEN];
+	u8 digest[SHA256_SUM_LEN], fake[SHA256_SUM_LEN];
+	const struct tpm_measure_event *ev;
+	static u8 buf[2][TEST_SIZE];
+	struct udevice *dev;
+	const void *log;
+	ulong start, size;
+
+	ut_assertok(uclass_first_device_err(UCLASS_TPM, &dev));
+	ut_asserteq(TPM_V2, tpm_get_version(dev));
+	ut_assertok(tpm_init(dev));
+	ut_assertok(tpm2_startup(dev, TPM2_SU_CLEAR));
+	ut_assertok(tpm2_self_test(dev, TPMI_YES));
+	ut_assertok(read_pcr(uts, dev, TPM_MEASURE_PCR_KERNEL, pcr8));
+	ut_assertok(read_pcr(uts, dev, TPM_MEASURE_PCR_DATA, pcr9));
+
+	memset(buf[0], 0xa5, TEST_SIZE);
+	memset(buf[1], 0x5a, TEST_SIZE);
+	sha256_csum_wd(buf[0], TEST_SIZE, digest, CHUNKSZ_SHA256);
+	memset(fake, 0x11, sizeof(fake));
+	tpm_measure_forget_all();
+	tpm_measure_get_log(&start);
+
+	/* Nothing remembered, so this is hashed */
+	ut_assertok(measure(TPM_MEASURE_PCR_KERNEL, buf[0], "kernel"));
+
+	/* Only SHA-256 digests are used */
+	tpm_measure_note_digest(buf[1], TEST_SIZE, "sha1", fake, 20);
+	tpm_measure_note_digest(buf[1], TEST_SIZE, "sha256", fake,
+				sizeof(fake));
+	ut_assertok(measure(TPM_MEASURE_PCR_DATA, buf[1], "initrd"));
+
+	/* A copy uses the same digest, until it is changed */
+	tpm_measure_move(buf[1], buf[0], TEST_SIZE);
+	ut_assertok(measure(TPM_MEASURE_PCR_DATA, buf[0], "copy"));
+	tpm_measure_forget(buf[0] + TEST_SIZE - 1, 1);
+	ut_assertok(measure(TPM_MEASURE_PCR_DATA, buf[0], "changed"));
+
+	/* The PCRs are not extended until flushed */
+	ut_assertok(read_pcr(uts, dev, TPM_MEASURE_PCR_KERNEL, val));
+	ut_asserteq_mem(pcr8, val, sizeof(val));
+	ut_assertok(tpm_measure_flush(dev));
+
+	test_extend(pcr8, digest);
+	ut_assertok(read_pcr(uts, dev, TPM_MEASURE_PCR_KERNEL, val));
+	ut_asserteq_mem(pcr8, val, sizeof(val));
+	test_extend(pcr9, fake);
+	test_extend(pcr9, fake);
+	test_extend(pcr9, digest);
+	ut_assertok(read_pcr(uts, dev, TPM_MEASURE_PCR_DATA, val));
+	ut_asserteq_mem(pcr9, val, sizeof(val));
+
+	/* The log matches */
+	log = tpm_measure_get_log(&size);
+	ut_assertnonnull(log);
+	ev = log + start;
+	ut_assertok(check_event(uts, &ev, TPM_MEASURE_PCR_KERNEL, digest,
+				"kernel"));
+	ut_assertok(check_event(uts, &ev, TPM_MEASURE_PCR_DATA, fake,
+				"initrd"));
+	ut_assertok(check_event(uts, &ev, TPM_MEASURE_PCR_DATA, fake, "copy"));
+	ut_assertok(check_event(uts, &ev, TPM_MEASURE_PCR_DATA, digest,
+				"changed"));
+	ut_asserteq_ptr(log + size, ev);
+
+	/* Nothing left to do */
+	ut_assertok(tpm_measure_flush(dev));
+	ut_asserteq(-EINVAL, measure(TPM2_MAX_PCRS, buf[0], "bad"));
+	tpm_measure_forget_all();
+
+	return 0;
+}
+DM_TEST(dm_test_tpm_measure, UT_TESTF_SCAN_FDT);
@@ -11,6 +11,9 @@
 #include <dm/test.h>
 #include <test/test.h>
 #include <test/ut.h>
+#include <asm/global_data.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 static inline bool lmb_is_nomap(struct lmb_property *m)
 {
@@ -690,12 +693,13 @@ static int lib_test_lmb_max_regions(struct unit_test_state *uts)
 	ut_asserteq(lmb.memory.cnt, 8);
 	ut_asserteq(lmb.reserved.cnt, 0);
 
-	/*  error for the 9th memory regions */
+	/*  the 9th memory region makes the array grow */
 	offset = ram + 2 * 8 * ram_size;
 	ret = lmb_add(&lmb, offset, ram_size);
-	ut_asserteq(ret, -1);
+	ut_asserteq(ret, 0);
 
-	ut_asserteq(lmb.memory.cnt, 8);
+	ut_asserteq(lmb.memory.cnt, 9);
+	ut_asserteq(lmb.memory.max, 16);
 	ut_asserteq(lmb.reserved.cnt, 0);
 
 	/*  reserve 8 regions */
@@ -705,24 +709,29 @@ static int lib_test_lmb_max_regions(struct unit_test_state *uts)
 		ut_asserteq(ret, 0);
 	}
 
-	ut_asserteq(lmb.memory.cnt, 8);
+	ut_asserteq(lmb.memory.cnt, 9);
 	ut_asserteq(lmb.reserved.cnt, 8);
 
-	/*  error for the 9th reserved blocks */
+	/*  the 9th reserved block makes the array grow */
 	offset = ram + 2 * 8 * blk_size;
 	ret = lmb_reserve(&lmb, offset, blk_size);
-	ut_asserteq(ret, -1);
+	ut_asserteq(ret, 0);
 
-	ut_asserteq(lmb.memory.cnt, 8);
-	ut_asserteq(lmb.reserved.cnt, 8);
+	ut_asserteq(lmb.memory.cnt, 9);
+	ut_asserteq(lmb.reserved.cnt, 9);
+	ut_asserteq(lmb.reserved.max, 16);
 
 	/*  check each regions */
-	for (i = 0; i < 8; i++)
+	for (i = 0; i < 9; i++)
 		ut_asserteq(lmb.memory.region[i].base, ram + 2 * i * ram_size);
 
-	for (i = 0; i < 8; i++)
+	for (i = 0; i < 9; i++)
 		ut_asserteq(lmb.reserved.region[i].base, ram + 2 * i * blk_size);
 
+	lmb_uninit(&lmb);
+	ut_asserteq(lmb.memory.cnt, 0);
+	ut_asserteq(lmb.memory.max, 8);
+
 	return 0;
 }
 
@@ -817,3 +826,93 @@ static int lib_test_lmb_flags(struct unit_test_state *uts)
 
 DM_TEST(lib_test_lmb_flags,
 	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Check that many regions stay sorted and can be found again */
+static int lib_test_lmb_many_regions(struct unit_test_state *uts)
+{
+	const phys_addr_t ram = 0x40000000;
+	const phys_size_t ram_size = 0x20000000;
+	const phys_size_t blk_size = 0x1000;
+	const int count = 200;
+	phys_addr_t addr;
+	struct lmb lmb;
+	long ret;
+	int i;
+
+	lmb_init(&lmb);
+	ret = lmb_add(&lmb, ram, ram_size);
+	ut_asserteq(ret, 0);
+
+	/* reserve every other block, in a scrambled order */
+	for (i = 0; i < count; i++) {
+		addr = ram + 2 * ((i * 7) % count) * blk_size;
+		ret = lmb_reserve(&lmb, addr, blk_size);
+		ut_asserteq(ret, 0);
+	}
+	ut_asserteq(lmb.reserved.cnt, count);
+	for (i = 0; i < count; i++)
+		ut_asserteq(lmb.reserved.region[i].base,
+			    ram + 2 * i * blk_size);
+
+	ut_asserteq(lmb_is_reserved(&lmb, ram + 2 * 100 * blk_size), 1);
+	ut_asserteq(lmb_is_reserved(&lmb, ram + 2 * 100 * blk_size - 1), 0);
+	ut_asserteq(lmb_get_free_size(&lmb, ram + 2 * 100 * blk_size - 1), 1);
+	ut_asserteq(lmb_get_free_size(&lmb, ram + 2 * count * blk_size),
+		    ram_size - 2 * count * blk_size);
+
+	/* overlapping a reserved block fails */
+	ret = lmb_reserve(&lmb, ram + 2 * 50 * blk_size + 0x800, blk_size);
+	ut_asserteq(ret, -1);
+	ut_asserteq(lmb_alloc_addr(&lmb, ram + 2 * 50 * blk_size, 1), 0);
+
+	/* filling the gaps merges everything into one region */
+	for (i = 0; i < count; i++) {
+		addr = ram + (2 * ((i * 7) % count) + 1) * blk_size;
+		ret = lmb_reserve(&lmb, addr, blk_size);
+		ut_assert(ret > 0);
+	}
+	ut_asserteq(lmb.reserved.cnt, 1);
+	ut_asserteq(lmb.reserved.region[0].base, ram);
+	ut_asserteq(lmb.reserved.region[0].size, 2 * count * blk_size);
+
+	/* freeing from the middle splits it again */
+	ret = lmb_free(&lmb, ram + blk_size, blk_size);
+	ut_asserteq(ret, 0);
+	ut_asserteq(lmb.reserved.cnt, 2);
+	ut_asserteq(lmb_alloc_addr(&lmb, ram + blk_size, blk_size),
+		    ram + blk_size);
+
+	lmb_uninit(&lmb);
+
+	return 0;
+}
+
+DM_TEST(lib_test_lmb_many_regions,
+	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Check that the devicetree reservations are the same each time */
+static int lib_test_lmb_fdt_rsv(struct unit_test_state *uts)
+{
+	struct lmb lmb1, lmb2;
+	int i;
+
+	lmb_init_and_reserve(&lmb1, gd->bd, (void *)gd->fdt_blob);
+	lmb_init_and_reserve(&lmb2, gd->bd, (void *)gd->fdt_blob);
+
+	ut_asserteq(lmb1.reserved.cnt, lmb2.reserved.cnt);
+	for (i = 0; i < lmb1.reserved.cnt; i++) {
+		ut_asserteq(lmb1.reserved.region[i].base,
+			    lmb2.reserved.region[i].base);
+		ut_asserteq(lmb1.reserved.region[i].size,
+			    lmb2.reserved.region[i].size);
+		ut_asserteq(lmb1.reserved.region[i].flags,
+			    lmb2.reserved.region[i].flags);
+	}
+	lmb_uninit(&lmb1);
+	lmb_uninit(&lmb2);
+
+	return 0;
+}
+
+DM_TEST(lib_test_lmb_fdt_rsv,
+	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for running jobs on the secondary cores
+ */
+
+#include <common.h>
+#include <worker.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* More jobs than fit in the queue, so that some run on the boot core */
+#define TEST_JOBS	50
+#define TEST_WORDS	4096
+
+struct test_sum {
+	const u32 *data;
+	ulong sum;
+};
+
+static int test_sum_job(void *arg)
+{
+	struct test_sum *ts = arg;
+	int i;
+
+	ts->sum = 0;
+	for (i = 0; i < TEST_WORDS; i++)
+		ts->sum += ts->data[i];
+
+	return ts->sum == 0 ? -ENOENT : 0;
+}
+
+static int run_jobs(struct unit_test_state *uts, const u32 *data)
+{
+	struct worker_job jobs[TEST_JOBS];
+	struct test_sum sums[TEST_JOBS];
+	int i;
+
+	for (i = 0; i < TEST_JOBS; i++) {
+		sums[i].data = data + i;
+		jobs[i].fn = test_sum_job;
+		jobs[i].arg = &sums[i];
+		worker_submit(&jobs[i]);
+	}
+	for (i = 0; i < TEST_JOBS; i++) {
+		ulong expect = (ulong)TEST_WORDS * (TEST_WORDS - 1) / 2 +
+			TEST_WORDS * i;
+
+		ut_assertok(worker_wait(&jobs[i]));
+		ut_asserteq(expect, sums[i].sum);
+	}
+
+	return 0;
+}
+
+/* Test submitting jobs and waiting for them */
+static int lib_test_worker(struct unit_test_state *uts)
+{
+	struct worker_job job;
+	struct test_sum ts;
+	static u32 data[TEST_WORDS + TEST_JOBS];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(data); i++)
+		data[i] = i;
+
+	ut_assertok(run_jobs(uts, data));
+	ut_assert(worker_count() > 0);
+
+	/* Errors are passed back */
+	ts.data = data + 1;
+	for (i = 0; i < TEST_WORDS; i++)
+		data[i + 1] = 0;
+	job.fn = test_sum_job;
+	job.arg = &ts;
+	worker_submit(&job);
+	ut_asserteq(-ENOENT, worker_wait(&job));
+	for (i = 0; i < ARRAY_SIZE(data); i++)
+		data[i] = i;
+
+	/* The workers start again after being stopped */
+	worker_stop();
+	ut_asserteq(0, worker_count());
+	ut_assertok(run_jobs(uts, data));
+	ut_assert(worker_count() > 0);
+	worker_stop();
+
+	return 0;
+}
+LIB_TEST(lib_test_worker, 0);
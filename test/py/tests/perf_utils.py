@@ -0,0 +1,149 @@
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Helpers for the performance tests (test_perf_*.py)
+#
+# Results are written as JSON so that they can be compared between releases.
+# By default they go to perf-results.json in the result directory; this can be
+# changed with the boardenv_* variable env__perf_results_file. The file looks
+# like this:
+#
+# {
+#     "board_type": "sandbox",
+#     "board_identity": "na",
+#     "version": "U-Boot 2022.01 ...",
+#     "results": {
+#         "fs.fat32.load": {
+#             "bytes": 16777216,
+#             "seconds": 0.021,
+#             "mb_per_s": 761.9,
+#             "iterations": 3
+#         },
+#         ...
+#     }
+# }
+#
+# Other boardenv_* variables:
+#
+# Number of times to repeat each measurement; the fastest run is reported
+# env__perf_iterations = 3
+
+import json
+import os
+import re
+
+TIME_RE = re.compile(r'time:(?: (\d+) minutes,)? (\d+)\.(\d+) seconds')
+
+# Set once this test session has started a new results file
+results_started = False
+
+def results_file(u_boot_console):
+    """Get the filename to which results are written
+
+    Args:
+        u_boot_console: A U-Boot console connection.
+
+    Returns:
+        str: Filename of the JSON results file.
+    """
+    config = u_boot_console.config
+    fname = config.env.get('env__perf_results_file', None)
+    if not fname:
+        fname = os.path.join(config.result_dir, 'perf-results.json')
+    return fname
+
+def iterations(u_boot_console):
+    """Get the number of times to repeat each measurement
+
+    Args:
+        u_boot_console: A U-Boot console connection.
+
+    Returns:
+        int: Number of iterations, at least 1.
+    """
+    return max(1, u_boot_console.config.env.get('env__perf_iterations', 3))
+
+def time_command(u_boot_console, cmd, expect=None):
+    """Run a command under the 'time' command and return how long it took
+
+    Args:
+        u_boot_console: A U-Boot console connection.
+        cmd: Command to run.
+        expect: If not None, a string which must appear in the output.
+
+    Returns:
+        tuple:
+            float: Time taken in seconds, with millisecond resolution.
+            str: Output from the command.
+    """
+    output = u_boot_console.run_command('time %s' % cmd)
+    m = TIME_RE.search(output)
+    assert m, 'No time in output: %s' % output
+    if expect:
+        assert expect in output
+    minutes = int(m.group(1) or 0)
+    secs = minutes * 60 + int(m.group(2)) + int(m.group(3)) / 1000
+    return secs, output
+
+def best_time(u_boot_console, cmd, expect=None, setup=None):
+    """Run a command several times and return the shortest time taken
+
+    Args:
+        u_boot_console: A U-Boot console connection.
+        cmd: Command to run.
+        expect: If not None, a string which must appear in the output.
+        setup: If not None, a command to run (untimed) before each run.
+
+    Returns:
+        float: Shortest time taken, in seconds.
+    """
+    best = None
+    for _ in range(iterations(u_boot_console)):
+        if setup:
+            u_boot_console.run_command(setup)
+        secs, _ = time_command(u_boot_console, cmd, expect)
+        if best is None or secs < best:
+            best = secs
+    return best
+
+def record(u_boot_console, name, secs, nbytes=None, **extra):
+    """Record a result in the JSON results file
+
+    The first result in each test session replaces any existing file.
+
+    Args:
+        u_boot_console: A U-Boot console connection.
+        name: Name of the result, e.g. 'fs.ext4.load'.
+        secs: Time taken in seconds.
+        nbytes: Number of bytes processed, or None if not a throughput test.
+        extra: Other values to record with the result.
+    """
+    global results_started
+
+    fname = results_file(u_boot_console)
+    data = None
+    if results_started and os.path.exists(fname):
+        with open(fname) as inf:
+            data = json.load(inf)
+    if not data:
+        config = u_boot_console.config
+        with u_boot_console.disable_check('main_signon'):
+            output = u_boot_console.run_command('version')
+        data = {
+            'board_type': config.board_type,
+            'board_identity': config.board_identity,
+            'version': output.splitlines()[0] if output else '',
+            'results': {},
+        }
+        results_started = True
+
+    result = {'seconds': secs, 'iterations': iterations(u_boot_console)}
+    if nbytes is not None:
+        result['bytes'] = nbytes
+        result['mb_per_s'] = (round(nbytes / secs / 1000000, 1) if secs
+                              else None)
+    result.update(extra)
+    data['results'][name] = result
+    u_boot_console.log.info('perf: %s: %s' % (name, result))
+
+    with open(fname, 'w') as outf:
+        json.dump(data, outf, indent=4, sort_keys=True)
@@ -515,3 +515,51 @@ def test_env_ext4(state_test_env):
     finally:
         if fs_img:
             call('rm -f %s' % fs_img, shell=True)
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_nvedit_select')
+@pytest.mark.buildconfigspec('env_is_in_ext4')
+@pytest.mark.buildconfigspec('env_save_skip_unchanged')
+def test_env_ext4_save_unchanged(state_test_env):
+
+    """Test that an unchanged ENV is not saved again."""
+    c = state_test_env.u_boot_console
+    fs_img = ''
+    try:
+        fs_img = mk_env_ext4(state_test_env)
+
+        c.run_command('host bind 0  %s' % fs_img)
+
+        response = c.run_command('env select EXT4')
+        assert 'Select Environment on EXT4: OK' in response
+
+        response = c.run_command('env save')
+        assert 'Saving Environment to EXT4' in response
+        assert 'unchanged' not in response
+
+        # nothing changed since the last save, so it is skipped
+        response = c.run_command('env save')
+        assert 'Saving Environment to EXT4... unchanged' in response
+
+        c.run_command('setenv test_env_unchanged 1')
+        response = c.run_command('env save')
+        assert 'Saving Environment to EXT4' in response
+        assert 'unchanged' not in response
+
+        # the location is selected again, so what it holds is not known
+        response = c.run_command('env select nowhere')
+        assert 'Select Environment on nowhere: OK' in response
+        response = c.run_command('env select EXT4')
+        assert 'Select Environment on EXT4: OK' in response
+
+        response = c.run_command('env save')
+        assert 'Saving Environment to EXT4' in response
+        assert 'unchanged' not in response
+
+        c.run_command('setenv test_env_unchanged')
+        response = c.run_command('env select nowhere')
+        assert 'Select Environment on nowhere: OK' in response
+
+    finally:
+        if fs_img:
+            call('rm -f %s' % fs_img, shell=True)
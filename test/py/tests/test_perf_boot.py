@@ -0,0 +1,46 @@
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Measure the time taken to boot to the command prompt
+#
+# Two times are recorded: the wall-clock time seen by the test, from starting
+# (or resetting) U-Boot until the prompt appears, and, if the bootstage
+# command is available, U-Boot's own time for reaching main_loop. The first
+# includes the time taken by any board reset hooks, so is mostly useful on
+# sandbox and QEMU.
+
+import re
+import time
+import perf_utils
+
+def main_loop_us(u_boot_console):
+    """Get the time at which main_loop was reached, from bootstage
+
+    Returns:
+        int: Time in microseconds, or None if not found.
+    """
+    output = u_boot_console.run_command('bootstage report')
+    m = re.search(r'^\s*([\d,]+)\s+[\d,]+\s+main_loop\s*$', output,
+                  re.MULTILINE)
+    return int(m.group(1).replace(',', '')) if m else None
+
+def test_perf_boot(u_boot_console):
+    """Measure boot-to-prompt time"""
+    use_bootstage = u_boot_console.config.buildconfig.get(
+        'config_cmd_bootstage', 'n') == 'y'
+    best_wall = None
+    best_main = None
+    for _ in range(perf_utils.iterations(u_boot_console)):
+        start = time.monotonic()
+        u_boot_console.restart_uboot()
+        wall = time.monotonic() - start
+        if best_wall is None or wall < best_wall:
+            best_wall = wall
+
+        main_us = main_loop_us(u_boot_console) if use_bootstage else None
+        if main_us is not None and (best_main is None or main_us < best_main):
+            best_main = main_us
+
+    perf_utils.record(u_boot_console, 'boot.to_prompt', round(best_wall, 3))
+    if best_main is not None:
+        perf_utils.record(u_boot_console, 'boot.main_loop',
+                          best_main / 1000000)
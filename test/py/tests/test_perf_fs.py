@@ -0,0 +1,139 @@
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Measure filesystem load throughput
+#
+# On sandbox, a FAT, ext4 and squashfs image are created holding a single file
+# of random data, and 'load' is timed reading it back. Other boards must
+# describe the files to read in the boardenv_* file, for example:
+#
+# env__perf_fs_files = (
+#     {
+#         # Name used in the results, e.g. 'fs.ext4.load'
+#         'fs': 'ext4',
+#         # Interface and device:partition to load from
+#         'ifname': 'virtio',
+#         'dev': '0:1',
+#         # File to load and its size in bytes
+#         'fn': '/perf.bin',
+#         'size': 16777216,
+#     },
+# )
+#
+# On sandbox the file size may be set with:
+# env__perf_fs_file_size = 16 * 1024 * 1024
+
+import os
+import shutil
+import pytest
+import u_boot_utils
+import perf_utils
+
+FS_TYPES = ['fat', 'ext4', 'squashfs']
+FS_TOOLS = {
+    'fat': ['mkfs.vfat', 'mcopy'],
+    'ext4': ['mkfs.ext4'],
+    'squashfs': ['mksquashfs'],
+}
+FS_CONFIGS = {
+    'fat': 'fs_fat',
+    'ext4': 'fs_ext4',
+    'squashfs': 'fs_squashfs',
+}
+PERF_FILE = 'perf.bin'
+
+def find_tool(tool):
+    """Find a host tool, also looking in /sbin where mkfs tools often live"""
+    return shutil.which(tool, path=os.environ['PATH'] + os.pathsep + '/sbin')
+
+def make_image(u_boot_console, fs_type, src_dir, size):
+    """Create a filesystem image containing the files in src_dir
+
+    Args:
+        u_boot_console: A U-Boot console connection.
+        fs_type: Filesystem type (see FS_TYPES).
+        src_dir: Directory containing the file to add.
+        size: Size of the file in bytes.
+
+    Returns:
+        str: Filename of the image.
+    """
+    img = os.path.join(u_boot_console.config.persistent_data_dir,
+                       'perf.%s.img' % fs_type)
+    src = os.path.join(src_dir, PERF_FILE)
+    if os.path.exists(img):
+        os.remove(img)
+
+    # Allow plenty of space for metadata
+    img_kb = (size * 3 // 2 + 4 * 1024 * 1024) // 1024
+    if fs_type == 'fat':
+        u_boot_utils.run_and_log(u_boot_console, [find_tool('mkfs.vfat'),
+                                 '-F', '32', '-C', img, str(img_kb)])
+        u_boot_utils.run_and_log(u_boot_console, [find_tool('mcopy'), '-i',
+                                 img, src, '::/' + PERF_FILE])
+    elif fs_type == 'ext4':
+        u_boot_utils.run_and_log(u_boot_console, [find_tool('mkfs.ext4'),
+                                 '-q', '-O', '^metadata_csum', '-d', src_dir,
+                                 img, '%dk' % img_kb])
+    else:
+        u_boot_utils.run_and_log(u_boot_console, [find_tool('mksquashfs'),
+                                 src_dir, img, '-noappend', '-quiet'])
+    return img
+
+def load_perf(u_boot_console, name, ifname, dev, fn, size):
+    """Time loading a file and record the result
+
+    Args:
+        u_boot_console: A U-Boot console connection.
+        name: Name of the result.
+        ifname: Interface to load from, e.g. 'host'.
+        dev: Device (and optional partition) to load from.
+        fn: Filename to load.
+        size: Expected size of the file in bytes.
+    """
+    addr = u_boot_utils.find_ram_base(u_boot_console)
+    secs = perf_utils.best_time(u_boot_console, 'load %s %s %x %s' %
+                                (ifname, dev, addr, fn),
+                                expect='%d bytes read' % size)
+    perf_utils.record(u_boot_console, name, secs, size)
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_fs_generic')
+@pytest.mark.buildconfigspec('cmd_time')
+@pytest.mark.parametrize('fs_type', FS_TYPES)
+def test_perf_fs_load_sandbox(u_boot_console, fs_type):
+    """Measure 'load' throughput from an image on sandbox"""
+    cons = u_boot_console
+    if cons.config.buildconfig.get('config_%s' % FS_CONFIGS[fs_type],
+                                   'n') != 'y':
+        pytest.skip('%s not enabled' % fs_type)
+    for tool in FS_TOOLS[fs_type]:
+        if not find_tool(tool):
+            pytest.skip('%s not found' % tool)
+
+    size = cons.config.env.get('env__perf_fs_file_size', 16 * 1024 * 1024)
+    src_dir = os.path.join(cons.config.persistent_data_dir, 'perf_fs')
+    os.makedirs(src_dir, exist_ok=True)
+    src = os.path.join(src_dir, PERF_FILE)
+    if not os.path.exists(src) or os.path.getsize(src) != size:
+        with open(src, 'wb') as outf:
+            outf.write(os.urandom(size))
+    img = make_image(cons, fs_type, src_dir, size)
+    try:
+        cons.run_command('host bind 0 %s' % img)
+        load_perf(cons, 'fs.%s.load' % fs_type, 'host', '0', '/' + PERF_FILE,
+                  size)
+    finally:
+        cons.run_command('host bind 0')
+        os.remove(img)
+
+@pytest.mark.notbuildconfigspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_fs_generic')
+@pytest.mark.buildconfigspec('cmd_time')
+def test_perf_fs_load(u_boot_console):
+    """Measure 'load' throughput for files described by the boardenv"""
+    files = u_boot_console.config.env.get('env__perf_fs_files', None)
+    if not files:
+        pytest.skip('No files to load (env__perf_fs_files)')
+    for f in files:
+        load_perf(u_boot_console, 'fs.%s.load' % f['fs'], f['ifname'],
+                  f['dev'], f['fn'], f['size'])
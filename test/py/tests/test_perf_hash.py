@@ -0,0 +1,122 @@
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Measure hashing and decompression throughput
+#
+# Hashes are computed over a region of memory filled by 'mw'. For
+# decompression, sandbox loads gzip and lz4 files created on the host; other
+# boards use the 'zip' command, if enabled, to create gzip data in memory.
+#
+# The amount of data to process may be set in the boardenv_* file:
+#
+# env__perf_hash_size = 16 * 1024 * 1024
+
+import gzip
+import os
+import shutil
+import pytest
+import u_boot_utils
+import perf_utils
+
+HASH_ALGOS = ['crc32', 'md5', 'sha1', 'sha256', 'sha384', 'sha512']
+
+def data_size(u_boot_console):
+    return u_boot_console.config.env.get('env__perf_hash_size',
+                                         16 * 1024 * 1024)
+
+@pytest.mark.buildconfigspec('cmd_hash')
+@pytest.mark.buildconfigspec('cmd_memory')
+@pytest.mark.buildconfigspec('cmd_time')
+@pytest.mark.parametrize('algo', HASH_ALGOS)
+def test_perf_hash(u_boot_console, algo):
+    """Measure 'hash' throughput for each algorithm"""
+    addr = u_boot_utils.find_ram_base(u_boot_console)
+    size = data_size(u_boot_console)
+    u_boot_console.run_command('mw.l %x 12345678 %x' % (addr, size // 4))
+
+    cmd = 'hash %s %x %x' % (algo, addr, size)
+    output = u_boot_console.run_command(cmd)
+    if 'Unknown hash algorithm' in output:
+        pytest.skip('%s not enabled' % algo)
+    secs = perf_utils.best_time(u_boot_console, cmd, expect='==>')
+    perf_utils.record(u_boot_console, 'hash.%s' % algo, secs, size)
+
+def make_data(size):
+    """Create compressible test data, compressing roughly 10:1"""
+    chunks = []
+    for _ in range(size // 1024):
+        chunks.append(os.urandom(64) * 14 + os.urandom(128))
+    return b''.join(chunks)[:size]
+
+def decompress_perf(u_boot_console, name, cmd, size):
+    """Time a decompression command and record the result
+
+    Args:
+        u_boot_console: A U-Boot console connection.
+        name: Name of the result.
+        cmd: Command to run.
+        size: Expected uncompressed size in bytes.
+    """
+    secs = perf_utils.best_time(u_boot_console, cmd,
+                                expect='Uncompressed size: %d' % size)
+    perf_utils.record(u_boot_console, name, secs, size)
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_time')
+@pytest.mark.parametrize('fmt', ['gzip', 'lz4'])
+def test_perf_decompress_sandbox(u_boot_console, fmt):
+    """Measure decompression throughput of host-compressed data"""
+    cons = u_boot_console
+    if fmt == 'gzip':
+        if cons.config.buildconfig.get('config_cmd_unzip', 'n') != 'y':
+            pytest.skip('unzip command not enabled')
+    elif (cons.config.buildconfig.get('config_cmd_unlz4', 'n') != 'y' or
+          not shutil.which('lz4')):
+        pytest.skip('unlz4 command or lz4 tool not available')
+
+    size = data_size(cons)
+    raw = os.path.join(cons.config.result_dir, 'perf_decomp.bin')
+    comp = raw + ('.gz' if fmt == 'gzip' else '.lz4')
+    data = make_data(size)
+    try:
+        if fmt == 'gzip':
+            with open(comp, 'wb') as outf:
+                outf.write(gzip.compress(data))
+        else:
+            with open(raw, 'wb') as outf:
+                outf.write(data)
+            u_boot_utils.run_and_log(cons, ['lz4', '-f', '-q', raw, comp])
+
+        addr = u_boot_utils.find_ram_base(cons)
+        dst = addr + size * 2
+        output = cons.run_command('host load hostfs - %x %s' % (addr, comp))
+        assert 'bytes read' in output
+        if fmt == 'gzip':
+            cmd = 'unzip %x %x %x' % (addr, dst, size)
+        else:
+            cmd = 'unlz4 %x %x %x' % (addr, dst, size)
+        decompress_perf(cons, 'decompress.%s' % fmt, cmd, size)
+    finally:
+        for fname in (raw, comp):
+            if os.path.exists(fname):
+                os.remove(fname)
+
+@pytest.mark.notbuildconfigspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_zip')
+@pytest.mark.buildconfigspec('cmd_unzip')
+@pytest.mark.buildconfigspec('cmd_memory')
+@pytest.mark.buildconfigspec('cmd_time')
+def test_perf_decompress(u_boot_console):
+    """Measure gzip decompression throughput using data compressed by 'zip'"""
+    addr = u_boot_utils.find_ram_base(u_boot_console)
+    size = data_size(u_boot_console)
+    comp = addr + size
+    dst = addr + size * 2
+
+    # A repeating but not trivial pattern
+    u_boot_console.run_command('mw.l %x 12345678 %x' % (addr, size // 4))
+    u_boot_console.run_command('mw.l %x 9abcdef0 %x' % (addr, size // 16))
+    output = u_boot_console.run_command('zip %x %x %x %x' %
+                                        (addr, size, comp, size))
+    assert 'Compressed size' in output
+    decompress_perf(u_boot_console, 'decompress.gzip',
+                    'unzip %x %x %x' % (comp, dst, size), size)
@@ -0,0 +1,169 @@
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Measure the time taken by mkimage to create and sign a large FIT
+#
+# This runs on the host, using the mkimage built for sandbox. The FIT has a
+# kernel and a ramdisk, each hashed and signed with every key, and a
+# configuration signed with every key. The public keys are written to a
+# separate device tree, as when signing for verified boot.
+#
+# The FIT size and the number of keys may be set in the boardenv_* file:
+#
+# env__perf_fit_size = 64 * 1024 * 1024
+# env__perf_fit_keys = 3
+
+import os
+import shutil
+import time
+import pytest
+import u_boot_utils as util
+import perf_utils
+
+ITS_HEADER = '''/dts-v1/;
+
+/ {
+	description = "Large signed FIT";
+	#address-cells = <1>;
+
+	images {
+'''
+
+ITS_IMAGE = '''		%(name)s {
+			data = /incbin/("%(fname)s");
+			type = "%(type)s";
+			arch = "sandbox";
+			os = "linux";
+			compression = "none";
+			load = <0x4>;
+			entry = <0x8>;
+			hash-1 {
+				algo = "sha256";
+			};
+%(sigs)s		};
+'''
+
+ITS_CONFIG = '''	};
+	configurations {
+		default = "conf-1";
+		conf-1 {
+			kernel = "kernel";
+			ramdisk = "ramdisk";
+%(sigs)s		};
+	};
+};
+'''
+
+ITS_SIG = '''			signature-%(num)d {
+				algo = "sha256,rsa2048";
+				key-name-hint = "key%(num)d";
+%(extra)s			};
+'''
+
+def make_its(tmpdir, keys):
+    """Write the .its file describing the FIT
+
+    Args:
+        tmpdir: Directory holding the image data and keys.
+        keys: Number of keys to sign with.
+
+    Returns:
+        str: Filename of the .its file.
+    """
+    img_sigs = ''.join(ITS_SIG % {'num': num, 'extra': ''}
+                       for num in range(keys))
+    conf_sigs = ''.join(ITS_SIG % {
+        'num': num,
+        'extra': '\t\t\t\tsign-images = "kernel", "ramdisk";\n'}
+                        for num in range(keys))
+    its = ITS_HEADER
+    for name, img_type in (('kernel', 'kernel'), ('ramdisk', 'ramdisk')):
+        its += ITS_IMAGE % {'name': name, 'type': img_type, 'sigs': img_sigs,
+                            'fname': os.path.join(tmpdir, name + '.bin')}
+    its += ITS_CONFIG % {'sigs': conf_sigs}
+
+    fname = os.path.join(tmpdir, 'perf.its')
+    with open(fname, 'w') as outf:
+        outf.write(its)
+    return fname
+
+def make_data(fname, size):
+    """Write a file of incompressible data
+
+    Args:
+        fname: Filename to write.
+        size: Size of the file in bytes.
+    """
+    block = os.urandom(1024 * 1024)
+    with open(fname, 'wb') as outf:
+        for pos in range(0, size, len(block)):
+            outf.write(block[:size - pos])
+
+def best_run(u_boot_console, args, setup=None):
+    """Run a host command several times and return the shortest time taken
+
+    Args:
+        u_boot_console: A U-Boot console connection.
+        args: Command to run, as a list of arguments.
+        setup: Function to call (untimed) before each run, or None.
+
+    Returns:
+        float: Shortest time taken, in seconds.
+    """
+    best = None
+    for _ in range(perf_utils.iterations(u_boot_console)):
+        if setup:
+            setup()
+        start = time.monotonic()
+        util.run_and_log(u_boot_console, args)
+        secs = time.monotonic() - start
+        if best is None or secs < best:
+            best = secs
+    return round(best, 3)
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('fit_signature')
+@pytest.mark.requiredtool('dtc')
+@pytest.mark.requiredtool('openssl')
+def test_perf_mkimage_sign(u_boot_console):
+    """Measure the time taken to create and to sign a large FIT"""
+    cons = u_boot_console
+    size = cons.config.env.get('env__perf_fit_size', 64 * 1024 * 1024)
+    keys = cons.config.env.get('env__perf_fit_keys', 3)
+    mkimage = os.path.join(cons.config.build_dir, 'tools', 'mkimage')
+    tmpdir = os.path.join(cons.config.result_dir, 'perf_mkimage')
+    fit = os.path.join(tmpdir, 'perf.fit')
+    unsigned = fit + '.unsigned'
+    dts = os.path.join(tmpdir, 'keys.dts')
+    dtb = os.path.join(tmpdir, 'keys.dtb')
+    os.makedirs(tmpdir, exist_ok=True)
+
+    try:
+        for num in range(keys):
+            key = os.path.join(tmpdir, 'key%d' % num)
+            util.run_and_log(cons, 'openssl genpkey -algorithm RSA -out '
+                             '%s.key -pkeyopt rsa_keygen_bits:2048' % key)
+            util.run_and_log(cons, 'openssl req -batch -new -x509 -key '
+                             '%s.key -out %s.crt' % (key, key))
+        for name in ('kernel', 'ramdisk'):
+            make_data(os.path.join(tmpdir, name + '.bin'), size // 2)
+        its = make_its(tmpdir, keys)
+        with open(dts, 'w') as outf:
+            outf.write('/dts-v1/;\n\n/ {\n};\n')
+
+        secs = best_run(cons, [mkimage, '-f', its, unsigned])
+        perf_utils.record(cons, 'mkimage.fit.create', secs, size)
+
+        def setup():
+            shutil.copyfile(unsigned, fit)
+            util.run_and_log(cons, ['dtc', '-I', 'dts', '-O', 'dtb', '-o',
+                                    dtb, dts])
+
+        secs = best_run(cons, [mkimage, '-F', '-k', tmpdir, '-K', dtb, '-r',
+                               fit], setup)
+        perf_utils.record(cons, 'mkimage.fit.sign', secs, size, keys=keys)
+
+        util.run_and_log(cons, [os.path.join(cons.config.build_dir, 'tools',
+                                             'fit_check_sign'),
+                                '-f', fit, '-k', dtb])
+    finally:
+        shutil.rmtree(tmpdir, ignore_errors=True)
@@ -0,0 +1,82 @@
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Measure TFTP throughput with various block and window sizes
+#
+# This uses the network configuration from test_net.py (env__net_uses_usb,
+# env__net_uses_pci, env__net_dhcp_server, env__net_static_env_vars) and the
+# file described by env__net_tftp_readable_file, which should be served by a
+# TFTP server on the local network so that the network itself is not the
+# bottleneck. The server must support the windowsize option (RFC 7440) for
+# window sizes above 1 to have any effect. It is best to use a file of several
+# megabytes.
+#
+# The sizes to try may be set in the boardenv_* file:
+#
+# env__perf_tftp_window_sizes = [1, 4, 8, 16]
+# env__perf_tftp_block_sizes = [1468]
+
+import pytest
+import perf_utils
+
+def net_setup(u_boot_console):
+    """Set up the network, as test_net.py does
+
+    Returns:
+        True if the network was set up, False if there is no configuration.
+    """
+    env = u_boot_console.config.env
+    if env.get('env__net_uses_usb', False):
+        u_boot_console.run_command('usb start')
+    if env.get('env__net_uses_pci', False):
+        u_boot_console.run_command('pci enum')
+
+    if env.get('env__net_dhcp_server', False):
+        u_boot_console.run_command('setenv autoload no')
+        output = u_boot_console.run_command('dhcp')
+        assert 'DHCP client bound to address ' in output
+        return True
+
+    env_vars = env.get('env__net_static_env_vars', None)
+    if not env_vars:
+        return False
+    for (var, val) in env_vars:
+        u_boot_console.run_command('setenv %s %s' % (var, val))
+    return True
+
+@pytest.mark.buildconfigspec('cmd_net')
+@pytest.mark.buildconfigspec('cmd_time')
+def test_perf_tftp(u_boot_console):
+    """Measure 'tftpboot' throughput for each block and window size"""
+    env = u_boot_console.config.env
+    f = env.get('env__net_tftp_readable_file', None)
+    if not f:
+        pytest.skip('No TFTP readable file to read')
+    if not net_setup(u_boot_console):
+        pytest.skip('Network not configured')
+
+    addr = f.get('addr', None)
+    if addr:
+        cmd = 'tftpboot %x %s' % (addr, f['fn'])
+    else:
+        cmd = 'tftpboot %s' % f['fn']
+    expect = 'Bytes transferred = '
+    if 'size' in f:
+        expect += '%d' % f['size']
+
+    window_sizes = env.get('env__perf_tftp_window_sizes', [1, 4, 8, 16])
+    block_sizes = env.get('env__perf_tftp_block_sizes', [1468])
+    try:
+        for blksize in block_sizes:
+            u_boot_console.run_command('setenv tftpblocksize %d' % blksize)
+            for winsize in window_sizes:
+                u_boot_console.run_command('setenv tftpwindowsize %d' %
+                                           winsize)
+                secs = perf_utils.best_time(u_boot_console, cmd, expect)
+                size = int(u_boot_console.run_command('echo $filesize'), 16)
+                perf_utils.record(u_boot_console,
+                                  'net.tftp.blk%d.win%d' % (blksize, winsize),
+                                  secs, size, blksize=blksize,
+                                  windowsize=winsize)
+    finally:
+        u_boot_console.run_command('setenv tftpblocksize')
+        u_boot_console.run_command('setenv tftpwindowsize')
@@ -0,0 +1,54 @@
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Measure SPI flash read and update throughput
+#
+# This uses the same boardenv_* configuration as test_sf.py (env__sf_configs).
+# Updates are only measured on areas marked as writeable. Each timed update
+# writes a different pattern, so that 'sf update' cannot skip unchanged
+# sectors.
+
+import pytest
+import perf_utils
+from test_sf import sf_prepare
+
+def result_name(env__sf_config, op):
+    return 'sf.%s@%x.%s' % (env__sf_config.get('id', 0),
+                            env__sf_config['offset'], op)
+
+@pytest.mark.buildconfigspec('cmd_sf')
+@pytest.mark.buildconfigspec('cmd_memory')
+@pytest.mark.buildconfigspec('cmd_time')
+def test_perf_sf_read(u_boot_console, env__sf_config):
+    """Measure 'sf read' throughput"""
+    sf_params = sf_prepare(u_boot_console, env__sf_config)
+    count = sf_params['len']
+    secs = perf_utils.best_time(u_boot_console, 'sf read %08x %08x %x' %
+                                (sf_params['ram_base'],
+                                 env__sf_config['offset'], count),
+                                expect='Read: OK')
+    perf_utils.record(u_boot_console, result_name(env__sf_config, 'read'),
+                      secs, count)
+
+@pytest.mark.buildconfigspec('cmd_sf')
+@pytest.mark.buildconfigspec('cmd_memory')
+@pytest.mark.buildconfigspec('cmd_time')
+def test_perf_sf_update(u_boot_console, env__sf_config):
+    """Measure 'sf update' throughput, including the erase"""
+    if not env__sf_config.get('writeable', False):
+        pytest.skip('Flash config is tagged as not writeable')
+
+    sf_params = sf_prepare(u_boot_console, env__sf_config)
+    addr = sf_params['ram_base']
+    count = sf_params['len']
+    best = None
+    for i in range(perf_utils.iterations(u_boot_console)):
+        u_boot_console.run_command('mw.b %08x %02x %x' %
+                                   (addr, (0x55 + i * 0x11) & 0xff, count))
+        secs, _ = perf_utils.time_command(u_boot_console,
+                                          'sf update %08x %08x %x' %
+                                          (addr, env__sf_config['offset'],
+                                           count), expect='written')
+        if best is None or secs < best:
+            best = secs
+    perf_utils.record(u_boot_console, result_name(env__sf_config, 'update'),
+                      best, count)
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Render a U-Boot bootstage timeline
+#
+# The timeline is written by U-Boot (CONFIG_BOOTSTAGE_TIMELINE) into a
+# reserved memory region, described in doc/develop/bootstage_timeline.rst.
+# On the target it can be dumped with, for example:
+#
+#   dd if=/dev/mem of=timeline.bin bs=4096 skip=$((ADDR / 4096)) count=16
+#
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = 0x4c545342
+VERSION = 1
+
+HDR_FMT = '<IIIIQIIIIII'
+EVENT_FMT = '<QQIBBH'
+
+TYPES = ['mark', 'device', 'command', 'span']
+PHASES = ['none', 'TPL', 'SPL', 'U-Boot', 'U-Boot']
+
+
+class Event:
+    def __init__(self, start, end, name, etype, phase):
+        self.start = start
+        self.end = end
+        self.name = name
+        self.etype = etype
+        self.phase = phase
+
+
+def read_timeline(data):
+    """Decode a timeline region
+
+    Args:
+        data (bytes): Contents of the region
+
+    Returns:
+        tuple:
+            int: Timer rate in Hz
+            int: Number of events dropped by U-Boot
+            list of Event: Events in the order recorded
+    """
+    hdr_len = struct.calcsize(HDR_FMT)
+    (magic, version, hdr_size, size, rate, count, max_count, str_used,
+     str_size, dropped, _) = struct.unpack_from(HDR_FMT, data)
+    if magic != MAGIC:
+        raise ValueError('Bad magic %#x' % magic)
+    if version != VERSION:
+        raise ValueError('Unsupported version %d' % version)
+    if hdr_size < hdr_len or size > len(data):
+        raise ValueError('Truncated timeline (%d of %d bytes)' %
+                         (len(data), size))
+    event_len = struct.calcsize(EVENT_FMT)
+    strings = hdr_size + max_count * event_len
+    events = []
+    for i in range(count):
+        start, end, name, etype, phase, _ = struct.unpack_from(
+            EVENT_FMT, data, hdr_size + i * event_len)
+        pos = strings + name
+        name = data[pos:data.index(b'\0', pos)].decode('utf-8', 'replace')
+        events.append(Event(start, end, name, TYPES[etype] if
+                            etype < len(TYPES) else str(etype),
+                            PHASES[phase] if phase < len(PHASES) else
+                            str(phase)))
+    return rate, dropped, events
+
+
+def to_ns(ticks, rate):
+    return ticks * 1000000000 // rate
+
+
+def show_text(rate, events, outf):
+    print('%14s %12s  %-8s %-8s %s' %
+          ('Start (ns)', 'Duration', 'Phase', 'Type', 'Name'), file=outf)
+    for ev in sorted(events, key=lambda ev: ev.start):
+        dur = ''
+        if ev.end != ev.start:
+            dur = '{:,}'.format(to_ns(ev.end - ev.start, rate))
+        print('%14s %12s  %-8s %-8s %s' %
+              ('{:,}'.format(to_ns(ev.start, rate)), dur, ev.phase,
+               ev.etype, ev.name), file=outf)
+
+
+def show_chrome(rate, events, outf):
+    """Write events in Chrome trace-event format (chrome://tracing)"""
+    out = []
+    for ev in events:
+        item = {
+            'name': ev.name,
+            'cat': ev.etype,
+            'pid': 0,
+            'tid': ev.phase,
+            'ts': to_ns(ev.start, rate) / 1000,
+        }
+        if ev.end == ev.start:
+            item.update({'ph': 'i', 's': 'g'})
+        else:
+            item.update({'ph': 'X',
+                         'dur': to_ns(ev.end - ev.start, rate) / 1000})
+        out.append(item)
+    json.dump({'traceEvents': out, 'displayTimeUnit': 'ns'}, outf,
+              indent=1)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Render a U-Boot bootstage timeline')
+    parser.add_argument('file', help='Dump of the timeline region')
+    parser.add_argument('-f', '--format', choices=['text', 'chrome'],
+                        default='text', help='Output format')
+    parser.add_argument('-o', '--output', help='Output file (default stdout)')
+    args = parser.parse_args()
+
+    with open(args.file, 'rb') as inf:
+        data = inf.read()
+    try:
+        rate, dropped, events = read_timeline(data)
+    except ValueError as exc:
+        sys.exit('%s: %s' % (args.file, exc))
+
+    outf = open(args.output, 'w') if args.output else sys.stdout
+    if args.format == 'chrome':
+        show_chrome(rate, events, outf)
+    else:
+        show_text(rate, events, outf)
+    if dropped:
+        print('Warning: %d events were dropped' % dropped, file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
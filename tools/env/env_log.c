@@ -0,0 +1 @@
+#include "../../env/log.c"
@@ -13,6 +13,7 @@
 #include <env.h>
 #include <errno.h>
 #include <env_flags.h>
+#include <env_log.h>
 #include <fcntl.h>
 #include <libgen.h>
 #include <linux/fs.h>
@@ -113,6 +114,9 @@ struct environment {
 	char *data;
 	enum flag_scheme flag_scheme;
 	int dirty;
+	char *stored;		/* data as read from flash, or NULL */
+	int is_log;		/* stored as a log, see include/env_log.h */
+	size_t log_end;		/* offset of the next record in the log */
 };
 
 static struct environment environment = {
@@ -347,6 +351,7 @@ static int ubi_write(int fd, const void *buf, size_t count)
 }
 
 static int flash_io(int mode);
+static int env_log_flush(void);
 static int parse_config(struct env_opts *opts);
 
 #if defined(CONFIG_FILE)
@@ -510,6 +515,19 @@ int fw_env_flush(struct env_opts *opts)
 	if (!environment.dirty)
 		return 0;
 
+	/* Variables may have been changed and then changed back */
+	if (environment.stored &&
+	    !env_log_diff(environment.stored, environment.data, NULL, 0))
+		return 0;
+
+	if (environment.is_log) {
+		if (env_log_flush()) {
+			fprintf(stderr, "Error: can't write fw_env to flash\n");
+			return -1;
+		}
+		return 0;
+	}
+
 	/*
 	 * Update CRC
 	 */
@@ -521,6 +539,9 @@ int fw_env_flush(struct env_opts *opts)
 		return -1;
 	}
 
+	if (environment.stored)
+		memcpy(environment.stored, environment.data, ENV_SIZE);
+
 	return 0;
 }
 
@@ -721,6 +742,37 @@ int fw_env_set(int argc, char *argv[], struct env_opts *opts)
 	return ret;
 }
 
+int fw_env_set_many(int count, char *const names[], char *const values[],
+		    struct env_opts *opts)
+{
+	int i;
+	int ret;
+
+	if (!opts)
+		opts = &default_opts;
+
+	if (fw_env_open(opts)) {
+		fprintf(stderr, "Error: environment not initialized\n");
+		return -1;
+	}
+
+	/* Nothing is written unless all the variables can be set */
+	for (i = 0; i < count; i++) {
+		char *value = values[i];
+
+		if (env_flags_validate_type(names[i], value) < 0 ||
+		    fw_env_write(names[i], value)) {
+			fw_env_close(opts);
+			return -1;
+		}
+	}
+
+	ret = fw_env_flush(opts);
+	fw_env_close(opts);
+
+	return ret;
+}
+
 /*
  * Parse  a file  and configure the u-boot variables.
  * The script file has a very simple format, as follows:
@@ -1406,6 +1458,160 @@ static int flash_io(int mode)
 	return rc;
 }
 
+/*
+ * Write a record after the last one in the log, without erasing. This is only
+ * used for NOR flash, dataflash and files.
+ */
+static int flash_log_append(const void *rec, size_t size)
+{
+	struct erase_info_user erase;
+	off_t offset = DEVOFFSET(dev_current) + environment.log_end;
+	int was_locked = 0;	/* flash lock flag */
+	int fd, rc = 0;
+
+	fd = open(DEVNAME(dev_current), O_RDWR);
+	if (fd < 0) {
+		fprintf(stderr,
+			"Can't open %s: %s\n",
+			DEVNAME(dev_current), strerror(errno));
+		return -1;
+	}
+
+	if (DEVTYPE(dev_current) != MTD_ABSENT) {
+		erase.start = DEVOFFSET(dev_current);
+		erase.length = environment_end(dev_current) -
+			       DEVOFFSET(dev_current);
+		was_locked = ioctl(fd, MEMISLOCKED, &erase);
+		/* treat any errors as unlocked flash */
+		if (was_locked < 0)
+			was_locked = 0;
+		if (was_locked)
+			ioctl(fd, MEMUNLOCK, &erase);
+	}
+
+#ifdef DEBUG
+	fprintf(stderr, "Append 0x%zx bytes at 0x%llx\n", size,
+		(unsigned long long)offset);
+#endif
+	if (pwrite(fd, rec, size, offset) != size) {
+		fprintf(stderr, "Write error on %s: %s\n",
+			DEVNAME(dev_current), strerror(errno));
+		rc = -1;
+	}
+
+	if (was_locked)
+		ioctl(fd, MEMLOCK, &erase);
+
+	if (fsync(fd) && !(errno == EINVAL || errno == EROFS)) {
+		fprintf(stderr,
+			"fsync failed on %s: %s\n",
+			DEVNAME(dev_current), strerror(errno));
+	}
+
+	if (close(fd)) {
+		fprintf(stderr,
+			"I/O error on %s: %s\n",
+			DEVNAME(dev_current), strerror(errno));
+		rc = -1;
+	}
+
+	return rc;
+}
+
+/*
+ * Write out an environment stored as a log: append a record holding the
+ * changes if there is room, else rewrite the area with a single full record
+ */
+static int env_log_flush(void)
+{
+	struct env_log_hdr *rec;
+	void *image = environment.image;
+	size_t avail = 0;
+	int len, rc = -1;
+
+	rec = malloc(CUR_ENVSIZE);
+	if (!rec) {
+		fprintf(stderr,
+			"Not enough memory for environment (%ld bytes)\n",
+			CUR_ENVSIZE);
+		return -1;
+	}
+
+	if (environment.log_end + sizeof(*rec) < CUR_ENVSIZE)
+		avail = CUR_ENVSIZE - environment.log_end - sizeof(*rec);
+	len = env_log_diff(environment.stored, environment.data,
+			   (char *)(rec + 1), avail);
+	if (!len) {
+		rc = 0;
+		goto out;
+	} else if (len > 0 &&
+		   environment.log_end + ENV_LOG_REC_SIZE(len) <= CUR_ENVSIZE) {
+		size_t size = env_log_seal(rec, ENV_LOG_MAGIC_DELTA, len);
+
+		rc = flash_log_append(rec, size);
+		if (!rc)
+			environment.log_end += size;
+		goto update;
+	}
+
+	/* The log is full, so compact it */
+	len = env_log_list_len(environment.data, ENV_SIZE);
+	if (len < 0 || ENV_LOG_REC_SIZE(len) > CUR_ENVSIZE) {
+		fprintf(stderr, "Environment too large for the log\n");
+		goto out;
+	}
+	memset(rec, 0xff, CUR_ENVSIZE);
+	memcpy(rec + 1, environment.data, len);
+	env_log_seal(rec, ENV_LOG_MAGIC_FULL, len);
+
+	environment.image = rec;
+	rc = flash_io(O_RDWR);
+	environment.image = image;
+	if (!rc)
+		environment.log_end = ENV_LOG_REC_SIZE(len);
+
+update:
+	if (!rc)
+		memcpy(environment.stored, environment.data, ENV_SIZE);
+out:
+	free(rec);
+
+	return rc;
+}
+
+/*
+ * Read an environment stored as a log (see include/env_log.h) into
+ * environment.data, keeping a copy so that fw_env_flush() can append just the
+ * changes
+ */
+static int env_log_load(void)
+{
+	size_t end;
+	char *list;
+	int len;
+
+	if (IS_UBI(dev_current) || DEVTYPE(dev_current) == MTD_NANDFLASH ||
+	    *(uint32_t *)environment.image != ENV_LOG_MAGIC_FULL)
+		return -ENOENT;
+
+	list = calloc(1, ENV_SIZE);
+	if (!list)
+		return -ENOMEM;
+
+	len = env_log_replay(environment.image, CUR_ENVSIZE, list, ENV_SIZE,
+			     &end);
+	if (len < 0) {
+		free(list);
+		return len;
+	}
+	memcpy(environment.data, list, ENV_SIZE);
+	environment.stored = list;
+	environment.is_log = 1;
+	environment.log_end = end;
+
+	return 0;
+}
+
 /*
  * Prevent confusion if running from erased flash memory
  */
@@ -1464,7 +1670,7 @@ int fw_env_open(struct env_opts *opts)
 
 	crc0_ok = (crc0 == *environment.crc);
 	if (!have_redund_env) {
-		if (!crc0_ok) {
+		if (!crc0_ok && env_log_load()) {
 			fprintf(stderr,
 				"Warning: Bad CRC, using default environment\n");
 			memcpy(environment.data, default_environment,
@@ -1599,6 +1805,14 @@ int fw_env_open(struct env_opts *opts)
 		fprintf(stderr, "Selected env in %s\n", DEVNAME(dev_current));
 #endif
 	}
+
+	/* Keep a copy so that fw_env_flush() can tell if anything changed */
+	if (!environment.stored && !environment.dirty) {
+		environment.stored = malloc(ENV_SIZE);
+		if (environment.stored)
+			memcpy(environment.stored, environment.data, ENV_SIZE);
+	}
+
 	return 0;
 
  open_cleanup:
@@ -1621,6 +1835,10 @@ int fw_env_close(struct env_opts *opts)
 
 	environment.image = NULL;
 
+	free(environment.stored);
+	environment.stored = NULL;
+	environment.is_log = 0;
+
 	return 0;
 }
 
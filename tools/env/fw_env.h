@@ -11,7 +11,7 @@
  * that varies depending on the U-Boot version.
  * This can be changed in future
  */
-#define FW_ENV_API_VERSION	1
+#define FW_ENV_API_VERSION	2
 
 struct env_opts {
 #ifdef CONFIG_FILE
@@ -57,6 +57,28 @@ int fw_printenv(int argc, char *argv[], int value_only, struct env_opts *opts);
  */
 int fw_env_set(int argc, char *argv[], struct env_opts *opts);
 
+/**
+ * fw_env_set_many() - adds or removes several variables with a single write
+ *
+ * @count: number of variables
+ * @names: names of the variables
+ * @values: new values, NULL or an empty string deletes the variable
+ * @opts: how to retrieve environment from flash, defaults are used if NULL
+ *
+ * Description:
+ *  Uses fw_env_open, fw_env_write, fw_env_flush. If any variable cannot be
+ *  set, nothing is written. If the variables end up with the values they
+ *  already had, nothing is written either. Available from API version 2.
+ *
+ * Return:
+ *  0 on success, -1 on failure (modifies errno)
+ *
+ * ERRORS:
+ *  EROFS - some variables ("ethaddr", "serial#") cannot be modified
+ */
+int fw_env_set_many(int count, char *const names[], char *const values[],
+		    struct env_opts *opts);
+
 /**
  * fw_parse_script() - adds or removes multiple variables with a batch script
  *
@@ -136,6 +158,8 @@ int fw_env_write(char *name, char *value);
  *
  * @opts: encryption key, configuration file, defaults are used if NULL
  *
+ * Nothing is written if the variables have the same values as in flash.
+ *
  * Return:
  *  0 on success, -1 on failure (modifies errno)
  */
@@ -16,7 +16,9 @@
 #include "imagetool.h"
 #include "fit_common.h"
 #include "mkimage.h"
+#include <fdt_region.h>
 #include <image.h>
+#include <limits.h>
 #include <string.h>
 #include <stdarg.h>
 #include <version.h>
@@ -24,65 +26,283 @@
 
 static image_header_t header;
 
-static int fit_add_file_data(struct image_tool_params *params, size_t size_inc,
+/*
+ * Upper bounds used to size the FDTs before signing. No hash is larger than
+ * FIT_SIGN_MAX_HASH bytes (SHA-512), no signature or public-key component is
+ * larger than FIT_SIGN_MAX_SIG bytes (RSA-8192) and no cipher key, IV or
+ * padding is larger than FIT_SIGN_MAX_CIPHER bytes. FIT_SIGN_STRINGS covers
+ * the names of the properties which are added.
+ */
+#define FIT_SIGN_MAX_HASH	64
+#define FIT_SIGN_MAX_SIG	1024
+#define FIT_SIGN_MAX_CIPHER	32
+#define FIT_SIGN_STRINGS	256
+
+/* Give up if this much extra space is not enough */
+#define FIT_SIGN_MAX_INC	(16 << 20)
+
+/* Space taken by a property with a @len-byte value, or an empty node */
+#define FIT_PROP_SPACE(len)	(sizeof(struct fdt_property) + \
+				 ALIGN((size_t)(len), FDT_TAGSIZE))
+#define FIT_NODE_SPACE(len)	(2 * FDT_TAGSIZE + \
+				 ALIGN((size_t)(len) + 1, FDT_TAGSIZE))
+
+/**
+ * fit_estimate_growth() - Work out how much space signing needs
+ *
+ * This returns an upper bound on the space needed to add the timestamp,
+ * hashes, signatures and encrypted data to the FIT, and the public keys and
+ * cipher keys to the key-destination FDT, so that everything can be done in a
+ * single pass.
+ *
+ * @fit: FIT to be signed
+ * @comment: Comment to add to signatures, or NULL
+ * @key_incp: Returns the space needed in the key-destination FDT
+ * Return: space needed in the FIT
+ */
+static size_t fit_estimate_growth(const void *fit, const char *comment,
+				  size_t *key_incp)
+{
+	size_t path_len[FDT_MAX_DEPTH];
+	size_t inc, key_inc, paths = 0;
+	int noffset, depth = 0;
+	int sigs = 0;
+
+	inc = FIT_SIGN_STRINGS + FIT_PROP_SPACE(sizeof(fdt32_t));
+	key_inc = FIT_SIGN_STRINGS + FIT_NODE_SPACE(strlen(FIT_SIG_NODENAME)) +
+		FIT_NODE_SPACE(strlen(FIT_CIPHER_NODENAME));
+
+	for (noffset = fdt_next_node(fit, -1, &depth);
+	     noffset >= 0 && depth >= 0;
+	     noffset = fdt_next_node(fit, noffset, &depth)) {
+		const char *name;
+		int hint_len = 0, algo_len = 0, iv_len = 0;
+		int len;
+
+		name = fdt_get_name(fit, noffset, &len);
+		if (!name || depth >= FDT_MAX_DEPTH)
+			continue;
+
+		/* Each path can appear in the hashed-nodes of a signature */
+		path_len[depth] = (depth ? path_len[depth - 1] : 0) + len + 1;
+		paths += path_len[depth] + 1;
+
+		if (!strncmp(name, FIT_HASH_NODENAME,
+			     strlen(FIT_HASH_NODENAME))) {
+			inc += FIT_PROP_SPACE(FIT_SIGN_MAX_HASH);
+		} else if (!strncmp(name, FIT_SIG_NODENAME,
+				    strlen(FIT_SIG_NODENAME))) {
+			sigs++;
+			inc += FIT_PROP_SPACE(FIT_SIGN_MAX_SIG) +
+				FIT_PROP_SPACE(sizeof("mkimage")) +
+				FIT_PROP_SPACE(sizeof(PLAIN_VERSION)) +
+				FIT_PROP_SPACE(comment ? strlen(comment) + 1 :
+					       0) +
+				FIT_PROP_SPACE(sizeof(fdt32_t)) +
+				FIT_PROP_SPACE(2 * sizeof(fdt32_t));
+
+			/* The public key is added as "key-<key-name-hint>" */
+			fdt_getprop(fit, noffset, FIT_KEY_HINT, &hint_len);
+			fdt_getprop(fit, noffset, FIT_ALGO_PROP, &algo_len);
+			key_inc += FIT_NODE_SPACE(hint_len + 4) +
+				FIT_PROP_SPACE(hint_len) +
+				FIT_PROP_SPACE(algo_len) +
+				FIT_PROP_SPACE(sizeof("image")) +
+				2 * FIT_PROP_SPACE(FIT_SIGN_MAX_SIG) +
+				3 * FIT_PROP_SPACE(sizeof(fdt64_t));
+		} else if (!strncmp(name, FIT_CIPHER_NODENAME,
+				    strlen(FIT_CIPHER_NODENAME))) {
+			/* Padded data, data-size-unciphered and iv */
+			inc += FIT_SIGN_MAX_CIPHER +
+				FIT_PROP_SPACE(sizeof(fdt32_t)) +
+				FIT_PROP_SPACE(FIT_SIGN_MAX_CIPHER);
+
+			/* Cipher key node, named after the algo, key and IV */
+			fdt_getprop(fit, noffset, FIT_KEY_HINT, &hint_len);
+			fdt_getprop(fit, noffset, FIT_ALGO_PROP, &algo_len);
+			fdt_getprop(fit, noffset, "iv-name-hint", &iv_len);
+			key_inc += FIT_NODE_SPACE(hint_len + algo_len + iv_len +
+						  6) +
+				FIT_PROP_SPACE(sizeof(fdt32_t)) +
+				2 * FIT_PROP_SPACE(FIT_SIGN_MAX_CIPHER);
+		}
+	}
+
+	/* Each signature can list every node in its hashed-nodes property */
+	inc += sigs * FIT_PROP_SPACE(paths);
+	*key_incp = key_inc;
+
+	return inc;
+}
+
+/**
+ * fit_open_into() - Copy an FDT into a new buffer, with extra space
+ *
+ * @blob: FDT to copy
+ * @size_inc: Extra space to provide
+ * @bufp: Returns the new buffer, which must be freed by the caller
+ * Return: 0 if OK, -ENOMEM if out of memory, other -ve on error
+ */
+static int fit_open_into(const void *blob, size_t size_inc, void **bufp)
+{
+	size_t size = fdt_totalsize(blob) + size_inc;
+	void *buf;
+
+	if (size > INT_MAX)
+		return -ENOSPC;
+	buf = malloc(size);
+	if (!buf)
+		return -ENOMEM;
+	if (fdt_open_into(blob, buf, size)) {
+		free(buf);
+		return -EINVAL;
+	}
+	*bufp = buf;
+
+	return 0;
+}
+
+/**
+ * fit_write_fdt() - Write an FDT to a file, sizing it to suit its contents
+ *
+ * The FDT is packed, then expanded again to @min_size if it is smaller than
+ * that, so that any free space the file had to start with is preserved.
+ *
+ * @cmdname: Command name, for error messages
+ * @fname: File to write
+ * @blob: FDT to write, which must have a size of at least @min_size
+ * @min_size: Minimum size of the FDT, normally its original size
+ * Return: 0 if OK, -EIO on error
+ */
+static int fit_write_fdt(const char *cmdname, const char *fname, void *blob,
+			 int min_size)
+{
+	int size;
+	int fd;
+
+	fdt_pack(blob);
+	if (fdt_totalsize(blob) < min_size)
+		fdt_open_into(blob, blob, min_size);
+	size = fdt_totalsize(blob);
+
+	fd = open(fname, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
+	if (fd < 0) {
+		fprintf(stderr, "%s: Can't open %s: %s\n",
+			cmdname, fname, strerror(errno));
+		return -EIO;
+	}
+	if (write(fd, blob, size) != size) {
+		fprintf(stderr, "%s: Can't write %s: %s\n",
+			cmdname, fname, strerror(errno));
+		close(fd);
+		return -EIO;
+	}
+	close(fd);
+
+	return 0;
+}
+
+/**
+ * fit_add_file_data() - Add hashes, signatures and encrypted data to a FIT
+ *
+ * The FIT and the key-destination FDT are copied into memory with enough
+ * extra space for everything that is added, so that each hash and signature
+ * is calculated only once. The files are written when all is done.
+ *
+ * @params: mkimage parameters
+ * @tmpfile: FIT file to update
+ * Return: 0 if OK, -ve on error
+ */
+static int fit_add_file_data(struct image_tool_params *params,
 			     const char *tmpfile)
 {
-	int tfd, destfd = 0;
-	void *dest_blob = NULL;
-	off_t destfd_size = 0;
-	struct stat sbuf;
-	void *ptr;
-	int ret = 0;
+	struct stat sbuf, dest_sbuf;
+	void *dest_blob = NULL, *dest_old = NULL;
+	void *ptr = NULL, *old;
+	size_t size_inc, key_inc;
+	int old_size, dest_size = 0;
+	int tfd, destfd = -1;
+	int ret;
 
-	tfd = mmap_fdt(params->cmdname, tmpfile, size_inc, &ptr, &sbuf, true,
-		       false);
+	tfd = mmap_fdt(params->cmdname, tmpfile, 0, &old, &sbuf, true, true);
 	if (tfd < 0)
 		return -EIO;
 
 	if (params->keydest) {
-		struct stat dest_sbuf;
-
-		destfd = mmap_fdt(params->cmdname, params->keydest, size_inc,
-				  &dest_blob, &dest_sbuf, false,
-				  false);
+		destfd = mmap_fdt(params->cmdname, params->keydest, 0,
+				  &dest_old, &dest_sbuf, false, true);
 		if (destfd < 0) {
 			ret = -EIO;
 			goto err_keydest;
 		}
-		destfd_size = dest_sbuf.st_size;
+		dest_size = fdt_totalsize(dest_old);
 	}
+	old_size = fdt_totalsize(old);
 
-	/* for first image creation, add a timestamp at offset 0 i.e., root  */
-	if (params->datafile || params->reset_timestamp) {
-		time_t time = imagetool_get_source_date(params->cmdname,
-							sbuf.st_mtime);
-		ret = fit_set_timestamp(ptr, 0, time);
-	}
+	/*
+	 * The estimate should always be enough, but if it is not, double it
+	 * and start again from the original FDTs
+	 */
+	size_inc = fit_estimate_growth(old, params->comment, &key_inc);
+	do {
+		free(ptr);
+		free(dest_blob);
+		ptr = NULL;
+		dest_blob = NULL;
+		debug("Adding data with size_inc=%zx, key_inc=%zx\n", size_inc,
+		      key_inc);
+		ret = fit_open_into(old, size_inc, &ptr);
+		if (!ret && dest_old)
+			ret = fit_open_into(dest_old, key_inc, &dest_blob);
+
+		/* for first image creation, add a timestamp at the root */
+		if (!ret && (params->datafile || params->reset_timestamp)) {
+			time_t time = imagetool_get_source_date(params->cmdname,
+								sbuf.st_mtime);
+			ret = fit_set_timestamp(ptr, 0, time);
+		}
 
-	if (!ret) {
-		ret = fit_cipher_data(params->keydir, dest_blob, ptr,
-				      params->comment,
-				      params->require_keys,
-				      params->engine_id,
-				      params->cmdname);
-	}
+		if (!ret) {
+			ret = fit_cipher_data(params->keydir, dest_blob, ptr,
+					      params->comment,
+					      params->require_keys,
+					      params->engine_id,
+					      params->cmdname);
+		}
 
-	if (!ret) {
-		ret = fit_add_verification_data(params->keydir,
-						params->keyfile, dest_blob, ptr,
-						params->comment,
-						params->require_keys,
-						params->engine_id,
-						params->cmdname);
-	}
+		if (!ret) {
+			ret = fit_add_verification_data(params->keydir,
+							params->keyfile,
+							dest_blob, ptr,
+							params->comment,
+							params->require_keys,
+							params->engine_id,
+							params->cmdname);
+		}
+		size_inc *= 2;
+		key_inc *= 2;
+	} while (ret == -ENOSPC && size_inc <= FIT_SIGN_MAX_INC);
 
-	if (dest_blob) {
-		munmap(dest_blob, destfd_size);
+	/* Unmap the files before they are overwritten */
+	if (dest_old) {
+		munmap(dest_old, dest_sbuf.st_size);
 		close(destfd);
 	}
+	munmap(old, sbuf.st_size);
+	close(tfd);
+
+	if (!ret)
+		ret = fit_write_fdt(params->cmdname, tmpfile, ptr, old_size);
+	if (!ret && dest_blob)
+		ret = fit_write_fdt(params->cmdname, params->keydest,
+				    dest_blob, dest_size);
+	free(dest_blob);
+	free(ptr);
+
+	return ret;
 
 err_keydest:
-	munmap(ptr, sbuf.st_size);
+	munmap(old, sbuf.st_size);
 	close(tfd);
 	return ret;
 }
@@ -126,11 +346,11 @@ static int fdt_property_file(struct image_tool_params *params,
 			     void *fdt, const char *name, const char *fname)
 {
 	struct stat sbuf;
-	void *ptr;
-	int ret;
+	void *ptr, *data;
+	int ret = -1;
 	int fd;
 
-	fd = open(fname, O_RDWR | O_BINARY);
+	fd = open(fname, O_RDONLY | O_BINARY);
 	if (fd < 0) {
 		fprintf(stderr, "%s: Can't open %s: %s\n",
 			params->cmdname, fname, strerror(errno));
@@ -146,18 +366,23 @@ static int fdt_property_file(struct image_tool_params *params,
 	ret = fdt_property_placeholder(fdt, "data", sbuf.st_size, &ptr);
 	if (ret)
 		goto err;
-	ret = read(fd, ptr, sbuf.st_size);
-	if (ret != sbuf.st_size) {
-		fprintf(stderr, "%s: Can't read %s: %s\n",
-			params->cmdname, fname, strerror(errno));
-		goto err;
+
+	/* Map the file rather than reading it, since it may be large */
+	if (sbuf.st_size) {
+		data = mmap(NULL, sbuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (data == MAP_FAILED) {
+			fprintf(stderr, "%s: Can't read %s: %s\n",
+				params->cmdname, fname, strerror(errno));
+			ret = -1;
+			goto err;
+		}
+		memcpy(ptr, data, sbuf.st_size);
+		munmap(data, sbuf.st_size);
 	}
-	close(fd);
 
-	return 0;
 err:
 	close(fd);
-	return -1;
+	return ret;
 }
 
 static int fdt_property_strf(void *fdt, const char *name, const char *fmt, ...)
@@ -425,6 +650,108 @@ err_buf:
 	return -1;
 }
 
+#if defined(__linux__) && defined(__GLIBC__) && \
+	(__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+#define HAVE_COPY_FILE_RANGE
+#endif
+
+/**
+ * struct fit_data_ref - location of the data for an image
+ *
+ * @node: Offset of the image node
+ * @src: Offset of the data in the source file
+ * @dst: Offset of the data in the external-data area
+ * @len: Size of the data in bytes
+ */
+struct fit_data_ref {
+	int node;
+	off_t src;
+	int dst;
+	int len;
+};
+
+/**
+ * fit_copy_range() - Copy part of one file to another
+ *
+ * This uses copy_file_range() where available, so that the kernel can share
+ * or copy the data without it passing through mkimage. Otherwise, or if that
+ * fails (e.g. across filesystems on older kernels), the data is written from
+ * a mapping of the source file.
+ *
+ * @in_fd: Source file
+ * @in_map: Mapping of the whole source file
+ * @in_off: Offset of the data in the source file
+ * @out_fd: Destination file
+ * @out_off: Offset of the data in the destination file
+ * @len: Number of bytes to copy
+ * Return: 0 if OK, -EIO on error
+ */
+static int fit_copy_range(int in_fd, const void *in_map, off_t in_off,
+			  int out_fd, off_t out_off, size_t len)
+{
+	ssize_t done;
+
+#ifdef HAVE_COPY_FILE_RANGE
+	while (len) {
+		done = copy_file_range(in_fd, &in_off, out_fd, &out_off, len,
+				       0);
+		if (done <= 0)
+			break;
+		len -= done;
+	}
+#endif
+	while (len) {
+		done = pwrite(out_fd, in_map + in_off, len, out_off);
+		if (done < 0 && errno == EINTR)
+			continue;
+		if (done <= 0)
+			return -EIO;
+		in_off += done;
+		out_off += done;
+		len -= done;
+	}
+
+	return 0;
+}
+
+/**
+ * fit_get_data_refs() - Find the image nodes which have data to move
+ *
+ * @fdt: FIT to check
+ * @prop: Property holding the data ("data") or its offset ("data-offset")
+ * @refsp: Returns a list of the image nodes with that property, in order,
+ *	with only @node filled in. The caller must free this
+ * Return: number of image nodes found, or -ve on error
+ */
+static int fit_get_data_refs(const void *fdt, const char *prop,
+			     struct fit_data_ref **refsp)
+{
+	struct fit_data_ref *refs;
+	int images;
+	int count;
+	int node;
+
+	images = fdt_path_offset(fdt, FIT_IMAGES_PATH);
+	if (images < 0) {
+		debug("%s: Cannot find /images node: %d\n", __func__, images);
+		return -EINVAL;
+	}
+	refs = calloc(fdtdec_get_child_count(fdt, images) + 1, sizeof(*refs));
+	if (!refs)
+		return -ENOMEM;
+
+	count = 0;
+	for (node = fdt_first_subnode(fdt, images);
+	     node >= 0;
+	     node = fdt_next_subnode(fdt, node)) {
+		if (fdt_getprop(fdt, node, prop, NULL))
+			refs[count++].node = node;
+	}
+	*refsp = refs;
+
+	return count;
+}
+
 /**
  * fit_extract_data() - Move all data outside the FIT
  *
@@ -433,93 +760,103 @@ err_buf:
  * using an offset into that area. The 'data' properties turn into
  * 'data-offset' properties.
  *
+ * A new file is written, then renamed over the original. The data is copied
+ * between the files with fit_copy_range(), which avoids reading it into
+ * mkimage where possible. The FDT is updated in a private mapping of the
+ * original file, last image first, so that each property change only moves
+ * the (already small) part of the FDT after it. It is written once its size
+ * is known.
+ *
  * This function cannot cope with FITs with 'data-offset' properties. All
  * data must be in 'data' properties on entry.
  */
 static int fit_extract_data(struct image_tool_params *params, const char *fname)
 {
-	void *buf = NULL;
-	int buf_ptr;
-	int fit_size, new_size;
-	int fd;
+	char newname[MKIMAGE_MAX_TMPFILE_LEN + 4];
+	struct fit_data_ref *refs = NULL;
+	void *src, *fdt = MAP_FAILED;
+	int new_size, fdt_size;
+	int fd, out_fd = -1;
 	struct stat sbuf;
-	void *fdt;
+	int buf_ptr;
+	int count;
 	int ret;
-	int images;
-	int node;
-	int image_number;
+	int i;
 	int align_size;
 
 	align_size = params->bl_len ? params->bl_len : 4;
-	fd = mmap_fdt(params->cmdname, fname, 0, &fdt, &sbuf, false, false);
+	fd = mmap_fdt(params->cmdname, fname, 0, &src, &sbuf, false, true);
 	if (fd < 0)
 		return -EIO;
-	fit_size = fdt_totalsize(fdt);
 
-	images = fdt_path_offset(fdt, FIT_IMAGES_PATH);
-	if (images < 0) {
-		debug("%s: Cannot find /images node: %d\n", __func__, images);
-		ret = -EINVAL;
-		goto err_munmap;
+	/* Writes to this mapping are not seen by the file, nor by @src */
+	fdt = mmap(NULL, sbuf.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+		   fd, 0);
+	if (fdt == MAP_FAILED) {
+		fprintf(stderr, "%s: Can't map %s: %s\n",
+			params->cmdname, fname, strerror(errno));
+		ret = -EIO;
+		goto err;
 	}
-	image_number = fdtdec_get_child_count(fdt, images);
 
-	/*
-	 * Allocate space to hold the image data we will extract,
-	 * extral space allocate for image alignment to prevent overflow.
-	 */
-	buf = calloc(1, fit_size + (align_size * image_number));
-	if (!buf) {
-		ret = -ENOMEM;
-		goto err_munmap;
+	count = fit_get_data_refs(fdt, FIT_DATA_PROP, &refs);
+	if (count < 0) {
+		ret = count;
+		goto err;
 	}
-	buf_ptr = 0;
 
-	for (node = fdt_first_subnode(fdt, images);
-	     node >= 0;
-	     node = fdt_next_subnode(fdt, node)) {
+	/* Lay out the external data, in image order */
+	buf_ptr = 0;
+	for (i = 0; i < count; i++) {
+		struct fit_data_ref *ref = &refs[i];
 		const char *data;
-		int len;
 
-		data = fdt_getprop(fdt, node, FIT_DATA_PROP, &len);
-		if (!data)
-			continue;
-		memcpy(buf + buf_ptr, data, len);
-		debug("Extracting data size %x\n", len);
+		data = fdt_getprop(fdt, ref->node, FIT_DATA_PROP, &ref->len);
+		ref->src = data - (const char *)fdt;
+		ref->dst = buf_ptr;
+		debug("Extracting data size %x\n", ref->len);
+		buf_ptr += ALIGN(ref->len, align_size);
+	}
 
-		ret = fdt_delprop(fdt, node, FIT_DATA_PROP);
+	/* Update the FDT, starting from the end to limit what is moved */
+	for (i = count - 1; i >= 0; i--) {
+		struct fit_data_ref *ref = &refs[i];
+
+		ret = fdt_delprop(fdt, ref->node, FIT_DATA_PROP);
 		if (ret) {
 			ret = -EPERM;
-			goto err_munmap;
+			goto err;
 		}
 		if (params->external_offset > 0) {
 			/* An external offset positions the data absolutely. */
-			fdt_setprop_u32(fdt, node, FIT_DATA_POSITION_PROP,
-					params->external_offset + buf_ptr);
+			ret = fdt_setprop_u32(fdt, ref->node,
+					      FIT_DATA_POSITION_PROP,
+					      params->external_offset +
+					      ref->dst);
 		} else {
-			fdt_setprop_u32(fdt, node, FIT_DATA_OFFSET_PROP,
-					buf_ptr);
+			ret = fdt_setprop_u32(fdt, ref->node,
+					      FIT_DATA_OFFSET_PROP, ref->dst);
+		}
+		if (!ret)
+			ret = fdt_setprop_u32(fdt, ref->node,
+					      FIT_DATA_SIZE_PROP, ref->len);
+		if (ret) {
+			debug("%s: Failed to write property: %s\n", __func__,
+			      fdt_strerror(ret));
+			ret = -EINVAL;
+			goto err;
 		}
-		fdt_setprop_u32(fdt, node, FIT_DATA_SIZE_PROP, len);
-		buf_ptr += ALIGN(len, align_size);
 	}
 
 	/* Pack the FDT and place the data after it */
 	fdt_pack(fdt);
 
-	new_size = fdt_totalsize(fdt);
-	new_size = ALIGN(new_size, align_size);
+	fdt_size = fdt_totalsize(fdt);
+	new_size = ALIGN(fdt_size, align_size);
 	fdt_set_totalsize(fdt, new_size);
-	debug("Size reduced from %x to %x\n", fit_size, fdt_totalsize(fdt));
+	debug("Size reduced from %x to %x\n", fdt_totalsize(src),
+	      fdt_totalsize(fdt));
 	debug("External data size %x\n", buf_ptr);
-	munmap(fdt, sbuf.st_size);
-
-	if (ftruncate(fd, new_size)) {
-		debug("%s: Failed to truncate file: %s\n", __func__,
-		      strerror(errno));
-		ret = -EIO;
-		goto err;
-	}
 
 	/* Check if an offset for the external data was set. */
 	if (params->external_offset > 0) {
@@ -529,75 +866,147 @@ static int fit_extract_data(struct image_tool_params *params, const char *fname)
 			ret = -EINVAL;
 			goto err;
 		}
-		new_size = params->external_offset;
 	}
-	if (lseek(fd, new_size, SEEK_SET) < 0) {
-		debug("%s: Failed to seek to end of file: %s\n", __func__,
+
+	snprintf(newname, sizeof(newname), "%s.new", fname);
+	out_fd = open(newname, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
+	if (out_fd < 0) {
+		fprintf(stderr, "%s: Can't open %s: %s\n",
+			params->cmdname, newname, strerror(errno));
+		ret = -EIO;
+		goto err;
+	}
+	/* The new file replaces the old one, so give it the same mode */
+	if (fchmod(out_fd, sbuf.st_mode & 07777)) {
+		fprintf(stderr, "%s: Can't set mode of %s: %s\n",
+			params->cmdname, newname, strerror(errno));
+		ret = -EIO;
+		goto err;
+	}
+
+	/*
+	 * Copy the data, then write the FDT in front of it. Any padding is
+	 * left as holes, which read as zero.
+	 */
+	for (i = 0; i < count; i++) {
+		off_t base = params->external_offset > 0 ?
+			params->external_offset : new_size;
+
+		ret = fit_copy_range(fd, src, refs[i].src, out_fd,
+				     base + refs[i].dst, refs[i].len);
+		if (ret) {
+			debug("%s: Failed to write external data to file %s\n",
+			      __func__, strerror(errno));
+			goto err;
+		}
+	}
+	if (ftruncate(out_fd, (params->external_offset > 0 ?
+			       params->external_offset : new_size) + buf_ptr) ||
+	    pwrite(out_fd, fdt, fdt_size, 0) != fdt_size) {
+		debug("%s: Failed to write file: %s\n", __func__,
 		      strerror(errno));
 		ret = -EIO;
 		goto err;
 	}
-	if (write(fd, buf, buf_ptr) != buf_ptr) {
-		debug("%s: Failed to write external data to file %s\n",
-		      __func__, strerror(errno));
+	close(out_fd);
+	out_fd = -1;
+
+	if (rename(newname, fname)) {
+		fprintf(stderr, "%s: Can't rename %s to %s: %s\n",
+			params->cmdname, newname, fname, strerror(errno));
 		ret = -EIO;
 		goto err;
 	}
-	free(buf);
-	close(fd);
-	return 0;
+	ret = 0;
 
-err_munmap:
-	munmap(fdt, sbuf.st_size);
 err:
-	free(buf);
+	if (out_fd >= 0) {
+		close(out_fd);
+		unlink(newname);
+	}
+	if (fdt != MAP_FAILED)
+		munmap(fdt, sbuf.st_size);
+	munmap(src, sbuf.st_size);
+	free(refs);
 	close(fd);
 	return ret;
 }
 
+/**
+ * fit_import_data() - Move all external data inside the FIT
+ *
+ * This is the reverse of fit_extract_data(). The new FIT is built in a
+ * mapping of a new file, which is then renamed over the original. The data
+ * properties are added last image first, so that each one only moves the
+ * (small) part of the FDT after it.
+ */
 static int fit_import_data(struct image_tool_params *params, const char *fname)
 {
-	void *fdt, *old_fdt;
-	int fit_size, new_size, size, data_base;
-	int fd;
+	char newname[MKIMAGE_MAX_TMPFILE_LEN + 4];
+	struct fit_data_ref *refs = NULL;
+	void *fdt = MAP_FAILED, *old_fdt;
+	int fit_size, new_size, data_base;
+	int fd, out_fd = -1;
+	int size = 0;
 	struct stat sbuf;
+	int count;
 	int ret;
-	int images;
-	int node;
+	int i;
 
-	fd = mmap_fdt(params->cmdname, fname, 0, &old_fdt, &sbuf, false, false);
+	fd = mmap_fdt(params->cmdname, fname, 0, &old_fdt, &sbuf, false, true);
 	if (fd < 0)
 		return -EIO;
 	fit_size = fdt_totalsize(old_fdt);
 	data_base = ALIGN(fit_size, 4);
 
-	/* Allocate space to hold the new FIT */
+	/* Nothing to do if all the data is already inside the FIT */
+	count = fit_get_data_refs(old_fdt, FIT_DATA_OFFSET_PROP, &refs);
+	if (count <= 0) {
+		ret = count;
+		goto err;
+	}
+
+	/* Create the new FIT, with space to hold the data */
 	size = sbuf.st_size + 16384;
-	fdt = calloc(1, size);
-	if (!fdt) {
-		fprintf(stderr, "%s: Failed to allocate memory (%d bytes)\n",
-			__func__, size);
-		ret = -ENOMEM;
-		goto err_munmap;
+	snprintf(newname, sizeof(newname), "%s.new", fname);
+	out_fd = open(newname, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0666);
+	if (out_fd < 0) {
+		fprintf(stderr, "%s: Can't open %s: %s\n",
+			params->cmdname, newname, strerror(errno));
+		ret = -EIO;
+		goto err;
+	}
+	/* The new file replaces the old one, so give it the same mode */
+	if (fchmod(out_fd, sbuf.st_mode & 07777)) {
+		fprintf(stderr, "%s: Can't set mode of %s: %s\n",
+			params->cmdname, newname, strerror(errno));
+		ret = -EIO;
+		goto err;
+	}
+	if (ftruncate(out_fd, size)) {
+		fprintf(stderr, "%s: Can't expand %s: %s\n",
+			params->cmdname, newname, strerror(errno));
+		ret = -EIO;
+		goto err;
+	}
+	fdt = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, out_fd, 0);
+	if (fdt == MAP_FAILED) {
+		fprintf(stderr, "%s: Can't map %s: %s\n",
+			params->cmdname, newname, strerror(errno));
+		ret = -EIO;
+		goto err;
 	}
 	ret = fdt_open_into(old_fdt, fdt, size);
 	if (ret) {
 		debug("%s: Failed to expand FIT: %s\n", __func__,
-		      fdt_strerror(errno));
+		      fdt_strerror(ret));
 		ret = -EINVAL;
-		goto err_munmap;
-	}
-
-	images = fdt_path_offset(fdt, FIT_IMAGES_PATH);
-	if (images < 0) {
-		debug("%s: Cannot find /images node: %d\n", __func__, images);
-		ret = -EINVAL;
-		goto err_munmap;
+		goto err;
 	}
 
-	for (node = fdt_first_subnode(fdt, images);
-	     node >= 0;
-	     node = fdt_next_subnode(fdt, node)) {
+	/* Node offsets are the same in both FDTs until the first change */
+	for (i = count - 1; i >= 0; i--) {
+		int node = refs[i].node;
 		int buf_ptr;
 		int len;
 
@@ -605,6 +1014,13 @@ static int fit_import_data(struct image_tool_params *params, const char *fname)
 		len = fdtdec_get_int(fdt, node, "data-size", -1);
 		if (buf_ptr == -1 || len == -1)
 			continue;
+		if ((off_t)data_base + buf_ptr + len > sbuf.st_size) {
+			fprintf(stderr, "%s: Data for '%s' is outside %s\n",
+				params->cmdname, fdt_get_name(fdt, node, NULL),
+				fname);
+			ret = -EINVAL;
+			goto err;
+		}
 		debug("Importing data size %x\n", len);
 
 		ret = fdt_setprop(fdt, node, "data",
@@ -613,100 +1029,44 @@ static int fit_import_data(struct image_tool_params *params, const char *fname)
 			debug("%s: Failed to write property: %s\n", __func__,
 			      fdt_strerror(ret));
 			ret = -EINVAL;
-			goto err_munmap;
+			goto err;
 		}
 	}
 
-	munmap(old_fdt, sbuf.st_size);
-
-	/* Close the old fd so we can re-use it. */
-	close(fd);
-
-	/* Pack the FDT and place the data after it */
+	/* Pack the FDT and drop the unused space */
 	fdt_pack(fdt);
 
 	new_size = fdt_totalsize(fdt);
 	debug("Size expanded from %x to %x\n", fit_size, new_size);
-
-	fd = open(fname, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0666);
-	if (fd < 0) {
-		fprintf(stderr, "%s: Can't open %s: %s\n",
-			params->cmdname, fname, strerror(errno));
+	munmap(fdt, size);
+	fdt = MAP_FAILED;
+	if (ftruncate(out_fd, new_size)) {
+		debug("%s: Failed to truncate file: %s\n", __func__,
+		      strerror(errno));
 		ret = -EIO;
 		goto err;
 	}
-	if (write(fd, fdt, new_size) != new_size) {
-		debug("%s: Failed to write external data to file %s\n",
-		      __func__, strerror(errno));
+	close(out_fd);
+	out_fd = -1;
+
+	if (rename(newname, fname)) {
+		fprintf(stderr, "%s: Can't rename %s to %s: %s\n",
+			params->cmdname, newname, fname, strerror(errno));
 		ret = -EIO;
 		goto err;
 	}
+	ret = 0;
 
-	free(fdt);
-	close(fd);
-	return 0;
-
-err_munmap:
-	munmap(old_fdt, sbuf.st_size);
 err:
-	free(fdt);
-	close(fd);
-	return ret;
-}
-
-static int copyfile(const char *src, const char *dst)
-{
-	int fd_src = -1, fd_dst = -1;
-	void *buf = NULL;
-	ssize_t size;
-	size_t count;
-	int ret = -1;
-
-	fd_src = open(src, O_RDONLY);
-	if (fd_src < 0) {
-		printf("Can't open file %s (%s)\n", src, strerror(errno));
-		goto out;
+	if (fdt != MAP_FAILED)
+		munmap(fdt, size);
+	if (out_fd >= 0) {
+		close(out_fd);
+		unlink(newname);
 	}
-
-	fd_dst = open(dst, O_WRONLY | O_CREAT, 0666);
-	if (fd_dst < 0) {
-		printf("Can't open file %s (%s)\n", dst, strerror(errno));
-		goto out;
-	}
-
-	buf = calloc(1, 512);
-	if (!buf) {
-		printf("Can't allocate buffer to copy file\n");
-		goto out;
-	}
-
-	while (1) {
-		size = read(fd_src, buf, 512);
-		if (size < 0) {
-			printf("Can't read file %s\n", src);
-			goto out;
-		}
-		if (!size)
-			break;
-
-		count = size;
-		size = write(fd_dst, buf, count);
-		if (size < 0) {
-			printf("Can't write file %s\n", dst);
-			goto out;
-		}
-	}
-
-	ret = 0;
-
- out:
-	if (fd_src >= 0)
-		close(fd_src);
-	if (fd_dst >= 0)
-		close(fd_dst);
-	if (buf)
-		free(buf);
-
+	munmap(old_fdt, sbuf.st_size);
+	free(refs);
+	close(fd);
 	return ret;
 }
 
@@ -725,9 +1085,7 @@ static int copyfile(const char *src, const char *dst)
 static int fit_handle_file(struct image_tool_params *params)
 {
 	char tmpfile[MKIMAGE_MAX_TMPFILE_LEN];
-	char bakfile[MKIMAGE_MAX_TMPFILE_LEN + 4] = {0};
 	char cmd[MKIMAGE_MAX_DTC_CMDLINE_LEN];
-	size_t size_inc;
 	int ret;
 
 	/* Flattened Image Tree (FIT) format  handling */
@@ -775,34 +1133,8 @@ static int fit_handle_file(struct image_tool_params *params)
 	if (ret)
 		goto err_system;
 
-	/*
-	 * Copy the tmpfile to bakfile, then in the following loop
-	 * we copy bakfile to tmpfile. So we always start from the
-	 * beginning.
-	 */
-	sprintf(bakfile, "%s%s", tmpfile, ".bak");
-	rename(tmpfile, bakfile);
-
-	/*
-	 * Set hashes for images in the blob. Unfortunately we may need more
-	 * space in either FDT, so keep trying until we succeed.
-	 *
-	 * Note: this is pretty inefficient for signing, since we must
-	 * calculate the signature every time. It would be better to calculate
-	 * all the data and then store it in a separate step. However, this
-	 * would be considerably more complex to implement. Generally a few
-	 * steps of this loop is enough to sign with several keys.
-	 */
-	for (size_inc = 0; size_inc < 64 * 1024; size_inc += 1024) {
-		if (copyfile(bakfile, tmpfile) < 0) {
-			printf("Can't copy %s to %s\n", bakfile, tmpfile);
-			ret = -EIO;
-			break;
-		}
-		ret = fit_add_file_data(params, size_inc, tmpfile);
-		if (!ret || ret != -ENOSPC)
-			break;
-	}
+	/* Set hashes and signatures for images in the blob */
+	ret = fit_add_file_data(params, tmpfile);
 
 	if (ret) {
 		fprintf(stderr, "%s Can't add hashes to FIT blob: %d\n",
@@ -822,16 +1154,13 @@ static int fit_handle_file(struct image_tool_params *params)
 				params->cmdname, tmpfile, params->imagefile,
 				strerror (errno));
 		unlink (tmpfile);
-		unlink(bakfile);
 		unlink (params->imagefile);
 		return EXIT_FAILURE;
 	}
-	unlink(bakfile);
 	return EXIT_SUCCESS;
 
 err_system:
 	unlink(tmpfile);
-	unlink(bakfile);
 	return -1;
 }
 
@@ -12,6 +12,7 @@
 #include <bootm.h>
 #include <fdt_region.h>
 #include <image.h>
+#include <pthread.h>
 #include <version.h>
 
 /**
@@ -44,6 +45,211 @@ static int fit_set_hash_value(void *fit, int noffset, uint8_t *value,
 	return 0;
 }
 
+/* Most threads to use for calculating hashes */
+#define FIT_HASH_MAX_THREADS	64
+
+/**
+ * struct fit_hash_entry - hash value calculated ahead of time
+ *
+ * @image_name: Name of the image node
+ * @node_name: Name of the hash node
+ * @algo: Hash algorithm
+ * @data: Image data, only valid while the hashes are calculated
+ * @size: Size of image data in bytes
+ * @value: Hash value
+ * @value_len: Length of hash value in bytes
+ * @ret: Result of calculate_hash()
+ */
+struct fit_hash_entry {
+	char *image_name;
+	char *node_name;
+	char *algo;
+	const void *data;
+	size_t size;
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+	int ret;
+};
+
+/**
+ * struct fit_hash_cache - hash values calculated by fit_hash_prepare()
+ *
+ * @entry: Hash values, largest image first
+ * @count: Number of entries
+ * @next: Next entry for a worker thread to calculate
+ * @lock: Protects @next
+ */
+static struct fit_hash_cache {
+	struct fit_hash_entry *entry;
+	int count;
+	int next;
+	pthread_mutex_t lock;
+} hash_cache = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static void *fit_hash_worker(void *arg)
+{
+	struct fit_hash_cache *cache = arg;
+	struct fit_hash_entry *ent;
+
+	while (1) {
+		pthread_mutex_lock(&cache->lock);
+		ent = cache->next < cache->count ?
+			&cache->entry[cache->next++] : NULL;
+		pthread_mutex_unlock(&cache->lock);
+		if (!ent)
+			break;
+		ent->ret = calculate_hash(ent->data, ent->size, ent->algo,
+					  ent->value, &ent->value_len);
+	}
+
+	return NULL;
+}
+
+static int fit_hash_cmp(const void *a, const void *b)
+{
+	const struct fit_hash_entry *ea = a, *eb = b;
+
+	return ea->size < eb->size ? 1 : ea->size > eb->size ? -1 : 0;
+}
+
+static void fit_hash_free(void)
+{
+	int i;
+
+	for (i = 0; i < hash_cache.count; i++) {
+		free(hash_cache.entry[i].image_name);
+		free(hash_cache.entry[i].node_name);
+		free(hash_cache.entry[i].algo);
+	}
+	free(hash_cache.entry);
+	hash_cache.entry = NULL;
+	hash_cache.count = 0;
+	hash_cache.next = 0;
+}
+
+static int fit_hash_add(const void *fit, int image_noffset)
+{
+	struct fit_hash_entry *ent;
+	const void *data;
+	size_t size;
+	int noffset;
+	char *algo;
+
+	/* Any errors are reported when the hashes are used */
+	if (fit_image_get_data_and_size(fit, image_noffset, &data, &size))
+		return 0;
+
+	for (noffset = fdt_first_subnode(fit, image_noffset);
+	     noffset >= 0;
+	     noffset = fdt_next_subnode(fit, noffset)) {
+		if (strncmp(fit_get_name(fit, noffset, NULL), FIT_HASH_NODENAME,
+			    strlen(FIT_HASH_NODENAME)) ||
+		    fit_image_hash_get_algo(fit, noffset, &algo))
+			continue;
+
+		ent = realloc(hash_cache.entry,
+			      (hash_cache.count + 1) * sizeof(*ent));
+		if (!ent)
+			return -ENOMEM;
+		hash_cache.entry = ent;
+		ent += hash_cache.count++;
+		memset(ent, '\0', sizeof(*ent));
+		ent->image_name = strdup(fit_get_name(fit, image_noffset,
+						      NULL));
+		ent->node_name = strdup(fit_get_name(fit, noffset, NULL));
+		ent->algo = strdup(algo);
+		ent->data = data;
+		ent->size = size;
+		if (!ent->image_name || !ent->node_name || !ent->algo)
+			return -ENOMEM;
+	}
+
+	return 0;
+}
+
+/**
+ * fit_hash_prepare() - Calculate the hashes for a set of images in parallel
+ *
+ * This calculates the value for every hash node of the given images, with a
+ * thread for each CPU, so that fit_image_hash_value() can return it later.
+ * The largest images are started first. The FIT must not change while this
+ * runs, but may change afterwards, since hash nodes are looked up by name.
+ *
+ * Any previous values are discarded. Call fit_hash_free() when done.
+ *
+ * @fit: FIT containing the images
+ * @images: Offsets of the image nodes
+ * @count: Number of image nodes
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+static int fit_hash_prepare(const void *fit, const int *images, int count)
+{
+	pthread_t threads[FIT_HASH_MAX_THREADS];
+	int nthreads, started;
+	long cpus;
+	int i;
+
+	fit_hash_free();
+	for (i = 0; i < count; i++) {
+		if (fit_hash_add(fit, images[i])) {
+			fit_hash_free();
+			return -ENOMEM;
+		}
+	}
+	qsort(hash_cache.entry, hash_cache.count, sizeof(*hash_cache.entry),
+	      fit_hash_cmp);
+
+	/* This thread does some of the work too */
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	nthreads = hash_cache.count < FIT_HASH_MAX_THREADS ?
+		hash_cache.count : FIT_HASH_MAX_THREADS;
+	if (cpus > 0 && cpus < nthreads)
+		nthreads = cpus;
+	for (started = 0; started < nthreads - 1; started++) {
+		if (pthread_create(&threads[started], NULL, fit_hash_worker,
+				   &hash_cache))
+			break;
+	}
+	debug("Hashing %d nodes with %d threads\n", hash_cache.count,
+	      started + 1);
+	fit_hash_worker(&hash_cache);
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+
+	return 0;
+}
+
+int fit_image_hash_value(const void *fit, int noffset, const char *algo,
+			 const void *data, size_t size, uint8_t *value,
+			 int *value_len)
+{
+	const char *image_name, *node_name;
+	int i;
+
+	if (hash_cache.count) {
+		image_name = fit_get_name(fit, fdt_parent_offset(fit, noffset),
+					  NULL);
+		node_name = fit_get_name(fit, noffset, NULL);
+		for (i = 0; i < hash_cache.count; i++) {
+			struct fit_hash_entry *ent = &hash_cache.entry[i];
+
+			if (ent->size != size || strcmp(ent->algo, algo) ||
+			    strcmp(ent->node_name, node_name) ||
+			    strcmp(ent->image_name, image_name))
+				continue;
+			if (ent->ret)
+				return ent->ret;
+			memcpy(value, ent->value, ent->value_len);
+			*value_len = ent->value_len;
+			return 0;
+		}
+	}
+
+	return calculate_hash(data, size, algo, value, value_len);
+}
+
 /**
  * fit_image_process_hash - Process a single subnode of the images/ node
  *
@@ -74,7 +280,8 @@ static int fit_image_process_hash(void *fit, const char *image_name,
 		return -ENOENT;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+	if (fit_image_hash_value(fit, noffset, algo, data, size, value,
+				 &value_len)) {
 		printf("Unsupported hash algorithm (%s) for '%s' hash node in '%s' image node\n",
 		       algo, node_name, image_name);
 		return -EPROTONOSUPPORT;
@@ -1055,6 +1262,39 @@ int fit_cipher_data(const char *keydir, void *keydest, void *fit,
 	return 0;
 }
 
+/**
+ * fit_hash_prepare_images() - Calculate the hashes for all images in parallel
+ *
+ * @fit: FIT containing the images
+ * @images_noffset: Offset of the /images node
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+static int fit_hash_prepare_images(const void *fit, int images_noffset)
+{
+	int *images = NULL;
+	int count = 0;
+	int noffset;
+	int ret;
+
+	for (noffset = fdt_first_subnode(fit, images_noffset);
+	     noffset >= 0;
+	     noffset = fdt_next_subnode(fit, noffset)) {
+		int *new_images;
+
+		new_images = realloc(images, (count + 1) * sizeof(*images));
+		if (!new_images) {
+			free(images);
+			return -ENOMEM;
+		}
+		images = new_images;
+		images[count++] = noffset;
+	}
+	ret = fit_hash_prepare(fit, images, count);
+	free(images);
+
+	return ret;
+}
+
 int fit_add_verification_data(const char *keydir, const char *keyfile,
 			      void *keydest, void *fit, const char *comment,
 			      int require_keys, const char *engine_id,
@@ -1072,6 +1312,16 @@ int fit_add_verification_data(const char *keydir, const char *keyfile,
 		return images_noffset;
 	}
 
+	/*
+	 * Calculate the image hashes in parallel. They are written to the FIT
+	 * below in the usual order, so the output does not change.
+	 */
+	ret = fit_hash_prepare_images(fit, images_noffset);
+	if (ret) {
+		printf("Out of memory preparing image hashes\n");
+		return ret;
+	}
+
 	/* Process its subnodes, print out component images details */
 	for (noffset = fdt_first_subnode(fit, images_noffset);
 	     noffset >= 0;
@@ -1084,19 +1334,20 @@ int fit_add_verification_data(const char *keydir, const char *keyfile,
 				fit, noffset, comment, require_keys, engine_id,
 				cmdname);
 		if (ret)
-			return ret;
+			goto out;
 	}
 
 	/* If there are no keys, we can't sign configurations */
 	if (!IMAGE_ENABLE_SIGN || !(keydir || keyfile))
-		return 0;
+		goto out;
 
 	/* Find configurations parent node offset */
 	confs_noffset = fdt_path_offset(fit, FIT_CONFS_PATH);
 	if (confs_noffset < 0) {
 		printf("Can't find images parent node '%s' (%s)\n",
 		       FIT_CONFS_PATH, fdt_strerror(confs_noffset));
-		return -ENOENT;
+		ret = -ENOENT;
+		goto out;
 	}
 
 	/* Process its subnodes, print out component images details */
@@ -1108,13 +1359,66 @@ int fit_add_verification_data(const char *keydir, const char *keyfile,
 						       require_keys,
 						       engine_id, cmdname);
 		if (ret)
-			return ret;
+			goto out;
 	}
 
-	return 0;
+out:
+	fit_hash_free();
+
+	return ret;
 }
 
 #ifdef CONFIG_FIT_SIGNATURE
+/**
+ * fit_hash_prepare_config() - Calculate hashes for a configuration's images
+ *
+ * This covers the images loaded by bootm_host_load_images()
+ *
+ * @fit: FIT containing the configuration
+ * @cfg_noffset: Offset of the configuration node
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+static int fit_hash_prepare_config(const void *fit, int cfg_noffset)
+{
+	static const char *const props[] = {
+		FIT_KERNEL_PROP, FIT_FDT_PROP, FIT_RAMDISK_PROP,
+	};
+	int *images = NULL;
+	int count = 0;
+	int i, j, k;
+	int ret;
+
+	for (i = 0; i < ARRAY_SIZE(props); i++) {
+		int num = fit_conf_get_prop_node_count(fit, cfg_noffset,
+						       props[i]);
+
+		for (j = 0; j < num; j++) {
+			int noffset, *new_images;
+
+			noffset = fit_conf_get_prop_node_index(fit, cfg_noffset,
+							       props[i], j);
+			if (noffset < 0)
+				continue;
+			for (k = 0; k < count && images[k] != noffset; k++)
+				;
+			if (k < count)
+				continue;
+			new_images = realloc(images,
+					     (count + 1) * sizeof(*images));
+			if (!new_images) {
+				free(images);
+				return -ENOMEM;
+			}
+			images = new_images;
+			images[count++] = noffset;
+		}
+	}
+	ret = fit_hash_prepare(fit, images, count);
+	free(images);
+
+	return ret;
+}
+
 int fit_check_sign(const void *fit, const void *key,
 		   const char *fit_uname_config)
 {
@@ -1131,7 +1435,13 @@ int fit_check_sign(const void *fit, const void *key,
 	if (ret)
 		return ret;
 	printf("Verified OK, loading images\n");
+
+	/* Hash the images in parallel, then check them in the usual order */
+	ret = fit_hash_prepare_config(fit, cfg_noffset);
+	if (ret)
+		return ret;
 	ret = bootm_host_load_images(fit, cfg_noffset);
+	fit_hash_free();
 
 	return ret;
 }
@@ -7,6 +7,7 @@
 
 #include <assert.h>
 #include <ctype.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <regex.h>
 #include <stdarg.h>
@@ -22,6 +23,40 @@
 
 #define MAX_LINE_LEN 500
 
+/* Maximum call depth tracked when building folded stacks */
+#define MAX_STACK_DEPTH	256
+
+/* From common/bootstage.c */
+#define BOOTSTAGE_VERSION	0
+#define BOOTSTAGE_MAGIC		0xb00757a3
+#define BOOTSTAGEF_ERROR	(1 << 0)
+
+/*
+ * Header of a bootstage stash, as written by 'bootstage stash'. The
+ * struct bootstage_record entries which follow it hold a ulong and a pointer,
+ * so their layout depends on whether U-Boot is 32- or 64-bit.
+ */
+struct bootstage_hdr {
+	uint32_t version;
+	uint32_t count;
+	uint32_t size;
+	uint32_t magic;
+	uint32_t next_id;
+};
+
+/* Size of struct bootstage_record in the stash, for 64- and 32-bit U-Boot */
+#define BOOTSTAGE_REC_SIZE_64	32
+#define BOOTSTAGE_REC_SIZE_32	20
+
+/* A record read from a bootstage stash */
+struct bootstage_info {
+	uint64_t time_us;	/* Time of mark, or accumulated time */
+	uint32_t start_us;	/* Start of the last interval, if accumulated */
+	const char *name;
+	int flags;
+	int id;
+};
+
 enum {
 	FUNCF_TRACE	= 1 << 0,	/* Include this function in trace */
 };
@@ -31,6 +66,7 @@ struct func_info {
 	const char *name;
 	unsigned long code_size;
 	unsigned long call_count;
+	unsigned long sample_count;
 	unsigned flags;
 	/* the section this function is in */
 	struct objsection_info *objsection;
@@ -55,6 +91,10 @@ struct func_info *func_list;
 int func_count;
 struct trace_call *call_list;
 int call_count;
+struct trace_sample *sample_list;
+int sample_count;
+struct bootstage_info *bootstage_list;
+int bootstage_count;
 int verbose;	/* Verbosity level 0=none, 1=warn, 2=notice, 3=info, 4=debug */
 unsigned long text_offset;		/* text address of first function */
 
@@ -85,8 +125,12 @@ static void usage(void)
 		"\n"
 		"Commands\n"
 		"   dump-ftrace\t\tDump out textual data in ftrace format\n"
+		"   dump-samples\tDump out a flat profile from sampling data\n"
+		"   dump-chrome\t\tDump out a timeline in Chrome trace-event JSON\n"
+		"   dump-folded\t\tDump out folded stacks for a flame graph\n"
 		"\n"
 		"Options:\n"
+		"   -b <stash>\tSpecify bootstage stash (or memory dump holding one)\n"
 		"   -m <map>\tSpecify Systen.map file\n"
 		"   -t <trace>\tSpecific trace data file (from U-Boot)\n"
 		"   -v <0-4>\tSpecify verbosity\n");
@@ -226,6 +270,28 @@ static int read_calls(FILE *fin, size_t count)
 	return 0;
 }
 
+static int read_samples(FILE *fin, size_t count)
+{
+	struct trace_sample *sample_data;
+	int i;
+
+	notice("sample count: %zu\n", count);
+	sample_list = (struct trace_sample *)calloc(count,
+						     sizeof(*sample_data));
+	if (!sample_list) {
+		error("Cannot allocate sample_list\n");
+		return -1;
+	}
+	sample_count = count;
+
+	sample_data = sample_list;
+	for (i = 0; i < count; i++, sample_data++) {
+		if (read_data(fin, sample_data, sizeof(*sample_data)))
+			return 1;
+	}
+	return 0;
+}
+
 static int read_profile(FILE *fin, int *not_found)
 {
 	struct trace_output_hdr hdr;
@@ -249,6 +315,11 @@ static int read_profile(FILE *fin, int *not_found)
 			if (read_calls(fin, hdr.rec_count))
 				return 1;
 			break;
+
+		case TRACE_CHUNK_SAMPLES:
+			if (read_samples(fin, hdr.rec_count))
+				return 1;
+			break;
 		}
 	}
 	return 0;
@@ -376,6 +447,128 @@ static void check_functions(void)
 	     not_found, removed_code_size);
 }
 
+/* Read a file into memory, returning its size or -1 on error */
+static long read_whole_file(const char *fname, char **bufp)
+{
+	FILE *fin;
+	char *buf;
+	long size;
+
+	fin = fopen(fname, "rb");
+	if (!fin) {
+		error("Cannot open file '%s'\n", fname);
+		return -1;
+	}
+	if (fseek(fin, 0, SEEK_END) || (size = ftell(fin)) < 0 ||
+	    fseek(fin, 0, SEEK_SET)) {
+		error("Cannot get size of file '%s'\n", fname);
+		fclose(fin);
+		return -1;
+	}
+	buf = malloc(size + 1);
+	if (!buf || fread(buf, 1, size, fin) != size) {
+		error("Cannot read file '%s'\n", fname);
+		free(buf);
+		fclose(fin);
+		return -1;
+	}
+	fclose(fin);
+	*bufp = buf;
+
+	return size;
+}
+
+/*
+ * Parse the records of a bootstage stash, given the size of each record.
+ * Returns 0 if OK, -1 if the data does not fit this record size.
+ */
+static int parse_bootstage(const char *base, const struct bootstage_hdr *hdr,
+			   int rec_size)
+{
+	const char *ptr, *end = base + hdr->size;
+	struct bootstage_info *list;
+	int i;
+
+	ptr = base + sizeof(*hdr) + (size_t)hdr->count * rec_size;
+	if (ptr > end)
+		return -1;
+
+	list = calloc(hdr->count, sizeof(*list));
+	assert(list);
+	for (i = 0; i < hdr->count; i++) {
+		const char *rec = base + sizeof(*hdr) + i * rec_size;
+		struct bootstage_info *info = &list[i];
+		const char *name = ptr;
+
+		while (ptr < end && *ptr)
+			ptr++;
+		if (ptr++ == end)
+			break;
+		info->name = name;
+
+		if (rec_size == BOOTSTAGE_REC_SIZE_64) {
+			memcpy(&info->time_us, rec, sizeof(uint64_t));
+			memcpy(&info->start_us, rec + 8, sizeof(uint32_t));
+			memcpy(&info->flags, rec + 24, sizeof(int));
+			memcpy(&info->id, rec + 28, sizeof(int));
+		} else {
+			uint32_t time_us;
+
+			memcpy(&time_us, rec, sizeof(uint32_t));
+			info->time_us = time_us;
+			memcpy(&info->start_us, rec + 4, sizeof(uint32_t));
+			memcpy(&info->flags, rec + 12, sizeof(int));
+			memcpy(&info->id, rec + 16, sizeof(int));
+		}
+	}
+
+	/* The names must exactly fill the rest of the stash */
+	if (i != hdr->count || ptr != end) {
+		free(list);
+		return -1;
+	}
+	bootstage_list = list;
+	bootstage_count = hdr->count;
+
+	return 0;
+}
+
+/*
+ * Read a bootstage stash. The file may also be a memory dump, in which case
+ * the first valid stash found at a 4-byte boundary is used.
+ */
+static int read_bootstage_file(const char *fname)
+{
+	char *buf;
+	long size, pos;
+
+	size = read_whole_file(fname, &buf);
+	if (size < 0)
+		return 1;
+
+	for (pos = 0; pos + (long)sizeof(struct bootstage_hdr) <= size;
+	     pos += 4) {
+		struct bootstage_hdr hdr;
+
+		memcpy(&hdr, buf + pos, sizeof(hdr));
+		if (hdr.magic != BOOTSTAGE_MAGIC ||
+		    hdr.version != BOOTSTAGE_VERSION ||
+		    hdr.size > size - pos || hdr.size < sizeof(hdr))
+			continue;
+		if (!parse_bootstage(buf + pos, &hdr, BOOTSTAGE_REC_SIZE_64) ||
+		    !parse_bootstage(buf + pos, &hdr, BOOTSTAGE_REC_SIZE_32)) {
+			notice("%d bootstage records found at offset %lx\n",
+			       bootstage_count, pos);
+			/* The names point into buf, so it is not freed */
+			return 0;
+		}
+	}
+	error("No bootstage stash found in '%s'\n", fname);
+	free(buf);
+
+	return 1;
+}
+
 static int read_trace_config(FILE *fin)
 {
 	char buff[200];
@@ -532,9 +725,258 @@ static int make_ftrace(void)
 	return 0;
 }
 
+/* Write a JSON string, with the quotes */
+static void out_json_str(const char *str)
+{
+	putchar('"');
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			printf("\\%c", *str);
+		else if ((unsigned char)*str < ' ')
+			printf("\\u%04x", *str);
+		else
+			putchar(*str);
+	}
+	putchar('"');
+}
+
+/*
+ * Chrome trace-event format, which can be loaded into chrome://tracing or
+ * https://ui.perfetto.dev. Function calls are shown as a nested timeline in
+ * one thread, bootstage records in another: marks as instant events and
+ * accumulated times (such as driver-model init) as a span with the total
+ * time, starting at the start of the last interval. Times are in
+ * microseconds.
+ */
+static int make_chrome(void)
+{
+	struct trace_call *call;
+	int missing_count = 0, skip_count = 0;
+	const char *sep = ",\n";
+	int i;
+
+	printf("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	printf("{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, "
+	       "\"args\": {\"name\": \"U-Boot\"}},\n");
+	printf("{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+	       "\"tid\": 1, \"args\": {\"name\": \"functions\"}},\n");
+	printf("{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+	       "\"tid\": 2, \"args\": {\"name\": \"bootstage\"}}");
+
+	for (i = 0, call = call_list; i < call_count; i++, call++) {
+		struct func_info *func = find_func_by_offset(call->func);
+		ulong time = call->flags & FUNCF_TIMESTAMP_MASK;
+
+		if (TRACE_CALL_TYPE(call) != FUNCF_ENTRY &&
+		    TRACE_CALL_TYPE(call) != FUNCF_EXIT)
+			continue;
+		if (!func) {
+			missing_count++;
+			continue;
+		}
+		if (!(func->flags & FUNCF_TRACE)) {
+			skip_count++;
+			continue;
+		}
+		printf("%s{\"name\": ", sep);
+		out_json_str(func->name);
+		printf(", \"cat\": \"func\", \"ph\": \"%c\", \"ts\": %lu, "
+		       "\"pid\": 1, \"tid\": 1}",
+		       TRACE_CALL_TYPE(call) == FUNCF_ENTRY ? 'B' : 'E', time);
+	}
+
+	for (i = 0; i < bootstage_count; i++) {
+		struct bootstage_info *rec = &bootstage_list[i];
+
+		printf("%s{\"name\": ", sep);
+		out_json_str(rec->name);
+		if (rec->start_us) {
+			/* Only the total is known, so show it as one span */
+			printf(", \"cat\": \"bootstage\", \"ph\": \"X\", "
+			       "\"ts\": %u, \"dur\": %" PRIu64, rec->start_us,
+			       rec->time_us);
+		} else {
+			printf(", \"cat\": \"bootstage\", \"ph\": \"i\", "
+			       "\"s\": \"p\", \"ts\": %" PRIu64, rec->time_us);
+		}
+		printf(", \"pid\": 1, \"tid\": 2, \"args\": {\"id\": %d%s}}",
+		       rec->id, rec->flags & BOOTSTAGEF_ERROR ?
+		       ", \"error\": true" : "");
+	}
+	printf("\n]}\n");
+	info("chrome: %d functions not found, %d excluded, %d bootstage records\n",
+	     missing_count, skip_count, bootstage_count);
+
+	return 0;
+}
+
+struct folded_stack {
+	char *stack;
+	unsigned long us;
+};
+
+static int h_cmp_folded(const void *v1, const void *v2)
+{
+	const struct folded_stack *f1 = v1, *f2 = v2;
+
+	return strcmp(f1->stack, f2->stack);
+}
+
+/*
+ * Folded stacks, as used by flamegraph.pl and speedscope: one line per call
+ * stack, with the function names separated by semicolons, followed by the
+ * time in microseconds spent in the last function itself:
+ *
+ *  board_init_r;initr_dm;dm_init_and_scan 1234
+ *
+ * The time of excluded functions is counted in their caller. An exit which
+ * does not match a function on the stack (e.g. because tracing started
+ * part-way through) is ignored.
+ */
+static int make_folded(void)
+{
+	struct func_info *stack[MAX_STACK_DEPTH];
+	struct folded_stack *list = NULL;
+	int count = 0, alloced = 0;
+	struct trace_call *call;
+	ulong last = 0;
+	int depth = 0, overflow = 0;
+	int i, j;
+
+	for (i = 0, call = call_list; i < call_count; i++, call++) {
+		struct func_info *func = find_func_by_offset(call->func);
+		ulong time = call->flags & FUNCF_TIMESTAMP_MASK;
+
+		if (TRACE_CALL_TYPE(call) != FUNCF_ENTRY &&
+		    TRACE_CALL_TYPE(call) != FUNCF_EXIT)
+			continue;
+		if (!func || !(func->flags & FUNCF_TRACE))
+			continue;
+
+		/* Charge the time since the last event to the current stack */
+		if (depth && !overflow && time > last) {
+			size_t len = 0;
+			char *str;
+
+			for (j = 0; j < depth; j++)
+				len += strlen(stack[j]->name) + 1;
+			str = malloc(len);
+			assert(str);
+			for (j = 0, len = 0; j < depth; j++) {
+				strcpy(str + len, stack[j]->name);
+				len += strlen(stack[j]->name);
+				str[len++] = ';';
+			}
+			str[len - 1] = '\0';
+
+			if (count == alloced) {
+				alloced += 4096;
+				list = realloc(list, alloced * sizeof(*list));
+				assert(list);
+			}
+			list[count].stack = str;
+			list[count++].us = time - last;
+		}
+		last = time;
+
+		if (TRACE_CALL_TYPE(call) == FUNCF_ENTRY) {
+			if (overflow || depth == MAX_STACK_DEPTH)
+				overflow++;
+			else
+				stack[depth++] = func;
+		} else if (overflow) {
+			overflow--;
+		} else {
+			for (j = depth - 1; j >= 0 && stack[j] != func; j--)
+				;
+			if (j >= 0)
+				depth = j;
+		}
+	}
+
+	/* Merge identical stacks */
+	qsort(list, count, sizeof(*list), h_cmp_folded);
+	for (i = 0; i < count; i = j) {
+		unsigned long us = 0;
+
+		for (j = i; j < count && !strcmp(list[i].stack, list[j].stack);
+		     j++)
+			us += list[j].us;
+		printf("%s %lu\n", list[i].stack, us);
+	}
+	for (i = 0; i < count; i++)
+		free(list[i].stack);
+	free(list);
+
+	return 0;
+}
+
+static int h_cmp_samples(const void *v1, const void *v2)
+{
+	const struct func_info *f1 = *(struct func_info **)v1;
+	const struct func_info *f2 = *(struct func_info **)v2;
+
+	if (f1->sample_count != f2->sample_count)
+		return f1->sample_count < f2->sample_count ? 1 : -1;
+
+	return strcmp(f1->name, f2->name);
+}
+
+/*
+ * Each sample is attributed to the function containing the sampled PC. The
+ * output is sorted by sample count, most frequent first:
+ *
+ *  samples   percent  function
+ *     1234    12.34%  mmc_bread
+ */
+static int make_samples(void)
+{
+	struct func_info **sorted;
+	struct trace_sample *sample;
+	int missing_count = 0;
+	int i, used;
+
+	for (i = 0, sample = sample_list; i < sample_count; i++, sample++) {
+		struct func_info *func = find_caller_by_offset(sample->pc);
+
+		if (!func || sample->pc >= func->offset + func->code_size) {
+			missing_count++;
+			continue;
+		}
+		func->sample_count++;
+	}
+
+	sorted = calloc(func_count, sizeof(*sorted));
+	if (!sorted) {
+		error("Cannot allocate sorted function list\n");
+		return -1;
+	}
+	for (i = used = 0; i < func_count; i++) {
+		if (func_list[i].sample_count && func_list[i].flags & FUNCF_TRACE)
+			sorted[used++] = &func_list[i];
+	}
+	qsort(sorted, used, sizeof(*sorted), h_cmp_samples);
+
+	printf("%9s %9s  %s\n", "samples", "percent", "function");
+	for (i = 0; i < used; i++) {
+		printf("%9lu %8.2f%%  %s\n", sorted[i]->sample_count,
+		       sorted[i]->sample_count * 100.0 / sample_count,
+		       sorted[i]->name);
+	}
+	if (missing_count) {
+		printf("%9d %8.2f%%  <outside U-Boot>\n", missing_count,
+		       missing_count * 100.0 / sample_count);
+	}
+	free(sorted);
+	info("samples: %d total, %d outside U-Boot\n", sample_count,
+	     missing_count);
+
+	return 0;
+}
+
 static int prof_tool(int argc, char *const argv[],
 		     const char *prof_fname, const char *map_fname,
-		     const char *trace_config_fname)
+		     const char *trace_config_fname, const char *bootstage_fname)
 {
 	int err = 0;
 
@@ -542,6 +984,8 @@ static int prof_tool(int argc, char *const argv[],
 		return -1;
 	if (prof_fname && read_profile_file(prof_fname))
 		return -1;
+	if (bootstage_fname && read_bootstage_file(bootstage_fname))
+		return -1;
 	if (trace_config_fname && read_trace_config_file(trace_config_fname))
 		return -1;
 
@@ -552,6 +996,12 @@ static int prof_tool(int argc, char *const argv[],
 
 		if (0 == strcmp(cmd, "dump-ftrace"))
 			err = make_ftrace();
+		else if (0 == strcmp(cmd, "dump-samples"))
+			err = make_samples();
+		else if (0 == strcmp(cmd, "dump-chrome"))
+			err = make_chrome();
+		else if (0 == strcmp(cmd, "dump-folded"))
+			err = make_folded();
 		else
 			warn("Unknown command '%s'\n", cmd);
 	}
@@ -564,11 +1014,16 @@ int main(int argc, char *argv[])
 	const char *map_fname = "System.map";
 	const char *prof_fname = NULL;
 	const char *trace_config_fname = NULL;
+	const char *bootstage_fname = NULL;
 	int opt;
 
 	verbose = 2;
-	while ((opt = getopt(argc, argv, "m:p:t:v:")) != -1) {
+	while ((opt = getopt(argc, argv, "b:m:p:t:v:")) != -1) {
 		switch (opt) {
+		case 'b':
+			bootstage_fname = optarg;
+			break;
+
 		case 'm':
 			map_fname = optarg;
 			break;
@@ -595,5 +1050,5 @@ int main(int argc, char *argv[])
 
 	debug("Debug enabled\n");
 	return prof_tool(argc, argv, prof_fname, map_fname,
-			 trace_config_fname);
+			 trace_config_fname, bootstage_fname);
 }
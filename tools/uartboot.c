@@ -0,0 +1,579 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Send an image to SPL over a UART with the stream protocol
+ *
+ * See include/uart_stream.h for the protocol. The image is sent as it is.
+ * Files in the LZ4 frame format (e.g. from 'lz4 -9 u-boot.itb') are
+ * detected and decompressed by SPL, which must have CONFIG_SPL_LZ4.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/stat.h>
+#include <u-boot/crc.h>
+#include <uart_stream.h>
+
+#ifdef __linux__
+#include "termios_linux.h"
+#else
+#include <termios.h>
+#endif
+
+#define LZ4F_MAGIC		0x184d2204
+
+/* Time to wait for a reply, and how often to try again */
+#define RSP_TIMEOUT_MS		1000
+#define RSP_RETRIES		10
+#define SYNC_INTERVAL_MS	100
+
+/* The target's baud rate must be this close to the one asked for (percent) */
+#define BAUD_TOLERANCE		2
+
+/* Baud rates to try, fastest first */
+static const unsigned int baud_rates[] = {
+	4000000, 3000000, 2000000, 1500000, 1152000, 1000000, 921600,
+	576000, 500000, 460800, 230400, 115200,
+};
+
+/**
+ * struct uartboot - state of the transfer
+ *
+ * @fd: tty
+ * @baud: Baud rate the tty is set to
+ * @max_baud: Fastest baud rate to try
+ * @data: Image to send
+ * @start: Description of the image, in CPU byte order
+ * @rbuf: Bytes read from the tty but not used yet
+ * @rpos: Position of the next byte in @rbuf
+ * @rlen: Number of bytes in @rbuf
+ */
+struct uartboot {
+	int fd;
+	unsigned int baud;
+	unsigned int max_baud;
+	const uint8_t *data;
+	struct ustream_start start;
+	uint8_t rbuf[256];
+	int rpos;
+	int rlen;
+};
+
+static unsigned long now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000;
+}
+
+static int tty_set_baud(int fd, unsigned int baud)
+{
+	struct termios tio;
+
+	if (tcgetattr(fd, &tio))
+		return -1;
+#ifdef BOTHER
+	tio.c_ospeed = baud;
+	tio.c_ispeed = baud;
+	if (cfsetospeed(&tio, BOTHER) || cfsetispeed(&tio, BOTHER))
+		return -1;
+#else
+	/* speed_t is the baud rate itself on the BSDs and macOS */
+	if (cfsetspeed(&tio, baud))
+		return -1;
+#endif
+	if (tcsetattr(fd, TCSANOW, &tio) || tcgetattr(fd, &tio))
+		return -1;
+#ifdef BOTHER
+	if (tio.c_ospeed * 100ULL < baud * (100ULL - BAUD_TOLERANCE) ||
+	    tio.c_ospeed * 100ULL > baud * (100ULL + BAUD_TOLERANCE)) {
+		errno = EINVAL;
+		return -1;
+	}
+#endif
+	tcflush(fd, TCIFLUSH);
+
+	return 0;
+}
+
+static int tty_open(const char *path, unsigned int baud)
+{
+	struct termios tio;
+	int fd;
+
+	fd = open(path, O_RDWR | O_NOCTTY);
+	if (fd < 0)
+		return -1;
+	if (tcgetattr(fd, &tio))
+		goto err;
+	cfmakeraw(&tio);
+	tio.c_cflag |= CREAD | CLOCAL;
+	tio.c_cflag &= ~(CSTOPB | HUPCL | CRTSCTS);
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 0;
+	if (tcsetattr(fd, TCSANOW, &tio) || tty_set_baud(fd, baud))
+		goto err;
+
+	return fd;
+err:
+	close(fd);
+
+	return -1;
+}
+
+static int write_all(int fd, const void *data, size_t len)
+{
+	const uint8_t *buf = data;
+	ssize_t n;
+
+	while (len) {
+		n = write(fd, buf, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		buf += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+static int send_frame(struct uartboot *ub, enum ustream_type type,
+		      uint32_t arg, const void *data, uint16_t len)
+{
+	struct ustream_hdr hdr = {
+		.magic = cpu_to_le32(USTREAM_MAGIC),
+		.type = type,
+		.len = cpu_to_le16(len),
+		.arg = cpu_to_le32(arg),
+	};
+	uint32_t crc;
+
+	crc = crc32(0, (uint8_t *)&hdr, offsetof(struct ustream_hdr, crc));
+	hdr.crc = cpu_to_le32(crc32(crc, data, len));
+	if (write_all(ub->fd, &hdr, sizeof(hdr)) ||
+	    write_all(ub->fd, data, len)) {
+		perror("write");
+		exit(EXIT_FAILURE);
+	}
+
+	return 0;
+}
+
+/* Read a byte, returning -ETIMEDOUT if none arrives before @deadline */
+static int read_byte(struct uartboot *ub, unsigned long deadline)
+{
+	struct pollfd pfd = { .fd = ub->fd, .events = POLLIN };
+	unsigned long now;
+	ssize_t n;
+	int ret;
+
+	while (ub->rpos == ub->rlen) {
+		now = now_ms();
+		ret = poll(&pfd, 1, now < deadline ? deadline - now : 0);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return -ETIMEDOUT;
+		n = read(ub->fd, ub->rbuf, sizeof(ub->rbuf));
+		if (n < 0 && errno != EINTR && errno != EAGAIN) {
+			perror("read");
+			exit(EXIT_FAILURE);
+		}
+		ub->rpos = 0;
+		ub->rlen = n > 0 ? n : 0;
+	}
+
+	return ub->rbuf[ub->rpos++];
+}
+
+/**
+ * recv_frame() - receive a frame from the target
+ *
+ * Anything which is not a frame, e.g. console output, is dropped. Frames from
+ * the target have no payload.
+ *
+ * @ub: Transfer state
+ * @hdr: Returns the header, in CPU byte order
+ * @timeout_ms: Time to wait
+ * Return: 0 if OK, -ETIMEDOUT if no frame arrived, -EBADMSG if the frame is
+ *	corrupted
+ */
+static int recv_frame(struct uartboot *ub, struct ustream_hdr *hdr,
+		      unsigned long timeout_ms)
+{
+	unsigned long deadline = now_ms() + timeout_ms;
+	uint8_t *p = (uint8_t *)hdr;
+	uint32_t magic = 0;
+	unsigned int i;
+	int ch;
+
+	do {
+		ch = read_byte(ub, deadline);
+		if (ch < 0)
+			return ch;
+		magic = magic >> 8 | (uint32_t)ch << 24;
+	} while (magic != USTREAM_MAGIC);
+
+	hdr->magic = cpu_to_le32(magic);
+	for (i = sizeof(magic); i < sizeof(*hdr); i++) {
+		ch = read_byte(ub, deadline + RSP_TIMEOUT_MS);
+		if (ch < 0)
+			return ch;
+		p[i] = ch;
+	}
+	if (hdr->len ||
+	    le32_to_cpu(hdr->crc) != crc32(0, p, offsetof(struct ustream_hdr,
+							    crc)))
+		return -EBADMSG;
+	hdr->arg = le32_to_cpu(hdr->arg);
+
+	return 0;
+}
+
+/* Pick the fastest baud rate which the target can run at accurately */
+static unsigned int pick_baud(struct uartboot *ub, unsigned int target_max)
+{
+	unsigned int baud, div, actual, i;
+
+	for (i = 0; i < sizeof(baud_rates) / sizeof(baud_rates[0]); i++) {
+		baud = baud_rates[i];
+		if (baud <= ub->baud)
+			break;
+		if (baud > ub->max_baud || baud > target_max)
+			continue;
+		div = (target_max + baud / 2) / baud;
+		actual = target_max / div;
+		if (actual * 100ULL >= baud * (100ULL - BAUD_TOLERANCE) &&
+		    actual * 100ULL <= baud * (100ULL + BAUD_TOLERANCE))
+			return baud;
+	}
+
+	return ub->baud;
+}
+
+static int wait_reply(struct uartboot *ub, struct ustream_hdr *hdr,
+		      unsigned long timeout_ms)
+{
+	unsigned long deadline = now_ms() + timeout_ms;
+	unsigned long now;
+	int ret;
+
+	while ((now = now_ms()) < deadline) {
+		ret = recv_frame(ub, hdr, deadline - now);
+		if (!ret && (hdr->type == USTREAM_ACK ||
+			     hdr->type == USTREAM_NAK))
+			return 0;
+	}
+
+	return -ETIMEDOUT;
+}
+
+/* Switch to the new baud rate and check that the target followed */
+static int sync_baud(struct uartboot *ub, unsigned int baud)
+{
+	unsigned int old_baud = ub->baud;
+	unsigned long start = now_ms();
+	struct ustream_hdr hdr;
+
+	tcdrain(ub->fd);
+	if (tty_set_baud(ub->fd, baud)) {
+		fprintf(stderr, "Cannot set baud rate %u: %s\n", baud,
+			strerror(errno));
+		return -1;
+	}
+	ub->baud = baud;
+	ub->rpos = ub->rlen = 0;
+
+	while (now_ms() - start < USTREAM_SYNC_MS) {
+		send_frame(ub, USTREAM_SYNC, 0, NULL, 0);
+		if (!wait_reply(ub, &hdr, SYNC_INTERVAL_MS) &&
+		    hdr.type == USTREAM_ACK)
+			return 0;
+	}
+
+	fprintf(stderr, "No reply at %u baud\n", baud);
+	tty_set_baud(ub->fd, old_baud);
+	ub->baud = old_baud;
+	ub->rpos = ub->rlen = 0;
+
+	return -1;
+}
+
+static int handshake(struct uartboot *ub)
+{
+	struct ustream_start start;
+	struct ustream_hdr hdr;
+	unsigned int baud;
+	int ret;
+
+	start.size = cpu_to_le32(ub->start.size);
+	start.crc = cpu_to_le32(ub->start.crc);
+	start.flags = cpu_to_le32(ub->start.flags);
+
+	printf("Waiting for the target...\n");
+	for (;;) {
+		do {
+			ret = recv_frame(ub, &hdr, RSP_TIMEOUT_MS);
+		} while (ret || hdr.type != USTREAM_HELLO);
+
+		baud = pick_baud(ub, hdr.arg);
+		send_frame(ub, USTREAM_START, baud, &start, sizeof(start));
+		if (wait_reply(ub, &hdr, RSP_TIMEOUT_MS))
+			continue;
+		if (hdr.type == USTREAM_NAK) {
+			fprintf(stderr,
+				"Target refused the image: too large%s?\n",
+				ub->start.flags & USTREAM_F_LZ4 ?
+				" or no LZ4 support" : "");
+			return -1;
+		}
+		if (hdr.arg == ub->baud || !hdr.arg)
+			return 0;
+		if (!sync_baud(ub, hdr.arg))
+			return 0;
+
+		/* Try something slower next time */
+		ub->max_baud = hdr.arg - 1;
+	}
+}
+
+static void show_progress(struct uartboot *ub, uint32_t done,
+			  unsigned long start)
+{
+	unsigned long ms = now_ms() - start + 1;
+
+	printf("\r%u/%u bytes (%u%%), %lu KiB/s ", done, ub->start.size,
+	       (unsigned int)(done * 100ULL / ub->start.size),
+	       done * 1000UL / ms / 1024);
+	fflush(stdout);
+}
+
+static int send_image(struct uartboot *ub)
+{
+	uint32_t size = ub->start.size, pos = 0, acked = 0, shown = 0, last = 0;
+	unsigned long start = now_ms();
+	struct ustream_hdr hdr;
+	int tries = 0;
+	uint16_t len;
+	int ret;
+
+	while (acked < size) {
+		/* Keep the window full, only waiting when there is no room */
+		if (pos < size && pos - acked < USTREAM_WINDOW) {
+			len = size - pos < USTREAM_BLOCK ? size - pos :
+			      USTREAM_BLOCK;
+			send_frame(ub, USTREAM_DATA, pos, ub->data + pos, len);
+			last = pos;
+			pos += len;
+			ret = recv_frame(ub, &hdr, 0);
+		} else {
+			ret = recv_frame(ub, &hdr, RSP_TIMEOUT_MS);
+			if (ret == -ETIMEDOUT) {
+				if (++tries > RSP_RETRIES && pos == size) {
+					fprintf(stderr,
+						"\nWarning: no final reply, assuming the image arrived\n");
+					return 0;
+				}
+				if (tries > RSP_RETRIES) {
+					fprintf(stderr, "\nNo reply\n");
+					return -1;
+				}
+				/*
+				 * Once all is sent, either the target lost the
+				 * last frame, or it has finished and its final
+				 * ACK was lost. Just send the last frame again,
+				 * since the target asks for anything else
+				 * which is missing
+				 */
+				pos = pos == size ? last : acked;
+			}
+		}
+		if (ret)
+			continue;
+
+		if (hdr.type == USTREAM_ACK && hdr.arg > acked &&
+		    hdr.arg <= size) {
+			acked = hdr.arg;
+			tries = 0;
+		} else if (hdr.type == USTREAM_NAK && hdr.arg >= acked &&
+			   hdr.arg <= size) {
+			if (hdr.arg == size) {
+				fprintf(stderr, "\nImage checksum mismatch\n");
+				return -1;
+			}
+			acked = hdr.arg;
+			pos = acked;
+			tries = 0;
+		}
+		if (acked - shown >= USTREAM_WINDOW || acked == size) {
+			show_progress(ub, acked, start);
+			shown = acked;
+		}
+	}
+	printf("\n");
+
+	return 0;
+}
+
+/* Copy between the terminal and the tty until Ctrl-\ is pressed */
+static int terminal(int tty)
+{
+	struct termios otio, tio;
+	int in = STDIN_FILENO;
+	char buf[256];
+	ssize_t n;
+
+	if (tcgetattr(in, &otio))
+		return -1;
+	tio = otio;
+	cfmakeraw(&tio);
+	tcsetattr(in, TCSANOW, &tio);
+	printf("[Type Ctrl-\\ to quit]\r\n");
+
+	for (;;) {
+		fd_set rfds;
+
+		FD_ZERO(&rfds);
+		FD_SET(tty, &rfds);
+		FD_SET(in, &rfds);
+		if (select((tty > in ? tty : in) + 1, &rfds, NULL, NULL,
+			   NULL) < 0)
+			break;
+		if (FD_ISSET(tty, &rfds)) {
+			n = read(tty, buf, sizeof(buf));
+			if (n <= 0 || write_all(STDOUT_FILENO, buf, n))
+				break;
+		}
+		if (FD_ISSET(in, &rfds)) {
+			n = read(in, buf, sizeof(buf));
+			if (n <= 0 || memchr(buf, '\34', n) ||
+			    write_all(tty, buf, n))
+				break;
+		}
+	}
+
+	tcsetattr(in, TCSANOW, &otio);
+	printf("\n");
+
+	return 0;
+}
+
+static void *read_image(const char *path, uint32_t *sizep)
+{
+	struct stat st;
+	void *buf;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st))
+		goto err;
+	if (!st.st_size || st.st_size > UINT32_MAX) {
+		errno = EFBIG;
+		goto err;
+	}
+	buf = malloc(st.st_size);
+	if (!buf)
+		goto err;
+	if (read(fd, buf, st.st_size) != st.st_size) {
+		free(buf);
+		goto err;
+	}
+	close(fd);
+	*sizep = st.st_size;
+
+	return buf;
+err:
+	perror(path);
+	if (fd >= 0)
+		close(fd);
+
+	return NULL;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [-b baud] [-B max_baud] [-t] <tty> <image>\n"
+		"\n"
+		"  -b baud      Initial baud rate (default 115200)\n"
+		"  -B max_baud  Do not go faster than this\n"
+		"  -t           Start a terminal once the image is sent\n",
+		prog);
+}
+
+int main(int argc, char *argv[])
+{
+	struct uartboot ub = { .max_baud = UINT32_MAX };
+	unsigned int baud = 115200;
+	unsigned long start;
+	bool term = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "b:B:th")) != -1) {
+		switch (opt) {
+		case 'b':
+			baud = strtoul(optarg, NULL, 0);
+			break;
+		case 'B':
+			ub.max_baud = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			term = true;
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+	if (argc - optind != 2 || !baud) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	ub.data = read_image(argv[optind + 1], &ub.start.size);
+	if (!ub.data)
+		return EXIT_FAILURE;
+	ub.start.crc = crc32(0, ub.data, ub.start.size);
+	if (ub.start.size >= 4 &&
+	    le32_to_cpu(*(uint32_t *)ub.data) == LZ4F_MAGIC)
+		ub.start.flags |= USTREAM_F_LZ4;
+
+	ub.fd = tty_open(argv[optind], baud);
+	if (ub.fd < 0) {
+		perror(argv[optind]);
+		return EXIT_FAILURE;
+	}
+	ub.baud = baud;
+
+	if (handshake(&ub))
+		return EXIT_FAILURE;
+	printf("Sending %u bytes%s at %u baud\n", ub.start.size,
+	       ub.start.flags & USTREAM_F_LZ4 ? " (LZ4)" : "", ub.baud);
+	start = now_ms();
+	if (send_image(&ub))
+		return EXIT_FAILURE;
+	printf("Done in %.1f s\n", (now_ms() - start) / 1000.0);
+
+	/* The target goes back to the original baud rate */
+	tcdrain(ub.fd);
+	if (ub.baud != baud)
+		tty_set_baud(ub.fd, baud);
+	if (term)
+		terminal(ub.fd);
+	close(ub.fd);
+
+	return EXIT_SUCCESS;
+}